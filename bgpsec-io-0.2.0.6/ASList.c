@@ -436,6 +436,46 @@ void freeASInfo(void* info)
   }
 }
 
+/**
+ * Create a copy of the given AS list. The DER keys are copied, the OpenSSL 
+ * keys are not and will be generated by the copy on first use. This allows
+ * each signing thread to use its own keys.
+ * 
+ * @param asList The AS list to be copied.
+ * 
+ * @return The copy of the list or NULL if no list was given. Use freeASList
+ *         to release the copy.
+ */
+TASList* copyASList(TASList* asList)
+{
+  TASList*  copy  = NULL;
+  ListElem* lelem = NULL;
+  TASInfo*  info  = NULL;
+  TASInfo*  cInfo = NULL;
+  
+  if (asList != NULL)
+  {
+    copy = (TASList*)createList();
+    // The list is sorted already, keep the order.
+    for (lelem = asList->head; lelem != NULL; lelem = lelem->next)
+    {
+      info  = (TASInfo*)lelem->elem;
+      cInfo = malloc(sizeof(TASInfo));
+      memcpy(cInfo, info, sizeof(TASInfo));
+      cInfo->ec_key     = NULL;
+      cInfo->ec_key_len = 0;
+      if (info->key.keyData != NULL)
+      {
+        cInfo->key.keyData = OPENSSL_malloc(info->key.keyLength);
+        memcpy(cInfo->key.keyData, info->key.keyData, info->key.keyLength);
+      }
+      addListElem((List*)copy, cInfo);
+    }
+  }
+  
+  return copy;
+}
+
 /**
  * Free the ASList recursively.
  * 
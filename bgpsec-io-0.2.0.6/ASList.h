@@ -126,6 +126,18 @@ void printASInfo(char* c1, char* c2, TASInfo* asInfo);
  */
 void printList(TASList* list);
 
+/**
+ * Create a copy of the given AS list. The DER keys are copied, the OpenSSL 
+ * keys are not and will be generated by the copy on first use. This allows
+ * each signing thread to use its own keys.
+ * 
+ * @param asList The AS list to be copied.
+ * 
+ * @return The copy of the list or NULL if no list was given. Use freeASList
+ *         to release the copy.
+ */
+TASList* copyASList(TASList* asList);
+
 /**
  * Free the ASList recursively.
  * 
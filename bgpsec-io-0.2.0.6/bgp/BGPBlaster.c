@@ -0,0 +1,540 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * This file implements the blaster, see BGPBlaster.h
+ *
+ * @version 0.2.0.6
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "bgp/BGPBlaster.h"
+
+/** Nano seconds per second. */
+#define BLAST_NSEC 1000000000ULL
+/** The interval in which the monitor session is checked (ns). */
+#define BLAST_POLL_INTERVAL 1000000ULL
+/** The monitor must not receive prefixes for this time (ns) before the
+ * blasting starts. */
+#define BLAST_MON_QUIET (1 * BLAST_NSEC)
+
+/**
+ * Sleep for the given time.
+ *
+ * @param nsec The time in nano seconds.
+ */
+static void _blastSleep(u_int64_t nsec)
+{
+  struct timespec wait;
+  wait.tv_sec  = nsec / BLAST_NSEC;
+  wait.tv_nsec = nsec % BLAST_NSEC;
+  nanosleep(&wait, NULL);
+}
+
+/**
+ * Return the number of prefixes the monitor session received.
+ *
+ * @param blaster The blaster.
+ *
+ * @return The number of prefixes.
+ */
+static u_int32_t _monitorPrefixes(BGPBlaster* blaster)
+{
+  return __atomic_load_n(&blaster->monitor->rcvPrefixes, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Determine if the given update can be packed with other updates. This is the
+ * case for updates without withdrawn routes that announce their prefixes in
+ * the NLRI field only. Updates containing a BGPsec path or MP_REACH_NLRI are
+ * not packed.
+ *
+ * @param update The update.
+ * @param attrLen OUT the size of the path attributes.
+ * @param nlri OUT the start of the NLRI.
+ * @param nlriLen OUT the size of the NLRI.
+ *
+ * @return true if the update can be packed.
+ */
+static bool _isPackable(BGP_UpdateMessage_1* update, u_int16_t* attrLen,
+                        u_int8_t** nlri, u_int16_t* nlriLen)
+{
+  u_int8_t* ptr  = (u_int8_t*)update + sizeof(BGP_UpdateMessage_1);
+  u_int8_t* end  = (u_int8_t*)update + ntohs(update->messageHeader.length);
+  BGP_PathAttribute* attr = NULL;
+  int       size = 0;
+
+  if (update->withdrawn_routes_length != 0
+      || ptr + sizeof(BGP_UpdateMessage_2) > end)
+  {
+    return false;
+  }
+  *attrLen = ntohs(((BGP_UpdateMessage_2*)ptr)->path_attr_length);
+  ptr     += sizeof(BGP_UpdateMessage_2);
+  *nlri    = ptr + *attrLen;
+  if (*nlri >= end)
+  {
+    return false;
+  }
+  *nlriLen = end - *nlri;
+
+  while (ptr + sizeof(BGP_PathAttribute) < *nlri)
+  {
+    attr = (BGP_PathAttribute*)ptr;
+    if (   attr->attr_type_code == BGP_UPD_A_TYPE_BGPSEC
+        || attr->attr_type_code == BGP_UPD_A_TYPE_MP_REACH_NLRI)
+    {
+      return false;
+    }
+    size = getPathAttributeSize(attr);
+    if (size <= 0)
+    {
+      return false;
+    }
+    ptr += size;
+  }
+
+  return true;
+}
+
+/**
+ * Take one token out of the bucket. If no token is available the staged data
+ * is written and the blaster waits for the next token.
+ *
+ * @param blaster The blaster.
+ *
+ * @return false if the staged data could not be written.
+ */
+static bool _takeToken(BGPBlaster* blaster)
+{
+  u_int64_t now    = 0;
+  double    rate   = blaster->config.rate;
+  double    target = 0;
+  int       idx    = 0;
+
+  if (rate == 0)
+  {
+    return true;
+  }
+
+  // Refill, at the second time the tokens must be available.
+  for (idx = 0; idx < 2; idx++)
+  {
+    now = getSessionClock();
+    if (blaster->lastRefill == 0)
+    {
+      blaster->lastRefill = now;
+    }
+    blaster->tokens += ((now - blaster->lastRefill) * rate) / BLAST_NSEC;
+    if (blaster->tokens > blaster->burst)
+    {
+      blaster->tokens = blaster->burst;
+    }
+    blaster->lastRefill = now;
+    if (blaster->tokens >= 1 || idx == 1)
+    {
+      break;
+    }
+    // Don't keep the staged updates while waiting.
+    if (!flushBlaster(blaster))
+    {
+      return false;
+    }
+    // Wait for 1ms of tokens, not only one, to keep the batches reasonable.
+    target = blaster->burst / 10;
+    target = target < 1 ? 1 : target;
+    _blastSleep((u_int64_t)(((target - blaster->tokens) * BLAST_NSEC) / rate));
+  }
+  blaster->tokens -= 1;
+
+  return true;
+}
+
+/**
+ * Start the monitor session.
+ *
+ * @param blaster The blaster.
+ */
+static void _startMonitor(BGPBlaster* blaster)
+{
+  BGP_SessionConf monConf;
+  int             idx = 0;
+
+  memcpy(&monConf, &blaster->session->bgpConf, sizeof(BGP_SessionConf));
+  monConf.asn           = blaster->config.monitorAS;
+  monConf.bgpIdentifier = blaster->config.monitorIdent;
+  memcpy(&monConf.local_addr, &blaster->config.monitorAddr,
+         sizeof(struct sockaddr_in));
+  for (idx = 0; idx < PRNT_MSG_COUNT; idx++)
+  {
+    monConf.printOnReceive[idx] = false;
+    monConf.printOnSend[idx]    = false;
+  }
+  monConf.printPollLoop = false;
+
+  blaster->monitor = createBGPSession(BGP_EXTMAX_MESSAGE_SIZE, &monConf, NULL);
+  if (blaster->monitor == NULL)
+  {
+    printf ("ERROR: Could not create the monitor session!\n");
+    return;
+  }
+  blaster->monitor->run = true;
+  if (pthread_create(&blaster->monitorThread, NULL, runBGP, blaster->monitor))
+  {
+    printf ("ERROR: Could not create the monitor thread!\n");
+    freeBGPSession(blaster->monitor);
+    blaster->monitor = NULL;
+  }
+}
+
+/**
+ * Create the blaster for the given session. If a monitor ASN is configured the
+ * monitor session is started as well.
+ *
+ * @param session The established or establishing session.
+ * @param config The blaster configuration.
+ *
+ * @return The blaster, must be freed with freeBlaster.
+ */
+BGPBlaster* createBlaster(BGPSession* session, BGP_BlastConf* config)
+{
+  BGPBlaster* blaster = malloc(sizeof(BGPBlaster));
+
+  memset(blaster, 0, sizeof(BGPBlaster));
+  blaster->session    = session;
+  memcpy(&blaster->config, config, sizeof(BGP_BlastConf));
+  // A batch is written once it exceeds BLAST_BATCH_SIZE, leave room for one
+  // more message.
+  blaster->buffSize   = BLAST_BATCH_SIZE + BGP_EXTMAX_MESSAGE_SIZE;
+  blaster->buff       = malloc(blaster->buffSize);
+  blaster->packOffset = -1;
+  blaster->noDelayFD  = -1;
+
+  if (config->rate > 0)
+  {
+    // Allow bursts of 10ms
+    blaster->burst  = config->rate / 100.0;
+    blaster->burst  = blaster->burst < 1 ? 1 : blaster->burst;
+    blaster->tokens = blaster->burst;
+  }
+
+  if (config->monitorAS != 0)
+  {
+    _startMonitor(blaster);
+  }
+
+  return blaster;
+}
+
+/**
+ * Stop the monitor session and free all memory of the blaster. Staged data is
+ * not written.
+ *
+ * @param blaster The blaster.
+ */
+void freeBlaster(BGPBlaster* blaster)
+{
+  if (blaster != NULL)
+  {
+    if (blaster->monitor != NULL)
+    {
+      // Stops the session the same way as the blasting session.
+      blaster->monitor->run = false;
+      pthread_join(blaster->monitorThread, NULL);
+      freeBGPSession(blaster->monitor);
+      blaster->monitor = NULL;
+    }
+    free(blaster->buff);
+    free(blaster);
+  }
+}
+
+/**
+ * Wait until the monitor session is established and record the prefixes it
+ * received so far.
+ *
+ * @param blaster The blaster.
+ *
+ * @return true if the monitor is established or no monitor is used.
+ */
+bool waitForMonitor(BGPBlaster* blaster)
+{
+  u_int64_t start   = getSessionClock();
+  u_int64_t timeout = blaster->config.monitorTimeout * BLAST_NSEC;
+  u_int64_t quiet   = 0;
+  u_int64_t now     = start;
+  u_int32_t count   = 0;
+
+  if (blaster->monitor == NULL)
+  {
+    return blaster->config.monitorAS == 0;
+  }
+
+  // The peer might still send its table to the monitor, wait until it is done.
+  while (now - start < timeout)
+  {
+    if (blaster->monitor->fsm.state == FSM_STATE_ESTABLISHED)
+    {
+      if (quiet == 0 || count != _monitorPrefixes(blaster))
+      {
+        count = _monitorPrefixes(blaster);
+        quiet = now;
+      }
+      else if (now - quiet >= BLAST_MON_QUIET)
+      {
+        blaster->baseline = count;
+        return true;
+      }
+    }
+    _blastSleep(BLAST_POLL_INTERVAL * 100);
+    now = getSessionClock();
+  }
+  printf ("WARNING: The monitor session to AS %u could not be established!\n",
+          blaster->monitor->bgpConf.peerAS);
+
+  return false;
+}
+
+/**
+ * Stage the given update for sending. The update is packed into the previous
+ * update if possible. The staged updates are written once a batch is full or
+ * the rate limit requires to wait.
+ *
+ * @param blaster The blaster.
+ * @param update The update to be send.
+ * @param stable true if the update memory does not change until the update is
+ *               written, it will be referenced instead of copied.
+ *
+ * @return false if the update could not be send.
+ */
+bool blastUpdate(BGPBlaster* blaster, BGP_UpdateMessage_1* update,
+                 bool stable)
+{
+  u_int16_t     size     = ntohs(update->messageHeader.length);
+  u_int32_t     maxSize  = getMaxUpdateSize(blaster->session);
+  u_int16_t     attrLen  = 0;
+  u_int16_t     nlriLen  = 0;
+  u_int16_t     lastSize = 0;
+  u_int8_t*     nlri     = NULL;
+  u_int8_t*     last     = NULL;
+  u_int8_t*     tail     = NULL;
+  struct iovec* iov      = NULL;
+  bool          packable = false;
+
+  if (size > maxSize)
+  {
+    // Let sendUpdate explain why the update can not be send.
+    return flushBlaster(blaster) && sendUpdate(blaster->session, update);
+  }
+  if (!_takeToken(blaster))
+  {
+    return false;
+  }
+  blaster->stats.updates++;
+  blaster->stats.prefixes += countUpdatePrefixes(update);
+
+  packable = _isPackable(update, &attrLen, &nlri, &nlriLen);
+  if (packable && blaster->packOffset >= 0 && attrLen == blaster->packAttrLen)
+  {
+    last     = blaster->buff + blaster->packOffset;
+    lastSize = ntohs(((BGP_MessageHeader*)last)->length);
+    if (   (lastSize + nlriLen) <= maxSize
+        && memcmp(last + sizeof(BGP_UpdateMessage_1)
+                       + sizeof(BGP_UpdateMessage_2),
+                  (u_int8_t*)update + sizeof(BGP_UpdateMessage_1)
+                                    + sizeof(BGP_UpdateMessage_2),
+                  attrLen) == 0)
+    {
+      // The packed update is the last one in the buffer, append the NLRI.
+      memcpy(blaster->buff + blaster->buffUsed, nlri, nlriLen);
+      ((BGP_MessageHeader*)last)->length = htons(lastSize + nlriLen);
+      blaster->iov[blaster->iovCount - 1].iov_len += nlriLen;
+      blaster->buffUsed += nlriLen;
+      blaster->staged   += nlriLen;
+      blaster->stats.packed++;
+      return (blaster->staged < BLAST_BATCH_SIZE) || flushBlaster(blaster);
+    }
+  }
+
+  if (blaster->iovCount == BLAST_MAX_IOV && !flushBlaster(blaster))
+  {
+    return false;
+  }
+
+  blaster->packOffset = -1;
+  if (stable && !packable)
+  {
+    // Zero copy, the update is written out of its own memory.
+    iov = &blaster->iov[blaster->iovCount++];
+    iov->iov_base = update;
+    iov->iov_len  = size;
+  }
+  else
+  {
+    tail = blaster->buff + blaster->buffUsed;
+    memcpy(tail, update, size);
+    iov = blaster->iovCount > 0 ? &blaster->iov[blaster->iovCount - 1] : NULL;
+    if (iov == NULL || (u_int8_t*)iov->iov_base + iov->iov_len != tail)
+    {
+      iov = &blaster->iov[blaster->iovCount++];
+      iov->iov_base = tail;
+      iov->iov_len  = 0;
+    }
+    iov->iov_len += size;
+    if (packable)
+    {
+      blaster->packOffset  = blaster->buffUsed;
+      blaster->packAttrLen = attrLen;
+    }
+    blaster->buffUsed += size;
+  }
+  blaster->staged += size;
+  blaster->stagedMsg++;
+
+  return (blaster->staged < BLAST_BATCH_SIZE) || flushBlaster(blaster);
+}
+
+/**
+ * Write all staged updates.
+ *
+ * @param blaster The blaster.
+ *
+ * @return false if the data could not be written.
+ */
+bool flushBlaster(BGPBlaster* blaster)
+{
+  BGPSession* session = blaster->session;
+  bool        retVal  = true;
+  int         noDelay = 1;
+
+  if (blaster->iovCount == 0)
+  {
+    return true;
+  }
+
+  // The batches are large, don't let the last one wait for more data.
+  if (session->sessionFD != blaster->noDelayFD)
+  {
+    setsockopt(session->sessionFD, IPPROTO_TCP, TCP_NODELAY, &noDelay,
+               sizeof(noDelay));
+    blaster->noDelayFD = session->sessionFD;
+  }
+
+  if (blaster->stats.firstSent == 0)
+  {
+    blaster->stats.firstSent = getSessionClock();
+  }
+  retVal = sendUpdateBatch(session, blaster->iov, blaster->iovCount);
+  if (retVal)
+  {
+    blaster->stats.lastSent  = getSessionClock();
+    blaster->stats.messages += blaster->stagedMsg;
+    blaster->stats.bytes    += blaster->staged;
+    blaster->stats.writes++;
+  }
+
+  blaster->iovCount   = 0;
+  blaster->buffUsed   = 0;
+  blaster->staged     = 0;
+  blaster->stagedMsg  = 0;
+  blaster->packOffset = -1;
+
+  return retVal;
+}
+
+/**
+ * Wait until the monitor session received all prefixes send, or until the
+ * monitor timeout is reached. Does nothing if no monitor is used.
+ *
+ * @param blaster The blaster.
+ *
+ * @return true if all prefixes were received.
+ */
+bool waitForConvergence(BGPBlaster* blaster)
+{
+  u_int64_t start    = getSessionClock();
+  u_int64_t timeout  = blaster->config.monitorTimeout * BLAST_NSEC;
+  u_int32_t expected = blaster->baseline + blaster->stats.prefixes;
+  u_int32_t count    = 0;
+
+  if (blaster->monitor == NULL)
+  {
+    return false;
+  }
+
+  count = _monitorPrefixes(blaster);
+  while (count < expected && (getSessionClock() - start) < timeout)
+  {
+    _blastSleep(BLAST_POLL_INTERVAL);
+    count = _monitorPrefixes(blaster);
+  }
+
+  blaster->stats.received     = count - blaster->baseline;
+  blaster->stats.lastReceived = __atomic_load_n(&blaster->monitor->lastPrefixRcv,
+                                                __ATOMIC_ACQUIRE);
+  blaster->stats.converged    = count >= expected;
+
+  return blaster->stats.converged;
+}
+
+/**
+ * Print the statistics of the blaster.
+ *
+ * @param blaster The blaster.
+ */
+void printBlastStatistics(BGPBlaster* blaster)
+{
+  BGP_BlastStats* stats    = &blaster->stats;
+  double          sendTime = 0;
+  double          convTime = 0;
+
+  if (stats->lastSent > stats->firstSent)
+  {
+    sendTime = (double)(stats->lastSent - stats->firstSent) / BLAST_NSEC;
+  }
+
+  printf ("Blaster statistics:\n");
+  printf ("  updates:     %u (%u prefixes, %u packed)\n", stats->updates,
+          stats->prefixes, stats->packed);
+  printf ("  messages:    %u in %u writes (%llu bytes)\n", stats->messages,
+          stats->writes, (unsigned long long)stats->bytes);
+  printf ("  send time:   %.6f s", sendTime);
+  if (sendTime > 0)
+  {
+    printf (" (%.0f updates/s)", stats->updates / sendTime);
+  }
+  printf ("\n");
+  if (blaster->monitor != NULL)
+  {
+    if (stats->received > 0 && stats->lastReceived > stats->firstSent)
+    {
+      convTime = (double)(stats->lastReceived - stats->firstSent) / BLAST_NSEC;
+    }
+    printf ("  convergence: %.6f s (%u of %u prefixes received%s)\n", convTime,
+            stats->received, stats->prefixes,
+            stats->converged ? "" : " - timeout");
+  }
+}
@@ -0,0 +1,214 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * The blaster sends the updates of a BGP session as fast as possible or at a
+ * given rate. Plain BGP-4 updates with identical path attributes are packed
+ * into one update, the updates are staged and written with one writev call
+ * per batch. BGPsec updates are never packed, RFC 8205 allows only one prefix
+ * per BGPsec update.
+ *
+ * The convergence is measured with a second (monitor) session to the same
+ * peer. The peer does not send the updates back to the session it learned
+ * them from, the monitor session uses its own ASN and local address and counts
+ * the prefixes it receives.
+ *
+ * @version 0.2.0.6
+ */
+#ifndef BGPBLASTER_H
+#define	BGPBLASTER_H
+
+#include <stdbool.h>
+#include <pthread.h>
+#include <netinet/in.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include "bgp/BGPHeader.h"
+#include "bgp/BGPSession.h"
+
+/** The number of bytes staged before they are written. */
+#define BLAST_BATCH_SIZE    262144
+/** The maximum number of io vectors per batch. */
+#define BLAST_MAX_IOV       1024
+/** Default time in seconds to wait for the monitor session. */
+#define BLAST_DEF_MON_TIMEOUT 60
+
+/** The blaster configuration. */
+typedef struct
+{
+  /** Updates per second, 0 for unlimited. */
+  u_int32_t rate;
+  /** The ASN of the monitor session, 0 if no monitor session is used. */
+  u_int32_t monitorAS;
+  /** The BGP identifier of the monitor session (host format). */
+  u_int32_t monitorIdent;
+  /** The local address the monitor session is bound to. */
+  struct sockaddr_in monitorAddr;
+  /** Maximum time in seconds to wait for the monitor session. */
+  u_int32_t monitorTimeout;
+} BGP_BlastConf;
+
+/** The statistics of the blaster. */
+typedef struct
+{
+  /** Number of updates handed to the blaster. */
+  u_int32_t updates;
+  /** Number of prefixes announced in these updates. */
+  u_int32_t prefixes;
+  /** Number of updates packed into a previous update. */
+  u_int32_t packed;
+  /** Number of update messages written. */
+  u_int32_t messages;
+  /** Number of bytes written. */
+  u_int64_t bytes;
+  /** Number of batches written. */
+  u_int32_t writes;
+  /** Time (getSessionClock) the first batch was written. */
+  u_int64_t firstSent;
+  /** Time (getSessionClock) the last batch was written. */
+  u_int64_t lastSent;
+  /** Prefixes received by the monitor session. */
+  u_int32_t received;
+  /** Time (getSessionClock) the monitor received the last prefix. */
+  u_int64_t lastReceived;
+  /** Indicates if all prefixes were received by the monitor session. */
+  bool      converged;
+} BGP_BlastStats;
+
+/** The blaster of one BGP session. */
+typedef struct
+{
+  /** The session the updates are send to. */
+  BGPSession*    session;
+  /** The configuration. */
+  BGP_BlastConf  config;
+
+  /** The staging buffer. */
+  u_int8_t*      buff;
+  /** The size of the staging buffer. */
+  u_int32_t      buffSize;
+  /** The bytes used in the staging buffer. */
+  u_int32_t      buffUsed;
+  /** The staged data, pointing into the buffer or to stable memory. */
+  struct iovec   iov[BLAST_MAX_IOV];
+  /** The number of staged io vectors. */
+  int            iovCount;
+  /** The number of staged bytes. */
+  u_int32_t      staged;
+  /** The number of staged messages. */
+  u_int32_t      stagedMsg;
+  /** Offset of the last staged update in the buffer if it can take more
+   * prefixes, -1 otherwise. */
+  int            packOffset;
+  /** Size of the path attributes of the update at packOffset. */
+  u_int16_t      packAttrLen;
+
+  /** The available tokens. */
+  double         tokens;
+  /** The maximum number of tokens. */
+  double         burst;
+  /** Time (getSessionClock) the tokens were refilled. */
+  u_int64_t      lastRefill;
+  /** The socket TCP_NODELAY was set for. */
+  int            noDelayFD;
+
+  /** The monitor session, NULL if not used. */
+  BGPSession*    monitor;
+  /** The thread running the monitor session. */
+  pthread_t      monitorThread;
+  /** The prefixes received by the monitor before blasting started. */
+  u_int32_t      baseline;
+
+  /** The statistics. */
+  BGP_BlastStats stats;
+} BGPBlaster;
+
+/**
+ * Create the blaster for the given session. If a monitor ASN is configured the
+ * monitor session is started as well.
+ *
+ * @param session The established or establishing session.
+ * @param config The blaster configuration.
+ *
+ * @return The blaster, must be freed with freeBlaster.
+ */
+BGPBlaster* createBlaster(BGPSession* session, BGP_BlastConf* config);
+
+/**
+ * Stop the monitor session and free all memory of the blaster. Staged data is
+ * not written.
+ *
+ * @param blaster The blaster.
+ */
+void freeBlaster(BGPBlaster* blaster);
+
+/**
+ * Wait until the monitor session is established and record the prefixes it
+ * received so far.
+ *
+ * @param blaster The blaster.
+ *
+ * @return true if the monitor is established or no monitor is used.
+ */
+bool waitForMonitor(BGPBlaster* blaster);
+
+/**
+ * Stage the given update for sending. The update is packed into the previous
+ * update if possible. The staged updates are written once a batch is full or
+ * the rate limit requires to wait.
+ *
+ * @param blaster The blaster.
+ * @param update The update to be send.
+ * @param stable true if the update memory does not change until the update is
+ *               written, it will be referenced instead of copied.
+ *
+ * @return false if the update could not be send.
+ */
+bool blastUpdate(BGPBlaster* blaster, BGP_UpdateMessage_1* update,
+                 bool stable);
+
+/**
+ * Write all staged updates.
+ *
+ * @param blaster The blaster.
+ *
+ * @return false if the data could not be written.
+ */
+bool flushBlaster(BGPBlaster* blaster);
+
+/**
+ * Wait until the monitor session received all prefixes send, or until the
+ * monitor timeout is reached. Does nothing if no monitor is used.
+ *
+ * @param blaster The blaster.
+ *
+ * @return true if all prefixes were received.
+ */
+bool waitForConvergence(BGPBlaster* blaster);
+
+/**
+ * Print the statistics of the blaster.
+ *
+ * @param blaster The blaster.
+ */
+void printBlastStatistics(BGPBlaster* blaster);
+
+#endif	/* BGPBLASTER_H */
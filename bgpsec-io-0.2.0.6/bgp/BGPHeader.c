@@ -814,3 +814,89 @@ int getPathAttributeSize(BGP_PathAttribute* attribute)
   
   return size;  
 }
+
+/**
+ * Count the prefixes within the given NLRI field.
+ * 
+ * @param ptr The start of the NLRI field.
+ * @param end The end of the NLRI field.
+ * 
+ * @return The number of complete prefixes.
+ */
+static u_int32_t _countNLRI(u_int8_t* ptr, u_int8_t* end)
+{
+  u_int32_t count = 0;
+  
+  while (ptr < end)
+  {
+    // The length in bits followed by the prefix bytes.
+    ptr += 1 + ((*ptr + 7) / 8);
+    if (ptr <= end)
+    {
+      count++;
+    }
+  }
+  
+  return count;
+}
+
+/**
+ * Count the prefixes announced in the given update. This includes the NLRI 
+ * at the end of the update and the NLRI within the MP_REACH_NLRI attribute.
+ * 
+ * @param update The update message (wire format)
+ * 
+ * @return The number of prefixes announced.
+ */
+u_int32_t countUpdatePrefixes(BGP_UpdateMessage_1* update)
+{
+  u_int8_t*  ptr     = (u_int8_t*)update;
+  u_int8_t*  end     = ptr + ntohs(update->messageHeader.length);
+  u_int8_t*  nlri    = NULL;
+  u_int8_t*  value   = NULL;
+  u_int16_t  length  = 0;
+  int        hdrSize = 0;
+  u_int32_t  count   = 0;
+  BGP_PathAttribute* attr = NULL;
+  
+  ptr += sizeof(BGP_UpdateMessage_1) + ntohs(update->withdrawn_routes_length);
+  if (ptr + sizeof(BGP_UpdateMessage_2) > end)
+  {
+    return 0;
+  }
+  nlri = ptr + sizeof(BGP_UpdateMessage_2) 
+         + ntohs(((BGP_UpdateMessage_2*)ptr)->path_attr_length);
+  if (nlri > end)
+  {
+    return 0;
+  }
+  count = _countNLRI(nlri, end);
+  
+  // Now look for the MP_REACH_NLRI attribute
+  ptr += sizeof(BGP_UpdateMessage_2);
+  while (ptr + sizeof(BGP_PathAttribute) < nlri)
+  {
+    attr    = (BGP_PathAttribute*)ptr;
+    hdrSize = sizeof(BGP_PathAttribute) 
+              + ((attr->attr_flags & BGP_UPD_A_FLAGS_EXT_LENGTH) ? 2 : 1);
+    if (ptr + hdrSize > nlri)
+    {
+      break;
+    }
+    length = getPathAttributeSize(attr) - hdrSize;
+    value  = ptr + hdrSize;
+    ptr    = value + length;
+    if (ptr > nlri)
+    {
+      break;
+    }
+    // afi (2), safi (1), next hop length (1), next hop, reserved (1), NLRI
+    if (   attr->attr_type_code == BGP_UPD_A_TYPE_MP_REACH_NLRI 
+        && length >= 5 && length >= 5 + value[3])
+    {
+      count += _countNLRI(value + 5 + value[3], ptr);
+    }
+  }
+  
+  return count;
+}
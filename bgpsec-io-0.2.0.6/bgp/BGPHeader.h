@@ -580,6 +580,9 @@ typedef struct {
   // @TODO: Add V6 support
   /** The peer server address ipv4 and port */
   struct sockaddr_in peer_addr; 
+  /** The local address the session is bound to. Not bound if the address is
+   * 0 */
+  struct sockaddr_in local_addr;
   /** The ASN of the peer. This must be set to assure we send the correct 
    * signed updates. (host format)*/
   u_int32_t peerAS;
@@ -784,5 +787,15 @@ int cpyBGPSecAddrMem(u_int16_t afi, u_int8_t* buff, BGPSEC_PrefixHdr* prefix);
  */
 int getPathAttributeSize(BGP_PathAttribute* attribute);
 
+/**
+ * Count the prefixes announced in the given update. This includes the NLRI 
+ * at the end of the update and the NLRI within the MP_REACH_NLRI attribute.
+ * 
+ * @param update The update message (wire format)
+ * 
+ * @return The number of prefixes announced.
+ */
+u_int32_t countUpdatePrefixes(BGP_UpdateMessage_1* update);
+
 #endif	/* BGPHEADER_H */
 
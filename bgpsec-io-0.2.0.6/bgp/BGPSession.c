@@ -99,6 +99,8 @@
 #include <openssl/err.h>
 #include <pthread.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <limits.h>
 #include <poll.h>
 #include "bgp/BGPSession.h"
 #include "bgp/BGPHeader.h"
@@ -107,6 +109,11 @@
 
 #define POLL_TIMEOUT_MS 100
 
+// IOV_MAX is not visible without _XOPEN_SOURCE, 1024 is the Linux limit.
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
 static void _processPacket(void* session);
 
 /**
@@ -162,6 +169,9 @@ BGPSession* createBGPSession(int buffSize, BGP_SessionConf* config,
     sessConfig->peerAS   = config->peerAS;
     memcpy(&session->bgpConf.peer_addr, &config->peer_addr, 
            sizeof(struct sockaddr_in));
+    memcpy(&session->bgpConf.local_addr, &config->local_addr, 
+           sizeof(struct sockaddr_in));
+    pthread_mutex_init(&session->sendLock, NULL);
     
     session->processPkt   = process  != NULL ? process  : _processPacket;
     
@@ -264,6 +274,7 @@ void freeBGPSession (BGPSession* session)
       free(sessParam);
       sessParam = next;
     }
+    pthread_mutex_destroy(&session->sendLock);
     free(session);
   }
 }
@@ -333,6 +344,21 @@ static bool _isSocketAlive(BGPSession* session, int timeout, bool readOnly)
   return retVal;
 }
 
+/**
+ * Wait until data can be read from the socket.
+ * 
+ * @param session The BGPSession information.
+ * @param timeout The maximum time to wait in milli seconds.
+ */
+static void _waitForData(BGPSession* session, int timeout)
+{
+  struct pollfd pfd;
+  pfd.fd      = session->sessionFD;
+  pfd.events  = POLLIN;
+  pfd.revents = 0;
+  poll(&pfd, 1, timeout);
+}
+
 /**
  * This is the sessions receiver thread. It will be created within runBGP.
  * 
@@ -401,7 +427,8 @@ static void* _rcvBGP(void* bgpSession)
       {
         printf("Wait for receive!\n");
       }
-      sleep(SESS_DEV_RCV_SLEEP);
+      // Wake up as soon as data arrives.
+      _waitForData(session, SESS_DEV_RCV_SLEEP * 1000);
     }
   }
   
@@ -548,6 +575,17 @@ bool establishTCPSession(BGPSession* session)
     fsmCanSwitchTo(&session->fsm, FSM_STATE_IDLE);
     return false;
   }
+  if (session->bgpConf.local_addr.sin_addr.s_addr != 0)
+  {
+    if (bind(session->sessionFD, 
+             (struct sockaddr *)&(session->bgpConf.local_addr),
+             sizeof(session->bgpConf.local_addr)) < 0)
+    {
+      printf("ERROR[%i]: Could not bind to the local address!\n", errno);
+      shutDownTCPSession(session, false);
+      return false;
+    }
+  }
   int conVal = connect(session->sessionFD, 
                        (struct sockaddr *)&(session->bgpConf.peer_addr), 
                        sizeof(session->bgpConf.peer_addr));
@@ -651,7 +689,7 @@ int readNextBGPMessage(BGPSession* session, int timeout)
       if (bytesAvailable == 0 && timeout != 0)
       {
         timeout--;
-        sleep(SESS_DEV_RCV_SLEEP);
+        _waitForData(session, SESS_DEV_RCV_SLEEP * 1000);
       }
     }
     if (bytesAvailable > 0 && _canReceiveBGPMessage(session->fsm))
@@ -1084,6 +1122,7 @@ static void _processPacket(void* self)
   BGPSession* session = (BGPSession*)self;
   BGP_MessageHeader* hdr = (BGP_MessageHeader*)session->recvBuff;
   u_int16_t length = ntohs(hdr->length);
+  u_int32_t count  = 0;
   if (length < sizeof(BGP_MessageHeader)) // 19
   {
     printf("ERROR: Received message with invalid message header!\n");
@@ -1147,6 +1186,13 @@ static void _processPacket(void* self)
         break;
       case BGP_T_UPDATE:
         session->lastReceived = time(0);
+        count = countUpdatePrefixes((BGP_UpdateMessage_1*)hdr);
+        if (count > 0)
+        {
+          __atomic_add_fetch(&session->rcvPrefixes, count, __ATOMIC_RELAXED);
+          __atomic_store_n(&session->lastPrefixRcv, getSessionClock(), 
+                           __ATOMIC_RELEASE);
+        }
         if (session->bgpConf.printOnReceive[PRNT_MSG_UPDATE])
         {
           printBGP_Message((BGP_MessageHeader*)hdr, 
@@ -1174,8 +1220,10 @@ static void _processPacket(void* self)
  */
 static int _writeData(BGPSession* session, u_int8_t* data, int size)
 {
+  pthread_mutex_lock(&session->sendLock);
   int written = write(session->sessionFD, data, size);
   session->lastSent = time(0);
+  pthread_mutex_unlock(&session->sendLock);
   return written;
 }
 
@@ -1435,3 +1483,115 @@ bool sendUpdate(BGPSession* session, BGP_UpdateMessage_1* update)
   return retVal;
 }
 
+
+/**
+ * Send the given BGP updates with as few system calls as possible. The updates
+ * MUST NOT exceed getMaxUpdateSize. This function will modify the 
+ * session.lastSent and session.lastUpdateSend values.
+ * 
+ * @param session The session where to send the updates to.
+ * @param iov The updates to be send, will be modified.
+ * @param iovCount The number of elements in iov.
+ * 
+ * @return true if all updates could be send.
+ */
+bool sendUpdateBatch(BGPSession* session, struct iovec* iov, int iovCount)
+{
+  bool      retVal  = true;
+  ssize_t   written = 0;
+  int       count   = 0;
+  u_int8_t* ptr     = NULL;
+  u_int8_t* end     = NULL;
+  
+  if (session->fsm.state != FSM_STATE_ESTABLISHED)
+  {
+    printf ("NOTICE: Cannot send Update, FSM is not in ESTABLISHED state!\n");
+    return false;
+  }
+  
+  if (session->bgpConf.printOnSend[PRNT_MSG_UPDATE])
+  {
+    for (count = 0; count < iovCount; count++)
+    {
+      ptr = (u_int8_t*)iov[count].iov_base;
+      end = ptr + iov[count].iov_len;
+      while (ptr < end)
+      {
+        printBGP_Message((BGP_MessageHeader*)ptr, "Send Update Message", 
+                         false);
+        ptr += ntohs(((BGP_MessageHeader*)ptr)->length);
+      }
+    }
+  }
+  
+  pthread_mutex_lock(&session->sendLock);
+  while (retVal && iovCount > 0)
+  {
+    count   = iovCount > IOV_MAX ? IOV_MAX : iovCount;
+    written = writev(session->sessionFD, iov, count);
+    if (written < 0)
+    {
+      retVal = errno == EINTR;
+      continue;
+    }
+    // Skip all completely written elements and adjust a partial written one.
+    while (iovCount > 0 && written >= (ssize_t)iov->iov_len)
+    {
+      written -= iov->iov_len;
+      iov++;
+      iovCount--;
+    }
+    if (iovCount > 0)
+    {
+      iov->iov_base  = (u_int8_t*)iov->iov_base + written;
+      iov->iov_len  -= written;
+    }
+  }
+  session->lastSent = time(0);
+  pthread_mutex_unlock(&session->sendLock);
+  
+  if (retVal)
+  {
+    session->lastSentUpdate = session->lastSent;
+  }
+  else
+  {
+    printf ("ERROR[%i]: Cannot send Updates, socket is broken - move to "
+            "IDLE!\n", errno);
+    if (fsmCanSwitchTo(&session->fsm, FSM_STATE_IDLE))
+    {
+      fsmSwitchState(&session->fsm, FSM_STATE_IDLE);
+    }
+  }
+  
+  return retVal;
+}
+
+/**
+ * Return the maximum size of update messages that can be send within this 
+ * session.
+ * 
+ * @param session The session.
+ * 
+ * @return BGP_MAX_MESSAGE_SIZE or the extended message size if negotiated.
+ */
+u_int32_t getMaxUpdateSize(BGPSession* session)
+{
+  bool extended = (    session->bgpConf.peerCap.extMsgSupp 
+                    && session->bgpConf.capConf.extMsgSupp)
+                  || session->bgpConf.capConf.extMsgForce;
+  // The length field of the message header is 2 bytes.
+  return extended ? BGP_EXTMAX_MESSAGE_SIZE - 1 : BGP_MAX_MESSAGE_SIZE;
+}
+
+/**
+ * Return the monotonic clock used for the session statistics.
+ * 
+ * @return The time in nano seconds.
+ */
+u_int64_t getSessionClock()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return ((u_int64_t)now.tv_sec * 1000000000ULL) + (u_int64_t)now.tv_nsec;
+}
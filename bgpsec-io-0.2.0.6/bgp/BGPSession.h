@@ -45,7 +45,9 @@
 #include <stdbool.h>
 #include <time.h>
 #include <semaphore.h>
+#include <pthread.h>
 #include <netinet/in.h>
+#include <sys/uio.h>
 
 #include "bgp/BGPHeader.h"
 #include "bgp/BGPFinalStateMachine.h"
@@ -111,6 +113,13 @@ typedef struct
   /** The semaphor for the hold timer. This allows to be woken up prior the time
    * expiration. No need for sleep anymore. */
   sem_t* sessHoldTimerSem;
+  
+  /** Serializes the messages written by the different threads. */
+  pthread_mutex_t sendLock;
+  /** The number of prefixes received from the peer. */
+  u_int32_t rcvPrefixes;
+  /** The time (getSessionClock) the last prefix was received. */
+  u_int64_t lastPrefixRcv;
 } BGPSession;
 
 /**
@@ -202,6 +211,36 @@ bool sendNotification(BGPSession* session, int error_code, int subcode,
  */
 bool sendUpdate(BGPSession* session, BGP_UpdateMessage_1* update);
 
+/**
+ * Send the given BGP updates with as few system calls as possible. The updates
+ * MUST NOT exceed getMaxUpdateSize. This function will modify the 
+ * session.lastSent and session.lastUpdateSend values.
+ * 
+ * @param session The session where to send the updates to.
+ * @param iov The updates to be send, will be modified.
+ * @param iovCount The number of elements in iov.
+ * 
+ * @return true if all updates could be send.
+ */
+bool sendUpdateBatch(BGPSession* session, struct iovec* iov, int iovCount);
+
+/**
+ * Return the maximum size of update messages that can be send within this 
+ * session.
+ * 
+ * @param session The session.
+ * 
+ * @return BGP_MAX_MESSAGE_SIZE or the extended message size if negotiated.
+ */
+u_int32_t getMaxUpdateSize(BGPSession* session);
+
+/**
+ * Return the monotonic clock used for the session statistics.
+ * 
+ * @return The time in nano seconds.
+ */
+u_int64_t getSessionClock();
+
 
 /**
  * Establish a TCP Session to the peer with the given peer IP. 
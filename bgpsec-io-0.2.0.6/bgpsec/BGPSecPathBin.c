@@ -70,6 +70,7 @@
  */
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <math.h>
 #include <netinet/in.h>
@@ -102,13 +103,15 @@ static u_int16_t TMP_SIGBLOCK_SIZE = 0;
 #define INIT_SIZE  64000
 //#define INIT_SIZE  3000
 #define EXTRA_BUFF 1000
+/** The initial number of AS numbers a tokenized path can hold. */
+#define INIT_PATH_SIZE 16
 
 static int _fillSignatureBlock(SRxCryptoAPI* capi, 
                                u_int8_t* data, AlgoParam* algo, int ctSegments, 
                                u_int32_t nextAS, BGPSEC_PrefixHdr* prefix,
                                tPSegList* spSeg, TASList* asList);
 
-static int _fillSecurePath(u_int8_t* data, char* asPath, int ctSegments);
+static int _fillSecurePath(u_int8_t* data, tASNPath* path, int ctSegments);
 
 /**
  * initialize the data stream and create it if not done already.
@@ -327,6 +330,77 @@ static tPSegList* _createPSegList(BGPSEC_SecurePathSegment* segment,
   return segList;
 }
 
+/**
+ * Add the given ASN to the end of the path and enlarge the path if needed.
+ * 
+ * @param path The path.
+ * @param asn The ASN in host format.
+ */
+static void _addASN(tASNPath* path, u_int32_t asn)
+{
+  if (path->noASN == path->size)
+  {
+    path->size = path->size == 0 ? INIT_PATH_SIZE : path->size * 2;
+    path->asn  = realloc(path->asn, path->size * sizeof(u_int32_t));
+  }
+  path->asn[path->noASN++] = asn;
+}
+
+/**
+ * Tokenize the given AS path for signing. Unless the peer is iBGP, the own AS
+ * is added in front of the path. This function is thread safe.
+ * 
+ * @param asPath (optional) a comma or blank separated string containing the AS 
+ *               path (origin is the right most AS), Can be empty or NULL.
+ * @param bgp_conf The configuration of the bgp session.
+ * @param path The path to be filled, must be initialized with 0 or be a path
+ *             used previously. Release the memory using freeASNPath.
+ * 
+ * @return false if no BGPSec path attribute is generated for this path - an
+ *         origination to an iBGP peer.
+ */
+bool tokenizeASNPath(char* asPath, BGP_SessionConf* bgp_conf, tASNPath* path)
+{
+  char*         longPath = convertAsnPath(asPath);
+  bool          iBGP     = bgp_conf->asn == bgp_conf->peerAS;
+  u_int32_t     asn      = 0;
+  tASNTokenizer tokenizer;
+
+  path->noASN = 0;
+  if (!iBGP)
+  {
+    // Add myself to the path if the peer is not iBGP (same as as myself)
+    _addASN(path, bgp_conf->asn);
+  }
+  // In case of iBGP the path is handed over as it was received.
+  asntok_th(longPath, &tokenizer);
+  while (asntok_next_th(&asn, &tokenizer))
+  {
+    _addASN(path, asn);
+  }
+  asntok_clear_th(&tokenizer);
+  free(longPath);
+  longPath = NULL;
+
+  // An empty path only happens for origin announcements to an iBGP peer, 
+  // don't generate path segments for them.
+  return path->noASN != 0;
+}
+
+/**
+ * Release the memory allocated within the given path.
+ * 
+ * @param path The path.
+ */
+void freeASNPath(tASNPath* path)
+{
+  if (path->asn != NULL)
+  {
+    free(path->asn);
+  }
+  memset(path, 0, sizeof(tASNPath));
+}
+
 /**
  * Generate the BGPSec Path attribute byte stream. All values inside the stream 
  * are written in network format, all parameters are given in host format.
@@ -357,6 +431,49 @@ BGP_PathAttribute* generateBGPSecAttr(SRxCryptoAPI* capi,
                                       BGP_SessionConf* bgp_conf,
                                       BGPSEC_PrefixHdr* prefix, TASList* asList,
                                       bool onlyExtendedLength)
+{
+  BGP_PathAttribute* attr = NULL;
+  tASNPath           path;
+
+  memset(&path, 0, sizeof(tASNPath));
+  if (tokenizeASNPath(asPath, bgp_conf, &path))
+  {
+    attr = generateBGPSecAttrFromPath(capi, useGlobal, &path, segmentCt, 
+                                      bgp_conf, prefix, asList, 
+                                      onlyExtendedLength);
+  }
+  freeASNPath(&path);
+
+  return attr;
+}
+
+/**
+ * Generate the BGPSec Path attribute byte stream for an already tokenized 
+ * path. See generateBGPSecAttr. With useGlobal set to false this function is
+ * thread safe as long as each thread uses its own bgp_conf and asList.
+ * 
+ * @param capi   The CryptoAPI to be used for signing. If NULL, the signing is 
+ *               performed using the internal signing implementation.
+ * @param useGlobal use internal data stream (not thread safe but faster)
+ * @param path   The path generated by tokenizeASNPath.
+ * @param segmentCt OUT variable that returns the number of path / signature 
+ *               segments this BGPSec path attribute contains.
+ * @param bgp_conf The configuration of the bgp session.
+ * @param prefix The prefix to be used. Depending on the AFI value it will be 
+ *               typecast to either BGPSEC_V4Prefix or BGPSEC_V6Prefix
+ * @param asList The AS list
+ * @param onlyExtendedLength Indicates if the attributes flag must be set to 
+ *               extended length regardless of parameter length.
+ * 
+ * @return Return the BGPSEC path attribute or NULL if the path generation 
+ *         failed.
+ */
+BGP_PathAttribute* generateBGPSecAttrFromPath(SRxCryptoAPI* capi,
+                                      bool useGlobal, tASNPath* path,
+                                      u_int32_t* segmentCt, 
+                                      BGP_SessionConf* bgp_conf,
+                                      BGPSEC_PrefixHdr* prefix, TASList* asList,
+                                      bool onlyExtendedLength)
 {
   // Contains the attributes data
   u_int8_t* data = NULL;
@@ -364,58 +481,22 @@ BGP_PathAttribute* generateBGPSecAttr(SRxCryptoAPI* capi,
   u_int8_t* tmp_data = NULL;
   u_int8_t* ptr = NULL;
   int ctSegments = 0;
+  u_int32_t idx;
   
-  char* longPath = convertAsnPath(asPath);;
-  bool iBGP = bgp_conf->asn == bgp_conf->peerAS;     
-  char* myPath = NULL;
-  
-  if (iBGP)
-  {
-    if (strlen(longPath) == 0)
-    {
-      // This is an origin announcement to an iBGP peer, Don't generate path 
-      // segments
-      free(longPath);
-      longPath = NULL;
-      return NULL;
-    }
-    else
-    {
-      // This is an origin transit, don't add the own as to the path, hand it 
-      // over as it was received.
-      myPath = strdup(longPath);
-    }
-  }
-  else
-  {
-    // Add myself to the path if the peer is not iBGP (same as as myself)
-    int digits   = (int)(log10(bgp_conf->asn)) + 1; // 1 for round up
-    int strLen   = strlen(longPath) + digits + 2;   // blank and \0
-    myPath = malloc(strLen);
-    snprintf (myPath, strLen, "%u %s", bgp_conf->asn, longPath);
-  }
-  // Clean up helper structure.
-  free(longPath);
-  longPath = NULL;
-  
-  u_int32_t asn, prevASN = 0;  
   // Check the number of distinct consecutive ASes
-  asntok(myPath);
-  while (asntok_next(&asn))
+  for (idx = 0; idx < path->noASN; idx++)
   {
-    if (asn != prevASN)
+    if ((idx == 0) || (path->asn[idx] != path->asn[idx-1]))
     {
       ctSegments++;
     }
-    prevASN = asn;
   }
-  asntok_reset();
   
   int sizeSegments    = sizeof(BGPSEC_SecurePathSegment) * ctSegments;
   // This is the attribute Size only including the signature segments but not
   // the signature blocks. They need to be added as they are processed.
   u_int16_t attrLength = sizeof(BGPSEC_SecurePath)  + sizeSegments;
-  u_int16_t tmp_size = 0;
+  int tmp_size = 0;
 
   // Prepare the attribute memory
   if (useGlobal) 
@@ -427,11 +508,13 @@ BGP_PathAttribute* generateBGPSecAttr(SRxCryptoAPI* capi,
   }
   else
   {
-    data = malloc(attrLength+EXTRA_BUFF);
-    memset(data, 0, attrLength+EXTRA_BUFF);
-    tmp_data = malloc(TMP_SIGBLOCK_SIZE+EXTRA_BUFF);
-    memset(tmp_data, 0, TMP_SIGBLOCK_SIZE+EXTRA_BUFF);    
-    tmp_size = attrLength+EXTRA_BUFF;           
+    // The temporary buffer receives a complete signature block.
+    tmp_size = attrLength + EXTRA_BUFF 
+               + ctSegments * (sizeof(BGPSEC_SignatureSegment) + UINT8_MAX);
+    data = malloc(tmp_size);
+    memset(data, 0, tmp_size);
+    tmp_data = malloc(tmp_size);
+    memset(tmp_data, 0, tmp_size);    
   }
   // Check that the memory is large enough
   if (attrLength > tmp_size)
@@ -465,7 +548,7 @@ BGP_PathAttribute* generateBGPSecAttr(SRxCryptoAPI* capi,
   BGPSEC_SecurePathSegment* pathSegments = (BGPSEC_SecurePathSegment*)
                                               (ptr + sizeof(BGPSEC_SecurePath)); 
   
-  ptr += _fillSecurePath(ptr, myPath, ctSegments);
+  ptr += _fillSecurePath(ptr, path, ctSegments);
   tPSegList* segList = _createPSegList(pathSegments, ctSegments);
   
   // Now process the signature blocks, one by one (max 2))
@@ -501,7 +584,7 @@ BGP_PathAttribute* generateBGPSecAttr(SRxCryptoAPI* capi,
         size_t offset = ptr - data;
         int newSize = attrLength + EXTRA_BUFF;
         data     = _my_realloc(data, tmp_size, newSize);
-        tmp_data = _my_realloc(data, tmp_size, newSize);
+        tmp_data = _my_realloc(tmp_data, tmp_size, newSize);
         tmp_size = newSize;
         ptr = data + offset; // reset the ptr - changes only ptr if data could not
                              // be extended and new memory had to be allocated. 
@@ -550,14 +633,18 @@ BGP_PathAttribute* generateBGPSecAttr(SRxCryptoAPI* capi,
   
   if (totalSigBlockLength == 0)
   {
-    printf ("ERROR: No Signatures where generated for AS path: \"%d %s\"\n",
-            bgp_conf->peerAS, myPath);
+    printf ("ERROR: No Signatures where generated for AS path: \"%d", 
+            bgp_conf->peerAS);
+    for (idx = 0; idx < path->noASN; idx++)
+    {
+      printf (" %u", path->asn[idx]);
+    }
+    printf ("\"\n");
     
     if (!useGlobal)
     {
       // Free allocated data memory if managed here
       free (data);
-      free (tmp_data);
     }
     else
     {
@@ -569,9 +656,6 @@ BGP_PathAttribute* generateBGPSecAttr(SRxCryptoAPI* capi,
   }
   
   _freePSegList(segList);
-  asntok_clear();
-  free(myPath);
-  myPath = NULL;
   
   if (segmentCt != NULL)
   {
@@ -584,14 +668,15 @@ BGP_PathAttribute* generateBGPSecAttr(SRxCryptoAPI* capi,
  * Get the Secure_Path Block. The given data buffer must be of efficient size.
  * 
  * @param data the data block where the 
- * @param asPath The AS path as string, items separated by blank.
+ * @param path The tokenized AS path.
  * @param ctSegments Count of segments in the path.
  * 
  * @return The length of the secure path in byte.
  */
-static int _fillSecurePath(u_int8_t* data, char* asPath, int ctSegments)
+static int _fillSecurePath(u_int8_t* data, tASNPath* path, int ctSegments)
 {
   u_int32_t asn = 0;  
+  u_int32_t idx = 0;
   BGPSEC_SecurePath* secPath = (BGPSEC_SecurePath*)data;
   u_int16_t sec_pLength = sizeof (BGPSEC_SecurePath) + 
                           (ctSegments * sizeof(BGPSEC_SecurePathSegment));
@@ -602,20 +687,18 @@ static int _fillSecurePath(u_int8_t* data, char* asPath, int ctSegments)
   // the template pointer used for the securePath segment
   BGPSEC_SecurePathSegment* spSeg;
   int segment;  
-  asntok_next(&asn);
-  bool go = true;
-  for (segment = 0; go & (segment < ctSegments); segment++)
+  for (segment = 0; (idx < path->noASN) && (segment < ctSegments); segment++)
   {
     spSeg = (BGPSEC_SecurePathSegment*)data; 
-    spSeg->asn    = asn; // First store it as host format, then convert later 
+    asn           = path->asn[idx];
     spSeg->pCount = 0;
     spSeg->flags  = 0;
-    while (go && (spSeg->asn == asn))
+    while ((idx < path->noASN) && (path->asn[idx] == asn))
     {
       spSeg->pCount++;
-      go = asntok_next(&asn);
+      idx++;
     }
-    spSeg->asn = htonl(spSeg->asn);  // Now convert to network format.
+    spSeg->asn = htonl(asn);  // Stored in network format.
     
     // Now move pointer to next Path segment or beginning of Signature Block if 
     // no further path segment exists.
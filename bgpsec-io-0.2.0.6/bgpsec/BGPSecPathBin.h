@@ -125,6 +125,19 @@ typedef struct {
   BGPSEC_SecurePathSegment* pathSegments;
 } tAS_Path;
 
+/**
+ * The tokenized AS path used for signing. The AS numbers are in host format
+ * and ordered from the sending AS towards the origin AS.
+ */
+typedef struct {
+  /** The AS numbers. */
+  u_int32_t* asn;
+  /** The number of AS numbers stored. */
+  u_int32_t  noASN;
+  /** The number of AS numbers that fit into the allocated memory. */
+  u_int32_t  size;
+} tASNPath;
+
 typedef struct _tPSegList {
   struct _tPSegList* to;
   struct _tPSegList* from;
@@ -186,6 +199,56 @@ BGP_PathAttribute* generateBGPSecAttr(SRxCryptoAPI* capi,
                                       BGPSEC_PrefixHdr* prefix, TASList* asList,
                                       bool onlyExtendedLength);
 
+/**
+ * Tokenize the given AS path for signing. Unless the peer is iBGP, the own AS
+ * is added in front of the path. This function is thread safe.
+ * 
+ * @param asPath (optional) a comma or blank separated string containing the AS 
+ *               path (origin is the right most AS), Can be empty or NULL.
+ * @param bgp_conf The configuration of the bgp session.
+ * @param path The path to be filled, must be initialized with 0 or be a path
+ *             used previously. Release the memory using freeASNPath.
+ * 
+ * @return false if no BGPSec path attribute is generated for this path - an
+ *         origination to an iBGP peer.
+ */
+bool tokenizeASNPath(char* asPath, BGP_SessionConf* bgp_conf, tASNPath* path);
+
+/**
+ * Release the memory allocated within the given path.
+ * 
+ * @param path The path.
+ */
+void freeASNPath(tASNPath* path);
+
+/**
+ * Generate the BGPSec Path attribute byte stream for an already tokenized 
+ * path. See generateBGPSecAttr. With useGlobal set to false this function is
+ * thread safe as long as each thread uses its own bgp_conf and asList.
+ * 
+ * @param capi   The CryptoAPI to be used for signing. If NULL, the signing is 
+ *               performed using the internal signing implementation.
+ * @param useGlobal use internal data stream (not thread safe but faster)
+ * @param path   The path generated by tokenizeASNPath.
+ * @param segmentCt OUT variable that returns the number of path / signature 
+ *               segments this BGPSec path attribute contains.
+ * @param bgp_conf The configuration of the bgp session.
+ * @param prefix The prefix to be used. Depending on the AFI value it will be 
+ *               typecast to either BGPSEC_V4Prefix or BGPSEC_V6Prefix
+ * @param asList The AS list
+ * @param onlyExtendedLength Indicates if the attributes flag must be set to 
+ *               extended length regardless of parameter length.
+ * 
+ * @return Return the BGPSEC path attribute or NULL if the path generation 
+ *         failed.
+ */
+BGP_PathAttribute* generateBGPSecAttrFromPath(SRxCryptoAPI* capi,
+                                      bool useGlobal, tASNPath* path,
+                                      u_int32_t* segmentCt, 
+                                      BGP_SessionConf* bgp_conf,
+                                      BGPSEC_PrefixHdr* prefix, TASList* asList,
+                                      bool onlyExtendedLength);
+
 /**
  * Free the test data stream.
  * 
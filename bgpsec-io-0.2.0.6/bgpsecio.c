@@ -82,6 +82,7 @@
 #include "antd-util/printer.h"
 #include "bgp/BGPHeader.h"
 #include "bgp/BGPSession.h"
+#include "bgp/BGPBlaster.h"
 #include "bgp/BGPFinalStateMachine.h"
 #include "bgp/printer/BGPHeaderPrinter.h"
 #include "bgp/printer/BGPUpdatePrinter.h"
@@ -91,6 +92,7 @@
 #include "cfg/configuration.h"
 #include "cfg/cfgFile.h"
 #include "player/player.h"
+#include "genPipeline.h"
 
 /** Only be used as parameter for preloadKeys */
 #define LOAD_KEYS_PRIVATE true
@@ -173,10 +175,6 @@ static int _runBGPRouterSession(PrgParams* params)
   bool useGlobalMemory = true;
   u_int8_t binBuff[SESS_MIN_MESSAGE_BUFFER];
   memset(&binBuff, 0, sizeof(binBuff));
-  BGPSEC_IO_Buffer ioBuff;
-  memset(&ioBuff, 0, sizeof(ioBuff));
-  ioBuff.data     = (u_int8_t*)&binBuff;
-  ioBuff.dataSize = sizeof(binBuff);
           
   u_int8_t msgBuff[SESS_MIN_MESSAGE_BUFFER]; //10KB Message Size
   memset(&msgBuff, 0, sizeof(msgBuff));
@@ -190,6 +188,13 @@ static int _runBGPRouterSession(PrgParams* params)
     return EXIT_FAILURE;
   }
   
+  // The blaster also starts the monitor session if configured.
+  BGPBlaster*       blaster    = params->blast 
+                                 ? createBlaster(session, &params->blastConf)
+                                 : NULL;
+  bool              blastReady = false;
+  bool              blastDone  = false;
+  
   BGP_PathAttribute*   bgpPathAttr = NULL;
   BGP_UpdateMessage_1* bgp_update  = NULL;
   int               stopTime       = session->bgpConf.disconnectTime;
@@ -201,18 +206,22 @@ static int _runBGPRouterSession(PrgParams* params)
 
   UpdateData*       update   = NULL;
   BGPSEC_PrefixHdr* prefix   = NULL;
-  BGPSEC_IO_Record  record;
-  memset (&record, 0, sizeof(BGPSEC_IO_Record));
+  BGPSEC_IO_Record* record   = NULL;
+  u_int8_t*         keys     = NULL;
+  u_int8_t*         data     = NULL;
   
-  // Prepare reading from file as well.
-  FILE* dataFile = NULL;
+  // Prepare reading from file as well. The updates are sent directly out of
+  // the mapped file.
+  BGPSEC_IO_Map*    dataMap  = NULL;
+  BGPSEC_IO_Cursor  cursor;
   if (hasBinTraffic)
   {
-    dataFile = fopen(params->binInFile, "r");
-    hasBinTraffic = dataFile != NULL;
+    dataMap = openDataMap(params->binInFile);
+    hasBinTraffic = dataMap != NULL;
     if (hasBinTraffic)
     {
-      hasBinTraffic = !feof(dataFile);
+      initDataCursor(&cursor, dataMap, htonl(session->bgpConf.asn), 
+                     htonl(session->bgpConf.peerAS), BGPSEC_IO_TYPE_ALL);
     }
   }
         
@@ -224,6 +233,13 @@ static int _runBGPRouterSession(PrgParams* params)
       sleep(1);
       continue;
     }    
+    
+    if (blaster != NULL && !blastReady)
+    {
+      // The monitor session must be settled before the first update is send.
+      waitForMonitor(blaster);
+      blastReady = true;
+    }
                 
     // Now session is established, first send all updates in the stack then
     // all stdin data followed by binary in data
@@ -241,7 +257,6 @@ static int _runBGPRouterSession(PrgParams* params)
       // First check the stack and stdin
       if (!isUpdateStackEmpty(params, inludeStdIn))
       {
-        record.recordType = BGPSEC_IO_TYPE_BGPSEC_ATTR;
         update    = (UpdateData*)popStack(&params->updateStack);
 
         if (update != NULL)
@@ -289,24 +304,21 @@ static int _runBGPRouterSession(PrgParams* params)
       else if (hasBinTraffic)
       {
         inludeStdIn = false;
-        hasBinTraffic = loadData(dataFile, htonl(session->bgpConf.asn), 
-                                 htonl(session->bgpConf.peerAS), 
-                                 BGPSEC_IO_TYPE_ALL, &record, &ioBuff);
+        hasBinTraffic = nextMappedData(&cursor, &record, &keys, &data);
         if (hasBinTraffic)
         {
-          switch (record.recordType)
+          switch (record->recordType)
           {
             case BGPSEC_IO_TYPE_BGPSEC_ATTR:
-                // Prepare the attribute memory
-              bgpPathAttr = (BGP_PathAttribute*)ioBuff.data;
-              prefix = (BGPSEC_PrefixHdr*)&record.prefix;
+              bgpPathAttr = (BGP_PathAttribute*)data;
+              prefix = (BGPSEC_PrefixHdr*)&record->prefix;
               break;
             case BGPSEC_IO_TYPE_BGP_UPDATE:
               useMPNLRI = false; // No MPNLRI for V4 addresses and AS_PATH
-              bgp_update = (BGP_UpdateMessage_1*)ioBuff.data;
+              bgp_update = (BGP_UpdateMessage_1*)data;
               break;
             default:
-              printf("ERROR: Invalid record type [%u]!\n", record.recordType);
+              printf("ERROR: Invalid record type [%u]!\n", record->recordType);
               break;
           }
         }
@@ -329,8 +341,20 @@ static int _runBGPRouterSession(PrgParams* params)
       
       if (bgp_update != NULL)
       {
-        sendUpdate(session, bgp_update);        
+        if (blaster != NULL)
+        {
+          // Updates located in the data file are not copied.
+          blastUpdate(blaster, bgp_update, 
+                      bgp_update == (BGP_UpdateMessage_1*)data);
+        }
+        else
+        {
+          sendUpdate(session, bgp_update);        
+        }
       }
+      // The attribute is either global memory or located in the data file or 
+      // the local buffer, neither of them is released.
+      bgpPathAttr = NULL;
       
       // Free the update information if it still exists. Don't do it earlier
       // because if the update was used, the prefix links to it.
@@ -341,6 +365,17 @@ static int _runBGPRouterSession(PrgParams* params)
       }      
     }
     
+    if (blaster != NULL)
+    {
+      flushBlaster(blaster);
+      if (!sendData && !blastDone)
+      {
+        waitForConvergence(blaster);
+        printBlastStatistics(blaster);
+        blastDone = true;
+      }
+    }
+    
     // the BGP session will take care of hold timer and disconnect timers.
     if (session->bgpConf.disconnectTime != 0)
     {
@@ -360,11 +395,10 @@ static int _runBGPRouterSession(PrgParams* params)
     }
   }
 
-  if (dataFile)
-  {
-    fclose(dataFile);
-    dataFile = NULL;
-  }  
+  closeDataMap(dataMap);
+  dataMap = NULL;
+  freeBlaster(blaster);
+  blaster = NULL;
   
   void* retVal = NULL;
   pthread_join(bgp_thread, &retVal);
@@ -523,14 +557,13 @@ static void __cleanPubKeys(PrgParams* params)
  * Register the keys found in the binary file with the SRxCryptoAPI.
  * 
  * @param capi The API module
- * @param ioBuff The keys.
+ * @param keys The keys as stored in the record.
+ * @param length The length of the keys.
  */
-static void __capiRegisterPublicKeys(SRxCryptoAPI* capi, 
-                                     BGPSEC_IO_Buffer* ioBuff)
+static void __capiRegisterPublicKeys(SRxCryptoAPI* capi, u_int8_t* keys,
+                                     u_int16_t length)
 {
-  u_int16_t* wordVal = (u_int16_t*)ioBuff->keys;
-  u_int16_t  length = *wordVal;
-  u_int8_t*  ptr = ioBuff->keys + sizeof(u_int16_t);
+  u_int8_t*  ptr = keys;
   
   BGPSEC_IO_KRecord* kRecord = NULL;
   BGPSecKey          bgpsec_key;
@@ -573,13 +606,6 @@ static int _runCAPI(PrgParams* params, SRxCryptoAPI* capi)
   UpdateData*               update   = NULL;
   BGP_PathAttribute*        pathAttr = NULL;
   BGPSEC_PrefixHdr*         prefix   = NULL;
-  
-  BGPSEC_IO_Buffer ioBuff;
-  memset (&ioBuff, 0, sizeof(BGPSEC_IO_Buffer));
-  ioBuff.data     = malloc(MAX_DATABUF);
-  ioBuff.dataSize = MAX_DATABUF;
-  ioBuff.keys     = malloc(MAX_DATABUF);
-  ioBuff.keySize  = MAX_DATABUF;
     
   int   valResult  = 0;
   
@@ -649,38 +675,38 @@ static int _runCAPI(PrgParams* params, SRxCryptoAPI* capi)
   
   if (params->binInFile[0] != '\0')
   {
-    // Read all data from binary in file
-    FILE* dataFile = fopen(params->binInFile, "r");
-    BGPSEC_IO_Record record;
-    BGP_PathAttribute* pathAttr = NULL;
-    // re-initialize the data buffer
-    memset (ioBuff.data, 0, ioBuff.dataSize);
+    // Read all data from binary in file, the data is used directly from the
+    // mapped file.
+    BGPSEC_IO_Map*    dataMap  = openDataMap(params->binInFile);
+    BGPSEC_IO_Record* record   = NULL;
+    u_int8_t*         keys     = NULL;
+    u_int8_t*         data     = NULL;
+    BGPSEC_IO_Cursor  cursor;
     
-    if (dataFile)
+    if (dataMap)
     { 
-      // re-initialize the data buffer.
-      memset (ioBuff.data, 0, MAX_DATABUF);
-      memset (ioBuff.keys, 0, MAX_DATABUF);
-      
       // Make sure no previously stored keys are still in the cache      
       __cleanPubKeys(params);
       u_int32_t asn    = htonl(params->bgpConf.asn);
       u_int32_t peerAS = htonl(params->bgpConf.peerAS);
-      while (loadData(dataFile, asn, peerAS, BGPSEC_IO_TYPE_BGPSEC_ATTR, 
-                      &record, &ioBuff) 
-             && (params->maxUpdates != 0))
+      initDataCursor(&cursor, dataMap, asn, peerAS, BGPSEC_IO_TYPE_BGPSEC_ATTR);
+      while ((params->maxUpdates != 0)
+             && nextMappedData(&cursor, &record, &keys, &data))
       {
         params->maxUpdates--;
-        pathAttr  = (BGP_PathAttribute*)ioBuff.data;
-        prefix    = (BGPSEC_PrefixHdr*)&record.prefix;
-        __capiRegisterPublicKeys(capi, &ioBuff);
+        pathAttr  = (BGP_PathAttribute*)data;
+        prefix    = (BGPSEC_PrefixHdr*)&record->prefix;
+        if (keys != NULL)
+        {
+          __capiRegisterPublicKeys(capi, keys, ntohs(record->keyDataLength));
+        }
         
         elapsed       = 0;
         valStatus     = API_STATUS_OK;
         valResult     = __capiProcessBGPSecAttr(capi, params, prefix, pathAttr,
                                                 &elapsed, &valStatus);
         
-        statistics[valResult].totalSegments += ntohl(record.noSegments);
+        statistics[valResult].totalSegments += ntohl(record->noSegments);
         statistics[valResult].totalTime     += elapsed;
         
         // TODO: Check if cleanup is still needed.
@@ -706,18 +732,9 @@ static int _runCAPI(PrgParams* params, SRxCryptoAPI* capi)
             printf("ERROR: API reports undefined validation result.\n");
             break;
         }        
-        
-        // re-initialize the beginning of the data buffer that contains the 
-        // length field of data stored in the buffer.
-        memset (ioBuff.data, 0, sizeof(BGPSEC_Ext_PathAttribute));
-        memset (ioBuff.keys, 0, 2);        
       }
-      fclose(dataFile);
-      dataFile = 0;
-    }  
-    else
-    {
-      printf("ERROR: Could not open input file '%s'\n", params->binInFile);
+      closeDataMap(dataMap);
+      dataMap = NULL;
     }
   }
   
@@ -768,12 +785,6 @@ static int _runCAPI(PrgParams* params, SRxCryptoAPI* capi)
     }
     printf ("\n");
   }
-  free (ioBuff.data);
-  ioBuff.data = NULL;
-  ioBuff.dataSize = 0;
-  free (ioBuff.keys);
-  ioBuff.keys = NULL;
-  ioBuff.keySize = 0;
 
   return EXIT_SUCCESS;
 }
@@ -790,22 +801,31 @@ static int _runCAPI(PrgParams* params, SRxCryptoAPI* capi)
 static int _runGEN(PrgParams* params, u_int8_t type)
 {
   int retVal = EXIT_SUCCESS;
-  u_int8_t msgBuff[SESS_MIN_MESSAGE_BUFFER]; //10KB Message Size
-  memset(&msgBuff, 0, SESS_MIN_MESSAGE_BUFFER);
 
   if (params->binOutFile[0] != '\0')
   {
+    // Records can only be appended to the stream format (version 1).
+    if (params->appendOut 
+        && !convertDataFile(params->binOutFile, BGPSEC_IO_FILE_V1))
+    {
+      return EXIT_FAILURE;
+    }
     FILE* outFile = params->appendOut ? fopen(params->binOutFile, "a")
                                       : fopen(params->binOutFile, "w");
-    if (outFile)
+    if (outFile && params->genThreads > 1)
+    {
+      if (!runGenPipeline(params, outFile, type, asList))
+      {
+        retVal = EXIT_FAILURE;
+      }
+      fclose(outFile);
+    }
+    else if (outFile)
     {
       // move to function that also reads from stdin
       UpdateData* update = NULL;
       BGP_PathAttribute* bgpsecPathAttr = NULL;
       BGPSEC_PrefixHdr* prefix = NULL;
-      BGPSEC_IO_StoreData store;
-      u_int16_t attrSize = 0;
-      int msgLen         = 0;
       
       while (!isUpdateStackEmpty(params, true) && (params->maxUpdates != 0))
       {
@@ -823,68 +843,31 @@ static int _runGEN(PrgParams* params, u_int8_t type)
         }
                 
         u_int32_t segmentCount = 0;
-        bool iBGP = params->bgpConf.asn == params->bgpConf.peerAS;
-        u_int32_t locPref = iBGP ? BGP_UPD_A_FLAGS_LOC_PREV_DEFAULT : 0;
         bgpsecPathAttr = (BGP_PathAttribute*)generateBGPSecAttr(NULL, true, 
                        update->pathStr, &segmentCount, &params->bgpConf, prefix, 
                        asList, params->onlyExtLength);        
         if (bgpsecPathAttr != NULL)
         {
-          // Include the attribute header information.
-          u_int8_t* attrLen = ((u_int8_t*)bgpsecPathAttr) + sizeof(BGP_PathAttribute);
-          if (bgpsecPathAttr->attr_flags & BGP_UPD_A_FLAGS_EXT_LENGTH > 0)
+          if (!storeGenData(outFile, type, &params->bgpConf, prefix, 
+                            bgpsecPathAttr, segmentCount, 
+                            params->bgpConf.algoParam.fakeUsed,
+                            params->bgpConf.algoParam.pubKeysStored,
+                            params->bgpConf.algoParam.pubKey))
           {
-            attrSize = ntohs(*((u_int16_t*)attrLen)) + sizeof(BGP_PathAttribute) 
-                       + 2; // 2 byte for length field in header.
+            printf("ERROR: Error writing path %s\n", update->pathStr);
           }
-          else
-          {
-            attrSize = *attrLen + sizeof(BGP_PathAttribute) + 1; // one byte
-          }
-          store.prefix       = prefix;
-          store.usesFake     = params->bgpConf.algoParam.fakeUsed;
-          store.numKeys      = params->bgpConf.algoParam.pubKeysStored;
-          store.keys         =  store.numKeys != 0 
-                                ? params->bgpConf.algoParam.pubKey : NULL;
-          store.segmentCount = segmentCount;
-          switch (type)
-          {            
-            case BGPSEC_IO_TYPE_BGPSEC_ATTR:
-              store.dataLength   = attrSize;
-              store.data         = (u_int8_t*)bgpsecPathAttr;
-              if (!storeData(outFile, BGPSEC_IO_TYPE_BGPSEC_ATTR, 
-                             params->bgpConf.asn, params->bgpConf.peerAS, 
-                             &store))
-              {
-                printf("ERROR: Error writing path %s\n", update->pathStr);
-              }
-              break;
-              
-            case BGPSEC_IO_TYPE_BGP_UPDATE:
-              msgLen = createUpdateMessage(msgBuff, sizeof(msgBuff), 
-                                 (BGP_PathAttribute*)bgpsecPathAttr, 
-                                 BGP_UPD_A_FLAGS_ORIGIN_INC,
-                                 locPref, params->bgpConf.bgpIdentifier, prefix, 
-                                 params->bgpConf.useMPNLRI);
-              store.dataLength = msgLen;
-              store.data       = (u_int8_t*)msgBuff;
-              if (!storeData(outFile, BGPSEC_IO_TYPE_BGP_UPDATE, 
-                             params->bgpConf.asn, params->bgpConf.peerAS, 
-                             &store))
-              {
-                printf("ERROR: Error writing path %s\n", update->pathStr);
-              }
-              break;
-              
-            default:
-              printf("ERROR: Invalid type[%u]\n", type);              
-          }                
         }
 
         freeUpdateData(update);          
       }
       fclose(outFile);
     }
+    
+    if (outFile && params->indexOut
+        && !convertDataFile(params->binOutFile, BGPSEC_IO_FILE_V2))
+    {
+      retVal = EXIT_FAILURE;
+    }
   }
   else
   {
@@ -129,6 +129,9 @@ bool generateFile(char* fName)
     fprintf (file, "# Maximum combined number of updates to process. Script 0 "
                    "for MAX INT\n");
     fprintf (file, "%s = 0;\n\n", P_CFG_MAX_UPD);
+    // Number of signing threads
+    fprintf (file, "# Number of threads signing the updates in GEN mode.\n");
+    fprintf (file, "%s = %u;\n\n", P_CFG_GEN_THREADS, DEF_GEN_THREADS);
     
     // Force Extended flag being set.
     fprintf (file, "# Allow to force the usage of the flag for extended length "
@@ -145,6 +148,27 @@ bool generateFile(char* fName)
     fprintf (file, "# Append data to the out file.\n");  
     fprintf (file, "%s = \"false\";\n\n", P_CFG_APPEND_OUT);
     
+    // indexOut
+    fprintf (file, "# Write the out file in the indexed format.\n");  
+    fprintf (file, "%s = false;\n\n", P_CFG_INDEX_OUT);
+    
+    // blaster mode
+    fprintf (file, "# Send the updates in blaster mode (BGP mode only) with "
+                   "the given updates per\n");
+    fprintf (file, "# second, 0 for unlimited.\n");  
+    fprintf (file, "%s = false;\n", P_CFG_BLAST);
+    fprintf (file, "%s = 0;\n", P_CFG_BLAST_RATE);
+    fprintf (file, "# Measure the convergence with a second session to the "
+                   "peer from a different\n");
+    fprintf (file, "# local address.\n");
+    fprintf (file, "#%s = {\n", P_CFG_BLAST_MONITOR);
+    fprintf (file, "#  %s       = 65;\n", P_CFG_MY_ASN);
+    fprintf (file, "#  %s = \"10.0.1.65\";\n", P_CFG_BGP_IDENT);
+    fprintf (file, "#  %s  = \"10.0.1.65\";\n", P_CFG_LOCAL_IP);
+    fprintf (file, "#  %s   = %u;\n", P_CFG_MON_TIMEOUT, 
+             BLAST_DEF_MON_TIMEOUT);
+    fprintf (file, "#};\n\n");
+    
     // capi_cfg
     fprintf (file, "# Allow to specify a configuration file for srx-crypto-api,"
                    "If this is not specified,\n");
@@ -218,10 +218,33 @@ void printSyntax()
   printf ("          given outfile. In case the outfile does not exist, a\n");
   printf ("          new one will be generated.\n");
   printf ("          Requires GEN mode!!\n");
+
+  // Indexed output file
+  printf ("  -%c, %s\n", P_C_INDEX_OUT, P_INDEX_OUT);
+  printf ("          If specified, the outfile will be written in the\n");
+  printf ("          indexed format (version 2). Both formats can be used as\n");
+  printf ("          binary input data.\n");
+  printf ("          Requires GEN mode!!\n");
   
   // Use Maximum number of updates 
   printf ("  -%c, %s\n", P_C_MAX_UPD, P_MAX_UPD);
   printf ("          Allows to restrict the number of updates generated.\n");
+
+  // Number of signing threads
+  printf ("  -%c <number>, %s <number>\n", P_C_GEN_THREADS, P_GEN_THREADS);
+  printf ("          The number of threads signing the updates in GEN mode\n");
+  printf ("          (1..%u, default %u). The output does not depend on\n",
+          MAX_GEN_THREADS, DEF_GEN_THREADS);
+  printf ("          the number of threads.\n");
+
+  // Blaster mode
+  printf ("  -%c, %s\n", P_C_BLAST, P_BLAST);
+  printf ("          Send the updates in blaster mode. Updates with equal\n");
+  printf ("          attributes are packed and written in large batches.\n");
+  printf ("          BGPsec updates are not packed. Requires BGP mode!!\n");
+  printf ("  -%c <number>, %s <number>\n", P_C_BLAST_RATE, P_BLAST_RATE);
+  printf ("          The updates per second in blaster mode, 0 for\n");
+  printf ("          unlimited (default).\n");
   
   // -C <config-file> - Generate a config file.
   printf ("  -%c <filename>\n", P_C_CREATE_CFG_FILE);
@@ -308,6 +331,14 @@ void printSyntax()
   printf ("          Print status information on validation result invalid.\n");
   printf ("          This setting only affects the CAPI mode.\n");
   
+  printf ("  %s = { %s, %s, %s, %s }\n", P_CFG_BLAST_MONITOR, P_CFG_MY_ASN,
+          P_CFG_BGP_IDENT, P_CFG_LOCAL_IP, P_CFG_MON_TIMEOUT);
+  printf ("          Monitor session of the blaster mode. It connects to the\n");
+  printf ("          same peer from the given local address and measures the\n");
+  printf ("          time until the peer announced all prefixes send.\n");
+  printf ("          The timeout defaults to %u seconds.\n", 
+          BLAST_DEF_MON_TIMEOUT);
+  
   printf ("\n");
   printf ("%s Version %s\nDeveloped 2015-2016 by Oliver Borchert ANTD/NIST\n", 
           PACKAGE_NAME, PACKAGE_VERSION);
@@ -357,6 +388,7 @@ char getShortParam(char* argument)
     else if (strcmp(argument, P_BINFILE) == 0)     { retVal = P_C_BINFILE; }
     else if (strcmp(argument, P_OUTFILE) == 0)     { retVal = P_C_OUTFILE; }
     else if (strcmp(argument, P_APPEND_OUT) == 0)  { retVal = P_C_APPEND_OUT; }
+    else if (strcmp(argument, P_INDEX_OUT) == 0)   { retVal = P_C_INDEX_OUT; }
     else if (strcmp(argument, P_NO_MPNLRI) == 0)   { retVal = P_C_NO_MPNLRI; }
     else if (strcmp(argument, P_NO_EXT_MSG_CAP) == 0) 
          { retVal = P_C_NO_EXT_MSG_CAP; }
@@ -365,6 +397,9 @@ char getShortParam(char* argument)
     else if (strcmp(argument, P_NO_PL_ECKEY) == 0) { retVal = P_C_NO_PL_ECKEY; }
     else if (strcmp(argument, P_CAPI_CFG) == 0)    { retVal = P_C_CAPI_CFG; }
     else if (strcmp(argument, P_MAX_UPD) == 0)     { retVal = P_C_MAX_UPD; }
+    else if (strcmp(argument, P_GEN_THREADS) == 0) { retVal = P_C_GEN_THREADS; }
+    else if (strcmp(argument, P_BLAST) == 0)       { retVal = P_C_BLAST; }
+    else if (strcmp(argument, P_BLAST_RATE) == 0)  { retVal = P_C_BLAST_RATE; }
   }
   
   return retVal;
@@ -673,6 +708,11 @@ bool readConfig(PrgParams* params)
       params->appendOut = (bool)intVal;
     }
     
+    if (config_lookup_bool(&cfg, P_CFG_INDEX_OUT, (int*)&intVal) == CONFIG_TRUE)
+    {
+      params->indexOut = (bool)intVal;
+    }
+    
     if (config_lookup_bool(&cfg, P_CFG_PL_ECKEY, (int*)&intVal) == CONFIG_TRUE)
     {
       params->preloadECKEY = (bool)intVal;
@@ -688,6 +728,70 @@ bool readConfig(PrgParams* params)
       params->maxUpdates = intVal != 0 ? (u_int32_t)intVal : MAX_UPDATES;
     }
     
+    if (config_lookup_int(&cfg, P_CFG_GEN_THREADS, &intVal) == CONFIG_TRUE)
+    {
+      if (intVal < 1 || intVal > MAX_GEN_THREADS)
+      {
+        printf ("WARNING: Invalid number of threads '%ld', use %u!\n",
+                (long)intVal, DEF_GEN_THREADS);
+        intVal = DEF_GEN_THREADS;
+      }
+      params->genThreads = (u_int16_t)intVal;
+    }
+    
+    if (config_lookup_bool(&cfg, P_CFG_BLAST, (int*)&intVal) == CONFIG_TRUE)
+    {
+      params->blast = (bool)intVal;
+    }
+    
+    if (config_lookup_int(&cfg, P_CFG_BLAST_RATE, &intVal) == CONFIG_TRUE)
+    {
+      params->blastConf.rate = intVal > 0 ? (u_int32_t)intVal : 0;
+    }
+    
+    cfgHlp = config_lookup(&cfg, P_CFG_BLAST_MONITOR);
+    if (cfgHlp != NULL)
+    {
+      sessVal = config_setting_get_member(cfgHlp, P_CFG_MY_ASN);
+      if (sessVal != NULL)
+      {
+        params->blastConf.monitorAS = (u_int32_t)config_setting_get_int(sessVal);
+      }
+      sessVal = config_setting_get_member(cfgHlp, P_CFG_BGP_IDENT);
+      strVal  = sessVal != NULL ? config_setting_get_string(sessVal) : NULL;
+      if (strVal != NULL)
+      {
+        strToIPAddress(strVal, &ipAddr); 
+        if (ipAddr.version == ADDR_IP_V4)
+        {
+          params->blastConf.monitorIdent = ntohl(ipAddr.addr.v4.u32);
+        }
+        else
+        {
+          sprintf(params->errMsgBuff, "%s: %s MUST be an IPv4 address!",
+                  P_CFG_BLAST_MONITOR, P_CFG_BGP_IDENT);
+        }
+      }
+      sessVal = config_setting_get_member(cfgHlp, P_CFG_LOCAL_IP);
+      strVal  = sessVal != NULL ? config_setting_get_string(sessVal) : NULL;
+      if (strVal != NULL)
+      {
+        _setIPAddress(strVal, 0, &params->blastConf.monitorAddr);
+      }
+      sessVal = config_setting_get_member(cfgHlp, P_CFG_MON_TIMEOUT);
+      if (sessVal != NULL)
+      {
+        params->blastConf.monitorTimeout = 
+                                  (u_int32_t)config_setting_get_int(sessVal);
+      }
+      if (   params->blastConf.monitorAS != 0 
+          && params->blastConf.monitorAddr.sin_addr.s_addr == 0)
+      {
+        sprintf(params->errMsgBuff, "%s: %s is required!",
+                P_CFG_BLAST_MONITOR, P_CFG_LOCAL_IP);
+      }
+    }
+    
     if (config_lookup_bool(&cfg, P_CFG_ONLY_EXTENDED_LENGTH, (int*)&intVal) == CONFIG_TRUE)
     {
       params->onlyExtLength = (bool)intVal;
@@ -1043,6 +1147,7 @@ void initParams(PrgParams* params)
   params->preloadECKEY                = true;
   params->onlyExtLength               = true;
   params->appendOut                   = false;
+  params->indexOut                    = false;
   params->bgpConf.printPollLoop       = false;
   params->bgpConf.printOnInvalid      = false;
   for (idx = 0; idx < PRNT_MSG_COUNT; idx++)
@@ -1052,6 +1157,10 @@ void initParams(PrgParams* params)
   }
   
   params->maxUpdates = MAX_UPDATES;
+  params->genThreads = DEF_GEN_THREADS;
+  params->blast      = false;
+  memset(&params->blastConf, 0, sizeof(BGP_BlastConf));
+  params->blastConf.monitorTimeout = BLAST_DEF_MON_TIMEOUT;
   
   memset(&params->bgpConf.algoParam, 0, sizeof (AlgoParam)); 
   // The following line is normally not needed, I just add it in case the SM_BIO
@@ -1212,6 +1321,14 @@ int parseParams(PrgParams* params, int argc, char** argv)
         }
         break;        
 
+      case P_C_GEN_THREADS:
+        if (++idx >= argc) 
+          { _setErrMsg(params, "Number of threads missing!"); break; }
+        if (atoi(argv[idx]) < 1 || atoi(argv[idx]) > MAX_GEN_THREADS)
+          { _setErrMsg(params, "Invalid number of threads!"); break; }
+        params->genThreads = atoi(argv[idx]);
+        break;
+
       case P_C_MY_ASN:
         if (++idx >= argc) 
           { _setErrMsg(params, "Own AS number missing!"); break; }
@@ -1277,6 +1394,22 @@ int parseParams(PrgParams* params, int argc, char** argv)
         params->appendOut = true;
         break;        
         
+      case P_C_INDEX_OUT:
+        params->indexOut = true;
+        break;
+        
+      case P_C_BLAST:
+        params->blast = true;
+        break;
+        
+      case P_C_BLAST_RATE:
+        if (++idx >= argc) 
+          { _setErrMsg(params, "Blaster rate missing!"); break; }
+        if (atoi(argv[idx]) < 0)
+          { _setErrMsg(params, "Invalid blaster rate!"); break; }
+        params->blastConf.rate = atoi(argv[idx]);
+        break;
+        
       case P_C_BINFILE:
         if (++idx >= argc) 
           { _setErrMsg(params, "Filename for binary in-file missing!"); break; }
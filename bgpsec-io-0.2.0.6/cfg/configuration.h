@@ -72,6 +72,7 @@
 #include <stdbool.h>
 #include "antd-util/stack.h"
 #include "bgpsec/BGPSecPathBin.h"
+#include "bgp/BGPBlaster.h"
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -94,6 +95,8 @@
 #define DEF_HOLD_TIME       180
 #define DEF_DISCONNECT_TIME 0
 #define DEF_ALGO_ID         1
+#define DEF_GEN_THREADS     1
+#define MAX_GEN_THREADS     64
 
 // Operational type
 #define P_TYPE_BGP  "BGP"
@@ -166,6 +169,13 @@
 // -U <number> - the maximum number of updates to be processed.
 #define P_C_MAX_UPD     'U'
 
+// gen_threads=<number> - the number of signing threads in GEN mode.
+#define P_CFG_GEN_THREADS "gen_threads"
+// --gen_threads <number> - the number of signing threads in GEN mode.
+#define P_GEN_THREADS     "--" P_CFG_GEN_THREADS
+// -T <number> - the number of signing threads in GEN mode.
+#define P_C_GEN_THREADS   'T'
+
 // The following only if BGP is selected.
 // asn=<asn> - The ASN of the player
 #define P_CFG_MY_ASN    "asn"
@@ -274,6 +284,13 @@
 // -O - Append to an existing out file - "NOT ZERO".
 #define P_C_APPEND_OUT   'O'
 
+// indexOut - Write the out file in the indexed format.
+#define P_CFG_INDEX_OUT "indexOut"
+// --indexOut - Write the out file in the indexed format.
+#define P_INDEX_OUT     "--" P_CFG_INDEX_OUT
+// -X - Write the out file in the indexed format.
+#define P_C_INDEX_OUT   'X'
+
 // bin="filename" - Pre-calculated data in binary format stored in a file.
 #define P_CFG_BINFILE "bin"
 // --bin <filename> - Pre-calculated data in binary format stored in a file.
@@ -288,11 +305,33 @@
 // -d <int> - disconnect time in seconds after the last update sent
 #define P_C_DISCONNECT_TIME   'd'
 
+// blast=true|false - Send the updates in blaster mode.
+#define P_CFG_BLAST      "blast"
+// --blast - Send the updates in blaster mode.
+#define P_BLAST          "--" P_CFG_BLAST
+// -B - Send the updates in blaster mode.
+#define P_C_BLAST        'B'
+
+// blast_rate=<int> - Updates per second in blaster mode, 0 for unlimited.
+#define P_CFG_BLAST_RATE "blast_rate"
+// --blast_rate <int> - Updates per second in blaster mode, 0 for unlimited.
+#define P_BLAST_RATE     "--" P_CFG_BLAST_RATE
+// -R <int> - Updates per second in blaster mode, 0 for unlimited.
+#define P_C_BLAST_RATE   'R'
+
 
 // Only command line parameter
 // -C <config-file> - Generate a config file.
 #define P_C_CREATE_CFG_FILE   'C'
 
+// Only configuration parameter - the monitor session of the blaster mode
+// blast_monitor = { asn, bgp_ident, local_ip, timeout }
+#define P_CFG_BLAST_MONITOR "blast_monitor"
+// The local address the monitor session is bound to.
+#define P_CFG_LOCAL_IP      "local_ip"
+// Time in seconds to wait for the monitor session.
+#define P_CFG_MON_TIMEOUT   "timeout"
+
 // Only configuration parameter - all part of session
 // print bgp packages on receive
 #define P_CFG_PRINT_ON_RECEIVE      "printOnReceive"
@@ -391,6 +430,8 @@ typedef struct
   char      binOutFile[FNAME_SIZE]; // Only used in mode GEN
   /** Indicate if the out file will be opened in append mode or overwrite mode*/
   bool      appendOut;
+  /** Indicate if the out file will be written in the indexed format. */
+  bool      indexOut;
   /* Name of the file that contains the binary pre-computed BGPSEC data. */
   char      binInFile[FNAME_SIZE];  // Only used for BGP and CAPI
   /* Indicate if also the standard input is used. */
@@ -399,6 +440,12 @@ typedef struct
   bool      createCfgFile;
   /* Allows to restrict the player to play a maximum of updates. */
   u_int32_t maxUpdates;
+  /* The number of threads signing the updates in GEN mode. */
+  u_int16_t genThreads;
+  /* Indicates if the updates are send in blaster mode. */
+  bool      blast;
+  /* The configuration of the blaster mode. */
+  BGP_BlastConf blastConf;
   /* Contains the configuration name if a configuration file has to be 
    * generated. */
   char      newCfgFileName[FNAME_SIZE];
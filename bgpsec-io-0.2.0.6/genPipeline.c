@@ -0,0 +1,593 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * The generation pipeline allows to generate the BGPSec traffic of the GEN
+ * modes using multiple threads. The updates are tokenized in one thread and 
+ * handed round robin to the signing threads. Each signing thread uses its own
+ * copy of the keys. The records are written in the order of the update stack,
+ * therefore the output does not depend on the number of threads.
+ * 
+ * @version 0.2.0.6
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <netinet/in.h>
+#include <openssl/crypto.h>
+#include "genPipeline.h"
+#include "updateStackUtil.h"
+#include "antd-util/stack.h"
+#include "bgp/BGPSession.h"
+#include "bgpsec/BGPSecPathBin.h"
+#include "player/player.h"
+
+/** One update processed by the pipeline. */
+typedef struct _GenJob {
+  /** The update popped from the update stack. */
+  UpdateData*        update;
+  /** The tokenized path of the update. */
+  tASNPath           path;
+  /** The generated attribute, NULL if it could not be generated. */
+  BGP_PathAttribute* attr;
+  /** The number of path segments. */
+  u_int32_t          segmentCount;
+  /** Indicates if a fake signature was used. */
+  bool               usesFake;
+  /** The number of keys used for signing. */
+  u_int16_t          numKeys;
+  /** The keys used for signing. */
+  BGPSecKey**        keys;
+  /** The next job in the queue. */
+  struct _GenJob*    next;
+} GenJob;
+
+/** A bounded job queue with one producer and one consumer. */
+typedef struct {
+  GenJob*         head;
+  GenJob*         tail;
+  int             count;
+  /** Set by the producer, no more jobs will be added. */
+  bool            closed;
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+} GenQueue;
+
+/** A signing thread. */
+typedef struct {
+  pthread_t       thread;
+  /** The jobs to be signed. */
+  GenQueue        inQueue;
+  /** The signed jobs in the order they were received. */
+  GenQueue        outQueue;
+  /** The own copy of the session configuration, signing modifies the 
+   * algorithm parameters. */
+  BGP_SessionConf bgpConf;
+  /** The own copy of the keys. */
+  TASList*        asList;
+  /** Specify if the extended length flag must always be set. */
+  bool            onlyExtLength;
+} GenSigner;
+
+/** The pipeline. */
+typedef struct {
+  PrgParams* params;
+  GenSigner* signer;
+  u_int16_t  noSigners;
+} GenPipeline;
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+/** The locks needed by OpenSSL prior 1.1.0 to be used by multiple threads. */
+static pthread_mutex_t* _sslLocks = NULL;
+
+/**
+ * The OpenSSL locking callback.
+ * 
+ * @param mode CRYPTO_LOCK or CRYPTO_UNLOCK.
+ * @param type The lock.
+ * @param file Not used.
+ * @param line Not used.
+ */
+static void _sslLockCallback(int mode, int type, const char* file, int line)
+{
+  if (mode & CRYPTO_LOCK)
+  {
+    pthread_mutex_lock(&_sslLocks[type]);
+  }
+  else
+  {
+    pthread_mutex_unlock(&_sslLocks[type]);
+  }
+}
+
+/**
+ * The OpenSSL thread id callback.
+ * 
+ * @return The id of the calling thread.
+ */
+static unsigned long _sslIdCallback()
+{
+  return (unsigned long)pthread_self();
+}
+#endif
+
+/**
+ * Install the OpenSSL locking unless the application did it already. OpenSSL
+ * 1.1.0 and newer does not need it.
+ */
+static void _initSSLLocks()
+{
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+  int idx;
+  
+  if (CRYPTO_get_locking_callback() == NULL)
+  {
+    _sslLocks = malloc(CRYPTO_num_locks() * sizeof(pthread_mutex_t));
+    for (idx = 0; idx < CRYPTO_num_locks(); idx++)
+    {
+      pthread_mutex_init(&_sslLocks[idx], NULL);
+    }
+    CRYPTO_set_id_callback(_sslIdCallback);
+    CRYPTO_set_locking_callback(_sslLockCallback);
+  }
+#endif
+}
+
+/**
+ * Remove the OpenSSL locking installed by _initSSLLocks.
+ */
+static void _releaseSSLLocks()
+{
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+  int idx;
+  
+  if (_sslLocks != NULL)
+  {
+    CRYPTO_set_locking_callback(NULL);
+    CRYPTO_set_id_callback(NULL);
+    for (idx = 0; idx < CRYPTO_num_locks(); idx++)
+    {
+      pthread_mutex_destroy(&_sslLocks[idx]);
+    }
+    free(_sslLocks);
+    _sslLocks = NULL;
+  }
+#endif
+}
+
+/**
+ * Initialize the given queue.
+ * 
+ * @param queue The queue.
+ */
+static void _initQueue(GenQueue* queue)
+{
+  memset(queue, 0, sizeof(GenQueue));
+  pthread_mutex_init(&queue->mutex, NULL);
+  pthread_cond_init(&queue->cond, NULL);
+}
+
+/**
+ * Release the given queue. The queue must be empty.
+ * 
+ * @param queue The queue.
+ */
+static void _releaseQueue(GenQueue* queue)
+{
+  pthread_mutex_destroy(&queue->mutex);
+  pthread_cond_destroy(&queue->cond);
+}
+
+/**
+ * Add the job to the queue. Waits as long as the queue is full.
+ * 
+ * @param queue The queue.
+ * @param job The job.
+ */
+static void _pushJob(GenQueue* queue, GenJob* job)
+{
+  pthread_mutex_lock(&queue->mutex);
+  while (queue->count >= GEN_QUEUE_SIZE)
+  {
+    pthread_cond_wait(&queue->cond, &queue->mutex);
+  }
+  job->next = NULL;
+  if (queue->tail == NULL)
+  {
+    queue->head = job;
+  }
+  else
+  {
+    queue->tail->next = job;
+  }
+  queue->tail = job;
+  queue->count++;
+  pthread_cond_signal(&queue->cond);
+  pthread_mutex_unlock(&queue->mutex);
+}
+
+/**
+ * Mark the queue as closed, no more jobs will be added.
+ * 
+ * @param queue The queue.
+ */
+static void _closeQueue(GenQueue* queue)
+{
+  pthread_mutex_lock(&queue->mutex);
+  queue->closed = true;
+  pthread_cond_signal(&queue->cond);
+  pthread_mutex_unlock(&queue->mutex);
+}
+
+/**
+ * Remove the first job from the queue. Waits as long as the queue is empty
+ * and not closed.
+ * 
+ * @param queue The queue.
+ * 
+ * @return The job or NULL if the queue is closed and empty.
+ */
+static GenJob* _popJob(GenQueue* queue)
+{
+  GenJob* job = NULL;
+  
+  pthread_mutex_lock(&queue->mutex);
+  while (queue->head == NULL && !queue->closed)
+  {
+    pthread_cond_wait(&queue->cond, &queue->mutex);
+  }
+  job = queue->head;
+  if (job != NULL)
+  {
+    queue->head = job->next;
+    if (queue->head == NULL)
+    {
+      queue->tail = NULL;
+    }
+    queue->count--;
+    job->next = NULL;
+    pthread_cond_signal(&queue->cond);
+  }
+  pthread_mutex_unlock(&queue->mutex);
+  
+  return job;
+}
+
+/**
+ * Free the job including the update.
+ * 
+ * @param job The job.
+ */
+static void _freeJob(GenJob* job)
+{
+  freeUpdateData(job->update);
+  freeASNPath(&job->path);
+  if (job->attr != NULL)
+  {
+    freeData((u_int8_t*)job->attr);
+  }
+  if (job->keys != NULL)
+  {
+    free(job->keys);
+  }
+  free(job);
+}
+
+/**
+ * The signing thread. Generates the attributes of all jobs in the in queue
+ * and hands them to the out queue.
+ * 
+ * @param arg The GenSigner.
+ * 
+ * @return NULL
+ */
+static void* _runSigner(void* arg)
+{
+  GenSigner* signer    = (GenSigner*)arg;
+  AlgoParam* algoParam = &signer->bgpConf.algoParam;
+  GenJob*    job       = NULL;
+  
+  while ((job = _popJob(&signer->inQueue)) != NULL)
+  {
+    job->attr = generateBGPSecAttrFromPath(NULL, false, &job->path, 
+                      &job->segmentCount, &signer->bgpConf, 
+                      (BGPSEC_PrefixHdr*)&job->update->prefixTpl, 
+                      signer->asList, signer->onlyExtLength);
+    if (job->attr != NULL)
+    {
+      // The keys point into the own key list or configuration.
+      job->usesFake = algoParam->fakeUsed;
+      job->numKeys  = algoParam->pubKeysStored;
+      if (job->numKeys != 0)
+      {
+        job->keys = malloc(job->numKeys * sizeof(BGPSecKey*));
+        memcpy(job->keys, algoParam->pubKey, job->numKeys * sizeof(BGPSecKey*));
+      }
+    }
+    _pushJob(&signer->outQueue, job);
+  }
+  _closeQueue(&signer->outQueue);
+  
+  return NULL;
+}
+
+/**
+ * The tokenizer thread. Pops the updates from the update stack and hands them
+ * round robin to the signing threads.
+ * 
+ * @param arg The GenPipeline.
+ * 
+ * @return NULL
+ */
+static void* _runTokenizer(void* arg)
+{
+  GenPipeline* pipeline = (GenPipeline*)arg;
+  PrgParams*   params   = pipeline->params;
+  GenJob*      job      = NULL;
+  u_int32_t    seqNo    = 0;
+  int          idx;
+  
+  while (!isUpdateStackEmpty(params, true) && (params->maxUpdates != 0))
+  {
+    params->maxUpdates--;
+    job = malloc(sizeof(GenJob));
+    memset(job, 0, sizeof(GenJob));
+    job->update = (UpdateData*)popStack(&params->updateStack);
+    if (tokenizeASNPath(job->update->pathStr, &params->bgpConf, &job->path))
+    {
+      _pushJob(&pipeline->signer[seqNo % pipeline->noSigners].inQueue, job);
+      seqNo++;
+    }
+    else
+    {
+      // Originations to iBGP peers are not generated.
+      _freeJob(job);
+    }
+  }
+  for (idx = 0; idx < pipeline->noSigners; idx++)
+  {
+    _closeQueue(&pipeline->signer[idx].inQueue);
+  }
+  
+  return NULL;
+}
+
+/**
+ * Copy the chain of algorithm parameters following the given one.
+ * 
+ * @param algoParam The first algorithm parameter, its next chain is replaced
+ *                  by a copy.
+ */
+static void _copyAlgoParams(AlgoParam* algoParam)
+{
+  AlgoParam* next = NULL;
+  
+  while (algoParam->next != NULL)
+  {
+    next = malloc(sizeof(AlgoParam));
+    memcpy(next, algoParam->next, sizeof(AlgoParam));
+    algoParam->next = next;
+    algoParam       = next;
+  }
+}
+
+/**
+ * Free the chain of algorithm parameters following the given one.
+ * 
+ * @param algoParam The first algorithm parameter.
+ */
+static void _freeAlgoParams(AlgoParam* algoParam)
+{
+  AlgoParam* next = algoParam->next;
+  
+  algoParam->next = NULL;
+  while (next != NULL)
+  {
+    algoParam = next;
+    next      = algoParam->next;
+    free(algoParam);
+  }
+}
+
+/**
+ * Store the generated BGPSec path attribute in the given file, either as is or
+ * embedded in a BGP update.
+ * 
+ * @param outFile The file to write into.
+ * @param type The record type, BGPSEC_IO_TYPE_BGPSEC_ATTR or 
+ *             BGPSEC_IO_TYPE_BGP_UPDATE.
+ * @param bgpConf The session configuration.
+ * @param prefix The prefix of the update.
+ * @param attr The BGPSec path attribute.
+ * @param segmentCount The number of path segments of the attribute.
+ * @param usesFake Indicates if a fake signature was used.
+ * @param numKeys The number of keys used for signing.
+ * @param keys The keys used for signing, NULL if numKeys is 0.
+ * 
+ * @return true if the record could be written.
+ */
+bool storeGenData(FILE* outFile, u_int8_t type, BGP_SessionConf* bgpConf,
+                  BGPSEC_PrefixHdr* prefix, BGP_PathAttribute* attr,
+                  u_int32_t segmentCount, bool usesFake, u_int16_t numKeys,
+                  BGPSecKey** keys)
+{
+  u_int8_t  msgBuff[SESS_MIN_MESSAGE_BUFFER]; //10KB Message Size
+  bool      iBGP     = bgpConf->asn == bgpConf->peerAS;
+  u_int32_t locPref  = iBGP ? BGP_UPD_A_FLAGS_LOC_PREV_DEFAULT : 0;
+  u_int8_t* attrLen  = ((u_int8_t*)attr) + sizeof(BGP_PathAttribute);
+  u_int16_t attrSize = 0;
+  bool      retVal   = false;
+  BGPSEC_IO_StoreData store;
+  
+  // Include the attribute header information.
+  if ((attr->attr_flags & BGP_UPD_A_FLAGS_EXT_LENGTH) != 0)
+  {
+    attrSize = ntohs(*((u_int16_t*)attrLen)) + sizeof(BGP_PathAttribute) 
+               + 2; // 2 byte for length field in header.
+  }
+  else
+  {
+    attrSize = *attrLen + sizeof(BGP_PathAttribute) + 1; // one byte
+  }
+  
+  store.prefix       = prefix;
+  store.usesFake     = usesFake;
+  store.numKeys      = numKeys;
+  store.keys         = numKeys != 0 ? keys : NULL;
+  store.segmentCount = segmentCount;
+  switch (type)
+  {            
+    case BGPSEC_IO_TYPE_BGPSEC_ATTR:
+      store.dataLength = attrSize;
+      store.data       = (u_int8_t*)attr;
+      retVal = storeData(outFile, BGPSEC_IO_TYPE_BGPSEC_ATTR, bgpConf->asn, 
+                         bgpConf->peerAS, &store);
+      break;
+
+    case BGPSEC_IO_TYPE_BGP_UPDATE:
+      memset(&msgBuff, 0, SESS_MIN_MESSAGE_BUFFER);
+      store.dataLength = createUpdateMessage(msgBuff, sizeof(msgBuff), attr, 
+                                 BGP_UPD_A_FLAGS_ORIGIN_INC, locPref, 
+                                 bgpConf->bgpIdentifier, prefix, 
+                                 bgpConf->useMPNLRI);
+      store.data       = (u_int8_t*)msgBuff;
+      retVal = storeData(outFile, BGPSEC_IO_TYPE_BGP_UPDATE, bgpConf->asn, 
+                         bgpConf->peerAS, &store);
+      break;
+
+    default:
+      printf("ERROR: Invalid type[%u]\n", type);              
+  }
+  
+  return retVal;
+}
+
+/**
+ * Generate and store the updates of the update stack using params->genThreads
+ * signing threads. The records are written in the same order as they are
+ * written by the single threaded generation.
+ * 
+ * @param params The program parameters.
+ * @param outFile The file to write into.
+ * @param type The record type, BGPSEC_IO_TYPE_BGPSEC_ATTR or 
+ *             BGPSEC_IO_TYPE_BGP_UPDATE.
+ * @param asList The AS list containing the keys, each signing thread uses a
+ *               copy of it.
+ * 
+ * @return false if the signing threads could not be started.
+ */
+bool runGenPipeline(PrgParams* params, FILE* outFile, u_int8_t type, 
+                    TASList* asList)
+{
+  GenPipeline pipeline;
+  GenSigner*  signer    = NULL;
+  GenJob*     job       = NULL;
+  pthread_t   tokenizer;
+  u_int32_t   seqNo     = 0;
+  int         started   = 0;
+  int         idx;
+  bool        retVal    = true;
+  
+  memset(&pipeline, 0, sizeof(GenPipeline));
+  pipeline.params    = params;
+  pipeline.noSigners = params->genThreads;
+  pipeline.signer    = malloc(pipeline.noSigners * sizeof(GenSigner));
+  memset(pipeline.signer, 0, pipeline.noSigners * sizeof(GenSigner));
+  
+  _initSSLLocks();
+  for (idx = 0; idx < pipeline.noSigners; idx++)
+  {
+    signer = &pipeline.signer[idx];
+    _initQueue(&signer->inQueue);
+    _initQueue(&signer->outQueue);
+    memcpy(&signer->bgpConf, &params->bgpConf, sizeof(BGP_SessionConf));
+    _copyAlgoParams(&signer->bgpConf.algoParam);
+    signer->asList        = copyASList(asList);
+    signer->onlyExtLength = params->onlyExtLength;
+  }
+  
+  for (; started < pipeline.noSigners; started++)
+  {
+    signer = &pipeline.signer[started];
+    if (pthread_create(&signer->thread, NULL, _runSigner, signer) != 0)
+    {
+      printf("ERROR: Could not start signing thread %d!\n", started);
+      retVal = false;
+      break;
+    }
+  }
+  if (retVal && (pthread_create(&tokenizer, NULL, _runTokenizer, &pipeline)
+                 != 0))
+  {
+    printf("ERROR: Could not start tokenizer thread!\n");
+    retVal = false;
+  }
+  
+  if (retVal)
+  {
+    // Write the jobs in the order the tokenizer distributed them.
+    for (seqNo = 0; 
+         (job = _popJob(&pipeline.signer[seqNo % pipeline.noSigners].outQueue))
+         != NULL; 
+         seqNo++)
+    {
+      if (job->attr != NULL)
+      {
+        if (!storeGenData(outFile, type, &params->bgpConf, 
+                          (BGPSEC_PrefixHdr*)&job->update->prefixTpl, 
+                          job->attr, job->segmentCount, job->usesFake, 
+                          job->numKeys, job->keys))
+        {
+          printf("ERROR: Error writing path %s\n", job->update->pathStr);
+        }
+      }
+      _freeJob(job);
+    }
+    pthread_join(tokenizer, NULL);
+  }
+  else
+  {
+    // Stop the signing threads that are started already.
+    for (idx = 0; idx < started; idx++)
+    {
+      _closeQueue(&pipeline.signer[idx].inQueue);
+    }
+  }
+  
+  for (idx = 0; idx < pipeline.noSigners; idx++)
+  {
+    signer = &pipeline.signer[idx];
+    if (idx < started)
+    {
+      pthread_join(signer->thread, NULL);
+    }
+    _releaseQueue(&signer->inQueue);
+    _releaseQueue(&signer->outQueue);
+    _freeAlgoParams(&signer->bgpConf.algoParam);
+    freeASList(signer->asList);
+    signer->asList = NULL;
+  }
+  free(pipeline.signer);
+  pipeline.signer = NULL;
+  _releaseSSLLocks();
+  
+  return retVal;
+}
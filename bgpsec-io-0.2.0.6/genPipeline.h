@@ -0,0 +1,81 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * The generation pipeline allows to generate the BGPSec traffic of the GEN
+ * modes using multiple threads. The updates are tokenized in one thread and 
+ * handed round robin to the signing threads. Each signing thread uses its own
+ * copy of the keys. The records are written in the order of the update stack,
+ * therefore the output does not depend on the number of threads.
+ * 
+ * @version 0.2.0.6
+ */
+#ifndef GENPIPELINE_H
+#define	GENPIPELINE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "ASList.h"
+#include "cfg/configuration.h"
+
+/** The maximum number of jobs waiting in each queue of a signing thread. */
+#define GEN_QUEUE_SIZE 128
+
+/**
+ * Store the generated BGPSec path attribute in the given file, either as is or
+ * embedded in a BGP update.
+ * 
+ * @param outFile The file to write into.
+ * @param type The record type, BGPSEC_IO_TYPE_BGPSEC_ATTR or 
+ *             BGPSEC_IO_TYPE_BGP_UPDATE.
+ * @param bgpConf The session configuration.
+ * @param prefix The prefix of the update.
+ * @param attr The BGPSec path attribute.
+ * @param segmentCount The number of path segments of the attribute.
+ * @param usesFake Indicates if a fake signature was used.
+ * @param numKeys The number of keys used for signing.
+ * @param keys The keys used for signing, NULL if numKeys is 0.
+ * 
+ * @return true if the record could be written.
+ */
+bool storeGenData(FILE* outFile, u_int8_t type, BGP_SessionConf* bgpConf,
+                  BGPSEC_PrefixHdr* prefix, BGP_PathAttribute* attr,
+                  u_int32_t segmentCount, bool usesFake, u_int16_t numKeys,
+                  BGPSecKey** keys);
+
+/**
+ * Generate and store the updates of the update stack using params->genThreads
+ * signing threads. The records are written in the same order as they are
+ * written by the single threaded generation.
+ * 
+ * @param params The program parameters.
+ * @param outFile The file to write into.
+ * @param type The record type, BGPSEC_IO_TYPE_BGPSEC_ATTR or 
+ *             BGPSEC_IO_TYPE_BGP_UPDATE.
+ * @param asList The AS list containing the keys, each signing thread uses a
+ *               copy of it.
+ * 
+ * @return false if the signing threads could not be started.
+ */
+bool runGenPipeline(PrgParams* params, FILE* outFile, u_int8_t type, 
+                    TASList* asList);
+
+#endif	/* GENPIPELINE_H */
@@ -41,9 +41,16 @@
 
 #include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <malloc.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <endian.h>
 #include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+#include <sys/stat.h>
 #include "player.h"
 #include "bgp/printer/BGPPrinterUtil.h"
 #include "cfg/configuration.h"
@@ -52,6 +59,7 @@
  * Load the next record and return it. If the given buff(er) is not NULL and 
  * not of sufficient size, the record will NOT be loaded and NULL will be 
  * returned. in this case the file pointer will not be advanced.
+ * Only version 1 files can be read this way, see openDataMap.
  * 
  * @param file the file to be loaded.
  * @param myAS My own ASN or ignore myAS if myAS == 0. (use network format)
@@ -148,6 +156,566 @@ bool loadData(FILE* file, u_int32_t myAS, u_int32_t peerAS, u_int8_t type,
   return retVal;
 }
 
+/**
+ * Return the record at the given offset of the mapping if it is complete.
+ * 
+ * @param map The mapped file.
+ * @param offset The offset of the record.
+ * @param length OUT - the length of the record including keys and data, can 
+ *               be NULL.
+ * 
+ * @return The record or NULL if the offset does not point to a valid record.
+ */
+static BGPSEC_IO_Record* _getRecord(BGPSEC_IO_Map* map, u_int64_t offset,
+                                    size_t* length)
+{
+  BGPSEC_IO_Record* record = NULL;
+  size_t            recLen = 0;
+  
+  if (offset <= map->size && map->size - offset >= sizeof(BGPSEC_IO_Record))
+  {
+    record = (BGPSEC_IO_Record*)(map->map + offset);
+    recLen = sizeof(BGPSEC_IO_Record) + ntohs(record->dataLength)
+             + ntohs(record->keyDataLength);
+    if (   record->version != BGPSEC_IO_RECORD_VERSION
+        || map->size - offset < recLen)
+    {
+      record = NULL;
+    }
+  }
+  if (length != NULL)
+  {
+    *length = recLen;
+  }
+  
+  return record;
+}
+
+/** A record of a version 1 file while building the index. */
+typedef struct {
+  /** The ASN of the player session (network format). */
+  u_int32_t asn;
+  /** The ASN of the players peer (network format). */
+  u_int32_t peerAS;
+  /** The offset of the record within the file. */
+  u_int64_t offset;
+} _IdxRecord;
+
+/**
+ * Compare two records by ASN and peer AS (memcmp of the network format), 
+ * records of the same session by their offset.
+ * 
+ * @param a The first record.
+ * @param b The second record.
+ * 
+ * @return <0, 0, >0 like memcmp.
+ */
+static int _compareRecords(const void* a, const void* b)
+{
+  const _IdxRecord* recA = (const _IdxRecord*)a;
+  const _IdxRecord* recB = (const _IdxRecord*)b;
+  int               cmp  = memcmp(&recA->asn, &recB->asn, sizeof(u_int32_t));
+  
+  if (cmp == 0)
+  {
+    cmp = memcmp(&recA->peerAS, &recB->peerAS, sizeof(u_int32_t));
+  }
+  if (cmp == 0)
+  {
+    cmp = (recA->offset < recB->offset) ? -1 
+                                        : (recA->offset > recB->offset) ? 1 : 0;
+  }
+  
+  return cmp;
+}
+
+/**
+ * Build the index of a version 1 file by scanning all records once. Scanning
+ * stops at the first invalid record.
+ * 
+ * @param map The mapped file.
+ * 
+ * @return false if not enough memory is available.
+ */
+static bool _buildIndex(BGPSEC_IO_Map* map)
+{
+  BGPSEC_IO_Record*     record  = NULL;
+  BGPSEC_IO_IdxSession* session = NULL;
+  _IdxRecord*           records = NULL;
+  _IdxRecord*           tmp     = NULL;
+  u_int64_t             offset  = 0;
+  size_t                length  = 0;
+  u_int32_t             size    = 0;
+  u_int32_t             idx     = 0;
+  
+  map->version = BGPSEC_IO_FILE_V1;
+  while (offset < map->size)
+  {
+    record = _getRecord(map, offset, &length);
+    if (record == NULL)
+    {
+      printf("ERROR: Invalid record at offset %llu, ignore the remaining "
+             "data!\n", (unsigned long long)offset);
+      break;
+    }
+    if (map->noRecords == size)
+    {
+      size = (size == 0) ? 1024 : size * 2;
+      tmp  = realloc(records, size * sizeof(_IdxRecord));
+      if (tmp == NULL)
+      {
+        free(records);
+        return false;
+      }
+      records = tmp;
+    }
+    records[map->noRecords].asn      = record->asn;
+    records[map->noRecords].peerAS   = record->peerAS;
+    records[map->noRecords++].offset = offset;
+    offset += length;
+  }
+  
+  if (map->noRecords == 0)
+  {
+    return true;
+  }
+  
+  // Group the records by session, within a session the order is kept.
+  qsort(records, map->noRecords, sizeof(_IdxRecord), _compareRecords);
+  map->offsets  = malloc(map->noRecords * sizeof(u_int64_t));
+  map->sessions = malloc(map->noRecords * sizeof(BGPSEC_IO_IdxSession));
+  if (map->offsets == NULL || map->sessions == NULL)
+  {
+    free(records);
+    return false;
+  }
+  for (idx = 0; idx < map->noRecords; idx++)
+  {
+    if (   session == NULL || session->asn != records[idx].asn 
+        || session->peerAS != records[idx].peerAS)
+    {
+      if (session != NULL)
+      {
+        session->count = htonl(idx - ntohl(session->first));
+      }
+      session = &map->sessions[map->noSessions++];
+      session->asn    = records[idx].asn;
+      session->peerAS = records[idx].peerAS;
+      session->first  = htonl(idx);
+    }
+    // The index is kept in network format, the same as in version 2 files.
+    map->offsets[idx] = htobe64(records[idx].offset);
+  }
+  session->count = htonl(idx - ntohl(session->first));
+  free(records);
+  
+  return true;
+}
+
+/**
+ * Use the index stored in a version 2 file. 
+ * 
+ * @param map The mapped file.
+ * 
+ * @return false if the header or index is invalid.
+ */
+static bool _readIndex(BGPSEC_IO_Map* map)
+{
+  BGPSEC_IO_IdxHeader* header = (BGPSEC_IO_IdxHeader*)map->map;
+  u_int64_t            length = sizeof(BGPSEC_IO_IdxHeader);
+  u_int32_t            idx    = 0;
+  
+  if (ntohs(header->version) != BGPSEC_IO_FILE_V2)
+  {
+    printf("ERROR: Incompatible file version. Expected V=%d, found V=%d\n",
+           BGPSEC_IO_FILE_V2, ntohs(header->version));
+    return false;
+  }
+  
+  map->version    = BGPSEC_IO_FILE_V2;
+  map->noSessions = ntohl(header->noSessions);
+  map->noRecords  = ntohl(header->noRecords);
+  length += (u_int64_t)map->noSessions * sizeof(BGPSEC_IO_IdxSession)
+            + (u_int64_t)map->noRecords * sizeof(u_int64_t);
+  if (length > map->size)
+  {
+    printf("ERROR: Truncated index!\n");
+    return false;
+  }
+  map->sessions = (BGPSEC_IO_IdxSession*)(header + 1);
+  map->offsets  = (u_int64_t*)(map->sessions + map->noSessions);
+  
+  for (idx = 0; idx < map->noSessions; idx++)
+  {
+    if (  (u_int64_t)ntohl(map->sessions[idx].first) 
+        + ntohl(map->sessions[idx].count) > map->noRecords)
+    {
+      printf("ERROR: Invalid index entry %u!\n", idx);
+      return false;
+    }
+  }
+  
+  return true;
+}
+
+/**
+ * Map the given data file into memory. Version 2 files use the stored index, 
+ * for version 1 files the index is build while scanning the records once. The
+ * records are not copied. 
+ * 
+ * @param fileName The data file.
+ * 
+ * @return The mapped file or NULL if it could not be mapped or is invalid.
+ */
+BGPSEC_IO_Map* openDataMap(const char* fileName)
+{
+  BGPSEC_IO_Map* map   = NULL;
+  void*          data  = MAP_FAILED;
+  bool           valid = false;
+  struct stat    fStat;
+  int            fd    = open(fileName, O_RDONLY);
+  
+  if (fd == -1 || fstat(fd, &fStat) != 0)
+  {
+    printf("ERROR: Could not open input file '%s'\n", fileName);
+  }
+  else
+  {
+    map = malloc(sizeof(BGPSEC_IO_Map));
+    if (map != NULL)
+    {
+      memset(map, 0, sizeof(BGPSEC_IO_Map));
+      map->version = BGPSEC_IO_FILE_V1;
+      map->size    = fStat.st_size;
+      // An empty file can not be mapped but is valid.
+      valid = map->size == 0;
+      if (!valid)
+      {
+        // The mapping is private and writable, changes to the records made 
+        // while processing them do not reach the file. 
+        data = mmap(NULL, map->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 
+                    0);
+      }
+    }
+  }
+  if (fd != -1)
+  {
+    // The mapping stays valid after the file is closed.
+    close(fd);
+  }
+  
+  if (data != MAP_FAILED)
+  {
+    map->map = (u_int8_t*)data;
+    if (   map->size >= sizeof(BGPSEC_IO_IdxHeader)
+        && memcmp(map->map, BGPSEC_IO_IDX_MAGIC, BGPSEC_IO_IDX_MAGIC_LEN) == 0)
+    {
+      valid = _readIndex(map);
+    }
+    else
+    {
+      valid = _buildIndex(map);
+    }
+    madvise(map->map, map->size, MADV_SEQUENTIAL);
+  }
+  else if (map != NULL && !valid)
+  {
+    printf("ERROR: Could not map input file '%s'\n", fileName);
+  }
+  
+  if (!valid)
+  {
+    closeDataMap(map);
+    map = NULL;
+  }
+  
+  return map;
+}
+
+/**
+ * Release the index and unmap the file. All record pointers retrieved from 
+ * this map become invalid.
+ * 
+ * @param map The mapped file, can be NULL.
+ */
+void closeDataMap(BGPSEC_IO_Map* map)
+{
+  if (map != NULL)
+  {
+    if (map->version == BGPSEC_IO_FILE_V1)
+    {
+      // The index of version 2 files is part of the mapping
+      free(map->sessions);
+      free(map->offsets);
+    }
+    if (map->map != NULL)
+    {
+      munmap(map->map, map->size);
+    }
+    free(map);
+  }
+}
+
+/**
+ * Initialize the cursor. The records of the session (myAS, peerAS) are found
+ * using the index. Records of different sessions are returned grouped by 
+ * session.
+ * 
+ * @param cursor The cursor to be initialized.
+ * @param map The mapped file.
+ * @param myAS My own ASN or ignore myAS if myAS == 0. (use network format)
+ * @param peerAS if not 0 then filter the data for the given peer. If 0 load
+ *               the data for all peers. (use network format)
+ * @param type the type of data (update, attribute, all)
+ */
+void initDataCursor(BGPSEC_IO_Cursor* cursor, BGPSEC_IO_Map* map, 
+                    u_int32_t myAS, u_int32_t peerAS, u_int8_t type)
+{
+  BGPSEC_IO_IdxSession* session = NULL;
+  u_int32_t             low     = 0;
+  u_int32_t             high    = map->noSessions;
+  u_int32_t             mid     = 0;
+  int                   cmp     = 0;
+  
+  memset(cursor, 0, sizeof(BGPSEC_IO_Cursor));
+  cursor->map    = map;
+  cursor->myAS   = myAS;
+  cursor->peerAS = peerAS;
+  cursor->type   = type;
+  
+  if (myAS != 0 && peerAS != 0)
+  {
+    // Find the first session that is not smaller
+    while (low < high)
+    {
+      mid     = low + (high - low) / 2;
+      session = &map->sessions[mid];
+      cmp     = memcmp(&session->asn, &myAS, sizeof(u_int32_t));
+      if (cmp == 0)
+      {
+        cmp = memcmp(&session->peerAS, &peerAS, sizeof(u_int32_t));
+      }
+      if (cmp < 0)
+      {
+        low = mid + 1;
+      }
+      else
+      {
+        high = mid;
+      }
+    }
+    cursor->session = low;
+  }
+}
+
+/**
+ * Return the next matching record. The returned pointers point into the 
+ * mapping, the data can be used directly (e.g. as update to send).
+ * 
+ * @param cursor The cursor.
+ * @param record OUT - the record header.
+ * @param keys OUT - the keys (BGPSEC_IO_KRecord list of record->keyDataLength 
+ *             bytes) or NULL if the record does not contain keys.
+ * @param data OUT - The data (update or attribute) of record->dataLength bytes
+ * 
+ * @return true if a record was found, otherwise false.
+ */
+bool nextMappedData(BGPSEC_IO_Cursor* cursor, BGPSEC_IO_Record** record,
+                    u_int8_t** keys, u_int8_t** data)
+{
+  BGPSEC_IO_Map*        map     = cursor->map;
+  BGPSEC_IO_IdxSession* session = NULL;
+  BGPSEC_IO_Record*     rec     = NULL;
+  u_int64_t             offset  = 0;
+  
+  while (cursor->session < map->noSessions)
+  {
+    session = &map->sessions[cursor->session];
+    if (   (cursor->myAS == 0   || cursor->myAS == session->asn)
+        && (cursor->peerAS == 0 || cursor->peerAS == session->peerAS)
+        && (cursor->next < ntohl(session->count)))
+    {
+      offset = be64toh(map->offsets[ntohl(session->first) + cursor->next++]);
+      rec    = _getRecord(map, offset, NULL);
+      if (rec == NULL)
+      {
+        printf("ERROR: Invalid record at offset %llu!\n", 
+               (unsigned long long)offset);
+      }
+      else if ((rec->recordType & cursor->type) == rec->recordType)
+      {
+        *record = rec;
+        *keys   = (rec->keyDataLength != 0) ? (u_int8_t*)(rec + 1) : NULL;
+        *data   = (u_int8_t*)(rec + 1) + ntohs(rec->keyDataLength);
+        return true;
+      }
+    }
+    else if (cursor->myAS != 0 && cursor->peerAS != 0)
+    {
+      // The index contains each session only once.
+      cursor->session = map->noSessions;
+    }
+    else
+    {
+      cursor->session++;
+      cursor->next = 0;
+    }
+  }
+  
+  return false;
+}
+
+/**
+ * Write the records of the mapped file as version 1 file.
+ * 
+ * @param map The mapped file.
+ * @param file The file to write to.
+ * 
+ * @return false if a record could not be written.
+ */
+static bool _writeStream(BGPSEC_IO_Map* map, FILE* file)
+{
+  BGPSEC_IO_Record* record = NULL;
+  size_t            length = 0;
+  u_int32_t         idx    = 0;
+  
+  for (idx = 0; idx < map->noRecords; idx++)
+  {
+    record = _getRecord(map, be64toh(map->offsets[idx]), &length);
+    if (record == NULL || fwrite(record, 1, length, file) != length)
+    {
+      return false;
+    }
+  }
+  
+  return true;
+}
+
+/**
+ * Write the records of the mapped file as version 2 file.
+ * 
+ * @param map The mapped file.
+ * @param file The file to write to.
+ * 
+ * @return false if a record could not be written.
+ */
+static bool _writeIndexed(BGPSEC_IO_Map* map, FILE* file)
+{
+  static const u_int8_t padding[BGPSEC_IO_RECORD_ALIGN] = { 0 };
+  
+  BGPSEC_IO_IdxHeader header;
+  BGPSEC_IO_Record*   record  = NULL;
+  u_int64_t*          offsets = NULL;
+  u_int64_t           start   = sizeof(BGPSEC_IO_IdxHeader)
+                              + map->noSessions * sizeof(BGPSEC_IO_IdxSession)
+                              + map->noRecords * sizeof(u_int64_t);
+  u_int64_t           offset  = start;
+  size_t              length  = 0;
+  u_int32_t           idx     = 0;
+  bool                ok      = true;
+  
+  if (map->noRecords != 0)
+  {
+    offsets = malloc(map->noRecords * sizeof(u_int64_t));
+    if (offsets == NULL)
+    {
+      return false;
+    }
+  }
+  
+  // The sessions cover the offsets in order, they can be written as they are.
+  for (idx = 0; ok && idx < map->noRecords; idx++)
+  {
+    offset = roundup(offset, BGPSEC_IO_RECORD_ALIGN);
+    ok     = _getRecord(map, be64toh(map->offsets[idx]), &length) != NULL;
+    offsets[idx] = htobe64(offset);
+    offset += length;
+  }
+  
+  memset(&header, 0, sizeof(BGPSEC_IO_IdxHeader));
+  memcpy(header.magic, BGPSEC_IO_IDX_MAGIC, BGPSEC_IO_IDX_MAGIC_LEN);
+  header.version    = htons(BGPSEC_IO_FILE_V2);
+  header.noSessions = htonl(map->noSessions);
+  header.noRecords  = htonl(map->noRecords);
+  offset = start;
+  ok = ok && fwrite(&header, sizeof(BGPSEC_IO_IdxHeader), 1, file) == 1;
+  if (ok && map->noRecords != 0)
+  {
+    ok =    fwrite(map->sessions, sizeof(BGPSEC_IO_IdxSession), 
+                   map->noSessions, file) == map->noSessions
+         && fwrite(offsets, sizeof(u_int64_t), map->noRecords, file) 
+            == map->noRecords;
+  }
+  
+  for (idx = 0; ok && idx < map->noRecords; idx++)
+  {
+    length = be64toh(offsets[idx]) - offset;
+    ok     = fwrite(padding, 1, length, file) == length;
+    record = _getRecord(map, be64toh(map->offsets[idx]), &length);
+    ok     = ok && fwrite(record, 1, length, file) == length;
+    offset = be64toh(offsets[idx]) + length;
+  }
+  free(offsets);
+  
+  return ok;
+}
+
+/**
+ * Convert the given data file into the given format. The file is written
+ * under a temporary name and renamed. Nothing is done if the file does not 
+ * exist or has the requested format already. The conversion into version 2
+ * groups the records by session, within a session the order is kept.
+ * 
+ * @param fileName The data file.
+ * @param version The requested format (BGPSEC_IO_FILE_V1 or V2)
+ * 
+ * @return false if the file could not be converted.
+ */
+bool convertDataFile(const char* fileName, u_int8_t version)
+{
+  char           tmpFile[MAXPATHLEN];
+  BGPSEC_IO_Map* map  = NULL;
+  FILE*          file = NULL;
+  bool           ok   = false;
+  
+  if (access(fileName, F_OK) != 0)
+  {
+    return true;
+  }
+  map = openDataMap(fileName);
+  if (map == NULL)
+  {
+    return false;
+  }
+  if (map->version == version)
+  {
+    closeDataMap(map);
+    return true;
+  }
+  
+  snprintf(tmpFile, MAXPATHLEN, "%s.tmp", fileName);
+  file = fopen(tmpFile, "w");
+  if (file != NULL)
+  {
+    ok = (version == BGPSEC_IO_FILE_V2) ? _writeIndexed(map, file)
+                                        : _writeStream(map, file);
+    ok = (fclose(file) == 0) && ok;
+    ok = ok && rename(tmpFile, fileName) == 0;
+    if (!ok)
+    {
+      remove(tmpFile);
+    }
+  }
+  if (!ok)
+  {
+    printf("ERROR: Could not convert '%s' into version %u!\n", fileName, 
+           version);
+  }
+  closeDataMap(map);
+  
+  return ok;
+}
+
 /**
  * Store the given data to the file. The data will be stored as a byte stream
  * as is. Best is if the data contains data types to convert them into 
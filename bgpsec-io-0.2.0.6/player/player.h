@@ -23,6 +23,19 @@
  * This header file contains the data structure for the BGPSEC-IO player.
  * The player itself allows to write/read the data to and from a file.
  * 
+ * There are two file formats. Version 1 is a plain stream of records as written
+ * by storeData. Version 2 (indexed) starts with a header and an index by 
+ * session (asn, peerAS) followed by the records, each record starts on a 
+ * BGPSEC_IO_RECORD_ALIGN boundary. Both formats are read through a memory
+ * mapping (openDataMap), version 2 files are generated from version 1 files
+ * (convertDataFile). 
+ *
+ * Layout of version 2, all numbers in network format:
+ *   BGPSEC_IO_IdxHeader
+ *   BGPSEC_IO_IdxSession[noSessions] - sorted by asn and peerAS
+ *   u_int64_t[noRecords]             - record offsets, grouped by session
+ *   records                          - padded to BGPSEC_IO_RECORD_ALIGN
+ * 
  * @version 0.2.0.5
  * 
  * Changelog:
@@ -53,6 +66,17 @@
 #define BGPSEC_IO_TYPE_BGP_UPDATE   1
 #define BGPSEC_IO_TYPE_BGPSEC_ATTR  2
 
+/** File format: stream of records */
+#define BGPSEC_IO_FILE_V1           1
+/** File format: indexed records */
+#define BGPSEC_IO_FILE_V2           2
+/** The magic number at the start of an indexed file. */
+#define BGPSEC_IO_IDX_MAGIC         "BIOX"
+/** The length of the magic number. */
+#define BGPSEC_IO_IDX_MAGIC_LEN     4
+/** The alignment of the records within an indexed file. */
+#define BGPSEC_IO_RECORD_ALIGN      64
+
 typedef struct {
   /** The version of this record. */          
   u_int8_t  version;
@@ -112,6 +136,66 @@ typedef struct {
   BGPSecKey** keys;  
 } BGPSEC_IO_StoreData;
 
+/** The header of an indexed (version 2) file. */
+typedef struct {
+  /** BGPSEC_IO_IDX_MAGIC */
+  char      magic[BGPSEC_IO_IDX_MAGIC_LEN];
+  /** The file format, BGPSEC_IO_FILE_V2 */
+  u_int16_t version;
+  /** Reserved, must be 0. */
+  u_int16_t reserved;
+  /** The number of sessions in the index. */
+  u_int32_t noSessions;
+  /** The number of records in the file. */
+  u_int32_t noRecords;
+} __attribute__((packed)) BGPSEC_IO_IdxHeader;
+
+/** The index entry of one session (asn, peerAS) */
+typedef struct {
+  /** The ASN of the player session. */
+  u_int32_t asn;
+  /** The ASN of the players peer. */
+  u_int32_t peerAS;
+  /** The position of the first record offset of this session. */
+  u_int32_t first;
+  /** The number of records of this session. */
+  u_int32_t count;
+} __attribute__((packed)) BGPSEC_IO_IdxSession;
+
+/** A memory mapped data file of either format. */
+typedef struct {
+  /** The mapped file. */
+  u_int8_t*             map;
+  /** The size of the mapped file. */
+  size_t                size;
+  /** The file format. */
+  u_int8_t              version;
+  /** The number of sessions. */
+  u_int32_t             noSessions;
+  /** The sessions (network format), within the mapping for version 2. */
+  BGPSEC_IO_IdxSession* sessions;
+  /** The number of records. */
+  u_int32_t             noRecords;
+  /** The record offsets (network format), within the mapping for version 2.*/
+  u_int64_t*            offsets;
+} BGPSEC_IO_Map;
+
+/** Iterates over the records of a mapped file, see initDataCursor. */
+typedef struct {
+  /** The mapped file. */
+  BGPSEC_IO_Map* map;
+  /** My own ASN or 0 (network format). */
+  u_int32_t      myAS;
+  /** The peer AS or 0 (network format). */
+  u_int32_t      peerAS;
+  /** The type of data (update, attribute, all) */
+  u_int8_t       type;
+  /** The current session. */
+  u_int32_t      session;
+  /** The next record within the current session. */
+  u_int32_t      next;
+} BGPSEC_IO_Cursor;
+
 /** This struct is used to allow one parameter for functions rather than 
  * multiple when it comes to buffers. */
 typedef struct {
@@ -130,6 +214,7 @@ typedef struct {
  * Load the next record and return it. If the given buff(er) is not NULL and 
  * not of sufficient size, the record will NOT be loaded and NULL will be 
  * returned. in this case the file pointer will not be advanced.
+ * Only version 1 files can be read this way, see openDataMap.
  * 
  * @param file the file to be loaded.
  * @param myAS My own ASN or ignore myAS if myAS == 0. (use network format)
@@ -159,5 +244,67 @@ bool loadData(FILE* file, u_int32_t myAS, u_int32_t peerAS, u_int8_t type,
 bool storeData(FILE* file, u_int8_t type, u_int32_t asn, u_int32_t peerAS, 
                BGPSEC_IO_StoreData* data);
 
+/**
+ * Map the given data file into memory. Version 2 files use the stored index, 
+ * for version 1 files the index is build while scanning the records once. The
+ * records are not copied. 
+ * 
+ * @param fileName The data file.
+ * 
+ * @return The mapped file or NULL if it could not be mapped or is invalid.
+ */
+BGPSEC_IO_Map* openDataMap(const char* fileName);
+
+/**
+ * Release the index and unmap the file. All record pointers retrieved from 
+ * this map become invalid.
+ * 
+ * @param map The mapped file, can be NULL.
+ */
+void closeDataMap(BGPSEC_IO_Map* map);
+
+/**
+ * Initialize the cursor. The records of the session (myAS, peerAS) are found
+ * using the index. Records of different sessions are returned grouped by 
+ * session.
+ * 
+ * @param cursor The cursor to be initialized.
+ * @param map The mapped file.
+ * @param myAS My own ASN or ignore myAS if myAS == 0. (use network format)
+ * @param peerAS if not 0 then filter the data for the given peer. If 0 load
+ *               the data for all peers. (use network format)
+ * @param type the type of data (update, attribute, all)
+ */
+void initDataCursor(BGPSEC_IO_Cursor* cursor, BGPSEC_IO_Map* map, 
+                    u_int32_t myAS, u_int32_t peerAS, u_int8_t type);
+
+/**
+ * Return the next matching record. The returned pointers point into the 
+ * mapping, the data can be used directly (e.g. as update to send).
+ * 
+ * @param cursor The cursor.
+ * @param record OUT - the record header.
+ * @param keys OUT - the keys (BGPSEC_IO_KRecord list of record->keyDataLength 
+ *             bytes) or NULL if the record does not contain keys.
+ * @param data OUT - The data (update or attribute) of record->dataLength bytes
+ * 
+ * @return true if a record was found, otherwise false.
+ */
+bool nextMappedData(BGPSEC_IO_Cursor* cursor, BGPSEC_IO_Record** record,
+                    u_int8_t** keys, u_int8_t** data);
+
+/**
+ * Convert the given data file into the given format. The file is written
+ * under a temporary name and renamed. Nothing is done if the file does not 
+ * exist or has the requested format already. The conversion into version 2
+ * groups the records by session, within a session the order is kept.
+ * 
+ * @param fileName The data file.
+ * @param version The requested format (BGPSEC_IO_FILE_V1 or V2)
+ * 
+ * @return false if the file could not be converted.
+ */
+bool convertDataFile(const char* fileName, u_int8_t version);
+
 #endif	/* PLAYER_H */
 
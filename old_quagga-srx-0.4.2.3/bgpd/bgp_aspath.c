@@ -329,9 +329,21 @@ aspath_free (struct aspath *aspath)
     assegment_free_all (aspath->segments);
   if (aspath->str)
     XFREE (MTYPE_AS_STR, aspath->str);
+  if (aspath->memo)
+    XFREE (MTYPE_AS_PATH_MEMO, aspath->memo);
   XFREE (MTYPE_AS_PATH, aspath);
 }
 
+/* Return the access-list memo of the AS path, ASPATH_MEMO_SIZE entries. */
+struct aspath_memo *
+aspath_memo_get (struct aspath *aspath)
+{
+  if (! aspath->memo)
+    aspath->memo = XCALLOC (MTYPE_AS_PATH_MEMO,
+                            ASPATH_MEMO_SIZE * sizeof (struct aspath_memo));
+  return aspath->memo;
+}
+
 /* Unintern aspath from AS path bucket. */
 void
 aspath_unintern (struct aspath **aspath)
@@ -609,6 +621,9 @@ aspath_str_update (struct aspath *as)
 {
   if (as->str)
     XFREE (MTYPE_AS_STR, as->str);
+  /* The path changed, so did the access-list results. */
+  if (as->memo)
+    XFREE (MTYPE_AS_PATH_MEMO, as->memo);
   aspath_make_str_count (as);
 }
 
@@ -680,6 +695,7 @@ aspath_hash_alloc (void *arg)
   new->segments = aspath->segments;
   new->str = aspath->str;
   new->str_len = aspath->str_len;
+  new->memo = NULL;
 
   return new;
 }
@@ -843,6 +859,49 @@ aspath_parse (struct stream *s, size_t length, int use32bit)
   return find;
 }
 
+/* Same as aspath_parse() for an AS path that is a single AS_SEQUENCE
+   of the num ASNs in asns, e.g. the path carried by a BGPsec_Path
+   attribute.  The sequence is split into segments of at most
+   AS_SEGMENT_MAX ASNs. */
+struct aspath *
+aspath_parse_asns (const as_t *asns, int num)
+{
+  struct aspath as;
+  struct aspath *find;
+  struct assegment *seg, *prev = NULL;
+  int length;
+
+  memset (&as, 0, sizeof (struct aspath));
+  while (num > 0)
+    {
+      length = MIN (num, AS_SEGMENT_MAX);
+      seg = assegment_new (AS_SEQUENCE, length);
+      memcpy (seg->as, asns, ASSEGMENT_DATA_SIZE (length, 1));
+
+      if (prev)
+        prev->next = seg;
+      else
+        as.segments = seg;
+      prev = seg;
+
+      asns += length;
+      num -= length;
+    }
+
+  find = hash_get (ashash, &as, aspath_hash_alloc);
+  assert (find);
+
+  if (find->refcnt)
+    {
+      assegment_free_all (as.segments);
+      XFREE (MTYPE_AS_STR, as.str);
+    }
+
+  find->refcnt++;
+
+  return find;
+}
+
 static void
 assegment_data_put (struct stream *s, as_t *as, int num, int use32bit)
 {
@@ -1921,6 +1980,7 @@ void
 aspath_init (void)
 {
   ashash = hash_create_size (32767, aspath_key_make, aspath_cmp);
+  hash_set_name (ashash, "BGP AS-Path");
 }
 
 void
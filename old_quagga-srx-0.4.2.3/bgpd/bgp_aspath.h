@@ -59,14 +59,29 @@ struct aspath
      and AS path regular expression match.  */
   char *str;
   unsigned short str_len;
+
+  /* Results of the AS path access-lists applied to this path, allocated
+     on first use.  See as_list_apply().  */
+  struct aspath_memo *memo;
 };
 
 #define ASPATH_STR_DEFAULT_LEN 32
 
+/* Memoized AS path access-list results, see as_list_apply(). */
+#define ASPATH_MEMO_SIZE 4
+
+struct aspath_memo
+{
+  const void *list;
+  unsigned int generation;
+  int result;
+};
+
 /* Prototypes. */
 extern void aspath_init (void);
 extern void aspath_finish (void);
 extern struct aspath *aspath_parse (struct stream *, size_t, int);
+extern struct aspath *aspath_parse_asns (const as_t *, int);
 extern struct aspath *aspath_dup (struct aspath *);
 extern struct aspath *aspath_aggregate (struct aspath *, struct aspath *);
 extern struct aspath *aspath_prepend (struct aspath *, struct aspath *);
@@ -81,6 +96,7 @@ extern struct aspath *aspath_empty (void);
 extern struct aspath *aspath_empty_get (void);
 extern struct aspath *aspath_str2aspath (const char *);
 extern void aspath_free (struct aspath *);
+extern struct aspath_memo *aspath_memo_get (struct aspath *);
 extern struct aspath *aspath_intern (struct aspath *);
 extern void aspath_unintern (struct aspath **);
 extern const char *aspath_print (struct aspath *);
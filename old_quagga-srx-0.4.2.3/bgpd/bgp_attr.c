@@ -207,6 +207,7 @@ static void
 cluster_init (void)
 {
   cluster_hash = hash_create (cluster_hash_key_make, cluster_hash_cmp);
+  hash_set_name (cluster_hash, "BGP Cluster List");
 }
 
 static void
@@ -283,6 +284,7 @@ static void
 transit_init (void)
 {
   transit_hash = hash_create (transit_hash_key_make, transit_hash_cmp);
+  hash_set_name (transit_hash, "BGP Transitive Attributes");
 }
 
 static void
@@ -334,12 +336,11 @@ bgp_attr_dup (struct attr *new, struct attr *orig)
   if (BGP_DEBUG (bgpsec, BGPSEC_DETAIL))
     if(orig->bgpsecPathAttr)
     {
-      zlog_debug("[BGPSEC] [%s] orig[%p]->bgpsecPathAttr:%p seg:%p AS:%d", \
+      zlog_debug("[BGPSEC] [%s] orig[%p]->bgpsecPathAttr:%p AS:%u", \
           __FUNCTION__, orig, orig->bgpsecPathAttr, \
-          orig->bgpsecPathAttr->pathSegments, orig->bgpsecPathAttr->pathSegments->as);
-      zlog_debug("[BGPSEC] [%s] new[%p]->bgpsecPathAttr:%p seg:%p",\
-          __FUNCTION__, new, new->bgpsecPathAttr, \
-          new->bgpsecPathAttr?new->bgpsecPathAttr->pathSegments:0);
+          bgpsec_path_segment_as (orig->bgpsecPathAttr, 0));
+      zlog_debug("[BGPSEC] [%s] new[%p]->bgpsecPathAttr:%p",\
+          __FUNCTION__, new, new->bgpsecPathAttr);
     }
 #endif
 
@@ -429,7 +430,7 @@ attrhash_key_make (void *p)
   /* only if bgpsec enabled case */
   if (attr->flag & ATTR_FLAG_BIT (BGP_ATTR_BGPSEC))
   {
-    if(bpa && bpa->pathSegments && bpa->sigBlocks && bpa->sigBlocks->sigSegments)
+    if (bpa)
       MIX(bgpsec_path_attr_key_make(bpa));
   }
 #endif /* USE_SRX */
@@ -484,6 +485,7 @@ static void
 attrhash_init (void)
 {
   attrhash = hash_create (attrhash_key_make, attrhash_cmp);
+  hash_set_name (attrhash, "BGP Attributes");
 }
 
 static void
@@ -585,8 +587,9 @@ bgp_attr_intern (struct attr *attr)
       attr->bgpsecPathAttr->refcnt++;
 
     if (BGP_DEBUG (bgpsec, BGPSEC_DETAIL))
-      zlog_debug("[BGPSEC] changed or dereferenced attr[%p]->bgpsecPath_Attr:%p AS:%d", \
-          attr, attr->bgpsecPathAttr, attr->bgpsecPathAttr->pathSegments->as);
+      zlog_debug("[BGPSEC] changed or dereferenced attr[%p]->bgpsecPath_Attr:%p AS:%u", \
+          attr, attr->bgpsecPathAttr, \
+          bgpsec_path_segment_as (attr->bgpsecPathAttr, 0));
   }
 #endif
 
@@ -596,8 +599,9 @@ bgp_attr_intern (struct attr *attr)
 #ifdef USE_SRX
   if (BGP_DEBUG (bgpsec, BGPSEC))
     if (find->bgpsecPathAttr) \
-      zlog_debug("[BGPSEC] AFTER find(attrhash...): attr[%p]->bgpsecPath_Attr:%p PathSeg:%p AS:%d",\
-          find, find->bgpsecPathAttr, find->bgpsecPathAttr->pathSegments, find->bgpsecPathAttr->pathSegments->as );
+      zlog_debug("[BGPSEC] AFTER find(attrhash...): attr[%p]->bgpsecPath_Attr:%p AS:%u",\
+          find, find->bgpsecPathAttr, \
+          bgpsec_path_segment_as (find->bgpsecPathAttr, 0));
 #endif
     return find;
 }
@@ -718,17 +722,11 @@ bgp_attr_unintern_sub (struct attr *attr)
       if (attr->extra->transit)
         transit_unintern (attr->extra->transit);
     }
-#ifdef USE_SRX__
+#ifdef USE_SRX
+  /* Same as for the aspath, the parser and bgp_attr_intern each hold a
+     reference. */
   if (attr->bgpsecPathAttr && (attr->flag & ATTR_FLAG_BIT (BGP_ATTR_BGPSEC)) )
-  {
-    struct BgpsecPathAttr *bpa = attr->bgpsecPathAttr;
-    if(bpa)
-    {
-      if(bpa->pathSegments && bpa->sigBlocks)
-        if(bpa->sigBlocks->sigSegments)
-          bgpsec_path_unintern(&bpa);
-    }
-  }
+    bgpsec_path_unintern (&attr->bgpsecPathAttr);
 #endif
 
 }
@@ -1793,77 +1791,49 @@ bgp_attr_unknown (struct bgp_attr_parser_args *args)
 
 #ifdef USE_SRX
 
+/* Number of AS numbers srx_convert_to_aspath() collects on the stack. */
+#define BGPSEC_ASPATH_STACK 64
+
 /**
  * This function generates the quagga internal as path attribute out of the
- * given BgpsecPathAttr structure.
+ * given BgpsecPathAttr structure. Each Secure_Path segment contributes its
+ * AS pCount times.
  *
- * @param attr the attribute.
- * @param peer the peer for this attribute.
+ * @param bpa the BGPSEC path attribute.
 
- * @return the aspath or NULL
+ * @return the interned aspath
  */
-static struct aspath * srx_convert_to_aspath(struct attr* attr, struct peer* peer)
+static struct aspath * srx_convert_to_aspath(struct BgpsecPathAttr* bpa)
 {
-  // @NOTE: The conversion can be easily done using the wired bgpsec
-  // path attribute. But it works, that's what counts for now.
-
-  // @TODO: Somehow I would like to use BgpsecPathAttr as parameter but the
-  // compiler complains it can't find it even though it is in one of the include
-  // files. There might be some circular dependencies in the includes that is
-  // playing a trick here. For now I will use the attr structure but hopefully
-  // this can be resolved soon.
-
-  // This code was initially part of bgp_attr_bgpsec and out-sourced here
-  // for clarity and re-usability.
+  as_t buf[BGPSEC_ASPATH_STACK];
+  as_t *asns = buf;
   struct aspath* retVal = NULL;
+  int num = 0, idx, pcnt;
 
-  struct PathSegment *ps = attr->bgpsecPathAttr->pathSegments;
-  struct PathSegment *tmpPs = ps;
-  size_t pcntTot = 0, pcnt=0;
-
-  /* calcuation of total pCount and aspath */
-  while(tmpPs)
+  for (idx = 0; idx < bpa->numSegments; idx++)
   {
-    pcntTot += tmpPs->pCount;
-    tmpPs = tmpPs->next;
+    num += bgpsec_path_segment_pcount(bpa, idx);
   }
-
-  // *4(AS octet length), +2(attr type 1 octet & attr length 1 octet)
-  size_t streamLen = MAX( ((attr->bgpsecPathAttr->securePathLen -2) /6)*4 +2, \
-                            pcntTot *4 +2);
-  struct stream *tmpStream = stream_new(streamLen);
-  u_short iter = (streamLen -2) /4;
-
-  stream_putc(tmpStream, BGP_ATTR_AS_PATH); // type
-  stream_putc(tmpStream, iter); // length
-
-  while(ps && iter--)
+  if (num > BGPSEC_ASPATH_STACK)
   {
-    pcnt = ps->pCount;
-    while(pcnt--)
-    {
-      stream_putl(tmpStream, ps->as);
-    }
-    ps = ps->next;
+    asns = XMALLOC (MTYPE_TMP, num * sizeof (as_t));
   }
 
-  if (BGP_DEBUG(as4, AS4_SEGMENT))
+  num = 0;
+  for (idx = 0; idx < bpa->numSegments; idx++)
   {
-    zlog_debug("[AS4SEG] dump the maden stream for aspath parse ");
-    unsigned int i;
-    for(i=0; i< streamLen; i++)
+    for (pcnt = bgpsec_path_segment_pcount(bpa, idx); pcnt > 0; pcnt--)
     {
-      printf("%02x ", tmpStream->data[i]);
-      if( (i+1) %16==0)  printf("\n");
+      asns[num++] = bgpsec_path_segment_as(bpa, idx);
     }
-    printf(" -- from [%s] \n", __FUNCTION__);
   }
 
-  /* call aspath_parse() here with the manipulated parameters */
-  retVal = aspath_parse (tmpStream, streamLen,
-                         CHECK_FLAG (peer->cap, PEER_CAP_AS4_RCV));
+  retVal = aspath_parse_asns (asns, num);
 
-  stream_free(tmpStream);
+  if (asns != buf)
+  {
+    XFREE (MTYPE_TMP, asns);
+  }
 
   return retVal;
 }
@@ -1997,18 +1967,22 @@ static bgp_attr_parse_ret_t bgp_attr_bgpsec(struct bgp_attr_parser_args *args)
   }
   stream_get(ptr, peer->ibuf, length);
 
-  // Create a fresh stream for the BgpsecPathAttr generation.
-  struct stream* str = stream_new(length);
-  stream_put(str, ptr, length);
+  // The attribute is checked in place in the validation data and only copied
+  // once more if it is not interned already.
+  struct BgpsecPathAttr bpa;
 
+  if (bgpsec_path_parse(&bpa, ptr, length) == BGPSEC_SUCCESS)
+  {
+    attr->bgpsecPathAttr = bgpsec_path_intern(&bpa);
+    attr->flag |= ATTR_FLAG_BIT (BGP_ATTR_BGPSEC);
+  }
   ptr = NULL;
 
-  attr->bgpsecPathAttr = bgpsec_parse(attr, peer, str, length);
-
   if (attr->bgpsecPathAttr == NULL)
   {
     // We encounteres a parsing error, remove all data.
-    zlog_err(/*peer->log,*/ "BGPSEC Path Update MUST NOT contain AS_PATH!!");
+    zlog_err(/*peer->log,*/ "[BGPSEC] Malformed BGPSEC path attribute from %s",
+             peer->host);
     if(valdata->nlri)
     {
       memset (valdata->nlri, 0, sizeof(SCA_Prefix));
@@ -2024,7 +1998,7 @@ static bgp_attr_parse_ret_t bgp_attr_bgpsec(struct bgp_attr_parser_args *args)
   }
 
   // Generate the BGP4 AS_PATH
-  attr->aspath = srx_convert_to_aspath(attr, peer);
+  attr->aspath = srx_convert_to_aspath(attr->bgpsecPathAttr);
   /* Add the aspath attribute flag. */
   attr->flag |= ATTR_FLAG_BIT (BGP_ATTR_AS_PATH);
 
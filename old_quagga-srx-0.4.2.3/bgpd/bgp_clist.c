@@ -345,7 +345,7 @@ community_regexp_match (struct community *com, regex_t * reg)
     str = community_str (com);
 
   /* Regular expression match.  */
-  if (regexec (reg, str, 0, NULL, 0) == 0)
+  if (bgp_regexec_str (reg, str) == 0)
     return 1;
 
   /* No match.  */
@@ -365,7 +365,7 @@ ecommunity_regexp_match (struct ecommunity *ecom, regex_t * reg)
     str = ecommunity_str (ecom);
 
   /* Regular expression match.  */
-  if (regexec (reg, str, 0, NULL, 0) == 0)
+  if (bgp_regexec_str (reg, str) == 0)
     return 1;
 
   /* No match.  */
@@ -412,7 +412,7 @@ community_regexp_delete (struct community *com, regex_t * reg)
           break;
         }
 
-      if (regexec (reg, str, 0, NULL, 0) == 0)
+      if (bgp_regexec_str (reg, str) == 0)
         community_del_val (com, com_nthval (com, i));
       else
         i++;
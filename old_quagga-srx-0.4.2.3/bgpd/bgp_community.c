@@ -639,6 +639,7 @@ community_init (void)
 {
   comhash = hash_create ((unsigned int (*) (void *))community_hash_make,
 			 (int (*) (const void *, const void *))community_cmp);
+  hash_set_name (comhash, "BGP Community");
 }
 
 void
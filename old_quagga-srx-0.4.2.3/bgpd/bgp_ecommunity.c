@@ -270,6 +270,7 @@ void
 ecommunity_init (void)
 {
   ecomhash = hash_create (ecommunity_hash_make, ecommunity_cmp);
+  hash_set_name (ecomhash, "BGP Extended Community");
 }
 
 void
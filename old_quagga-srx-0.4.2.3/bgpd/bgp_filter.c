@@ -95,6 +95,10 @@ static struct as_list_master as_list_master =
   NULL
 };
 
+/* Bumped on every change of an AS path access-list, invalidates the
+   results memoized on the AS paths by as_list_apply(). */
+static unsigned int as_list_generation = 1;
+
 /* Allocate new AS filter. */
 static struct as_filter *
 as_filter_new (void)
@@ -150,6 +154,8 @@ as_list_filter_add (struct as_list *aslist, struct as_filter *asfilter)
   else
     aslist->head = asfilter;
   aslist->tail = asfilter;
+
+  as_list_generation++;
 }
 
 /* Lookup as_list from list of as_list by name. */
@@ -336,6 +342,8 @@ as_list_delete (struct as_list *aslist)
     list->head = aslist->next;
 
   as_list_free (aslist);
+
+  as_list_generation++;
 }
 
 static int
@@ -362,6 +370,8 @@ as_list_filter_delete (struct as_list *aslist, struct as_filter *asfilter)
 
   as_filter_free (asfilter);
 
+  as_list_generation++;
+
   /* If access_list becomes empty delete it from access_master. */
   if (as_list_empty (aslist))
     as_list_delete (aslist);
@@ -385,18 +395,35 @@ as_list_apply (struct as_list *aslist, void *object)
 {
   struct as_filter *asfilter;
   struct aspath *aspath;
+  struct aspath_memo *memo;
+  enum as_filter_type type = AS_FILTER_DENY;
 
   aspath = (struct aspath *) object;
 
   if (aslist == NULL)
     return AS_FILTER_DENY;
 
+  /* The same interned path is shared by many routes, the result is kept
+     on the path until any AS path access-list changes. */
+  memo = aspath_memo_get (aspath);
+  memo += ((uintptr_t) aslist / sizeof (struct as_list)) % ASPATH_MEMO_SIZE;
+  if (memo->list == aslist && memo->generation == as_list_generation)
+    return memo->result;
+
   for (asfilter = aslist->head; asfilter; asfilter = asfilter->next)
     {
       if (as_filter_match (asfilter, aspath))
-	return asfilter->type;
+	{
+	  type = asfilter->type;
+	  break;
+	}
     }
-  return AS_FILTER_DENY;
+
+  memo->list = aslist;
+  memo->generation = as_list_generation;
+  memo->result = type;
+
+  return type;
 }
 
 /* Add hook function. */
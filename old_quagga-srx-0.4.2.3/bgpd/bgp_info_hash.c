@@ -53,35 +53,41 @@ static int show_info_hash (struct vty* vty, struct bgp* bgp,
 {
   static const char RES_CODE_CHAR[] = { 'v', 'n', 'i', '?' };
 
-  struct bgp_info_hash_item* curr;
+  struct bgp_info* info;
   char pbuf[INET6_ADDRSTRLEN];
   struct attr* attr;
   int valState;
+  uint32_t idx;
   
-  if (HASH_COUNT (hash->table) == 0)
+  if (hash->count == 0)
   {
     vty_out (vty, "   (No entries)%s%s", VTY_NEWLINE, VTY_NEWLINE);
     return 0;
   }
 
   vty_out (vty, SHOW_HEADER, VTY_NEWLINE);
-  for (curr = hash->table; curr != NULL; curr = curr->hh.next)
+  for (idx = 0; idx < hash->size; idx++)
   {
-    valState = srx_calc_validation_state(bgp, curr->info);
+    if (hash->keys[idx] == 0)
+    {
+      continue;
+    }
+    info = hash->infos[idx];
+    valState = srx_calc_validation_state(bgp, info);
     vty_out (vty, "   %c(%c%c) %08X ", 
         RES_CODE_CHAR[valState],             
-        RES_CODE_CHAR[curr->info->val_res_ROA],
-        RES_CODE_CHAR[curr->info->val_res_BGPSEC],
-        curr->identifier);
+        RES_CODE_CHAR[info->val_res_ROA],
+        RES_CODE_CHAR[info->val_res_BGPSEC],
+        hash->keys[idx]);
 
     /* Node - identified by its prefix */
-    if (curr->info->node)
+    if (info->node)
     {
       vty_out (vty, "%15s/%-2d  ",
-               inet_ntop (curr->info->node->p.family, 
-                          &curr->info->node->p.u.prefix, 
+               inet_ntop (info->node->p.family, 
+                          &info->node->p.u.prefix, 
                           pbuf, INET6_ADDRSTRLEN),
-        curr->info->node->p.prefixlen);
+        info->node->p.prefixlen);
     }
     else
     {
@@ -89,7 +95,7 @@ static int show_info_hash (struct vty* vty, struct bgp* bgp,
     }
 
     /* Ignore flag */
-    if (CHECK_FLAG (curr->info->flags, BGP_INFO_IGNORE))
+    if (CHECK_FLAG (info->flags, BGP_INFO_IGNORE))
     {
       vty_out (vty, "x ");
     }
@@ -98,7 +104,7 @@ static int show_info_hash (struct vty* vty, struct bgp* bgp,
       vty_out (vty, "  ");
     }
 
-    attr = curr->info->attr;
+    attr = info->attr;
 
     /* Local-preference and adjustment */
     if (attr->flag & ATTR_FLAG_BIT (BGP_ATTR_LOCAL_PREF))
@@ -189,29 +195,247 @@ void bgp_all_info_hashes_init (void)
 // install_element (VIEW_NODE, &show_bgp_info_hashes_cmd);
 }
 
-struct bgp_info_hash* bgp_info_hash_init (void)
+/**
+ * Return the home slot of the given identifier. Local identifiers are
+ * sequential, therefore the identifier is spread using a multiplicative
+ * (Fibonacci) hash of which the upper bits are used.
+ *
+ * @param hash The info hash
+ * @param identifier The identifier
+ *
+ * @return the home slot of the identifier
+ */
+static inline uint32_t _bgp_info_hash_home (struct bgp_info_hash* hash,
+                                            uint32_t identifier)
+{
+  return (uint32_t)(identifier * 2654435769U) >> hash->shift;
+}
+
+/**
+ * Return the distance of the given slot from the home slot of its identifier.
+ *
+ * @param hash The info hash
+ * @param slot The slot to be checked, MUST be in use.
+ *
+ * @return the probe distance of the slot.
+ */
+static inline uint32_t _bgp_info_hash_dist (struct bgp_info_hash* hash,
+                                            uint32_t slot)
+{
+  return (slot - _bgp_info_hash_home (hash, hash->keys[slot]))
+         & (hash->size - 1);
+}
+
+/**
+ * Allocate the slot arrays of the given size.
+ *
+ * @param hash The info hash
+ * @param size The number of slots, MUST be a power of two.
+ *
+ * @return 1 if the slots could be allocated, otherwise 0.
+ */
+static int _bgp_info_hash_alloc (struct bgp_info_hash* hash, uint32_t size)
+{
+  hash->keys  = XCALLOC (MTYPE_BGP_INFO_HASH_ITEM, size * sizeof (uint32_t));
+  hash->infos = XCALLOC (MTYPE_BGP_INFO_HASH_ITEM,
+                         size * sizeof (struct bgp_info*));
+  if (hash->keys == NULL || hash->infos == NULL)
+  {
+    if (hash->keys)
+    {
+      XFREE (MTYPE_BGP_INFO_HASH_ITEM, hash->keys);
+    }
+    if (hash->infos)
+    {
+      XFREE (MTYPE_BGP_INFO_HASH_ITEM, hash->infos);
+    }
+    return 0;
+  }
+  hash->size  = size;
+  hash->count = 0;
+  for (hash->shift = 32; size > 1; size >>= 1)
+  {
+    hash->shift--;
+  }
+  return 1;
+}
+
+/**
+ * Store the identifier in the hash. If the identifier is already known the
+ * info will be replaced. The caller MUST make sure the hash has a free slot.
+ *
+ * @param hash The info hash
+ * @param info The info to be stored
+ * @param identifier The identifier of the info, MUST NOT be 0.
+ *
+ * @return 1 if the identifier was added, 0 if it was known already.
+ */
+static int _bgp_info_hash_put (struct bgp_info_hash* hash,
+                               struct bgp_info* info, uint32_t identifier)
+{
+  uint32_t mask = hash->size - 1;
+  uint32_t slot = _bgp_info_hash_home (hash, identifier);
+  uint32_t dist = 0;
+  uint32_t slotDist;
+  uint32_t tmpKey;
+  struct bgp_info* tmpInfo;
+
+  while (hash->keys[slot] != 0)
+  {
+    if (hash->keys[slot] == identifier)
+    {
+      hash->infos[slot] = info;
+      return 0;
+    }
+    // Robin Hood: take the slot from entries closer to their home slot.
+    slotDist = _bgp_info_hash_dist (hash, slot);
+    if (slotDist < dist)
+    {
+      tmpKey  = hash->keys[slot];
+      tmpInfo = hash->infos[slot];
+      hash->keys[slot]  = identifier;
+      hash->infos[slot] = info;
+      identifier = tmpKey;
+      info       = tmpInfo;
+      dist       = slotDist;
+    }
+    slot = (slot + 1) & mask;
+    dist++;
+  }
+
+  hash->keys[slot]  = identifier;
+  hash->infos[slot] = info;
+  hash->count++;
+
+  return 1;
+}
+
+/**
+ * Find the slot of the given identifier.
+ *
+ * @param hash The info hash
+ * @param identifier The identifier to look for.
+ *
+ * @return the slot or hash->size if the identifier is not known.
+ */
+static uint32_t _bgp_info_hash_find (struct bgp_info_hash* hash,
+                                     uint32_t identifier)
+{
+  uint32_t mask = hash->size - 1;
+  uint32_t slot = _bgp_info_hash_home (hash, identifier);
+  uint32_t dist = 0;
+
+  while (hash->keys[slot] != 0)
+  {
+    if (hash->keys[slot] == identifier)
+    {
+      return slot;
+    }
+    // All entries with this home slot are placed before this one.
+    if (_bgp_info_hash_dist (hash, slot) < dist)
+    {
+      break;
+    }
+    slot = (slot + 1) & mask;
+    dist++;
+  }
+
+  return hash->size;
+}
+
+/**
+ * Move all entries into a new slot array of the given size.
+ *
+ * @param hash The info hash
+ * @param size The new number of slots, MUST be a power of two.
+ *
+ * @return 1 if the hash was resized, otherwise 0.
+ */
+static int _bgp_info_hash_resize (struct bgp_info_hash* hash, uint32_t size)
+{
+  uint32_t* oldKeys  = hash->keys;
+  struct bgp_info** oldInfos = hash->infos;
+  uint32_t  oldSize  = hash->size;
+  uint32_t  idx;
+
+  if (!_bgp_info_hash_alloc (hash, size))
+  {
+    hash->keys  = oldKeys;
+    hash->infos = oldInfos;
+    zlog_err ("Not enough memory to resize info hash to %u slots", size);
+    return 0;
+  }
+
+  for (idx = 0; idx < oldSize; idx++)
+  {
+    if (oldKeys[idx] != 0)
+    {
+      _bgp_info_hash_put (hash, oldInfos[idx], oldKeys[idx]);
+    }
+  }
+
+  XFREE (MTYPE_BGP_INFO_HASH_ITEM, oldKeys);
+  XFREE (MTYPE_BGP_INFO_HASH_ITEM, oldInfos);
+
+  return 1;
+}
+
+/**
+ * Create a new info hash that can store the given number of identifiers
+ * without being resized.
+ *
+ * @param expected The expected number of identifiers, e.g. the number of
+ *                 routes in the RIB.
+ *
+ * @return the new info hash or NULL.
+ */
+struct bgp_info_hash* bgp_info_hash_init (uint32_t expected)
 {
   struct bgp_info_hash* new;
-  
+  uint32_t size = BGP_INFO_HASH_MIN_SIZE;
+
+  while (BGP_INFO_HASH_MAX_LOAD (size) < expected && size < 0x80000000U)
+  {
+    size <<= 1;
+  }
+
   new = XCALLOC(MTYPE_BGP_INFO_HASH, sizeof(struct bgp_info_hash));
   if (new)
   {
-    new->table = NULL;
+    if (!_bgp_info_hash_alloc (new, size))
+    {
+      XFREE (MTYPE_BGP_INFO_HASH, new);
+      new = NULL;
+    }
   }
   return new;
 }
 
-void bgp_info_hash_finish (struct bgp_info_hash** hash)
+/**
+ * Make sure the hash can store the given number of identifiers without
+ * being resized again.
+ *
+ * @param hash The info hash
+ * @param expected The expected number of identifiers.
+ */
+void bgp_info_hash_reserve (struct bgp_info_hash* hash, uint32_t expected)
 {
-  struct bgp_info_hash_item* curr;
+  uint32_t size = hash->size;
 
-  while ((*hash)->table)
+  while (BGP_INFO_HASH_MAX_LOAD (size) < expected && size < 0x80000000U)
   {
-    curr = (*hash)->table;
-    HASH_DEL ((*hash)->table, curr);
-    XFREE (MTYPE_BGP_INFO_HASH_ITEM, curr);
+    size <<= 1;
   }
+  if (size != hash->size)
+  {
+    _bgp_info_hash_resize (hash, size);
+  }
+}
 
+void bgp_info_hash_finish (struct bgp_info_hash** hash)
+{
+  XFREE (MTYPE_BGP_INFO_HASH_ITEM, (*hash)->keys);
+  XFREE (MTYPE_BGP_INFO_HASH_ITEM, (*hash)->infos);
   XFREE (MTYPE_BGP_INFO_HASH, *hash);
   *hash = NULL;
 }
@@ -233,24 +457,19 @@ int bgp_info_register (struct bgp_info_hash* hash, struct bgp_info* info,
     return 0;
   }
   
-  struct bgp_info_hash_item *new;
-  
-  /* Add to the hash */
-  new = XCALLOC (MTYPE_BGP_INFO_HASH_ITEM, sizeof(struct bgp_info_hash_item));
-  if (new == NULL) 
+  if (hash->count >= BGP_INFO_HASH_MAX_LOAD (hash->size))
   {
-    zlog_err("Not enough memory to store update [0x%80X]", identifier);
-    return -1;
+    if (!_bgp_info_hash_resize (hash, hash->size << 1)
+        && hash->count == hash->size - 1)
+    {
+      zlog_err("Not enough memory to store update [0x%08X]", identifier);
+      return -1;
+    }
   }
 
-  new->identifier = identifier;
-  new->info       = info;
-
-  HASH_ADD(hh, hash->table, identifier, sizeof(uint32_t), new);
-
   info->info_hash = hash;
 
-  return 1;
+  return _bgp_info_hash_put (hash, info, identifier);
 }
 
 /**
@@ -261,14 +480,27 @@ int bgp_info_register (struct bgp_info_hash* hash, struct bgp_info* info,
  */
 void bgp_info_unregister(struct bgp_info_hash* hash, uint32_t identifier)
 {
-  struct bgp_info_hash_item* entry;
+  uint32_t mask = hash->size - 1;
+  uint32_t slot = _bgp_info_hash_find (hash, identifier);
+  uint32_t next;
+
+  if (slot == hash->size)
+  {
+    return;
+  }
 
-  HASH_FIND(hh, hash->table, &identifier, sizeof(uint32_t), entry);
-  if (entry)
+  // Shift the following entries back until one is in its home slot.
+  next = (slot + 1) & mask;
+  while (hash->keys[next] != 0 && _bgp_info_hash_dist (hash, next) != 0)
   {
-    HASH_DEL(hash->table, entry);
-    XFREE(MTYPE_BGP_INFO_HASH, entry);
+    hash->keys[slot]  = hash->keys[next];
+    hash->infos[slot] = hash->infos[next];
+    slot = next;
+    next = (next + 1) & mask;
   }
+  hash->keys[slot]  = 0;
+  hash->infos[slot] = NULL;
+  hash->count--;
 }
 
 /**
@@ -282,22 +514,15 @@ void bgp_info_unregister(struct bgp_info_hash* hash, uint32_t identifier)
 struct bgp_info* bgp_info_fetch (struct bgp_info_hash* hash, 
                                  uint32_t identifier)
 {
-  struct bgp_info_hash_item* entry;
-  
-  HASH_FIND (hh, hash->table, &identifier, sizeof(uint32_t), entry);
+  uint32_t slot;
 
-  if(entry) 
+  if (identifier == 0)
   {
-    for( entry= hash->table; entry!=NULL; 
-         entry=(struct bgp_info_hash_item*)(entry->hh.next))
-    {
-      if (entry->identifier == identifier)
-      {
-        return entry->info;
-      }
-    }
+    return NULL;
   }
-  return NULL;
+
+  slot = _bgp_info_hash_find (hash, identifier);
+  return slot != hash->size ? hash->infos[slot] : NULL;
 }
 
 #endif /* USE_SRX */
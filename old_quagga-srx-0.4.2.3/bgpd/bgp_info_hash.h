@@ -36,24 +36,36 @@
 
 #ifdef USE_SRX
 
-#include <uthash.h>
-
-struct bgp_info_hash_item {
-  uint32_t        identifier;
-  struct bgp_info *info;
-  UT_hash_handle  hh;
-};
-
+/**
+ * Flat open addressing index (Robin Hood hashing) that maps the 32 bit
+ * update / local identifier to the bgp_info. Keys and values are stored in
+ * two parallel arrays, the identifier 0 marks an empty slot. Deletion uses
+ * backward shifting, no tombstones are needed.
+ */
 struct bgp_info_hash {
-  struct bgp_info_hash_item *table;
+  /* The identifiers, 0 = empty slot. */
+  uint32_t         *keys;
+  /* The bgp_info of the identifier in the same slot. */
+  struct bgp_info **infos;
+  /* Number of slots, always a power of two. */
+  uint32_t          size;
+  /* 32 - log2(size), selects the upper bits of the hash value. */
+  uint32_t          shift;
+  /* Number of used slots. */
+  uint32_t          count;
 };
 
+/* Minimum number of slots of an index. */
+#define BGP_INFO_HASH_MIN_SIZE    1024
+/* Grow the index once more than 7/8 of the slots are used. */
+#define BGP_INFO_HASH_MAX_LOAD(S) ((S) - ((S) >> 3))
 
 /* Install VTY commands - call only once */
 extern void bgp_all_info_hashes_init (void);
 
 /* Create and destroy a info hash */
-extern struct bgp_info_hash* bgp_info_hash_init (void);
+extern struct bgp_info_hash* bgp_info_hash_init (uint32_t);
+extern void bgp_info_hash_reserve (struct bgp_info_hash *, uint32_t);
 extern void bgp_info_hash_finish (struct bgp_info_hash **);
 
 /* Access the hash */
@@ -581,6 +581,7 @@ bgp_address_init (void)
 {
   bgp_address_hash = hash_create (bgp_address_hash_key_make,
                                   bgp_address_hash_cmp);
+  hash_set_name (bgp_address_hash, "BGP Address");
 }
 
 static void
@@ -28,6 +28,692 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "bgp_aspath.h"
 #include "bgp_regex.h"
 
+/* Compiled matcher.
+
+   Most AS path and community expressions only use a small subset of the
+   POSIX extended syntax: literals, bracket expressions, `.', anchors,
+   groups, alternation and the `*', `+' and `?' repetitions.  Such an
+   expression is translated into a Thompson NFA which is run as a lazily
+   built DFA, one table lookup per input character.  AS paths are fed
+   straight from their segment ASN arrays, generating the characters of
+   aspath->str on the fly, so an expression keeps exactly the meaning it
+   has with regexec().
+
+   Anything else (intervals, character classes, back references, ...) is
+   left to regexec(), as is an expression whose DFA grows beyond
+   BGP_DFA_MAX_STATES states. */
+
+#define BGP_NFA_MAX_NODES   1024
+#define BGP_DFA_MAX_STATES  256
+
+enum bgp_nfa_type
+{
+  BGP_NFA_CHAR,
+  BGP_NFA_SPLIT,
+  BGP_NFA_EMPTY,
+  BGP_NFA_BOL,
+  BGP_NFA_EOL,
+  BGP_NFA_MATCH
+};
+
+struct bgp_nfa_node
+{
+  u_char type;
+  int out1;
+  int out2;
+
+  /* Accepted characters of a BGP_NFA_CHAR node. */
+  u_char set[32];
+};
+
+struct bgp_dfa_state
+{
+  /* NFA nodes of this state, one bit per node. */
+  u_int32_t *set;
+
+  /* Next state for each character class, -1 if not built yet. */
+  int *next;
+
+  /* The input is accepted as soon as this state is reached. */
+  u_char match;
+
+  /* The input is accepted if it ends in this state. */
+  u_char match_at_end;
+};
+
+struct bgp_dfa
+{
+  struct bgp_nfa_node *nodes;
+  int nnodes;
+  int size;
+  int start;
+  int final;
+
+  /* Characters no NFA node can tell apart share one class. */
+  u_char class[256];
+  u_char class_char[256];
+  int nclasses;
+
+  /* State 0 is the initial state.  It is never shared with the states
+     reached after the first character, `^' only holds in there. */
+  struct bgp_dfa_state *states;
+  int nstates;
+  int words;
+
+  /* The state budget is exhausted, regexec() is used from now on. */
+  int overflow;
+
+  /* Scratch space of bgp_dfa_closure(). */
+  int *stack;
+  u_int32_t *visited;
+  u_int32_t *work;
+};
+
+struct bgp_regex
+{
+  /* Must be first, bgp_regcomp() hands out a pointer to it. */
+  regex_t reg;
+
+  /* NULL if the expression is not supported by the compiled matcher. */
+  struct bgp_dfa *dfa;
+};
+
+struct bgp_nfa_frag
+{
+  int start;
+  int end;
+};
+
+struct bgp_nfa_parser
+{
+  struct bgp_dfa *dfa;
+  const u_char *p;
+  int error;
+};
+
+#define BGP_DFA_TEST(S,N)   ((S)[(N) >> 5] & (1U << ((N) & 31)))
+#define BGP_DFA_SET(S,N)    ((S)[(N) >> 5] |= (1U << ((N) & 31)))
+#define BGP_NFA_TEST(S,C)   ((S)[(C) >> 3] & (1 << ((C) & 7)))
+#define BGP_NFA_SET(S,C)    ((S)[(C) >> 3] |= (1 << ((C) & 7)))
+
+static struct bgp_nfa_frag bgp_nfa_alt (struct bgp_nfa_parser *);
+
+/* Allocate a new NFA node.  Nodes are addressed by index, the node
+   array moves when it grows. */
+static int
+bgp_nfa_node (struct bgp_nfa_parser *ps, u_char type)
+{
+  struct bgp_dfa *dfa = ps->dfa;
+  struct bgp_nfa_node *node;
+
+  if (ps->error)
+    return 0;
+  if (dfa->nnodes == BGP_NFA_MAX_NODES)
+    {
+      ps->error = 1;
+      return 0;
+    }
+  if (dfa->nnodes == dfa->size)
+    {
+      dfa->size = dfa->size ? dfa->size * 2 : 16;
+      dfa->nodes = XREALLOC (MTYPE_BGP_REGEXP_DFA, dfa->nodes,
+                             dfa->size * sizeof (struct bgp_nfa_node));
+    }
+  node = &dfa->nodes[dfa->nnodes];
+  memset (node, 0, sizeof (struct bgp_nfa_node));
+  node->type = type;
+  node->out1 = -1;
+  node->out2 = -1;
+
+  return dfa->nnodes++;
+}
+
+static struct bgp_nfa_frag
+bgp_nfa_single (struct bgp_nfa_parser *ps, u_char type)
+{
+  struct bgp_nfa_frag f;
+
+  f.start = f.end = bgp_nfa_node (ps, type);
+  return f;
+}
+
+/* Bracket expression, ranges and negation only. */
+static struct bgp_nfa_frag
+bgp_nfa_bracket (struct bgp_nfa_parser *ps)
+{
+  struct bgp_nfa_frag f;
+  u_char set[32];
+  int negate = 0;
+  int first = 1;
+  int lo, hi, c;
+
+  memset (set, 0, sizeof (set));
+  f = bgp_nfa_single (ps, BGP_NFA_CHAR);
+
+  ps->p++;
+  if (*ps->p == '^')
+    {
+      negate = 1;
+      ps->p++;
+    }
+
+  for (;;)
+    {
+      lo = *ps->p;
+      if (lo == ']' && ! first)
+	{
+	  ps->p++;
+	  break;
+	}
+      /* Backslash has a different meaning for the GNU and PCRE
+         libraries, leave it to them as the collating elements and
+         character classes. */
+      if (lo == '\0' || lo == '\\'
+	  || (lo == '[' && (ps->p[1] == ':' || ps->p[1] == '.'
+	                    || ps->p[1] == '=')))
+	{
+	  ps->error = 1;
+	  return f;
+	}
+      first = 0;
+      hi = lo;
+      ps->p++;
+
+      if (ps->p[0] == '-' && ps->p[1] != ']' && ps->p[1] != '\0')
+	{
+	  hi = ps->p[1];
+	  if (hi == '\\' || hi == '[' || hi < lo)
+	    {
+	      ps->error = 1;
+	      return f;
+	    }
+	  ps->p += 2;
+	}
+
+      for (c = lo; c <= hi; c++)
+	BGP_NFA_SET (set, c);
+    }
+
+  if (negate)
+    for (c = 0; c < 32; c++)
+      set[c] = ~set[c];
+  /* The input never contains NUL. */
+  set[0] &= ~1;
+
+  if (! ps->error)
+    memcpy (ps->dfa->nodes[f.start].set, set, sizeof (set));
+  return f;
+}
+
+static struct bgp_nfa_frag
+bgp_nfa_atom (struct bgp_nfa_parser *ps, int *anchor)
+{
+  struct bgp_nfa_frag f;
+  int c = *ps->p;
+
+  *anchor = 0;
+  switch (c)
+    {
+    case '(':
+      ps->p++;
+      f = bgp_nfa_alt (ps);
+      if (*ps->p != ')')
+	ps->error = 1;
+      else
+	ps->p++;
+      return f;
+    case '[':
+      return bgp_nfa_bracket (ps);
+    case '.':
+      ps->p++;
+      f = bgp_nfa_single (ps, BGP_NFA_CHAR);
+      if (! ps->error)
+	{
+	  memset (ps->dfa->nodes[f.start].set, 0xff, 32);
+	  ps->dfa->nodes[f.start].set[0] &= ~1;
+	}
+      return f;
+    case '^':
+    case '$':
+      ps->p++;
+      *anchor = 1;
+      return bgp_nfa_single (ps, c == '^' ? BGP_NFA_BOL : BGP_NFA_EOL);
+    case '\\':
+      c = ps->p[1];
+      if (c == '\0' || isalnum (c))
+	ps->error = 1;
+      else
+	ps->p += 2;
+      break;
+    case ')':
+    case '|':
+    case '*':
+    case '+':
+    case '?':
+    case '{':
+    case '\0':
+      ps->error = 1;
+      break;
+    default:
+      ps->p++;
+      break;
+    }
+
+  f = bgp_nfa_single (ps, BGP_NFA_CHAR);
+  if (! ps->error)
+    BGP_NFA_SET (ps->dfa->nodes[f.start].set, c);
+  return f;
+}
+
+static struct bgp_nfa_frag
+bgp_nfa_repeat (struct bgp_nfa_parser *ps)
+{
+  struct bgp_nfa_frag f;
+  struct bgp_nfa_node *nodes;
+  int anchor;
+  int split, end;
+
+  f = bgp_nfa_atom (ps, &anchor);
+
+  while (! ps->error
+	 && (*ps->p == '*' || *ps->p == '+' || *ps->p == '?'))
+    {
+      if (anchor)
+	{
+	  ps->error = 1;
+	  break;
+	}
+      split = bgp_nfa_node (ps, BGP_NFA_SPLIT);
+      end = bgp_nfa_node (ps, BGP_NFA_EMPTY);
+      if (ps->error)
+	break;
+
+      nodes = ps->dfa->nodes;
+      nodes[split].out1 = f.start;
+      nodes[split].out2 = end;
+      switch (*ps->p)
+	{
+	case '*':
+	  nodes[f.end].out1 = split;
+	  f.start = split;
+	  break;
+	case '+':
+	  nodes[f.end].out1 = split;
+	  break;
+	case '?':
+	  nodes[f.end].out1 = end;
+	  f.start = split;
+	  break;
+	}
+      f.end = end;
+      ps->p++;
+    }
+
+  /* Intervals are left to regexec(). */
+  if (*ps->p == '{')
+    ps->error = 1;
+
+  return f;
+}
+
+static struct bgp_nfa_frag
+bgp_nfa_concat (struct bgp_nfa_parser *ps)
+{
+  struct bgp_nfa_frag f, g;
+
+  f = bgp_nfa_single (ps, BGP_NFA_EMPTY);
+
+  while (! ps->error
+	 && *ps->p != '\0' && *ps->p != '|' && *ps->p != ')')
+    {
+      g = bgp_nfa_repeat (ps);
+      if (ps->error)
+	break;
+      ps->dfa->nodes[f.end].out1 = g.start;
+      f.end = g.end;
+    }
+  return f;
+}
+
+static struct bgp_nfa_frag
+bgp_nfa_alt (struct bgp_nfa_parser *ps)
+{
+  struct bgp_nfa_frag f, g;
+  int split, end;
+
+  f = bgp_nfa_concat (ps);
+
+  while (! ps->error && *ps->p == '|')
+    {
+      ps->p++;
+      g = bgp_nfa_concat (ps);
+      split = bgp_nfa_node (ps, BGP_NFA_SPLIT);
+      end = bgp_nfa_node (ps, BGP_NFA_EMPTY);
+      if (ps->error)
+	break;
+
+      ps->dfa->nodes[split].out1 = f.start;
+      ps->dfa->nodes[split].out2 = g.start;
+      ps->dfa->nodes[f.end].out1 = end;
+      ps->dfa->nodes[g.end].out1 = end;
+      f.start = split;
+      f.end = end;
+    }
+  return f;
+}
+
+static void
+bgp_dfa_free (struct bgp_dfa *dfa)
+{
+  int i;
+
+  for (i = 0; i < dfa->nstates; i++)
+    {
+      XFREE (MTYPE_BGP_REGEXP_DFA, dfa->states[i].set);
+      XFREE (MTYPE_BGP_REGEXP_DFA, dfa->states[i].next);
+    }
+  if (dfa->states)
+    XFREE (MTYPE_BGP_REGEXP_DFA, dfa->states);
+  if (dfa->nodes)
+    XFREE (MTYPE_BGP_REGEXP_DFA, dfa->nodes);
+  if (dfa->stack)
+    XFREE (MTYPE_BGP_REGEXP_DFA, dfa->stack);
+  if (dfa->visited)
+    XFREE (MTYPE_BGP_REGEXP_DFA, dfa->visited);
+  if (dfa->work)
+    XFREE (MTYPE_BGP_REGEXP_DFA, dfa->work);
+  XFREE (MTYPE_BGP_REGEXP_DFA, dfa);
+}
+
+/* Add the epsilon closure of NODE to dfa->work.  Only the nodes which
+   consume a character, the pending `$' assertions and the final node are
+   kept. */
+static void
+bgp_dfa_closure (struct bgp_dfa *dfa, int node, int at_start, int at_end)
+{
+  struct bgp_nfa_node *n;
+  int sp = 0;
+
+#define BGP_DFA_PUSH(N)                                         \
+  do {                                                          \
+    if ((N) >= 0 && ! BGP_DFA_TEST (dfa->visited, (N)))         \
+      {                                                         \
+        BGP_DFA_SET (dfa->visited, (N));                        \
+        dfa->stack[sp++] = (N);                                 \
+      }                                                         \
+  } while (0)
+
+  BGP_DFA_PUSH (node);
+  while (sp > 0)
+    {
+      node = dfa->stack[--sp];
+      n = &dfa->nodes[node];
+
+      switch (n->type)
+	{
+	case BGP_NFA_CHAR:
+	case BGP_NFA_MATCH:
+	  BGP_DFA_SET (dfa->work, node);
+	  continue;
+	case BGP_NFA_EOL:
+	  if (! at_end)
+	    {
+	      BGP_DFA_SET (dfa->work, node);
+	      continue;
+	    }
+	  break;
+	case BGP_NFA_BOL:
+	  if (! at_start)
+	    continue;
+	  break;
+	case BGP_NFA_SPLIT:
+	  BGP_DFA_PUSH (n->out2);
+	  break;
+	}
+      BGP_DFA_PUSH (n->out1);
+    }
+#undef BGP_DFA_PUSH
+}
+
+/* Look up the state for the node set in dfa->work, create it if it does
+   not exist yet.  Returns -1 when the state budget is exhausted. */
+static int
+bgp_dfa_state (struct bgp_dfa *dfa, int initial)
+{
+  struct bgp_dfa_state *state;
+  size_t len = dfa->words * sizeof (u_int32_t);
+  int i;
+
+  if (! initial)
+    for (i = 1; i < dfa->nstates; i++)
+      if (memcmp (dfa->states[i].set, dfa->work, len) == 0)
+	return i;
+
+  if (dfa->nstates == BGP_DFA_MAX_STATES)
+    {
+      dfa->overflow = 1;
+      return -1;
+    }
+
+  state = &dfa->states[dfa->nstates];
+  state->set = XMALLOC (MTYPE_BGP_REGEXP_DFA, len);
+  memcpy (state->set, dfa->work, len);
+  state->next = XMALLOC (MTYPE_BGP_REGEXP_DFA, dfa->nclasses * sizeof (int));
+  for (i = 0; i < dfa->nclasses; i++)
+    state->next[i] = -1;
+  state->match = BGP_DFA_TEST (state->set, dfa->final) ? 1 : 0;
+
+  /* At the end of the input the pending `$' assertions hold. */
+  memset (dfa->work, 0, len);
+  memset (dfa->visited, 0, len);
+  for (i = 0; i < dfa->nnodes; i++)
+    if (BGP_DFA_TEST (state->set, i) && dfa->nodes[i].type == BGP_NFA_EOL)
+      bgp_dfa_closure (dfa, i, initial, 1);
+  state->match_at_end = state->match
+                        || BGP_DFA_TEST (dfa->work, dfa->final) ? 1 : 0;
+
+  return dfa->nstates++;
+}
+
+/* Build the transition of state FROM for character class K. */
+static int
+bgp_dfa_build (struct bgp_dfa *dfa, int from, int k)
+{
+  struct bgp_dfa_state *state = &dfa->states[from];
+  size_t len = dfa->words * sizeof (u_int32_t);
+  int c = dfa->class_char[k];
+  int i, next;
+
+  memset (dfa->work, 0, len);
+  memset (dfa->visited, 0, len);
+  for (i = 0; i < dfa->nnodes; i++)
+    if (BGP_DFA_TEST (state->set, i)
+	&& dfa->nodes[i].type == BGP_NFA_CHAR
+	&& BGP_NFA_TEST (dfa->nodes[i].set, c))
+      bgp_dfa_closure (dfa, dfa->nodes[i].out1, 0, 0);
+
+  /* Same as regexec(), a match may start at any position. */
+  bgp_dfa_closure (dfa, dfa->start, 0, 0);
+
+  next = bgp_dfa_state (dfa, 0);
+  if (next >= 0)
+    state->next[k] = next;
+  return next;
+}
+
+static struct bgp_dfa *
+bgp_dfa_compile (const char *str)
+{
+  struct bgp_nfa_parser ps;
+  struct bgp_nfa_frag f;
+  struct bgp_nfa_node *n;
+  struct bgp_dfa *dfa;
+  int c, k, i;
+
+  dfa = XCALLOC (MTYPE_BGP_REGEXP_DFA, sizeof (struct bgp_dfa));
+
+  ps.dfa = dfa;
+  ps.p = (const u_char *) str;
+  ps.error = 0;
+
+  f = bgp_nfa_alt (&ps);
+  if (*ps.p != '\0')
+    ps.error = 1;
+  dfa->final = bgp_nfa_node (&ps, BGP_NFA_MATCH);
+  if (ps.error)
+    {
+      bgp_dfa_free (dfa);
+      return NULL;
+    }
+  dfa->nodes[f.end].out1 = dfa->final;
+  dfa->start = f.start;
+
+  /* Group the characters into classes. */
+  for (c = 0; c < 256; c++)
+    {
+      for (k = 0; k < dfa->nclasses; k++)
+	{
+	  for (i = 0; i < dfa->nnodes; i++)
+	    {
+	      n = &dfa->nodes[i];
+	      if (n->type == BGP_NFA_CHAR
+		  && ! BGP_NFA_TEST (n->set, c)
+		     != ! BGP_NFA_TEST (n->set, dfa->class_char[k]))
+		break;
+	    }
+	  if (i == dfa->nnodes)
+	    break;
+	}
+      if (k == dfa->nclasses)
+	dfa->class_char[dfa->nclasses++] = c;
+      dfa->class[c] = k;
+    }
+
+  dfa->words = (dfa->nnodes + 31) / 32;
+  dfa->stack = XMALLOC (MTYPE_BGP_REGEXP_DFA, dfa->nnodes * sizeof (int));
+  dfa->visited = XMALLOC (MTYPE_BGP_REGEXP_DFA,
+                          dfa->words * sizeof (u_int32_t));
+  dfa->work = XMALLOC (MTYPE_BGP_REGEXP_DFA, dfa->words * sizeof (u_int32_t));
+  dfa->states = XCALLOC (MTYPE_BGP_REGEXP_DFA,
+                         BGP_DFA_MAX_STATES * sizeof (struct bgp_dfa_state));
+
+  memset (dfa->work, 0, dfa->words * sizeof (u_int32_t));
+  memset (dfa->visited, 0, dfa->words * sizeof (u_int32_t));
+  bgp_dfa_closure (dfa, dfa->start, 1, 0);
+  bgp_dfa_state (dfa, 1);
+
+  return dfa;
+}
+
+/* Advance by one character.  Returns 1 when the input is accepted, -1
+   when the DFA overflows and 0 otherwise. */
+static inline int
+bgp_dfa_feed (struct bgp_dfa *dfa, int *state, u_char c)
+{
+  int k = dfa->class[c];
+  int next = dfa->states[*state].next[k];
+
+  if (next < 0)
+    {
+      next = bgp_dfa_build (dfa, *state, k);
+      if (next < 0)
+	return -1;
+    }
+  *state = next;
+  return dfa->states[next].match;
+}
+
+static int
+bgp_dfa_exec_str (struct bgp_dfa *dfa, const char *str)
+{
+  int state = 0;
+  int ret;
+
+  if (dfa->states[0].match)
+    return 1;
+
+  for (; *str; str++)
+    if ((ret = bgp_dfa_feed (dfa, &state, *str)) != 0)
+      return ret;
+
+  return dfa->states[state].match_at_end;
+}
+
+/* Match the AS path without its string form, in the format of
+   aspath_make_str_count(). */
+static int
+bgp_dfa_exec_aspath (struct bgp_dfa *dfa, struct aspath *aspath)
+{
+  struct assegment *seg;
+  char digits[10];
+  char seperator, start, end;
+  as_t asn;
+  int state = 0;
+  int ret, i, n;
+
+#define BGP_DFA_FEED(C)                                                 \
+  do {                                                                  \
+    if ((ret = bgp_dfa_feed (dfa, &state, (C))) != 0)                   \
+      return ret;                                                       \
+  } while (0)
+
+  if (dfa->states[0].match)
+    return 1;
+
+  for (seg = aspath->segments; seg; seg = seg->next)
+    {
+      switch (seg->type)
+	{
+	case AS_SEQUENCE:
+	  seperator = ' ';
+	  start = end = '\0';
+	  break;
+	case AS_CONFED_SEQUENCE:
+	  seperator = ' ';
+	  start = '(';
+	  end = ')';
+	  break;
+	case AS_SET:
+	  seperator = ',';
+	  start = '{';
+	  end = '}';
+	  break;
+	case AS_CONFED_SET:
+	  seperator = ',';
+	  start = '[';
+	  end = ']';
+	  break;
+	default:
+	  return -1;
+	}
+
+      if (start)
+	BGP_DFA_FEED (start);
+      for (i = 0; i < seg->length; i++)
+	{
+	  if (i > 0)
+	    BGP_DFA_FEED (seperator);
+	  asn = seg->as[i];
+	  n = 0;
+	  do
+	    {
+	      digits[n++] = '0' + asn % 10;
+	      asn /= 10;
+	    }
+	  while (asn);
+	  while (n > 0)
+	    BGP_DFA_FEED (digits[--n]);
+	}
+      if (end)
+	BGP_DFA_FEED (end);
+      if (seg->next)
+	BGP_DFA_FEED (' ');
+    }
+#undef BGP_DFA_FEED
+
+  return dfa->states[state].match_at_end;
+}
+
 /* Character `_' has special mean.  It represents [,{}() ] and the
    beginning of the line(^) and the end of the line ($).  
 
@@ -43,7 +729,7 @@ bgp_regcomp (const char *regstr)
   char *magic_str;
   char magic_regexp[] = "(^|[,{}() ]|$)";
   int ret;
-  regex_t *regex;
+  struct bgp_regex *regex;
 
   len = strlen (regstr);
   for (i = 0; i < len; i++)
@@ -64,30 +750,62 @@ bgp_regcomp (const char *regstr)
     }
   magic_str[j] = '\0';
 
-  regex = XMALLOC (MTYPE_BGP_REGEXP, sizeof (regex_t));
+  regex = XCALLOC (MTYPE_BGP_REGEXP, sizeof (struct bgp_regex));
 
-  ret = regcomp (regex, magic_str, REG_EXTENDED|REG_NOSUB);
-
-  XFREE (MTYPE_TMP, magic_str);
+  ret = regcomp (&regex->reg, magic_str, REG_EXTENDED|REG_NOSUB);
 
   if (ret != 0)
     {
+      XFREE (MTYPE_TMP, magic_str);
       XFREE (MTYPE_BGP_REGEXP, regex);
       return NULL;
     }
 
-  return regex;
+  regex->dfa = bgp_dfa_compile (magic_str);
+
+  XFREE (MTYPE_TMP, magic_str);
+
+  return &regex->reg;
 }
 
 int
 bgp_regexec (regex_t *regex, struct aspath *aspath)
 {
+  struct bgp_regex *bregex = (struct bgp_regex *) regex;
+  int ret;
+
+  if (bregex->dfa && ! bregex->dfa->overflow)
+    {
+      ret = bgp_dfa_exec_aspath (bregex->dfa, aspath);
+      if (ret >= 0)
+	return ret ? 0 : REG_NOMATCH;
+    }
   return regexec (regex, aspath->str, 0, NULL, 0);
 }
 
+/* Same as bgp_regexec() for a string, such as the community lists. */
+int
+bgp_regexec_str (regex_t *regex, const char *str)
+{
+  struct bgp_regex *bregex = (struct bgp_regex *) regex;
+  int ret;
+
+  if (bregex->dfa && ! bregex->dfa->overflow)
+    {
+      ret = bgp_dfa_exec_str (bregex->dfa, str);
+      if (ret >= 0)
+	return ret ? 0 : REG_NOMATCH;
+    }
+  return regexec (regex, str, 0, NULL, 0);
+}
+
 void
 bgp_regex_free (regex_t *regex)
 {
+  struct bgp_regex *bregex = (struct bgp_regex *) regex;
+
+  if (bregex->dfa)
+    bgp_dfa_free (bregex->dfa);
   regfree (regex);
-  XFREE (MTYPE_BGP_REGEXP, regex);
+  XFREE (MTYPE_BGP_REGEXP, bregex);
 }
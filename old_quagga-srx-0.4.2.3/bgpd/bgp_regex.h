@@ -36,5 +36,6 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 extern void bgp_regex_free (regex_t *regex);
 extern regex_t *bgp_regcomp (const char *str);
 extern int bgp_regexec (regex_t *regex, struct aspath *aspath);
+extern int bgp_regexec_str (regex_t *regex, const char *str);
 
 #endif /* _QUAGGA_BGP_REGEX_H */
@@ -319,15 +319,14 @@ void threadControlCall(int type)
     if(type == COM_ERR_PROXY_UNKNOWN && rq->clientFD != 0)
     {
       // Never will happen because this error is never send!!!
-      FD_CLR (rq->clientFD, &bm->master->readfd);
-      zlog_debug (" FD_CLR called for avoiding select() error" );
+      thread_suspend_read (bm->master, rq->clientFD);
+      zlog_debug (" Stop polling the proxy fd for avoiding select() error" );
     }
     else if(type == COM_ERR_PROXY_COULD_NOT_SEND)
     {
-      if( FD_ISSET(rq->clientFD, &bm->master->readfd) )
+      if (thread_suspend_read (bm->master, rq->clientFD))
       {
-        FD_CLR (rq->clientFD, &bm->master->readfd);
-        zlog_debug (" FD_CLR called for avoiding select() error" );
+        zlog_debug (" Stop polling the proxy fd for avoiding select() error" );
       }
       return;
     }
@@ -803,36 +802,340 @@ void srx_bgp_requeue_update(struct bgp_info *info)
 }
 
 /**
- * Requeue all updates associated with this router. this method is used for the
- * terminal command "srx apply-policy"
+ * Return the name of the given walk type as used in log and vty output.
  *
- * @param The bgp router
+ * @param type The walk type
+ *
+ * @return the name of the walk.
  */
-void srx_bgp_requeue_all(struct bgp *bgp)
+const char* srx_bgp_walk_name(SRxWalkType type)
+{
+  return type == SRX_WALK_SYNCH ? "synchronization" : "apply-policy";
+}
+
+/**
+ * Release the resume point held by the given walk.
+ *
+ * @param walk The RIB walk.
+ */
+static void _srx_bgp_walk_release(struct srx_walk* walk)
+{
+  if (walk->rn != NULL)
+  {
+    bgp_unlock_node (walk->rn);
+    walk->rn = NULL;
+  }
+  if (walk->prn != NULL)
+  {
+    bgp_unlock_node (walk->prn);
+    walk->prn = NULL;
+  }
+}
+
+/**
+ * Move the walk to the first node of the next table. For SAFI_MPLS_VPN the
+ * tables are stored per route distinguisher, in this case the walk continues
+ * with the next route distinguisher before it moves on to the next AFI/SAFI.
+ *
+ * @param walk The RIB walk.
+ *
+ * @return the locked first node of the next non empty table or NULL if all
+ *         tables are processed.
+ */
+static struct bgp_node* _srx_bgp_walk_next_table(struct srx_walk* walk)
 {
   struct bgp_table* table;
-  struct bgp_node *bnode;
+  struct bgp_node*  rn;
 
-  if (bgp != NULL)
+  while (walk->afi < AFI_MAX)
   {
-    table = bgp->rib[AFI_IP][SAFI_MULTICAST];
-    for (bnode = bgp_table_top(table); bnode; bnode = bgp_route_next(bnode))
+    table = walk->bgp->rib[walk->afi][walk->safi];
+    if (table != NULL && walk->safi == SAFI_MPLS_VPN)
+    {
+      // Continue with the next route distinguisher that has a table.
+      walk->prn = walk->inTable ? (walk->prn ? bgp_route_next (walk->prn)
+                                             : NULL)
+                                : bgp_table_top (table);
+      walk->inTable = 1;
+      while (walk->prn != NULL && walk->prn->info == NULL)
+      {
+        walk->prn = bgp_route_next (walk->prn);
+      }
+      if (walk->prn != NULL)
+      {
+        rn = bgp_table_top ((struct bgp_table*)walk->prn->info);
+        if (rn != NULL)
+        {
+          return rn;
+        }
+        continue;
+      }
+    }
+    else if (table != NULL && !walk->inTable)
     {
-      if (bnode->info != NULL)
+      walk->inTable = 1;
+      rn = bgp_table_top (table);
+      if (rn != NULL)
       {
-        srx_bgp_requeue_update(bnode->info);
+        return rn;
       }
     }
 
-    table = bgp->rib[AFI_IP][SAFI_UNICAST];
-    for (bnode = bgp_table_top(table); bnode; bnode = bgp_route_next(bnode))
+    // This AFI/SAFI is done
+    walk->inTable = 0;
+    if (++walk->safi == SAFI_MAX)
+    {
+      walk->safi = SAFI_UNICAST;
+      walk->afi++;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * Process all paths of the given node. A synchronization walk sends a
+ * validation request for each path, an apply-policy walk hands the node over
+ * to the best path selection.
+ *
+ * @param walk The RIB walk.
+ * @param rn The node to be processed.
+ */
+static void _srx_bgp_walk_node(struct srx_walk* walk, struct bgp_node* rn)
+{
+  struct bgp_info*  binfo;
+  SRxDefaultResult  defResult;
+  unsigned long     paths = 0;
+
+  for (binfo = rn->info; binfo; binfo = binfo->next)
+  {
+    if (CHECK_FLAG (binfo->flags, BGP_INFO_REMOVED))
+    {
+      continue;
+    }
+    paths++;
+    if (walk->type == SRX_WALK_SYNCH)
+    {
+      defResult.resSourceROA        = SRxRS_ROUTER;
+      defResult.resSourceBGPSEC     = SRxRS_ROUTER;
+      defResult.result.roaResult    = binfo->val_res_ROA;
+      defResult.result.bgpsecResult = binfo->val_res_BGPSEC;
+      verify_update (walk->bgp, binfo, &defResult, false);
+    }
+  }
+
+  if (paths > 0)
+  {
+    walk->nodes++;
+    walk->paths += paths;
+    if (walk->type == SRX_WALK_REQUEUE)
+    {
+      bgp_process (walk->bgp, rn, walk->afi, walk->safi);
+    }
+  }
+}
+
+/**
+ * Work queue function of the SRx walk queue. Processes up to srx_walk_batch
+ * nodes and then requeues the walk with a locked resume point. This keeps
+ * bgpd responsive while large tables are synchronized with srx-server.
+ *
+ * @param wq The walk queue
+ * @param data The RIB walk
+ *
+ * @return WQ_REQUEUE if the walk is not finished yet, otherwise WQ_SUCCESS.
+ */
+static wq_item_status srx_bgp_walk_process(struct work_queue *wq, void *data)
+{
+  struct srx_walk* walk  = (struct srx_walk*)data;
+  struct bgp_node* rn    = walk->rn;
+  u_int32_t        count = 0;
+
+  walk->cycles++;
+
+  // Without connection the synchronization is useless. srx-server will
+  // request it again once the connection is re-established.
+  if (walk->type == SRX_WALK_SYNCH && !isConnected (walk->bgp->srxProxy))
+  {
+    zlog_info ("SRx %s aborted, srx-server not connected!",
+               srx_bgp_walk_name (walk->type));
+    return WQ_SUCCESS;
+  }
+
+  walk->rn = NULL;
+  if (rn == NULL)
+  {
+    rn = _srx_bgp_walk_next_table (walk);
+  }
+
+  while (rn != NULL)
+  {
+    if (count == walk->bgp->srx_walk_batch)
     {
-      if (bnode->info != NULL)
+      // Keep the lock, the walk continues with this node in the next cycle
+      walk->rn = rn;
+      return WQ_REQUEUE;
+    }
+    _srx_bgp_walk_node (walk, rn);
+    count++;
+
+    rn = bgp_route_next (rn);
+    if (rn == NULL)
+    {
+      rn = _srx_bgp_walk_next_table (walk);
+    }
+  }
+
+  walk->finished = bgp_clock ();
+  zlog_info ("SRx %s of %lu paths in %lu nodes completed in %lu cycles!",
+             srx_bgp_walk_name (walk->type), walk->paths, walk->nodes,
+             walk->cycles);
+  return WQ_SUCCESS;
+}
+
+/**
+ * Called by the walk queue when the walk is removed from the queue.
+ *
+ * @param wq The walk queue
+ * @param data The RIB walk
+ */
+static void srx_bgp_walk_del(struct work_queue *wq, void *data)
+{
+  struct srx_walk* walk = (struct srx_walk*)data;
+
+  _srx_bgp_walk_release (walk);
+  walk->active = 0;
+  bgp_unlock (walk->bgp);
+}
+
+/**
+ * Return the number of paths received from all peers of this router, summed
+ * over all address families. Locally originated paths are not counted, the
+ * info hashes grow beyond this number if needed.
+ *
+ * @param bgp The bgp router
+ *
+ * @return the number of received paths.
+ */
+unsigned long srx_bgp_path_count(struct bgp *bgp)
+{
+  unsigned long count = 0;
+  struct listnode *node, *nnode;
+  struct peer *peer;
+  afi_t  afi;
+  safi_t safi;
+
+  for (ALL_LIST_ELEMENTS (bgp->peer, node, nnode, peer))
+  {
+    for (afi = AFI_IP; afi < AFI_MAX; afi++)
+    {
+      for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++)
       {
-        srx_bgp_requeue_update(bnode->info);
+        count += peer->pcount[afi][safi];
       }
     }
   }
+
+  return count;
+}
+
+/**
+ * Start a walk of the given type over all RIB tables of this router. The walk
+ * is performed in batches from within a work queue. If the walk is already in
+ * progress it is restarted from the beginning.
+ *
+ * @param bgp The bgp router
+ * @param type The type of walk.
+ */
+void srx_bgp_walk_start(struct bgp *bgp, SRxWalkType type)
+{
+  struct srx_walk* walk = &bgp->srx_walk[type];
+
+  if (bgp->srx_walk_queue == NULL)
+  {
+    bgp->srx_walk_queue = work_queue_new (bm->master, "srx_walk_queue");
+    if (bgp->srx_walk_queue == NULL)
+    {
+      zlog_err ("%s: Failed to allocate work queue", __func__);
+      return;
+    }
+    bgp->srx_walk_queue->spec.hold          = 10;
+    bgp->srx_walk_queue->spec.workfunc      = &srx_bgp_walk_process;
+    bgp->srx_walk_queue->spec.del_item_data = &srx_bgp_walk_del;
+    bgp->srx_walk_queue->spec.max_retries   = 0;
+  }
+
+  if (type == SRX_WALK_SYNCH && bgp->info_uid_hash != NULL)
+  {
+    // srx-server will answer with one update identifier per path of the RIB.
+    bgp_info_hash_reserve (bgp->info_uid_hash, srx_bgp_path_count (bgp));
+  }
+
+  if (walk->active)
+  {
+    zlog_info ("SRx %s restarted!", srx_bgp_walk_name (type));
+    _srx_bgp_walk_release (walk);
+  }
+
+  walk->bgp      = bgp;
+  walk->type     = type;
+  walk->afi      = AFI_IP;
+  walk->safi     = SAFI_UNICAST;
+  walk->inTable  = 0;
+  walk->nodes    = 0;
+  walk->paths    = 0;
+  walk->cycles   = 0;
+  walk->started  = bgp_clock ();
+  walk->finished = 0;
+  walk->runs++;
+
+  if (!walk->active)
+  {
+    walk->active = 1;
+    bgp_lock (bgp); /* srx_bgp_walk_del */
+    work_queue_add (bgp->srx_walk_queue, walk);
+  }
+}
+
+/**
+ * Stop all RIB walks of this router and release the walk queue.
+ *
+ * @param bgp The bgp router
+ */
+void srx_bgp_walk_cancel(struct bgp *bgp)
+{
+  int type;
+
+  if (bgp->srx_walk_queue == NULL)
+  {
+    return;
+  }
+
+  // work_queue_free does not call del_item_data, release the walks here.
+  for (type = 0; type < SRX_WALK_MAX; type++)
+  {
+    if (bgp->srx_walk[type].active)
+    {
+      srx_bgp_walk_del (bgp->srx_walk_queue, &bgp->srx_walk[type]);
+    }
+  }
+  work_queue_free (bgp->srx_walk_queue);
+  bgp->srx_walk_queue = NULL;
+}
+
+/**
+ * Requeue all updates associated with this router. this method is used for the
+ * terminal command "srx apply-policy". All AFI/SAFI tables are processed in
+ * batches by the SRx walk queue.
+ *
+ * @param The bgp router
+ */
+void srx_bgp_requeue_all(struct bgp *bgp)
+{
+  if (bgp != NULL)
+  {
+    srx_bgp_walk_start (bgp, SRX_WALK_REQUEUE);
+  }
 }
 
 
@@ -890,6 +1193,70 @@ int checkEcomSRxValid(struct attr* attr)
   return ret;
 }
 
+static u_int32_t srx_loc_prev_value(struct bgp* bgp, u_int32_t locPref,
+                                    int valResult);
+
+/**
+ * Determine if a change of the validation state of the given update can alter
+ * the outcome of the best path selection of its node. The state is only used
+ * in bgp_info_cmp for the local preference policy and the prefer-valid
+ * policy, therefore a change that results in the same local preference and
+ * the same "valid" precedence can not change the selection.
+ *
+ * @param bgp The bgp instance
+ * @param info The update which changed its validation state
+ * @param oldResult The validation state before the change.
+ * @param newResult The validation state after the change.
+ *
+ * @return true if the node has to go through the best path selection.
+ */
+static bool srx_validation_affects_selection(struct bgp* bgp,
+                                             struct bgp_info* info,
+                                             int oldResult, int newResult)
+{
+  struct bgp_info* ri;
+  u_int32_t locPref;
+
+  if (oldResult == newResult || (bgp->srx_config & SRX_CONFIG_EVALUATE) == 0)
+  {
+    return false;
+  }
+
+  // Not a candidate for the selection (history, damped, or removed).
+  if (BGP_INFO_HOLDDOWN (info))
+  {
+    return false;
+  }
+
+  // Without a competing candidate the selection can not change.
+  for (ri = info->node->info; ri != NULL; ri = ri->next)
+  {
+    if (ri != info && !BGP_INFO_HOLDDOWN (ri))
+    {
+      break;
+    }
+  }
+  if (ri == NULL)
+  {
+    return false;
+  }
+
+  if (CHECK_FLAG (bgp->srx_val_policy, SRX_VAL_POLICY_PREFER_VALID)
+      && ((oldResult == SRx_RESULT_VALID) != (newResult == SRx_RESULT_VALID)))
+  {
+    return true;
+  }
+
+  locPref = bgp->default_local_pref;
+  if (info->attr->flag & ATTR_FLAG_BIT (BGP_ATTR_LOCAL_PREF))
+  {
+    locPref = info->attr->local_pref;
+  }
+
+  return    srx_loc_prev_value(bgp, locPref, oldResult)
+         != srx_loc_prev_value(bgp, locPref, newResult);
+}
+
 /**
  * Modifies the BGP update information according to the SRX settings.
  * This will be done using the bgp_info data structure.
@@ -899,7 +1266,9 @@ int checkEcomSRxValid(struct attr* attr)
  * ignored.
  * 
  * Also the update will only be put back into the queue if the ignore state
- * changed or the validation result changed.
+ * changed or the validation result changed in a way that can alter the best
+ * path selection. Results for the same node are batched by bgp_process which
+ * queues each node only once until it is processed.
  */
 void bgp_info_set_validation_result (struct bgp_info *info,
                                      ValidationResultType resType,
@@ -932,10 +1301,13 @@ void bgp_info_set_validation_result (struct bgp_info *info,
     // Check if it is fully valid and if not decide if the update has to be
     // ignored
     bool ignoreChanged = bgp_info_set_ignore_flag(info) != oldIgnore;
-    bool resultChanged = oldResult != srx_calc_validation_state(bgp, info);
-    
-    // Only re-queue if the ignore state changed or if the result changed.
-    requeue = ignoreChanged || resultChanged;
+    bool resultChanged = srx_validation_affects_selection(bgp, info,
+                                      oldResult,
+                                      srx_calc_validation_state(bgp, info));
+
+    // Only re-queue if the ignore state changed or if the result changed the
+    // rank of the update. Paths in hold down are not part of the selection.
+    requeue = (ignoreChanged && !BGP_INFO_HOLDDOWN (info)) || resultChanged;
 
     if (requeue)
     {
@@ -7273,84 +7645,43 @@ static void srx_route_vty_out_detail(struct vty *vty, struct bgp *bgp,
     }
     else
     {
-      struct PathSegment* pathSegment;
-      struct SigBlock *sigBlock;
-      struct SigSegment *sigSegment1;
-      struct SigSegment *sigSegment2;
-
-      int blockCounter=0;
-      int segCounter=0;
-
-      pathSegment = binfo->attr->bgpsecPathAttr->pathSegments;
-      sigBlock    = binfo->attr->bgpsecPathAttr->sigBlocks;
-
-      // Determine the number of path segments by counting the number of
-      // path segments
-      while (pathSegment)
-      {
-        segCounter++;
-        pathSegment = pathSegment->next;
-      }
-
-       // Determine the number of signature blocks
-      sigBlock = binfo->attr->bgpsecPathAttr->sigBlocks;
-      blockCounter=0;
-      while (sigBlock)
-      {
-        blockCounter++;
-        sigBlock = sigBlock->next;
-      }
+      struct BgpsecPathAttr *bpa = binfo->attr->bgpsecPathAttr;
+      struct BgpsecSigSegment sigSegment;
+      const u_char *sigPtr[BGPSEC_MAX_SIGBLOCK];
+      int blockIdx, segIdx, i;
 
       vty_out (vty, "BGPSEC-Path ( %d signature blocks, each with %d path "
-                     "segments)%s", blockCounter, segCounter, VTY_NEWLINE);
-
-      sigBlock    = binfo->attr->bgpsecPathAttr->sigBlocks;
-      pathSegment = binfo->attr->bgpsecPathAttr->pathSegments;
-      sigSegment1 = sigBlock->sigSegments;
-      sigSegment2 = (sigBlock->next) ? sigBlock->next->sigSegments : NULL;
+                     "segments)%s", bpa->numSigBlocks, bpa->numSegments,
+                     VTY_NEWLINE);
 
       // Now print information about each block and its segments:
-      while(sigBlock)
+      for (blockIdx = 0; blockIdx < bpa->numSigBlocks; blockIdx++)
       {
         vty_out (vty, "        signature block #%d: algorithm suite id %d%s",
-                      blockCounter, sigBlock->algoSuiteId, VTY_NEWLINE);
-        sigBlock = sigBlock->next;
+                      blockIdx + 1, bpa->sigBlocks[blockIdx].algoSuiteId,
+                      VTY_NEWLINE);
+        sigPtr[blockIdx] = bpa->data + bpa->sigBlocks[blockIdx].offset;
       }
 
       // Now walk through the path segments and display them incl. signatures
-      segCounter=0;
-      pathSegment = binfo->attr->bgpsecPathAttr->pathSegments;
-      while (pathSegment)
+      for (segIdx = 0; segIdx < bpa->numSegments; segIdx++)
       {
-        segCounter++;
-        vty_out (vty, "        path segment %d: as=%d; pcount=%d%s", segCounter,
-                      pathSegment->as, pathSegment->pCount, VTY_NEWLINE);
-        pathSegment = pathSegment->next;
-
-
-        int i;
-        if (sigSegment1)
-        {
-          vty_out (vty, "          signature segment [%d]: block 1, ski=",
-                        segCounter);
-          for (i=0; i < 20; i++)
-          {
-            vty_out (vty, "%02X", sigSegment1->ski[i]);
-          }
-          vty_out (vty, "%s", VTY_NEWLINE);
-          sigSegment1 = sigSegment1->next;
-        }
+        vty_out (vty, "        path segment %d: as=%u; pcount=%d%s", segIdx + 1,
+                      bgpsec_path_segment_as (bpa, segIdx),
+                      bgpsec_path_segment_pcount (bpa, segIdx), VTY_NEWLINE);
 
-        if (sigSegment2)
+        // Each block holds one signature segment per path segment.
+        for (blockIdx = 0; blockIdx < bpa->numSigBlocks; blockIdx++)
         {
-          vty_out (vty, "          signature segment [%d]: block 2, ski=",
-                        segCounter);
-          for (i=0; i < 20; i++)
+          sigPtr[blockIdx] = bgpsec_sig_segment_read (sigPtr[blockIdx],
+                                                      &sigSegment);
+          vty_out (vty, "          signature segment [%d]: block %d, ski=",
+                        segIdx + 1, blockIdx + 1);
+          for (i=0; i < BGPSEC_SKI_LENGTH; i++)
           {
-            vty_out (vty, "%02X", sigSegment2->ski[i]);
+            vty_out (vty, "%02X", sigSegment.ski[i]);
           }
           vty_out (vty, "%s", VTY_NEWLINE);
-          sigSegment2 = sigSegment2->next;
         }
       }
     }
@@ -10802,7 +11133,8 @@ bgp_table_stats_walker (struct thread *t)
       struct bgp_node *prn = bgp_node_parent_nolock (rn);
       unsigned int rinum = 0;
 
-      if (rn == top)
+      /* The default route covers everything, leave it out. */
+      if (rn->p.prefixlen == 0)
         continue;
 
       if (!rn->info)
@@ -10822,7 +11154,7 @@ bgp_table_stats_walker (struct thread *t)
       while (prn && !prn->info)
         prn = bgp_node_parent_nolock (prn);
 
-      if (prn == NULL || prn == top)
+      if (prn == NULL || prn->p.prefixlen == 0)
         {
           ts->counts[BGP_STATS_UNAGGREGATEABLE]++;
           /* announced address space */
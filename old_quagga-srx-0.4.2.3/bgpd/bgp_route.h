@@ -245,6 +245,10 @@ extern void bgp_info_unset_flag (struct bgp_node *, struct bgp_info *, u_int32_t
 extern int  bgp_info_set_ignore_flag(struct bgp_info *);
 extern void srx_bgp_requeue_update(struct bgp_info *);
 extern void srx_bgp_requeue_all(struct bgp *);
+extern void srx_bgp_walk_start(struct bgp *, SRxWalkType);
+extern void srx_bgp_walk_cancel(struct bgp *);
+extern const char* srx_bgp_walk_name(SRxWalkType);
+extern unsigned long srx_bgp_path_count(struct bgp *);
 extern void bgp_info_set_validation_result (struct bgp_info *,
                                        ValidationResultType resType,
                                        uint8_t roaResult, uint8_t bgpsecResult);
@@ -109,7 +109,10 @@ bgp_table_init (afi_t afi, safi_t safi)
 
   rt = XCALLOC (MTYPE_BGP_TABLE, sizeof (struct bgp_table));
 
-  rt->route_table = route_table_init_with_delegate (&bgp_table_delegate);
+  /*
+   * BGP tables get large, keep them in a multibit trie.
+   */
+  rt->route_table = route_table_init_trie_with_delegate (&bgp_table_delegate);
 
   /*
    * Set up back pointer to bgp_table.
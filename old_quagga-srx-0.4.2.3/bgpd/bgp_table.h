@@ -163,7 +163,7 @@ bgp_node_prefixlen (struct bgp_node *node)
 static inline struct bgp_node *
 bgp_node_parent_nolock (struct bgp_node *node)
 {
-  return bgp_node_from_rnode (node->parent);
+  return bgp_node_from_rnode (route_node_parent (bgp_node_to_rnode (node)));
 }
 
 /*
@@ -22,111 +22,26 @@ SRxCryptoAPI *g_capi;
 
 /* Hash for bgpsec path.  This is the top level structure of BGPSEC AS path. */
 static struct hash *bgpsechash;
-// Forward declarations
-static u_int8_t* ski_new();
-static void *signature_new(size_t size);
-static struct PathSegment* pathSegment_New(void);
-static struct SigSegment* sigSegment_New(void);
-static struct SigBlock* sigBlock_New(void);
-static void bgpsec_sigBlock_free_all (struct SigBlock *sb);
-static void bgpsec_sigBlock_free (struct SigBlock *sb);
-static void sigSegment_free_all(struct SigSegment *ss);
-static void sigSegment_free(struct SigSegment *ss);
-static void bgpsec_path_segment_free_all (struct PathSegment *seg);
-static void bgpsec_path_segment_free (struct PathSegment *seg);
-static struct BgpsecPathAttr * bgpsec_path_attr_new (void);
 static void * bgpsec_path_hash_alloc (void *arg);
 
-/* If two aspath have same value then return 1 else return 0 */
+/* If two bgpsec path attrs carry the same data then return 1 else 0 */
 int bgpsec_path_attr_cmp (const void *arg1, const void *arg2)
 {
-  const struct PathSegment *seg1 = ((const struct BgpsecPathAttr *)arg1)->pathSegments;
-  const struct PathSegment *seg2 = ((const struct BgpsecPathAttr *)arg2)->pathSegments;
+  const struct BgpsecPathAttr *bpa1 = arg1;
+  const struct BgpsecPathAttr *bpa2 = arg2;
 
-  const struct SigBlock *sb1 = ((const struct BgpsecPathAttr *)arg1)->sigBlocks;
-  const struct SigBlock *sb2 = ((const struct BgpsecPathAttr *)arg2)->sigBlocks;
-
-  while (seg1 || seg2)
-    {
-      if ((!seg1 && seg2) || (seg1 && !seg2))
-	return 0;
-      if (seg1->as != seg2->as)
-        return 0;
-      if (seg1->pCount != seg2->pCount)
-        return 0;
-      if (seg1->flags != seg2->flags)
-          return 0;
-      seg1 = seg1->next;
-      seg2 = seg2->next;
-    }
-
-  while (sb1 || sb2)
-    {
-      if ((!sb1 && sb2) || (sb1 && !sb2))
-	return 0;
-      if (sb1->sigBlockLen != sb2->sigBlockLen)
-        return 0;
-      if (sb1->algoSuiteId != sb2->algoSuiteId)
-        return 0;
-      /* TODO: need to have more better comparing  using SKI and signature
-       * not only using sigSegments
-       * Because comparing sigSegemts are just address comparing, so it need to compare more
-       * concrete data like sigSegments->ski, ski_leng and signature */
-      if (sb1->sigSegments != sb2->sigSegments)
-          return 0;
-      sb1 = sb1->next;
-      sb2 = sb2->next;
-    }
-  return 1;
+  return bpa1->length == bpa2->length
+         && memcmp (bpa1->data, bpa2->data, bpa1->length) == 0;
 }
 
 
-/* Make hash value by raw bgpsec path attr data. */
+/* Make hash value from the attribute data, the Secure_Path and all
+ * Signature_Blocks. */
 unsigned int bgpsec_path_attr_key_make (void *p)
 {
   struct BgpsecPathAttr *bpa = (struct BgpsecPathAttr *) p;
-  struct PathSegment *seg = bpa->pathSegments;
-  struct SigBlock *sb = bpa->sigBlocks;
-  struct SigSegment *ss;
-  unsigned int key = 0;
-
-  if (BGP_DEBUG (bgpsec, BGPSEC_DETAIL))
-  {
-    zlog_debug("[BGPSEC] [%s]: bpa:%p, seg:%p, sb:%p sigSeg:%p AS:%d ", \
-        __FUNCTION__, bpa, seg, sb, sb->sigSegments, seg->as);
-  }
 
-  if (sb)
-  {
-    ss = sb->sigSegments;
-    key += jhash(sb, 4, 0);
-    key += jhash (ss->signature, ss->sigLen, 0);
-  }
-  /*
-  else if(seg)
-  {
-    u_int32_t as = seg->as;
-
-    key += (as & 0xff000000) >> 24;
-    key += (as & 0x00ff0000) >> 16;
-    key += (as & 0x0000ff00) >> 8;
-    key += (as & 0x000000ff);
-  }
-  */
-  else
-  {
-#define MIX(val)	key = jhash_1word(val, key)
-    MIX(bpa->securePathLen);
-    key += jhash(bpa->pathSegments, 4, 0);
-    key += jhash(bpa->sigBlocks, 4, 0);
-  }
-
-  if (BGP_DEBUG (bgpsec, BGPSEC_DETAIL))
-  {
-    zlog_debug("[BGPSEC] [%s]:  - - key = =:%d, index:%d", \
-        __FUNCTION__, key, key % 32767);
-  }
-  return key;
+  return jhash (bpa->data, bpa->length, 0);
 }
 
 /*
@@ -142,6 +57,7 @@ void bgpsec_path_attr_init()
  //        srx-server.
   // aspath_init initialize its aspath hash as many as the number of 32767 hashes, so follows the same number
   bgpsechash = hash_create_size (32767, bgpsec_path_attr_key_make, bgpsec_path_attr_cmp);
+  hash_set_name (bgpsechash, "BGPsec Path");
   g_capi = malloc(sizeof(SRxCryptoAPI));
   memset (g_capi, 0, sizeof(SRxCryptoAPI));
   sca_status_t sca_status = API_STATUS_OK;
@@ -171,250 +87,35 @@ void bgpsec_path_attr_finish (void)
   bgpsechash = NULL;
 }
 
+/* Copy the looked up attribute into one block holding the structure and
+ * the attribute data. */
 static void * bgpsec_path_hash_alloc (void *arg)
 {
-  const struct BgpsecPathAttr *bpa = arg;
+  struct BgpsecPathAttr *bpa = (struct BgpsecPathAttr *) arg;
   struct BgpsecPathAttr *new;
-  struct PathSegment *newSeg, *origSeg;
-
-  /* Malformed AS path value. */
-  assert (bpa->sigBlocks);
-  assert (bpa->pathSegments);
-  if (! bpa->sigBlocks->sigSegments)
-    return NULL;
-
-  /* New aspath structure is needed. */
-  new = bgpsec_path_attr_new();
-  new->securePathLen    = bpa->securePathLen;
-  new->pathSegments     = pathSegment_New();
-
-  /* pathSegment allocation according to the number of segments */
-  origSeg   = bpa->pathSegments;
-  newSeg    = new->pathSegments;
-  while(origSeg)
-  {
-    *newSeg  = *origSeg; //struct copy
-
-    if(origSeg->next)
-    {
-      newSeg->next = pathSegment_New();
-      newSeg = newSeg->next;
-    }
-
-    origSeg = origSeg->next;
-  }
-
-  /* sigBlock allocation according to the number of segments */
-  struct SigSegment *newSig, *origSig;
-  if(bpa->sigBlocks)
-  {
-    new->sigBlocks = sigBlock_New();
-    *new->sigBlocks = *bpa->sigBlocks; // sigBlock struct copy
-
-    newSig = new->sigBlocks->sigSegments = sigSegment_New();
-    origSig = bpa->sigBlocks->sigSegments;
-
-    while (origSig)
-    {
-      *newSig = *origSig;     // sigSegment strcut copy
-
-      /* ski allocation and copy from arg */
-      if(origSig->ski)
-      {
-        newSig->ski = calloc (1, BGPSEC_SKI_LENGTH);
-        memcpy(newSig->ski, origSig->ski, BGPSEC_SKI_LENGTH);
-      }
+  u_char *data;
 
-      /* signature allocation and copy from arg */
-      if(origSig->signature)
-      {
-        newSig->signature = calloc (1, origSig->sigLen);
-        memcpy(newSig->signature, origSig->signature, origSig->sigLen);
-      }
-
-      if(origSig->next)
-      {
-        newSig->next = sigSegment_New();
-        newSig = newSig->next;
-      }
-
-      origSig = origSig->next;
-    } /* while */
-  } /* if - sigBlock */
+  new = XMALLOC (MTYPE_BGPSEC_PATH,
+                 sizeof (struct BgpsecPathAttr) + bpa->length);
+  data = (u_char *) (new + 1);
+  memcpy (data, bpa->data, bpa->length);
 
+  *new = *bpa;
+  new->data = data;
   new->refcnt = 0;
-  return new;
-}
 
-/**
- * Instantiate an initialize a new BgpsecPathAttr instance.
- *
- * @return the new instantiated BgpsecPathAttr.
- *
- * @see bgpsec_path_free
- */
-static struct BgpsecPathAttr * bgpsec_path_attr_new (void)
-{
-  struct BgpsecPathAttr *new;
-  new = XCALLOC (MTYPE_BGPSEC_PATH, sizeof (struct BgpsecPathAttr));
-  memset(new, 0x0, sizeof(struct BgpsecPathAttr));
   return new;
 }
 
 /**
- * Create a complete BgpsecPathAttr structure including all internal
- * allocations to the pointers.
- *
- * @return A fully instantiated BgpsecPathAttr.
+ * Free BGPSEC path attr structure together with its data.
  *
- * @see bgpsec_path_free
- */
-static struct BgpsecPathAttr * bgpsec_path_attr_all_new(void)
-{
-  struct BgpsecPathAttr *bpa;
-
-  bpa = bgpsec_path_attr_new();
-  bpa->pathSegments           = pathSegment_New();
-  bpa->sigBlocks              = sigBlock_New();
-  bpa->sigBlocks->sigSegments = sigSegment_New();
-
-  return bpa;
-}
-
-/**
- * Free the path segment of the segment structure.
- *
- * @param seg The secure path segment to be freed
- *
- * @see pathSegment_New
- */
-static void bgpsec_path_segment_free (struct PathSegment *seg)
-{
-  if (seg != NULL)
-  {
-    memset(seg, 0, sizeof(struct PathSegment));
-    XFREE (MTYPE_BGPSEC_PATH_SEG, seg);
-  }
-
-  return;
-}
-
-/**
- * Free entire chain of segments.
- *
- * @param seg The chain of signature segments.
- */
-static void bgpsec_path_segment_free_all (struct PathSegment *seg)
-{
-  struct PathSegment *prev;
-
-  while (seg != NULL)
-  {
-    prev = seg;
-    seg = seg->next;
-    bgpsec_path_segment_free (prev);
-  }
-}
-
-/**
- * Frees the allocated memory for the given signature segment.
- *
- * @param ss The signature segment to be freed.
- *
- * @see sigSegment_New
- *
- */
-static void sigSegment_free(struct SigSegment *ss)
-{
-  if (ss != NULL)
-  {
-   // Free the ski
-   if (ss->ski != NULL)
-   {
-     memset( ss->ski, 0, SKI_LENGTH);
-     free(ss->ski);
-   }
-
-   // Free the signature
-   if (ss->signature != NULL)
-   {
-     memset(ss->signature, 0, ss->sigLen);
-     free(ss->signature);
-   }
-
-   memset (ss, 0, sizeof(struct SigSegment));
-   /* but here, call xfree for Signature Segment itself */
-   XFREE (MTYPE_BGPSEC_SIG_SEG, ss);
-  }
-}
-
-/**
- * Free the complete signature segment chain
- *
- * @param ss The signature segment chain.
- */
-static void sigSegment_free_all(struct SigSegment *ss)
-{
-  struct SigSegment *prev;
-
-  while (ss != NULL)
-  {
-    prev = ss;
-    ss = ss->next;
-    sigSegment_free(prev);
-  }
-}
-
-/**
- * Free the signature block of the list structure
- *
- * @param sb The signature block to be freed.
- *
- * @see sigBlock_New
- */
-static void bgpsec_sigBlock_free (struct SigBlock *sb)
-{
-  if (sb != NULL)
-  {
-    // First free all signature segments
-    sigSegment_free_all(sb->sigSegments);
-    memset (sb, 0, sizeof(struct SigBlock));
-    XFREE (MTYPE_BGPSEC_SIG_BLK, sb);
-  }
-}
-
-/**
- * free entire chain of Signature_Block segments
- *
- * @param sb Free all signature blocks.
- */
-static void bgpsec_sigBlock_free_all (struct SigBlock *sb)
-{
-  struct SigBlock *prev;
-
-  while (sb != NULL)
-  {
-    prev = sb;
-    sb = sb->next;
-    bgpsec_sigBlock_free (prev);
-  }
-}
-
-/**
- * Free BGPSEC path attr structure.
- *
- * @param bgp The complete
- *
- * @see bgpsec_path_attr_all_new
+ * @param bpa The attribute as returned by bgpsec_path_intern
  */
 void bgpsec_path_free (struct BgpsecPathAttr *bpa)
 {
   if (bpa != NULL)
   {
-    bgpsec_path_segment_free_all (bpa->pathSegments);
-    bgpsec_sigBlock_free_all (bpa->sigBlocks);
-
-    memset(bpa, 0, sizeof(struct BgpsecPathAttr));
     XFREE (MTYPE_BGPSEC_PATH, bpa);
   }
 }
@@ -444,14 +145,13 @@ void bgpsec_path_unintern (struct BgpsecPathAttr **pbpa)
 }
 
 
-/* Intern allocated bgpsec path attr. */
+/* Intern bgpsec path attr.  The given attribute is only used for the
+ * lookup, usually it refers to the received update, and stays with the
+ * caller. */
 struct BgpsecPathAttr *bgpsec_path_intern (struct BgpsecPathAttr *bpa)
 {
   struct BgpsecPathAttr *find;
 
-  /* Assert this BGPSEC path attr structure is not interned. */
-  assert (bpa->refcnt == 0);
-
   /* Check bgpsec path attr hash. */
   find = hash_get (bgpsechash, bpa, bgpsec_path_hash_alloc);
 
@@ -461,342 +161,94 @@ struct BgpsecPathAttr *bgpsec_path_intern (struct BgpsecPathAttr *bpa)
         __FUNCTION__, find, find->refcnt, bpa);
 #endif
 
-  if (find != bpa)
-    bgpsec_path_free (bpa);
-
   find->refcnt++;
 
   return find;
 }
 
-
-/**
- * Allocates memory for the new secure path segment
- *
- * @return Return a newly allocates secure path segment
- *
- * @see bgpsec_path_segment_free
- */
-static struct PathSegment* pathSegment_New(void)
-{
-  struct PathSegment *new;
-  new = XCALLOC (MTYPE_BGPSEC_PATH_SEG, sizeof (struct PathSegment));
-  memset(new, 0x00, sizeof(struct PathSegment));
-
-  return new;
-}
-
-/**
- * Generates and returns a zero initialized ski of length SKI_LENGTH
- *
- * @return Generates and returns a zero initialized ski of length SKI_LENGTH
- */
-static u_int8_t* ski_new()
-{
-  u_int8_t* ski = malloc (SKI_LENGTH);
-  memset(ski, 0, SKI_LENGTH);
-  return ski;
-}
-
-/* signature allocation */
-static void *signature_new(size_t size)
-{
-  u_int8_t* signature;
-  signature = XMALLOC(MTYPE_BGPSEC_SIGNATURE, size);
-  memset(signature, 0, size);
-  return signature;
-//  return calloc (1, size);
-}
-
 /**
- * Create a new signature segment for the pointer structure.
+ * Check the structure of a BGPSEC path attribute value and record where its
+ * segments are. Nothing is copied, bpa refers to the given data afterwards;
+ * bgpsec_path_intern makes the copy that is kept.
  *
- * @return The signature segment.
+ * @param bpa The attribute view to fill in.
+ * @param data The attribute value, Secure_Path followed by Signature_Blocks.
+ * @param length The length of the attribute value.
  *
- * @see sigSegment_free
+ * @return BGPSEC_SUCCESS or BGPSEC_FAILURE in case the attribute is
+ *         malformed.
  */
-static struct SigSegment* sigSegment_New(void)
-{
-
-  struct SigSegment *new;
-  new = XCALLOC (MTYPE_BGPSEC_SIG_SEG, sizeof (struct SigSegment));
-  memset(new, 0x00, sizeof(struct SigSegment));
-
-  return new;
-}
-
-/**
- * Generate a new Signature Block for the pinter structure.
- *
- * @return The new created signature block
- *
- * @see bgpsec_sigBlock_free
- */
-static struct SigBlock* sigBlock_New(void)
-{
-  struct SigBlock *new;
-  new = XCALLOC (MTYPE_BGPSEC_SIG_BLK, sizeof (struct SigBlock));
-  memset(new, 0x00, sizeof(struct SigBlock));
-
-  return new;
-}
-
-
-/**
- * This function parses the byte stream and generates the internal
- * bgpsecPathAttr structure. In case the handed update is malformed no
- * bgpsecPathAttr is generated and the return value is NULL
- *
- * @param attr The attribute.
- * @param peer The bgpsec session information
- * @param s The stream containing the attribute information.
- * @param length total length of bgpsec pdu including Secure_Path and Signature_Block
- *
- * @return The BgpsecPathAttr as pointer structure or NULL in case the BGPSEC
- *         attribute is malformed.
- */
-struct BgpsecPathAttr* bgpsec_parse(struct attr *attr, struct peer *peer,
-                                    struct stream *s, size_t length)
-{
-  // @INFO:  The pointer structure makes sense for generation of the sending out
-  //         attribute.
-  u_char* startp = NULL;
-  u_char* endp   = NULL;
-//  struct stream *s = peer->ibuf;
-  size_t start_getp = 0;
-  size_t start_endp = 0;
-  // This is the secure path pointer
-  size_t spp = 0;
-  // This is the secure block pointer
-  size_t sbp = 0;
-
-  /* sanity check */
-  // @TODO: Add the correct sanity check as specified in the DRAFT, This means
-  //        Check the existence of max 2 signature blocks etc.
-  if ((STREAM_READABLE(s) < length) || (length <= 0))
-  {
-    zlog_err("bad bgpsec packet - length mismatch");
-    return NULL;
-  }
-
-  startp     = BGP_INPUT_PNT (peer); // current address pointer
-  start_getp = stream_get_getp (s);
-  start_endp = stream_get_endp (s);
-  endp       = startp + length;
-
-  if (BGP_DEBUG (bgpsec, BGPSEC_IN) || BGP_DEBUG(bgpsec, BGPSEC_DETAIL))
-  {
-    zlog_debug("[IN] %p -  startp: %p-- getp:%d endp:%d -- endp(startp+length):%p length:%d ", \
-        stream_pnt(s), startp, (int)start_getp, (int)start_endp, endp, (int)length);
-  }
-
-  // Retrieving the prefix is not needed anymore, this function just does
-  // Syntax check and generation of the helper structure.
-  int numSecurePathSegment = 0;
-
-  if (BGP_DEBUG (bgpsec, BGPSEC_IN) || BGP_DEBUG(bgpsec, BGPSEC_DETAIL))
-  {
-    zlog_debug("[IN] peer as:%d peer->local_as:%d Secure_Path Len:%d",\
-        peer->as, peer->local_as, stream_getw_from(s, start_getp));
-  }
-
-  /* calculation of total aspath length using SecurePath Len */
-  u_int16_t spl    = stream_getw_from(s, start_getp);
-  u_int16_t numSeg = 0;
-
-  if ( (spl-OCTET_SECURE_PATH_LEN) % OCTET_SECURE_PATH_SEGMENT != 0)
-  {
-    zlog_err(" SecurePath Length parsing error");
-    return NULL;
-  }
-
-  numSeg = (spl - OCTET_SECURE_PATH_LEN) / OCTET_SECURE_PATH_SEGMENT;
-
-  struct BgpsecPathAttr* bpa = NULL;
-  struct PathSegment *seg;
-  struct SigBlock    *sb;
-
-  bool syntaxError = false;
-
-  /*
-   * If this is the originating AS
-   */
-  // @INFO: OK this is wrong. if numSeg is < 2 this does not mean that this is
-  // the originator. numSeg is also < 2 if this is the second hop. I will modify
-  // the code in such that it uses the iteration in both parts.
-  /*
-   * in case not origin as, which means transit router
-   */
-  // It is a transit AS, it received this attribute.
-  u_short iter;
-  struct PathSegment  *prev = NULL, *head = NULL;
-
-  /* BGPSEC_Path Attribute and others */
-  bpa = bgpsec_path_attr_new();
-  /* Secure_Path len */
-  bpa->securePathLen = stream_getw(s);
-
-  /* Secure_Path length includes two octets used to express its own length field */
-  iter = numSecurePathSegment =
-    (bpa->securePathLen - OCTET_SECURE_PATH_LEN) / OCTET_SECURE_PATH_SEGMENT;
-
-  /* read the multiple Secure_Path Segments */
-  while(iter)
-  {
-    // Check we have enough bytes left
-    if (STREAM_READABLE(s) < OCTET_SECURE_PATH_SEGMENT)
+int bgpsec_path_parse (struct BgpsecPathAttr *bpa, const u_char *data,
+                       size_t length)
+{
+  const u_char *end = data + length;
+  const u_char *p, *blockEnd;
+  struct BgpsecSigBlock *sb;
+  u_int16_t securePathLen, sigBlockLen, sigLen;
+  int numSigs;
+
+  memset (bpa, 0, sizeof (struct BgpsecPathAttr));
+
+  if (length < OCTET_SECURE_PATH_LEN)
+    goto malformed;
+
+  // The Secure_Path carries at least one segment.
+  securePathLen = (data[0] << 8) | data[1];
+  if (securePathLen > length
+      || securePathLen < OCTET_SECURE_PATH_LEN + OCTET_SECURE_PATH_SEGMENT
+      || (securePathLen - OCTET_SECURE_PATH_LEN) % OCTET_SECURE_PATH_SEGMENT)
+    goto malformed;
+  bpa->numSegments = (securePathLen - OCTET_SECURE_PATH_LEN)
+                     / OCTET_SECURE_PATH_SEGMENT;
+
+  // Each Signature_Block has one Signature_Segment per Secure_Path segment.
+  for (p = data + securePathLen; p < end; p = blockEnd)
+  {
+    if (bpa->numSigBlocks == BGPSEC_MAX_SIGBLOCK
+        || end - p < OCTET_SIG_BLOCK_LEN + OCTET_ALGORITHM_ID)
+      goto malformed;
+
+    sigBlockLen = (p[0] << 8) | p[1];
+    if (sigBlockLen < OCTET_SIG_BLOCK_LEN + OCTET_ALGORITHM_ID
+        || sigBlockLen > end - p)
+      goto malformed;
+    blockEnd = p + sigBlockLen;
+
+    sb = &bpa->sigBlocks[bpa->numSigBlocks++];
+    sb->algoSuiteId = p[OCTET_SIG_BLOCK_LEN];
+    p += OCTET_SIG_BLOCK_LEN + OCTET_ALGORITHM_ID;
+    sb->offset = p - data;
+    sb->length = blockEnd - p;
+
+    for (numSigs = 0; p < blockEnd; numSigs++)
     {
-      syntaxError = true;
-      break;
+      if (blockEnd - p < BGPSEC_SKI_LENGTH + OCTET_SIGNATURE_LEN)
+        goto malformed;
+      sigLen = (p[BGPSEC_SKI_LENGTH] << 8) | p[BGPSEC_SKI_LENGTH + 1];
+      p += BGPSEC_SKI_LENGTH + OCTET_SIGNATURE_LEN;
+      if (sigLen > blockEnd - p)
+        goto malformed;
+      p += sigLen;
     }
-    seg = pathSegment_New();
 
-    /* concatenating */
-    if (prev)
-    {
-      prev->next = seg;
-    }
-    else
-    {
-      bpa->pathSegments = head = seg;
-    }
-
-    // Moved AS down, DRAFT 15
-    seg->pCount = stream_getc(s);
-    seg->flags  = stream_getc(s);
-    seg->as     = stream_getl(s);
-
-    if (BGP_DEBUG (bgpsec, BGPSEC_IN) || BGP_DEBUG(bgpsec, BGPSEC_DETAIL))
-    {
-      zlog_debug("[IN]  Secure_Path segment --> %d AS:%d", iter, seg->as);
-    }
-
-    prev = seg;
-
-    iter--;
-  } /* end of while */
-
-  // @INFO: I don't really know the meaning of the comment below but for now,
-  // I let it stand and do check during debug what is going on. Also very
-  // important here is to make sure that we have a maximum of 2 signature blocks
-  // if we have more, we encountered a syntax error and have to clean up all our
-  // data.
-  /*
-   * TODO: the code for parsing the 2nd Signature Block(sb2)
-   * But, here, just assumed one Sigature Block received.
-  */
-  struct SigSegment *ss_prev = NULL, *ss_curr = NULL;
-
-  // @INFO Now add my change of parsing through the signature block. Also add
-  // the RFC required syntax check.
-  if (STREAM_READABLE(s) < 1)
-  {
-    syntaxError = true;
+    if (numSigs != bpa->numSegments)
+      goto malformed;
   }
 
-  int numSigBlocks = 0;
-  while (STREAM_READABLE(s) > 0)
-  {
-    numSigBlocks++;
-    if (numSigBlocks > BGPSEC_MAX_SIGBLOCK)
-    {
-      syntaxError = true;
-      break;
-    }
-    // Now generate the BgpsecPathAttribtue Signature block structure.
-    if (bpa->sigBlocks == NULL)
-    {
-      // This is the first signature block
-      sb = bpa->sigBlocks = sigBlock_New(); // new Signature_Block instance
-    }
-    else
-    {
-      sb->next = sigBlock_New();
-      sb = sb->next;
-    }
-
-    sb->sigBlockLen = stream_getw(s);   // Signature_Block Length incl. this field.
-    if ((sb->sigBlockLen-2) > STREAM_READABLE(s))
-    {
-      // Length field contains invalid value.
-      syntaxError = true;
-      break;
-    }
-    sb->algoSuiteId     = stream_getc(s);   // Algorithm Suite Identifier
-    // The remaining bytes for the signature segments
-    u_int16_t remainingBytes = sb->sigBlockLen - 3;
-
-    if (BGP_DEBUG (bgpsec, BGPSEC_IN) || BGP_DEBUG(bgpsec, BGPSEC_DETAIL))
-    {
-      zlog_debug("[IN] Secure_Block --> %d, AlgoID: %u, Length: %u",
-                 numSigBlocks, sb->algoSuiteId, sb->sigBlockLen);
-    }
-
-    int numSignatures = 0;
-  // @INFO: Actually according to the RFC we need to parse according to the
-  // block length, not blindly through the number of segments. This is false.
-  // Only this way we can detect a structural error with the update.
-    while (remainingBytes > 0)
-    {
-      numSignatures++;
-      if (sb->sigSegments == NULL)
-      {
-        sb->sigSegments = sigSegment_New();
-        ss_prev = NULL;
-        ss_curr = sb->sigSegments;
-      }
-      else
-      {
-        ss_prev->next = sigSegment_New();
-        ss_curr = ss_prev->next;
-      }
-      ss_prev = ss_curr;
-
-      ss_curr->ski = ski_new();
-      stream_get(ss_curr->ski, s, SKI_LENGTH); // SKI
-      remainingBytes -= SKI_LENGTH;
-      ss_curr->sigLen = stream_getw(s);        // Signature Length
-      remainingBytes -= 2;
-
-      if (STREAM_READABLE(s) < ss_curr->sigLen)
-      {
-        // Invalid signature length
-        zlog_err("Bad bgpsec signatUre length: bigger than remaining byte");
-        syntaxError = true;
-        break;
-      }
+  if (bpa->numSigBlocks == 0)
+    goto malformed;
 
-      ss_curr->signature = signature_new(ss_curr->sigLen);
-      stream_get(ss_curr->signature, s, ss_curr->sigLen);     // signature
-      remainingBytes -= ss_curr->sigLen;
+  bpa->data          = data;
+  bpa->length        = length;
+  bpa->securePathLen = securePathLen;
 
-      if (BGP_DEBUG (bgpsec, BGPSEC_IN) || BGP_DEBUG(bgpsec, BGPSEC_DETAIL))
-      {
-        zlog_debug("[IN]    signature --> %d, Length: %u",
-                   numSignatures, ss_curr->sigLen);
-      }
-    }
-    if (numSignatures != numSecurePathSegment)
-    {
-      zlog_err("Number signatures does not match number secure path segments");
-      syntaxError = true;
-      break;
-    }
-  }
+  return BGPSEC_SUCCESS;
 
-  if (syntaxError)
-  {
-    // cleanup
-    bgpsec_path_free(bpa);
-    bpa = NULL;
-  }
-
-  if (BGP_DEBUG (bgpsec, BGPSEC_IN) || BGP_DEBUG(bgpsec, BGPSEC_DETAIL))
-  {
-    zlog_debug("[IN]  %s: return value(final bpa): %p", __FUNCTION__, bpa);
-  }
-
-  return bpa;
+malformed:
+  zlog_err("[BGPSEC] Malformed BGPSEC path attribute (length %u)",
+           (unsigned int)length);
+  memset (bpa, 0, sizeof (struct BgpsecPathAttr));
+  return BGPSEC_FAILURE;
 }
 
 /**
@@ -984,111 +436,80 @@ int constructBGPSecPathAttribute(struct bgp *bgp, struct peer *peer,
   // We already established that we do bgpsec and if internal, We already
   // forwarded the traffic.
   //
-  struct BgpsecPathAttr* bpa = bgpsecDup(attr->bgpsecPathAttr, true);
+  // The received attribute, if any, is copied over in wire format.
+  struct BgpsecPathAttr* bpa = attr->bgpsecPathAttr;
+  int numPathSegments = 1 + ((bpa != NULL) ? bpa->numSegments : 0);
+
   // Create the secure path
   uint16_t secPathLen = LEN_SECPATHSEGMENT
-                        + ((bpa->securePathLen == 0) ? 2 : bpa->securePathLen);
+                        + ((bpa == NULL) ? 2 : bpa->securePathLen);
   stream_putw (s, secPathLen);
 
   // Now add my own signature path segment
-  int numPathSegments = 1;
   stream_putc (s, pCount);
   stream_putc (s, flags);
-  stream_putl (s, bgp->as); // Check if these values have to be put in network format.
-  struct PathSegment* pSeg = bpa->pathSegments;
-  while (pSeg != NULL)
+  stream_putl (s, bgp->as);
+  if (bpa != NULL)
   {
-    numPathSegments++;
-    stream_putc (s, pSeg->pCount);
-    stream_putc (s, pSeg->flags);
-    stream_putl (s, pSeg->as);
-    pSeg = pSeg->next;
+    stream_put (s, bpa->data + OCTET_SECURE_PATH_LEN,
+                bpa->securePathLen - OCTET_SECURE_PATH_LEN);
   }
 
-  int sigIdx = 0;
-  struct SigBlock* sigBlock = NULL;
-  // The prevBlock is used to allow removing the signature block.
-  // if we remove a signature block we might need to allow taking it out of the
-  // list. OK currently the list MUST NOT exceed two segments but this might
-  // change in the future - So I just prepare that.
-  struct SigBlock* prevBlock = NULL;
-  // Now add the signature block(s) - one for each signature generated.
+  // Each received signature block is used at most once.
+  unsigned int usedBlocks = 0;
+  struct BgpsecSigBlock* sigBlock = NULL;
   SCA_Signature* signature = NULL;
+  int sigIdx, blockIdx;
+
+  // Now add the signature block(s) - one for each signature generated.
   for (sigIdx = 0; sigIdx < numSignatures; sigIdx++)
   {
-    sigBlock  = bpa->sigBlocks;
-    prevBlock = sigBlock;
     signature = signatures[sigIdx];
+    sigBlock  = NULL;
 
-    // Now locate the correct signature block that matches the signature.
-    // What about if we have more signature block with the same signature ID?????
-    // Maybe we have to remove the block once we found it?
-    while ((sigBlock != NULL) && (sigBlock->algoSuiteId != signature->algoID))
-    {
-      sigBlock  = sigBlock->next;
-      prevBlock = sigBlock;
-    }
-    if (sigBlock == NULL)
+    // Now locate the signature block that matches the signature's algorithm.
+    for (blockIdx = 0; bpa != NULL && blockIdx < bpa->numSigBlocks; blockIdx++)
     {
-      if (numPathSegments != 1)
+      if (!(usedBlocks & (1 << blockIdx))
+          && bpa->sigBlocks[blockIdx].algoSuiteId == signature->algoID)
       {
-        zlog_err("[BGPSEC] no path segments, something went completely wrong!\n");
-        return 0;
+        sigBlock = &bpa->sigBlocks[blockIdx];
+        usedBlocks |= 1 << blockIdx;
+        break;
       }
-      // OK we are originating.
-
-      // Now generate a signature block for the signature we just generated
-      sigBlock  = sigBlock_New();
-      prevBlock = NULL;
-      sigBlock->algoSuiteId = signature->algoID;
+    }
+    if (sigBlock == NULL && numPathSegments != 1)
+    {
+      zlog_err("[BGPSEC] no signature block for algorithm %u, something went "
+               "completely wrong!\n", signature->algoID);
+      return 0;
     }
 
     // store the stream position to later determine the length of the block
     size_t sbPointer = stream_get_endp (s);
     stream_putw (s, 0); // Store a dummy as signature block length and come back
                         // and store the correct value.
-    stream_putc (s, sigBlock->algoSuiteId);
+    stream_putc (s, signature->algoID);
 
     // Now store latest generated signature
     stream_put  (s, signature->ski, SKI_LENGTH);
     stream_putw (s, signature->sigLen);
     stream_put  (s, signature->sigBuff, signature->sigLen);
 
-    // Now add the remaining signatures to the block
-    struct SigSegment* sigSeg = sigBlock->sigSegments;
-    while (sigSeg != NULL)
+    // Now add the remaining signatures of the block as they were received
+    if (sigBlock != NULL)
     {
-      stream_put  (s, sigSeg->ski, SKI_LENGTH);
-      stream_putw (s, sigSeg->sigLen);
-      stream_put  (s, sigSeg->signature, sigSeg->sigLen);
-      sigSeg = sigSeg->next;
+      stream_put (s, bpa->data + sigBlock->offset, sigBlock->length);
     }
 
     // Now calculate the signatrue block length
     size_t sbEndPointer = stream_get_endp(s);
     uint16_t sbLength = (uint16_t)(sbEndPointer - sbPointer);
-    //stream_putw_at (s, sizep_PathLen, tmpBpa->securePathLen); // Secure_Path Len
-    stream_putw_at (s, sbPointer, sbLength); // Secure_Path Len
-
-    if (bpa->sigBlocks == sigBlock)
-    { // This block was the first one, move the head
-      bpa->sigBlocks = sigBlock->next;
-    }
-    else if (prevBlock != NULL)
-    { // The block was not the first one. In case the list exceeds two blocks we
-      // might be somewhere in the middle. Now point the previous block to the
-      // next one
-      prevBlock->next = sigBlock->next;
-    }
-    // Now we can remove the signature block
-    bgpsec_sigBlock_free(sigBlock);
-    sigBlock = NULL;
+    stream_putw_at (s, sbPointer, sbLength);
   }
   // Now set the length of the attribute
   size_t endPtr = stream_get_endp(s);
   uint16_t attrLen = (uint16_t)(endPtr - attrLenPtr);
-  bgpsec_path_free(bpa);
-  bpa = NULL;
 
   return attrLen;
 }
@@ -1134,169 +555,26 @@ void test_print(struct BgpsecPdu pdu, size_t *bptr, char *sigbuff, char* hashbuf
  */
 void print_signature(struct BgpsecPathAttr *bpa)
 {
-  //struct BgpsecPathAttr *new_bpa;
-  struct PathSegment *seg = bpa->pathSegments;
-  struct SigBlock *sb = bpa->sigBlocks;
-  struct SigSegment *ss = sb->sigSegments;
+  struct BgpsecSigSegment ss;
+  int i;
 
-  if(seg && sb && ss);
+  if (bpa->numSigBlocks == 0)
+    return;
 
-  int i;
-  int sig_length = ss->sigLen;
+  bgpsec_sig_segment_read (bpa->data + bpa->sigBlocks[0].offset, &ss);
 
   if(zlog_default->maxlvl[ZLOG_DEST_STDOUT] > 0)
   {
   /* signature print out */
-    for(i=0; i<sig_length; i++ )
+    for(i=0; i<ss.sigLen; i++ )
     {
       if(i%16 ==0) printf("\n");
-      printf("%02x ", (unsigned char)ss->signature[i]);
+      printf("%02x ", ss.signature[i]);
     }
     printf(" - from[%s]\n", __FUNCTION__);
   }
 }
 
-int bgpsecSanityCheck(struct BgpsecPathAttr *bpa)
-{
-  struct PathSegment *seg;
-  struct SigBlock *sb;
-  struct SigSegment *ss;
-
-  if(!bpa)
-    return -1;
-
-  seg = bpa->pathSegments;
-  sb  = bpa->sigBlocks;
-
-  if(!seg || !sb)
-    return -1;
-
-  ss = sb->sigSegments;
-
-  if(!ss)
-    return -1;
-
-  if(!ss->signature || !ss->ski)
-    return -1;
-
-  return 0;
-}
-
-/**
- * This function duplicate the original attribute and its sub structures into a
- * new instance or generate a new empty one if requested. Freeing the memory
- * of the original one does NOT affect the duplicate.
- *
- * @param orig The original bgpsec path attribute (can be NULL)
- * @param newIfNULL generate a new empty structure if the original one is NULL.
- *
- * @return A copy of the given structure or a new one if the original is NULL
- *         and the attribute newIfNULL is set to true.
- */
-struct BgpsecPathAttr * bgpsecDup(struct BgpsecPathAttr *orig, bool newIfNULL)
-{
-  struct BgpsecPathAttr* new = NULL;
-
-  if(bgpsecSanityCheck(orig) == 0)
-  {
-    /* pointer links */
-    new = bgpsec_path_attr_all_new();
-
-    new->securePathLen = orig->securePathLen;
-
-    /* concatenation of Path_Segment */
-    concatPathSegment(new->pathSegments, orig->pathSegments);
-
-    /* concatenation of Sigature_Blocks and Signature_Segment inside this function */
-    concatSigBlock(new->sigBlocks, orig->sigBlocks);
-  }
-  else if ((new == NULL) && newIfNULL)
-  {
-    new = bgpsec_path_attr_new();
-  }
-
-  return new;
-}
-
-void concatSigSegment(struct SigSegment* const new, struct SigSegment * const orig)
-{
-  struct SigSegment *src = orig;
-  struct SigSegment *pnt = new;
-
-  while(pnt)
-  {
-    /* ski allocation and copy from original */
-    pnt->ski = calloc (1, BGPSEC_SKI_LENGTH);
-    assert(src->ski);
-    memcpy(pnt->ski, src->ski, BGPSEC_SKI_LENGTH);
-
-    pnt->sigLen = src->sigLen;
-
-    /* signature allocation and copy from original */
-    pnt->signature = calloc (1, src->sigLen);
-    assert(src->signature);
-    memcpy(pnt->signature, src->signature, src->sigLen);
-
-    if(src->next)
-    {
-      src       = src->next;
-      pnt->next = sigSegment_New();
-    }
-
-    pnt = pnt->next;
-  }
-
-}
-
-void concatSigBlock(struct SigBlock* const new, struct SigBlock * const orig)
-{
-
-  struct SigBlock *src = orig;
-  struct SigBlock *pnt = new;
-
-  while(pnt)
-  {
-    pnt->sigBlockLen = src->sigBlockLen;
-    pnt->algoSuiteId = src->algoSuiteId;
-
-    concatSigSegment(pnt->sigSegments, src->sigSegments);
-
-    if(src->next)
-    {
-      src       = src->next;
-      pnt->next = sigBlock_New();
-    }
-
-    pnt = pnt->next;
-  }
-
-}
-
-void concatPathSegment(struct PathSegment * const new_seg,
-                       struct PathSegment * const orig)
-{
-
-  /* concatenation of path segemnts */
-  struct PathSegment *src = orig;
-  struct PathSegment *pntSeg = new_seg;
-
-  while(pntSeg)
-  {
-    pntSeg->as       = src->as;
-    pntSeg->pCount   = src->pCount;
-    pntSeg->flags    = src->flags;
-
-    if(src->next)
-    {
-      src = src->next;
-      pntSeg->next = pathSegment_New();
-    }
-
-    pntSeg = pntSeg->next;
-  }
-
-}
-
 
 /**
  * @brief convert into binary value, faster than stdio functions
@@ -65,47 +65,42 @@
 #define OCTET_SIG_BLOCK_LEN         2
 #define OCTET_SIGNATURE_LEN         2
 
-/* BGPSEC_PATH segment data in abstracted form, no limit is placed on length */
-struct PathSegment
+/* Signature_Block of a BGPSEC path attribute.  Its Signature_Segments stay
+ * in wire format within the attribute data. */
+struct BgpsecSigBlock
 {
-  struct PathSegment    *next;
-  u_int32_t             as;
-  u_int8_t              pCount;
-  u_int8_t              flags;
-  unsigned long         refcnt;
-};
-
-struct SigSegment
-{
-  struct SigSegment     *next;
-  u_char                *ski;
-  u_int16_t             sigLen;
-  u_char                *signature;
-  unsigned long         refcnt;
-};
-
-struct SigBlock
-{
-  struct SigBlock       *next;
-  u_int16_t             sigBlockLen;
   u_int8_t              algoSuiteId;
-  struct SigSegment     *sigSegments;
-  unsigned long         refcnt;
+  /* Position of the Signature_Segments within the attribute data. */
+  u_int16_t             offset;
+  u_int16_t             length;
 };
 
-/* BGPSEC path may be include some BGPSEC Segments.  */
+/* BGPSEC path attribute value in wire format, the Secure_Path followed by
+ * the Signature_Blocks, as checked by bgpsec_path_parse.  Segments are read
+ * in place with the accessors below. */
 struct BgpsecPathAttr
 {
+  const u_char          *data;
+  size_t                length;
+
+  /* Length of the Secure_Path including its length field. */
   size_t                securePathLen;
+  u_int16_t             numSegments;
 
-  /* segment data */
-  struct PathSegment    *pathSegments;
-  struct SigBlock       *sigBlocks;
+  u_int8_t              numSigBlocks;
+  struct BgpsecSigBlock sigBlocks[BGPSEC_MAX_SIGBLOCK];
 
   /* Reference count to this bgpsec path.  */
   unsigned long         refcnt;
 };
 
+/* Signature_Segment read from the attribute data. */
+struct BgpsecSigSegment
+{
+  const u_char          *ski;
+  u_int16_t             sigLen;
+  const u_char          *signature;
+};
 
 /* BGPSEC protocol pdu format structure */
 struct BgpsecPdu
@@ -129,6 +124,46 @@ put_u32(void *p, u_int32_t x)
   memcpy(p, &x, 4);
 }
 
+/* Secure_Path segment idx of the attribute: pCount, flags and AS number. */
+static inline const u_char *
+bgpsec_path_segment (const struct BgpsecPathAttr *bpa, int idx)
+{
+  return bpa->data + OCTET_SECURE_PATH_LEN + idx * OCTET_SECURE_PATH_SEGMENT;
+}
+
+static inline u_int8_t
+bgpsec_path_segment_pcount (const struct BgpsecPathAttr *bpa, int idx)
+{
+  return bgpsec_path_segment (bpa, idx)[0];
+}
+
+static inline u_int8_t
+bgpsec_path_segment_flags (const struct BgpsecPathAttr *bpa, int idx)
+{
+  return bgpsec_path_segment (bpa, idx)[1];
+}
+
+static inline u_int32_t
+bgpsec_path_segment_as (const struct BgpsecPathAttr *bpa, int idx)
+{
+  u_int32_t as;
+
+  memcpy (&as, bgpsec_path_segment (bpa, idx) + 2, sizeof (as));
+  return ntohl (as);
+}
+
+/* Read the Signature_Segment at p and return where the next one starts.
+ * The segments of block n end at data + sigBlocks[n].offset
+ * + sigBlocks[n].length. */
+static inline const u_char *
+bgpsec_sig_segment_read (const u_char *p, struct BgpsecSigSegment *ss)
+{
+  ss->ski       = p;
+  ss->sigLen    = (p[BGPSEC_SKI_LENGTH] << 8) | p[BGPSEC_SKI_LENGTH + 1];
+  ss->signature = p + BGPSEC_SKI_LENGTH + OCTET_SIGNATURE_LEN;
+  return ss->signature + ss->sigLen;
+}
+
 extern int bgpsecSignDataWithAsciiSKI();
 struct BgpsecPathAttr *bgpsec_path_intern (struct BgpsecPathAttr *bpa);
 void bgpsec_path_unintern (struct BgpsecPathAttr **pbpa);
@@ -143,23 +178,6 @@ void bgpsec_path_attr_init (void);
 SRxCryptoAPI* getSrxCAPI();
 int bgpsec_path_attr_cmp (const void *arg1, const void *arg2);
 unsigned int bgpsec_path_attr_key_make (void *p);
-/**
- * This function duplicate the original attribute and its sub structures into a 
- * new instance or generate a new empty one if requested. Freeing the memory
- * of the original one does NOT affect the duplicate.
- * 
- * @param orig The original bgpsec path attribute (can be NULL)
- * @param newIfNULL generate a new empty structure if the original one is NULL.
- * 
- * @return A copy of the given structure or a new one if the original is NULL 
- *         and the attribute newIfNULL is set to true.
- */
-struct BgpsecPathAttr * bgpsecDup(struct BgpsecPathAttr *orig, bool newIfNULL);
-
-void concatPathSegment(struct PathSegment * const , struct PathSegment * const);
-void concatSigSegment(struct SigSegment* const , struct SigSegment * const);
-void concatSigBlock(struct SigBlock* const , struct SigBlock * const);
-
 /**
  * @brief bgpsecVerify library function caller from external calling,
  * i.e., bgp_info_set_validation_result() at bgp_route.c
@@ -195,23 +213,20 @@ int constructBGPSecPathAttribute(struct bgp *bgp, struct peer *peer,
                                  u_int8_t flags, u_int8_t pCount,
                                  SCA_Signature** signature, int numSignatures);
 
-int bgpsecSanityCheck(struct BgpsecPathAttr *);
-
 /**
- * This function parses the byte stream and generates the internal
- * bgpsecPathAttr structure. In case the handed update is malformed no
- * bgpsecPathAttr is generated and the return value is NULL
+ * Check the structure of a BGPSEC path attribute value and record where its
+ * segments are. Nothing is copied, bpa refers to the given data afterwards;
+ * bgpsec_path_intern makes the copy that is kept.
  *
- * @param attr The attribute.
- * @param peer The bgpsec session information
- * @param s The stream containing the attribute information.
- * @param length total length of bgpsec pdu including Secure_Path and Signature_Block
+ * @param bpa The attribute view to fill in.
+ * @param data The attribute value, Secure_Path followed by Signature_Blocks.
+ * @param length The length of the attribute value.
  *
- * @return The BgpsecPathAttr as pointer structure or NULL in case the BGPSEC
- *         attribute is malformed. 
+ * @return BGPSEC_SUCCESS or BGPSEC_FAILURE in case the attribute is
+ *         malformed.
  */
-struct BgpsecPathAttr* bgpsec_parse(struct attr *attr, struct peer *peer, 
-                                    struct stream* s, size_t length);
+int bgpsec_path_parse (struct BgpsecPathAttr *bpa, const u_char *data,
+                       size_t length);
 
 /**
  * This method does call the signing of the BGPSEC path attribute. This method
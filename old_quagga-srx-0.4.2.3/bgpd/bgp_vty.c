@@ -2140,6 +2140,109 @@ DEFUN (srx_keepwindow,
   return CMD_SUCCESS;
 }
 
+DEFUN (srx_walk_batch,
+       srx_walk_batch_cmd,
+       SRX_VTY_CMD_WALK_BATCH,
+       SRX_VTY_HLP_WALK_BATCH)
+{
+  struct bgp *bgp;
+
+  bgp = vty->index;
+  VTY_GET_INTEGER_RANGE ("walk batch", bgp->srx_walk_batch, argv[0],
+                         1, 65535);
+
+  return CMD_SUCCESS;
+}
+
+DEFUN (srx_show_walk,
+       srx_show_walk_cmd,
+       SRX_VTY_CMD_SHOW_WALK,
+       SRX_VTY_HLP_SHOW_WALK)
+{
+  struct bgp *bgp;
+  struct srx_walk *walk;
+  int type;
+  time_t now;
+
+  bgp = vty->index;
+  now = bgp_clock ();
+
+  vty_out (vty, "SRx RIB walk settings:%s", VTY_NEWLINE);
+  vty_out (vty, "  walk-batch.....: %u%s", bgp->srx_walk_batch, VTY_NEWLINE);
+
+  for (type = 0; type < SRX_WALK_MAX; type++)
+  {
+    walk = &bgp->srx_walk[type];
+    vty_out (vty, "SRx %s:%s", srx_bgp_walk_name (type), VTY_NEWLINE);
+    if (walk->runs == 0)
+    {
+      vty_out (vty, "  state..........: never started%s", VTY_NEWLINE);
+      continue;
+    }
+    if (walk->active)
+    {
+      vty_out (vty, "  state..........: running (%s %s)%s",
+               walk->afi == AFI_IP6 ? "IPv6"
+                 : walk->safi == SAFI_MPLS_VPN ? "VPNv4" : "IPv4",
+               walk->safi == SAFI_MULTICAST ? "Multicast" : "Unicast",
+               VTY_NEWLINE);
+    }
+    else
+    {
+      vty_out (vty, "  state..........: %s%s",
+               walk->finished != 0 ? "completed" : "aborted", VTY_NEWLINE);
+    }
+    vty_out (vty, "  runs...........: %lu%s", walk->runs, VTY_NEWLINE);
+    vty_out (vty, "  nodes..........: %lu%s", walk->nodes, VTY_NEWLINE);
+    vty_out (vty, "  paths..........: %lu%s", walk->paths, VTY_NEWLINE);
+    vty_out (vty, "  cycles.........: %lu%s", walk->cycles, VTY_NEWLINE);
+    vty_out (vty, "  duration.......: %lds%s",
+             (long)((walk->finished != 0 ? walk->finished : now)
+                    - walk->started), VTY_NEWLINE);
+  }
+
+  return CMD_SUCCESS;
+}
+
+DEFUN (srx_show_bgpsec_cache,
+       srx_show_bgpsec_cache_cmd,
+       SRX_VTY_CMD_SHOW_BGPSEC_CACHE,
+       SRX_VTY_HLP_SHOW_BGPSEC_CACHE)
+{
+  struct bgp *bgp;
+  SCA_CacheStatistics stats;
+
+  bgp = vty->index;
+
+  if (bgp->srxCAPI == NULL
+      || !bgp->srxCAPI->getCacheStatistics (&stats))
+  {
+    vty_out (vty, "The crypto library keeps no BGPsec signature cache%s",
+             VTY_NEWLINE);
+    return CMD_SUCCESS;
+  }
+
+  vty_out (vty, "BGPsec signature cache:%s", VTY_NEWLINE);
+  vty_out (vty, "  capacity.......: %u%s", stats.capacity, VTY_NEWLINE);
+  vty_out (vty, "  entries........: %u%s", stats.entries, VTY_NEWLINE);
+  vty_out (vty, "  lookups........: %llu%s",
+           (unsigned long long)stats.lookups, VTY_NEWLINE);
+  vty_out (vty, "  hits...........: %llu (%.1f%%)%s",
+           (unsigned long long)stats.hits,
+           stats.lookups != 0 ? 100.0 * stats.hits / stats.lookups : 0.0,
+           VTY_NEWLINE);
+  vty_out (vty, "  skipped sigs...: %llu%s",
+           (unsigned long long)stats.hitSegments, VTY_NEWLINE);
+  vty_out (vty, "  inserts........: %llu%s",
+           (unsigned long long)stats.inserts, VTY_NEWLINE);
+  vty_out (vty, "  evictions......: %llu%s",
+           (unsigned long long)stats.evictions, VTY_NEWLINE);
+  vty_out (vty, "  flushes........: %llu%s",
+           (unsigned long long)stats.flushes, VTY_NEWLINE);
+
+  return CMD_SUCCESS;
+}
+
 DEFUN (srx_proxyid,
        srx_proxyid_cmd,
        SRX_VTY_CMD_PROXYID,
@@ -10421,6 +10524,9 @@ bgp_vty_init (void)
 
   install_element (BGP_NODE, &srx_keepwindow_cmd);
   install_element (BGP_NODE, &srx_proxyid_cmd);
+  install_element (BGP_NODE, &srx_walk_batch_cmd);
+  install_element (BGP_NODE, &srx_show_walk_cmd);
+  install_element (BGP_NODE, &srx_show_bgpsec_cache_cmd);
 
   install_element (BGP_NODE, &srx_policy_local_preference_var_cmd);
   install_element (BGP_NODE, &srx_policy_local_preference_fix_cmd);
@@ -2370,16 +2370,6 @@ peer_group_unbind (struct bgp *bgp, struct peer *peer,
 
 #ifdef USE_SRX
 
-static void srxLockUpdate(struct bgp_info* info)
-{
-  // TODO LOCK MUTEX OR WHATEVER
-}
-
-static void srxUnLockUpdate(struct bgp_info* info)
-{
-  // TODO UNLOCK MUTEX OR WHATEVER
-}
-
 /**
  * This method receives communication inform of codes from the SRX API. These
  * communications can be errors or other codes that are of importance for
@@ -2396,6 +2386,208 @@ void handleSRxMessages(SRxProxyCommCode mainCode, int subCode, void* userPtr)
   threadControlCall((int)mainCode);
 }
 
+/**
+ * Work queue function of the BGPsec validation queue. Validates the BGPsec path
+ * of up to SRX_BGPSEC_BATCH pending updates with one call to the SRx Crypto API
+ * and stores their BGPsec validation results.
+ *
+ * @param wq The BGPsec validation queue
+ * @param data The pending updates
+ *
+ * @return WQ_REQUEUE if updates are left, otherwise WQ_SUCCESS.
+ */
+static wq_item_status srx_bgpsec_queue_process (struct work_queue *wq,
+                                                void *data)
+{
+  struct srx_bgpsec_queue*   queue = (struct srx_bgpsec_queue*)data;
+  struct bgp*                bgp   = queue->bgp;
+  struct srx_bgpsec_pending* pending;
+  SCA_BGPSecValidationData*  valData[SRX_BGPSEC_BATCH];
+  int                        results[SRX_BGPSEC_BATCH];
+  u_int32_t                  valIdx[SRX_BGPSEC_BATCH];
+  u_int32_t                  num   = queue->count - queue->head;
+  u_int32_t                  idx;
+  int                        noData = 0;
+  int                        vIdx   = 0;
+
+  if (num > SRX_BGPSEC_BATCH)
+  {
+    num = SRX_BGPSEC_BATCH;
+  }
+  pending      = queue->pending + queue->head;
+  queue->head += num;
+
+  for (idx = 0; idx < num; idx++)
+  {
+    if (bgp->srxCAPI != NULL
+        && !CHECK_FLAG (pending[idx].info->flags, BGP_INFO_REMOVED)
+        && pending[idx].info->attr->bgpsec_validationData != NULL)
+    {
+      valData[noData] = pending[idx].info->attr->bgpsec_validationData;
+      valIdx[noData]  = idx;
+      noData++;
+    }
+  }
+
+  if (noData > 0)
+  {
+    bgp->srxCAPI->validateBatch(valData, noData, results);
+  }
+
+  for (idx = 0; idx < num; idx++)
+  {
+    if (vIdx < noData && valIdx[vIdx] == idx)
+    {
+      // Now CAPI validation result and the SRx Validation result are
+      // different values. We need to adjust them.
+      if (results[vIdx] == API_VALRESULT_VALID)
+      {
+        pending[idx].bgpsecResult = SRx_RESULT_VALID;
+      }
+      else
+      {
+        pending[idx].bgpsecResult = SRx_RESULT_INVALID;
+        if ((valData[vIdx]->status & API_STATUS_ERROR_MASK) > 0)
+        {
+          zlog_err("Update [0x%08X] validation returned invalid with an error: status=0x%X\n",
+                   pending[idx].info->updateID, valData[vIdx]->status);
+        }
+      }
+      vIdx++;
+    }
+
+    // Only the BGPsec result, the origin result was stored when the update
+    // was queued and may have been updated by srx-server since.
+    if (!CHECK_FLAG (pending[idx].info->flags, BGP_INFO_REMOVED))
+    {
+      bgp_info_set_validation_result (pending[idx].info, VRT_BGPSEC,
+                                      pending[idx].info->val_res_ROA,
+                                      pending[idx].bgpsecResult);
+    }
+    bgp_info_unlock (pending[idx].info);
+  }
+
+  if (queue->head < queue->count)
+  {
+    return WQ_REQUEUE;
+  }
+  queue->head  = 0;
+  queue->count = 0;
+  return WQ_SUCCESS;
+}
+
+/**
+ * Called by the BGPsec validation queue when the pending updates are removed
+ * from the queue. Releases the updates that were not validated.
+ *
+ * @param wq The BGPsec validation queue
+ * @param data The pending updates
+ */
+static void srx_bgpsec_queue_del (struct work_queue *wq, void *data)
+{
+  struct srx_bgpsec_queue* queue = (struct srx_bgpsec_queue*)data;
+
+  for (; queue->head < queue->count; queue->head++)
+  {
+    bgp_info_unlock (queue->pending[queue->head].info);
+  }
+  queue->head   = 0;
+  queue->count  = 0;
+  queue->active = 0;
+  bgp_unlock (queue->bgp);
+}
+
+/**
+ * Queue the update for the local BGPsec path validation. Its BGPsec validation
+ * result is stored once the path is validated.
+ *
+ * @param bgp The bgp router
+ * @param info The update
+ * @param bgpsecResult The path validation result of srx-server, stored if the
+ *                     path can not be validated locally.
+ */
+static void srx_bgpsec_queue_add (struct bgp *bgp, struct bgp_info *info,
+                                  uint8_t bgpsecResult)
+{
+  struct srx_bgpsec_queue*   queue = &bgp->srx_bgpsec_queue;
+  struct srx_bgpsec_pending* item;
+
+  if (bgp->srx_bgpsec_wq == NULL)
+  {
+    bgp->srx_bgpsec_wq = work_queue_new (bm->master, "srx_bgpsec_queue");
+    if (bgp->srx_bgpsec_wq == NULL)
+    {
+      zlog_err ("%s: Failed to allocate work queue", __func__);
+      bgp_info_set_validation_result (info, VRT_BGPSEC, info->val_res_ROA,
+                                      bgpsecResult);
+      return;
+    }
+    // Collect the results of a few reads from srx-server in one batch
+    bgp->srx_bgpsec_wq->spec.hold          = 10;
+    bgp->srx_bgpsec_wq->spec.workfunc      = &srx_bgpsec_queue_process;
+    bgp->srx_bgpsec_wq->spec.del_item_data = &srx_bgpsec_queue_del;
+    bgp->srx_bgpsec_wq->spec.max_retries   = 0;
+  }
+
+  if (queue->count == queue->size)
+  {
+    if (queue->head > 0)
+    {
+      // Reuse the space of the updates validated already
+      queue->count -= queue->head;
+      memmove (queue->pending, queue->pending + queue->head,
+               queue->count * sizeof (struct srx_bgpsec_pending));
+      queue->head = 0;
+    }
+    else
+    {
+      queue->size    = queue->size ? queue->size * 2 : SRX_BGPSEC_BATCH;
+      queue->pending = XREALLOC (MTYPE_BGPSEC_VAL_QUEUE, queue->pending,
+                         queue->size * sizeof (struct srx_bgpsec_pending));
+    }
+  }
+
+  item = &queue->pending[queue->count++];
+  item->info         = bgp_info_lock (info);
+  item->bgpsecResult = bgpsecResult;
+
+  if (!queue->active)
+  {
+    queue->active = 1;
+    queue->bgp    = bgp;
+    bgp_lock (bgp); /* srx_bgpsec_queue_del */
+    work_queue_add (bgp->srx_bgpsec_wq, queue);
+  }
+}
+
+/**
+ * Drop all pending BGPsec validations of this router and release the BGPsec
+ * validation queue.
+ *
+ * @param bgp The bgp router
+ */
+static void srx_bgpsec_queue_cancel (struct bgp *bgp)
+{
+  if (bgp->srx_bgpsec_wq == NULL)
+  {
+    return;
+  }
+
+  // work_queue_free does not call del_item_data, release the updates here.
+  if (bgp->srx_bgpsec_queue.active)
+  {
+    srx_bgpsec_queue_del (bgp->srx_bgpsec_wq, &bgp->srx_bgpsec_queue);
+  }
+  work_queue_free (bgp->srx_bgpsec_wq);
+  bgp->srx_bgpsec_wq = NULL;
+
+  if (bgp->srx_bgpsec_queue.pending != NULL)
+  {
+    XFREE (MTYPE_BGPSEC_VAL_QUEUE, bgp->srx_bgpsec_queue.pending);
+  }
+  bgp->srx_bgpsec_queue.size = 0;
+}
+
 /**
  * Called by proxy once notifications are received. Will either update the
  * validation state or in case the update is not known, respond with a delete to
@@ -2436,25 +2628,24 @@ bool handleSRxValidationResult (SRxUpdateID updateID, uint32_t localID,
       // in case no srx-server is available.
 
       //------ To be deleted later on-----------
-      if (bgp->srxCAPI != NULL && info->attr->bgpsec_validationData != NULL)
+      if (bgp->srxCAPI != NULL && info->attr->bgpsec_validationData != NULL
+          && (valType & VRT_BGPSEC) != 0)
       {
-        // Now CAPI validation result and the SRx Validation result are different
-        // values. We need to adjust them.
-        int valResult = bgp->srxCAPI->validate(info->attr->bgpsec_validationData);
-        bgpsecResult = valResult == API_VALRESULT_VALID ? SRx_RESULT_VALID
-                                                        : SRx_RESULT_INVALID;
-
-        if (bgpsecResult == SRx_RESULT_INVALID)
+        // The origin result is stored now. The path is validated together
+        // with the other updates received meanwhile, srx_bgpsec_queue_process
+        // stores only the BGPsec result, so that it does not overwrite a newer
+        // origin result received from srx-server in the meantime.
+        if ((valType & VRT_ROA) != 0)
         {
-          if ((info->attr->bgpsec_validationData->status & API_STATUS_ERROR_MASK) > 0)
-          {
-            zlog_err("Update [0x%08X] validation returned invalid with an error: status=0x%X\n",
-                    updateID, info->attr->bgpsec_validationData->status);
-          }
+          bgp_info_set_validation_result (info, VRT_ROA, roaResult,
+                                          bgpsecResult);
         }
+        srx_bgpsec_queue_add (bgp, info, bgpsecResult);
+      }
+      else
+      {
+        bgp_info_set_validation_result (info, valType, roaResult, bgpsecResult);
       }
-
-      bgp_info_set_validation_result (info, valType, roaResult, bgpsecResult);
       retVal = true;
     }
   }
@@ -2493,38 +2684,6 @@ void handleSRxSignatures(SRxUpdateID updateID, BGPSecCallbackData* data,
   // TODO: Add the signature to the update that was/will be send out.
 }
 
-/**
- * Send a validation request for each update in the given table.
- *
- * @param bgp
- * @param table
- */
-static void _handleSRxSynchRequest_processTable(struct bgp* bgp,
-                                                struct bgp_table* table)
-{
-  struct bgp_info *binfo;
-  struct bgp_node *bnode;
-
-  SRxDefaultResult defResult;
-
-  /* Start processing of routes. */
-  for (bnode = bgp_table_top(table); bnode; bnode = bgp_route_next(bnode))
-  {
-    if (bnode->info != NULL)
-    {
-      binfo  = (struct bgp_info*)bnode->info;
-      srxLockUpdate(binfo);
-      defResult.resSourceROA    = SRxRS_ROUTER;
-      defResult.resSourceBGPSEC = SRxRS_ROUTER;
-      defResult.result.roaResult    = binfo->val_res_ROA;
-      defResult.result.bgpsecResult = binfo->val_res_BGPSEC;
-      verify_update (bgp, binfo, &defResult, false);
-      srxUnLockUpdate(binfo);
-    }
-  }
-}
-
-
 /**
  * Called by proxy once a synchronization request is received. The request will
  * only be served as long as SRx is connected to the router, regardless of
@@ -2545,8 +2704,8 @@ void handleSRxSynchRequest(void* bgpRouter)
     return;
   }
 
-  _handleSRxSynchRequest_processTable(bgp, bgp->rib[AFI_IP][SAFI_MULTICAST]);
-  _handleSRxSynchRequest_processTable(bgp, bgp->rib[AFI_IP][SAFI_UNICAST]);
+  // Resend all paths of all tables in batches, see srx_bgp_walk_process
+  srx_bgp_walk_start(bgp, SRX_WALK_SYNCH);
 }
 
 /**
@@ -2565,13 +2724,17 @@ void srx_set_default(struct bgp *bgp)
   // TODO OB Update the default setting
   if(!bgp->info_uid_hash)
   {
-    bgp->info_uid_hash      = bgp_info_hash_init();
-    bgp->info_lid_hash      = bgp_info_hash_init();
+    // The RIB is still empty here, the indexes start small and grow with it.
+    // The update identifier index is reserved for all received paths before
+    // a synchronization walk, see srx_bgp_walk_start.
+    bgp->info_uid_hash      = bgp_info_hash_init(0);
+    bgp->info_lid_hash      = bgp_info_hash_init(0);
   }
   srx_set_proxyID(bgp, ntohl(bgp->router_id.s_addr));
   //bgp->srx_proxyID          = bgp->router_id.s_addr;
   bgp->srx_keepWindow       = SRX_KEEP_WINDOW;
   bgp->srx_handshakeTimeout = SRX_HANDHAKE_TIMEOUT;
+  bgp->srx_walk_batch       = SRX_WALK_BATCH_DEFAULT;
 
   // Can be turned off using config file
   bgp->srx_val_policy        = SRX_VAL_POLICY_IGNORE_UNDEFINED;
@@ -2795,6 +2958,13 @@ bgp_delete (struct bgp *bgp)
     bgp->peer_self = NULL;
   }
 
+#ifdef USE_SRX
+  /* Stop pending synchronization / apply-policy walks and BGPsec validations,
+   * they hold a lock. */
+  srx_bgp_walk_cancel (bgp);
+  srx_bgpsec_queue_cancel (bgp);
+#endif /* USE_SRX */
+
   /* Remove visibility via the master list - there may however still be
    * routes to be processed still referencing the struct bgp.
    */
@@ -5919,6 +6089,13 @@ static int srx_config_write_configuration (struct vty *vty, struct bgp *bgp)
   vty_out (vty, " %s %d%s", SRX_VTY_CMD_KEEPWINDOW_SHORT,
                 bgp->srx_keepWindow,  VTY_NEWLINE);
 
+  // RIB WALK BATCH SIZE
+  if (bgp->srx_walk_batch != SRX_WALK_BATCH_DEFAULT)
+  {
+    vty_out (vty, " %s %u%s", SRX_VTY_CMD_WALK_BATCH_SHORT,
+                  bgp->srx_walk_batch, VTY_NEWLINE);
+  }
+
   // EVALUATION MODE
   if (srx_config_check(bgp, SRX_CONFIG_EVAL_PATH))
   { // if this is set the ROA flag is set too -> BGPSEC
@@ -179,6 +179,23 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
                                  "Apply SRx policy changes to all updates in" \
                                  " the RIB.\n"
 
+// RIB WALK (SYNCHRONIZATION AND APPLY POLICY)
+#define SRX_VTY_CMD_WALK_BATCH_SHORT "srx walk-batch"
+#define SRX_VTY_CMD_WALK_BATCH  SRX_VTY_CMD_WALK_BATCH_SHORT " <1-65535>"
+#define SRX_VTY_HLP_WALK_BATCH  SRX_VTY_HLP_STR \
+                                "Configure the number of RIB nodes processed" \
+                                " per cycle during synchronization and" \
+                                " apply-policy.\n" \
+                                "Number of RIB nodes\n"
+
+#define SRX_VTY_CMD_SHOW_WALK   "show srx-walk"
+#define SRX_VTY_HLP_SHOW_WALK   SHOW_STR "Progress of the SRx synchronization" \
+                                " and apply-policy RIB walks\n"
+
+#define SRX_VTY_CMD_SHOW_BGPSEC_CACHE "show srx-bgpsec-cache"
+#define SRX_VTY_HLP_SHOW_BGPSEC_CACHE SHOW_STR "Statistics of the cache of" \
+                                " verified BGPsec signature segments\n"
+
 // POLICY
 #define SRX_VTY_HLP_POLICY      "Evaluation policy command\n"
 #define SRX_VTY_HLP_POLICY_ROA  "Prefix-origin validation using ROA's\n"
@@ -378,6 +395,69 @@ struct srx_local_pref {
   // the local pref value
   uint32_t value;
 };
+
+/** The type of RIB walk performed by the SRx walk queue. */
+typedef enum {
+  // Resend all paths to srx-server (synchronization request)
+  SRX_WALK_SYNCH   = 0,
+  // Re-run the best path selection on all nodes (apply-policy)
+  SRX_WALK_REQUEUE = 1,
+  SRX_WALK_MAX     = 2
+} SRxWalkType;
+
+/** Default number of RIB nodes processed per walk queue cycle. */
+#define SRX_WALK_BATCH_DEFAULT 500
+
+/** A resumable walk over all RIB tables of one bgp instance. The walk keeps
+ * a locked resume point and processes at most srx_walk_batch nodes before it
+ * hands control back to the thread scheduler. */
+struct srx_walk {
+  struct bgp*      bgp;
+  SRxWalkType      type;
+  // Set while the walk is queued in the walk queue.
+  int              active;
+  // The table currently walked.
+  afi_t            afi;
+  safi_t           safi;
+  // Set once the walk entered the table of the current AFI/SAFI.
+  int              inTable;
+  // For SAFI_MPLS_VPN the locked route distinguisher node.
+  struct bgp_node* prn;
+  // The locked node the walk resumes with, NULL if at start of table.
+  struct bgp_node* rn;
+  // Progress of the current (or last) walk.
+  unsigned long    nodes;
+  unsigned long    paths;
+  unsigned long    cycles;
+  unsigned long    runs;
+  time_t           started;
+  time_t           finished;
+};
+
+/** Maximum number of updates validated per BGPsec validation queue cycle. */
+#define SRX_BGPSEC_BATCH 256
+
+/** An update waiting for the local BGPsec path validation together with the
+ * BGPsec validation result received from srx-server, which is used if the path
+ * can not be validated locally. */
+struct srx_bgpsec_pending {
+  struct bgp_info* info;
+  uint8_t          bgpsecResult;
+};
+
+/** The updates whose BGPsec path is validated locally using the SRx Crypto
+ * API. The updates are collected while srx-server results are received and
+ * validated in batches from within a work queue. */
+struct srx_bgpsec_queue {
+  struct bgp*                bgp;
+  // Set while the queue is in the work queue.
+  int                        active;
+  // The pending updates, head is the next one to be validated.
+  struct srx_bgpsec_pending* pending;
+  u_int32_t                  head;
+  u_int32_t                  count;
+  u_int32_t                  size;
+};
 #endif /* USE_SRX */
 
 /* BGP instance structure.  */
@@ -550,6 +630,16 @@ struct bgp
 #define SRX_BGP_FLAG_ECOMMUNITY_EBGP (1 << 1)
   u_int8_t srx_ecommunity_flags;
   u_int8_t srx_ecommunity_subcode;
+
+  /** Work queue for resumable RIB walks (synchronization, apply-policy) */
+  struct work_queue* srx_walk_queue;
+  struct srx_walk    srx_walk[SRX_WALK_MAX];
+  /** Number of RIB nodes processed per walk queue cycle. */
+  u_int32_t          srx_walk_batch;
+
+  /** Work queue for the local BGPsec path validation. */
+  struct work_queue*      srx_bgpsec_wq;
+  struct srx_bgpsec_queue srx_bgpsec_queue;
 #endif /* USE_SRX */
 };
 
@@ -522,11 +522,63 @@ lsp_update_data (struct isis_lsp *lsp, struct stream *stream,
   return;
 }
 
+/*
+ * What of an LSP the shortest path tree depends on: whether it takes part
+ * at all, its bits, the protocols it speaks and its IS neighbors.
+ */
+static struct stream *
+lsp_topology (struct isis_lsp *lsp)
+{
+  struct stream *s;
+  struct listnode *node;
+  struct is_neigh *is_neigh;
+  struct te_is_neigh *te_is_neigh;
+  size_t size = 4 + sizeof (struct nlpids);
+
+  if (lsp->tlv_data.is_neighs)
+    size += listcount (lsp->tlv_data.is_neighs) * (ISIS_SYS_ID_LEN + 2);
+  if (lsp->tlv_data.te_is_neighs)
+    size += listcount (lsp->tlv_data.te_is_neighs) * (ISIS_SYS_ID_LEN + 4);
+
+  s = stream_new (size);
+  stream_putc (s, lsp->lsp_header->rem_lifetime == 0);
+  stream_putc (s, lsp->lsp_header->seq_num == 0);
+  stream_putc (s, lsp->lsp_header->lsp_bits);
+  if (lsp->tlv_data.nlpids)
+    {
+      stream_putc (s, lsp->tlv_data.nlpids->count);
+      stream_put (s, lsp->tlv_data.nlpids->nlpids,
+                  lsp->tlv_data.nlpids->count);
+    }
+  else
+    stream_putc (s, 0);
+
+  if (lsp->tlv_data.is_neighs)
+    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.is_neighs, node, is_neigh))
+      {
+        stream_put (s, is_neigh->neigh_id, ISIS_SYS_ID_LEN + 1);
+        stream_putc (s, is_neigh->metrics.metric_default);
+      }
+  if (lsp->tlv_data.te_is_neighs)
+    for (ALL_LIST_ELEMENTS_RO (lsp->tlv_data.te_is_neighs, node,
+                               te_is_neigh))
+      {
+        stream_put (s, te_is_neigh->neigh_id, ISIS_SYS_ID_LEN + 1);
+        stream_put (s, te_is_neigh->te_metric, 3);
+      }
+
+  return s;
+}
+
 void
 lsp_update (struct isis_lsp *lsp, struct stream *stream,
             struct isis_area *area, int level)
 {
   dnode_t *dnode = NULL;
+  struct stream *old_topology, *new_topology;
+  int same_topology;
+
+  old_topology = lsp_topology (lsp);
 
   /* Remove old LSP from database. This is required since the
    * lsp_update_data will free the lsp->pdu (which has the key, lsp_id)
@@ -538,8 +590,31 @@ lsp_update (struct isis_lsp *lsp, struct stream *stream,
   /* rebuild the lsp data */
   lsp_update_data (lsp, stream, area, level);
 
-  /* insert the lsp back into the database */
-  lsp_insert (lsp, area->lspdb[level - 1]);
+  new_topology = lsp_topology (lsp);
+  same_topology = (stream_get_endp (old_topology)
+                   == stream_get_endp (new_topology))
+                  && memcmp (STREAM_DATA (old_topology),
+                             STREAM_DATA (new_topology),
+                             stream_get_endp (new_topology)) == 0;
+  stream_free (old_topology);
+  stream_free (new_topology);
+
+  /* insert the lsp back into the database; if only the prefixes changed,
+   * the SPF can keep its tree and just compute the routes again */
+  if (!same_topology)
+    {
+      lsp_insert (lsp, area->lspdb[level - 1]);
+      return;
+    }
+
+  dict_alloc_insert (area->lspdb[level - 1], lsp->lsp_header->lsp_id, lsp);
+  if (lsp->lsp_header->seq_num != 0)
+    {
+      isis_spf_schedule_prc (lsp->area, lsp->level);
+#ifdef HAVE_IPV6
+      isis_spf_schedule6_prc (lsp->area, lsp->level);
+#endif
+    }
 }
 
 /* creation of LSP directly from what we received */
@@ -31,6 +31,8 @@
 #include "memory.h"
 #include "prefix.h"
 #include "hash.h"
+#include "jhash.h"
+#include "pqueue.h"
 #include "if.h"
 #include "table.h"
 
@@ -224,6 +226,7 @@ isis_vertex_new (void *id, enum vertextype vtype)
   vertex->Adj_N = list_new ();
   vertex->parents = list_new ();
   vertex->children = list_new ();
+  vertex->tent_index = -1;
 
   return vertex;
 }
@@ -259,6 +262,100 @@ isis_vertex_adj_del (struct isis_vertex *vertex, struct isis_adjacency *adj)
   return;
 }
 
+/* TENT is ordered by distance, then by vertextype, then first come first
+ * served. */
+static int
+isis_vertex_tent_cmp (void *a, void *b)
+{
+  struct isis_vertex *va = a, *vb = b;
+
+  if (va->d_N != vb->d_N)
+    return va->d_N < vb->d_N ? -1 : 1;
+  if (va->type != vb->type)
+    return va->type < vb->type ? -1 : 1;
+  if (va->tent_seq != vb->tent_seq)
+    return va->tent_seq < vb->tent_seq ? -1 : 1;
+  return 0;
+}
+
+static void
+isis_vertex_tent_update (void *node, int position)
+{
+  struct isis_vertex *vertex = node;
+
+  vertex->tent_index = position;
+}
+
+static int
+isis_vertex_id_len (enum vertextype vtype)
+{
+  switch (vtype)
+    {
+    case VTYPE_ES:
+    case VTYPE_NONPSEUDO_IS:
+    case VTYPE_NONPSEUDO_TE_IS:
+      return ISIS_SYS_ID_LEN;
+    case VTYPE_PSEUDO_IS:
+    case VTYPE_PSEUDO_TE_IS:
+      return ISIS_SYS_ID_LEN + 1;
+    default:
+      return 0;
+    }
+}
+
+static unsigned int
+isis_vertex_hash_key (void *arg)
+{
+  struct isis_vertex *vertex = arg;
+  struct prefix *p;
+  int len = isis_vertex_id_len (vertex->type);
+
+  if (len)
+    return jhash (vertex->N.id, len, vertex->type);
+
+  p = &vertex->N.prefix;
+  return jhash (&p->u.prefix, PSIZE (p->prefixlen),
+                (vertex->type << 16) | (p->family << 8) | p->prefixlen);
+}
+
+static int
+isis_vertex_hash_cmp (const void *a, const void *b)
+{
+  const struct isis_vertex *va = a, *vb = b;
+  const struct prefix *p1, *p2;
+  int len;
+
+  if (va->type != vb->type)
+    return 0;
+
+  len = isis_vertex_id_len (va->type);
+  if (len)
+    return memcmp (va->N.id, vb->N.id, len) == 0;
+
+  p1 = &va->N.prefix;
+  p2 = &vb->N.prefix;
+  return p1->family == p2->family && p1->prefixlen == p2->prefixlen
+         && memcmp (&p1->u.prefix, &p2->u.prefix, PSIZE (p1->prefixlen)) == 0;
+}
+
+static void
+init_spt (struct isis_spftree *spftree)
+{
+  int i;
+
+  for (i = 0; i < spftree->tents->size; i++)
+    isis_vertex_del (spftree->tents->array[i]);
+  spftree->tents->size = 0;
+  spftree->tent_seq = 0;
+
+  hash_clean (spftree->vertices, NULL);
+
+  spftree->paths->del = (void (*)(void *)) isis_vertex_del;
+  list_delete_all_node (spftree->paths);
+  spftree->paths->del = NULL;
+  return;
+}
+
 struct isis_spftree *
 isis_spftree_new (struct isis_area *area)
 {
@@ -271,9 +368,13 @@ isis_spftree_new (struct isis_area *area)
       return NULL;
     }
 
-  tree->tents = list_new ();
+  tree->tents = pqueue_create ();
+  tree->tents->cmp = isis_vertex_tent_cmp;
+  tree->tents->update = isis_vertex_tent_update;
+  tree->vertices = hash_create (isis_vertex_hash_key, isis_vertex_hash_cmp);
   tree->paths = list_new ();
   tree->area = area;
+  tree->full = 1;
   tree->last_run_timestamp = 0;
   tree->last_run_duration = 0;
   tree->runcount = 0;
@@ -286,11 +387,14 @@ isis_spftree_del (struct isis_spftree *spftree)
 {
   THREAD_TIMER_OFF (spftree->t_spf);
 
-  spftree->tents->del = (void (*)(void *)) isis_vertex_del;
-  list_delete (spftree->tents);
+  init_spt (spftree);
+
+  pqueue_delete (spftree->tents);
   spftree->tents = NULL;
 
-  spftree->paths->del = (void (*)(void *)) isis_vertex_del;
+  hash_free (spftree->vertices);
+  spftree->vertices = NULL;
+
   list_delete (spftree->paths);
   spftree->paths = NULL;
 
@@ -303,10 +407,11 @@ void
 isis_spftree_adj_del (struct isis_spftree *spftree, struct isis_adjacency *adj)
 {
   struct listnode *node;
+  int i;
   if (!adj)
     return;
-  for (node = listhead (spftree->tents); node; node = listnextnode (node))
-    isis_vertex_adj_del (listgetdata (node), adj);
+  for (i = 0; i < spftree->tents->size; i++)
+    isis_vertex_adj_del (spftree->tents->array[i], adj);
   for (node = listhead (spftree->paths); node; node = listnextnode (node))
     isis_vertex_adj_del (listgetdata (node), adj);
   return;
@@ -443,6 +548,7 @@ isis_spf_add_root (struct isis_spftree *spftree, int level, u_char *sysid)
     vertex = isis_vertex_new (sysid, VTYPE_NONPSEUDO_IS);
 
   listnode_add (spftree->paths, vertex);
+  hash_get (spftree->vertices, vertex, hash_alloc_intern);
 
 #ifdef EXTREME_DEBUG
   zlog_debug ("ISIS-Spf: added this IS  %s %s depth %d dist %d to PATHS",
@@ -453,67 +559,55 @@ isis_spf_add_root (struct isis_spftree *spftree, int level, u_char *sysid)
   return vertex;
 }
 
+/* Find a vertex of TENT or PATHS, tent_index tells which. */
 static struct isis_vertex *
-isis_find_vertex (struct list *list, void *id, enum vertextype vtype)
+isis_find_vertex (struct isis_spftree *spftree, void *id,
+                  enum vertextype vtype)
 {
-  struct listnode *node;
-  struct isis_vertex *vertex;
-  struct prefix *p1, *p2;
+  struct isis_vertex key;
+  int len = isis_vertex_id_len (vtype);
 
-  for (ALL_LIST_ELEMENTS_RO (list, node, vertex))
-    {
-      if (vertex->type != vtype)
-	continue;
-      switch (vtype)
-	{
-	case VTYPE_ES:
-	case VTYPE_NONPSEUDO_IS:
-	case VTYPE_NONPSEUDO_TE_IS:
-	  if (memcmp ((u_char *) id, vertex->N.id, ISIS_SYS_ID_LEN) == 0)
-	    return vertex;
-	  break;
-	case VTYPE_PSEUDO_IS:
-	case VTYPE_PSEUDO_TE_IS:
-	  if (memcmp ((u_char *) id, vertex->N.id, ISIS_SYS_ID_LEN + 1) == 0)
-	    return vertex;
-	  break;
-	case VTYPE_IPREACH_INTERNAL:
-	case VTYPE_IPREACH_EXTERNAL:
-	case VTYPE_IPREACH_TE:
-#ifdef HAVE_IPV6
-	case VTYPE_IP6REACH_INTERNAL:
-	case VTYPE_IP6REACH_EXTERNAL:
-#endif /* HAVE_IPV6 */
-	  p1 = (struct prefix *) id;
-	  p2 = (struct prefix *) &vertex->N.id;
-	  if (p1->family == p2->family && p1->prefixlen == p2->prefixlen &&
-	      memcmp (&p1->u.prefix, &p2->u.prefix,
-		      PSIZE (p1->prefixlen)) == 0)
-	    return vertex;
-	  break;
-	}
-    }
+  key.type = vtype;
+  if (len)
+    memcpy (key.N.id, id, len);
+  else
+    memcpy (&key.N.prefix, id, sizeof (struct prefix));
 
-  return NULL;
+  return hash_lookup (spftree->vertices, &key);
+}
+
+/* Remove a vertex from TENT, when a shorter path to it was found. */
+static void
+isis_tent_del (struct isis_spftree *spftree, struct isis_vertex *vertex)
+{
+  struct listnode *pnode, *pnextnode;
+  struct isis_vertex *pvertex;
+
+  pqueue_remove_at (vertex->tent_index, spftree->tents);
+  hash_release (spftree->vertices, vertex);
+  assert (listcount (vertex->children) == 0);
+  for (ALL_LIST_ELEMENTS (vertex->parents, pnode, pnextnode, pvertex))
+    listnode_delete (pvertex->children, vertex);
+  isis_vertex_del (vertex);
 }
 
 /*
- * Add a vertex to TENT sorted by cost and by vertextype on tie break situation
+ * Add a vertex to TENT, which keeps it sorted by cost and by vertextype on
+ * tie break situation
  */
 static struct isis_vertex *
 isis_spf_add2tent (struct isis_spftree *spftree, enum vertextype vtype,
 		   void *id, uint32_t cost, int depth, int family,
 		   struct isis_adjacency *adj, struct isis_vertex *parent)
 {
-  struct isis_vertex *vertex, *v;
+  struct isis_vertex *vertex;
   struct listnode *node;
   struct isis_adjacency *parent_adj;
 #ifdef EXTREME_DEBUG
   u_char buff[BUFSIZ];
 #endif
 
-  assert (isis_find_vertex (spftree->paths, id, vtype) == NULL);
-  assert (isis_find_vertex (spftree->tents, id, vtype) == NULL);
+  assert (isis_find_vertex (spftree, id, vtype) == NULL);
   vertex = isis_vertex_new (id, vtype);
   vertex->d_N = cost;
   vertex->depth = depth;
@@ -538,31 +632,9 @@ isis_spf_add2tent (struct isis_spftree *spftree, enum vertextype vtype,
 	      vertex->depth, vertex->d_N, listcount(vertex->Adj_N));
 #endif /* EXTREME_DEBUG */
 
-  if (list_isempty (spftree->tents))
-    {
-      listnode_add (spftree->tents, vertex);
-      return vertex;
-    }
-
-  /* XXX: This cant use the standard ALL_LIST_ELEMENTS macro */
-  for (node = listhead (spftree->tents); node; node = listnextnode (node))
-    {
-      v = listgetdata (node);
-      if (v->d_N > vertex->d_N)
-	{
-	  list_add_node_prev (spftree->tents, node, vertex);
-	  break;
-	}
-      else if (v->d_N == vertex->d_N && v->type > vertex->type)
-	{
-	  /*  Tie break, add according to type */
-          list_add_node_prev (spftree->tents, node, vertex);
-	  break;
-	}
-    }
-
-  if (node == NULL)
-      listnode_add (spftree->tents, vertex);
+  vertex->tent_seq = spftree->tent_seq++;
+  pqueue_enqueue (vertex, spftree->tents);
+  hash_get (spftree->vertices, vertex, hash_alloc_intern);
 
   return vertex;
 }
@@ -574,9 +646,9 @@ isis_spf_add_local (struct isis_spftree *spftree, enum vertextype vtype,
 {
   struct isis_vertex *vertex;
 
-  vertex = isis_find_vertex (spftree->tents, id, vtype);
+  vertex = isis_find_vertex (spftree, id, vtype);
 
-  if (vertex)
+  if (vertex && vertex->tent_index >= 0)
     {
       /* C.2.5   c) */
       if (vertex->d_N == cost)
@@ -599,13 +671,7 @@ isis_spf_add_local (struct isis_spftree *spftree, enum vertextype vtype,
 	}
       else {  /* vertex->d_N > cost */
 	  /*         f) */
-	  struct listnode *pnode, *pnextnode;
-	  struct isis_vertex *pvertex;
-	  listnode_delete (spftree->tents, vertex);
-	  assert (listcount (vertex->children) == 0);
-	  for (ALL_LIST_ELEMENTS (vertex->parents, pnode, pnextnode, pvertex))
-	    listnode_delete(pvertex->children, vertex);
-	  isis_vertex_del (vertex);
+	  isis_tent_del (spftree, vertex);
       }
     }
 
@@ -639,8 +705,8 @@ process_N (struct isis_spftree *spftree, enum vertextype vtype, void *id,
     }
 
   /*       c)    */
-  vertex = isis_find_vertex (spftree->paths, id, vtype);
-  if (vertex)
+  vertex = isis_find_vertex (spftree, id, vtype);
+  if (vertex && vertex->tent_index < 0)
     {
 #ifdef EXTREME_DEBUG
       zlog_debug ("ISIS-Spf: process_N %s %s %s dist %d already found from PATH",
@@ -651,7 +717,6 @@ process_N (struct isis_spftree *spftree, enum vertextype vtype, void *id,
       return;
     }
 
-  vertex = isis_find_vertex (spftree->tents, id, vtype);
   /*       d)    */
   if (vertex)
     {
@@ -687,13 +752,7 @@ process_N (struct isis_spftree *spftree, enum vertextype vtype, void *id,
 	}
       else
 	{
-	  struct listnode *pnode, *pnextnode;
-	  struct isis_vertex *pvertex;
-	  listnode_delete (spftree->tents, vertex);
-	  assert (listcount (vertex->children) == 0);
-	  for (ALL_LIST_ELEMENTS (vertex->parents, pnode, pnextnode, pvertex))
-	    listnode_delete(pvertex->children, vertex);
-	  isis_vertex_del (vertex);
+	  isis_tent_del (spftree, vertex);
 	}
     }
 
@@ -713,7 +772,8 @@ process_N (struct isis_spftree *spftree, enum vertextype vtype, void *id,
 static int
 isis_spf_process_lsp (struct isis_spftree *spftree, struct isis_lsp *lsp,
 		      uint32_t cost, uint16_t depth, int family,
-		      u_char *root_sysid, struct isis_vertex *parent)
+		      u_char *root_sysid, struct isis_vertex *parent,
+		      int prefixes_only)
 {
   struct listnode *node, *fragnode = NULL;
   uint32_t dist;
@@ -742,7 +802,7 @@ lspfragloop:
       zlog_debug ("ISIS-Spf: process_lsp %s", print_sys_hostname(lsp->lsp_header->lsp_id));
 #endif /* EXTREME_DEBUG */
 
-  if (!ISIS_MASK_LSP_OL_BIT (lsp->lsp_header->lsp_bits))
+  if (!prefixes_only && !ISIS_MASK_LSP_OL_BIT (lsp->lsp_header->lsp_bits))
   {
     if (lsp->tlv_data.is_neighs)
     {
@@ -931,7 +991,7 @@ pseudofragloop:
 static int
 isis_spf_preload_tent (struct isis_spftree *spftree, int level,
 		       int family, u_char *root_sysid,
-		       struct isis_vertex *parent)
+		       struct isis_vertex *parent, int prefixes_only)
 {
   struct isis_circuit *circuit;
   struct listnode *cnode, *anode, *ipnode;
@@ -989,6 +1049,8 @@ isis_spf_preload_tent (struct isis_spftree *spftree, int level,
 	    }
 	}
 #endif /* HAVE_IPV6 */
+      if (prefixes_only)
+	continue;
       if (circuit->circ_type == CIRCUIT_T_BROADCAST)
 	{
 	  /*
@@ -1134,8 +1196,6 @@ add_to_paths (struct isis_spftree *spftree, struct isis_vertex *vertex,
 {
   u_char buff[BUFSIZ];
 
-  if (isis_find_vertex (spftree->paths, vertex->N.id, vertex->type))
-    return;
   listnode_add (spftree->paths, vertex);
 
 #ifdef EXTREME_DEBUG
@@ -1159,81 +1219,44 @@ add_to_paths (struct isis_spftree *spftree, struct isis_vertex *vertex,
   return;
 }
 
-static void
-init_spt (struct isis_spftree *spftree)
+/*
+ * C.2.5 Step 0 b), from the circuits of this system or, for another root,
+ * from its LSP
+ */
+static int
+isis_spf_preload_root (struct isis_spftree *spftree, int level, int family,
+		       u_char *sysid, struct isis_vertex *root_vertex,
+		       int prefixes_only)
 {
-  spftree->tents->del = spftree->paths->del = (void (*)(void *)) isis_vertex_del;
-  list_delete_all_node (spftree->tents);
-  list_delete_all_node (spftree->paths);
-  spftree->tents->del = spftree->paths->del = NULL;
-  return;
+  struct isis_lsp *lsp;
+
+  if (memcmp (sysid, isis->sysid, ISIS_SYS_ID_LEN) == 0)
+    return isis_spf_preload_tent (spftree, level, family, sysid, root_vertex,
+				  prefixes_only);
+
+  lsp = isis_root_system_lsp (spftree->area, level, sysid);
+  if (lsp == NULL)
+    return ISIS_WARNING;
+  return isis_spf_process_lsp (spftree, lsp, 0, 0, family, sysid,
+			       root_vertex, prefixes_only);
 }
 
-static int
-isis_run_spf (struct isis_area *area, int level, int family, u_char *sysid)
+/*
+ * C.2.7 Step 2, move the vertices from TENT to PATHS
+ */
+static void
+isis_spf_run_tent (struct isis_spftree *spftree, int level, int family,
+		   u_char *sysid)
 {
-  int retval = ISIS_OK;
-  struct listnode *node;
+  struct isis_area *area = spftree->area;
   struct isis_vertex *vertex;
-  struct isis_vertex *root_vertex;
-  struct isis_spftree *spftree = NULL;
   u_char lsp_id[ISIS_SYS_ID_LEN + 2];
   struct isis_lsp *lsp;
-  struct route_table *table = NULL;
-  struct timeval time_now;
-  unsigned long long start_time, end_time;
-
-  /* Get time that can't roll backwards. */
-  quagga_gettime(QUAGGA_CLK_MONOTONIC, &time_now);
-  start_time = time_now.tv_sec;
-  start_time = (start_time * 1000000) + time_now.tv_usec;
-
-  if (family == AF_INET)
-    spftree = area->spftree[level - 1];
-#ifdef HAVE_IPV6
-  else if (family == AF_INET6)
-    spftree = area->spftree6[level - 1];
-#endif
-  assert (spftree);
-  assert (sysid);
-
-  /* Make all routes in current route table inactive. */
-  if (family == AF_INET)
-    table = area->route_table[level - 1];
-#ifdef HAVE_IPV6
-  else if (family == AF_INET6)
-    table = area->route_table6[level - 1];
-#endif
-
-  isis_route_invalidate_table (area, table);
-
-  /*
-   * C.2.5 Step 0
-   */
-  init_spt (spftree);
-  /*              a) */
-  root_vertex = isis_spf_add_root (spftree, level, sysid);
-  /*              b) */
-  retval = isis_spf_preload_tent (spftree, level, family, sysid, root_vertex);
-  if (retval != ISIS_OK)
-    {
-      zlog_warn ("ISIS-Spf: failed to load TENT SPF-root:%s", print_sys_hostname(sysid));
-      goto out;
-    }
-
-  /*
-   * C.2.7 Step 2
-   */
-  if (listcount (spftree->tents) == 0)
-    {
-      zlog_warn ("ISIS-Spf: TENT is empty SPF-root:%s", print_sys_hostname(sysid));
-      goto out;
-    }
 
-  while (listcount (spftree->tents) > 0)
+  while (spftree->tents->size > 0)
     {
-      node = listhead (spftree->tents);
-      vertex = listgetdata (node);
+      vertex = pqueue_dequeue (spftree->tents);
+      vertex->tent_index = -1;
 
 #ifdef EXTREME_DEBUG
   zlog_debug ("ISIS-Spf: get TENT node %s %s depth %d dist %d to PATHS",
@@ -1242,7 +1265,6 @@ isis_run_spf (struct isis_area *area, int level, int family, u_char *sysid)
 #endif /* EXTREME_DEBUG */
 
       /* Remove from tent list and add to paths list */
-      list_delete_node (spftree->tents, node);
       add_to_paths (spftree, vertex, level);
       switch (vertex->type)
         {
@@ -1264,7 +1286,8 @@ isis_run_spf (struct isis_area *area, int level, int family, u_char *sysid)
 	      else
 		{
 		  isis_spf_process_lsp (spftree, lsp, vertex->d_N,
-					vertex->depth, family, sysid, vertex);
+					vertex->depth, family, sysid, vertex,
+					0);
 		}
 	    }
 	  else
@@ -1276,8 +1299,155 @@ isis_run_spf (struct isis_area *area, int level, int family, u_char *sysid)
 	default:;
 	}
     }
+}
+
+/*
+ * Build the SPT from scratch.
+ */
+static int
+isis_spf_full (struct isis_spftree *spftree, int level, int family,
+	       u_char *sysid)
+{
+  struct isis_vertex *root_vertex;
+  int retval;
+
+  /*
+   * C.2.5 Step 0
+   */
+  init_spt (spftree);
+  /*              a) */
+  root_vertex = isis_spf_add_root (spftree, level, sysid);
+  /*              b) */
+  retval = isis_spf_preload_root (spftree, level, family, sysid, root_vertex,
+				  0);
+  if (retval != ISIS_OK)
+    {
+      zlog_warn ("ISIS-Spf: failed to load TENT SPF-root:%s", print_sys_hostname(sysid));
+      return retval;
+    }
+
+  /*
+   * C.2.7 Step 2
+   */
+  if (spftree->tents->size == 0)
+    {
+      zlog_warn ("ISIS-Spf: TENT is empty SPF-root:%s", print_sys_hostname(sysid));
+      return retval;
+    }
+
+  isis_spf_run_tent (spftree, level, family, sysid);
+  spftree->full = 0;
+
+  return retval;
+}
+
+/*
+ * Partial route calculation: when the LSPs changed only in the prefixes
+ * they announce, the IS and ES vertices of the last SPT still hold, and
+ * only the prefixes need to be computed again from them.
+ */
+static int
+isis_spf_prc (struct isis_spftree *spftree, int level, int family,
+	      u_char *sysid)
+{
+  struct isis_area *area = spftree->area;
+  struct listnode *node, *nnode, *pnode;
+  struct isis_vertex *vertex, *root_vertex, *pvertex;
+  u_char lsp_id[ISIS_SYS_ID_LEN + 2];
+  struct isis_lsp *lsp;
+  struct isis_adjacency *adj;
+  int retval;
+
+  assert (spftree->tents->size == 0);
+  root_vertex = listgetdata (listhead (spftree->paths));
+
+  /* The new LSP of this system, for an adjacency gone down, is yet to
+   * come. */
+  for (ALL_LIST_ELEMENTS_RO (spftree->paths, node, vertex))
+    for (ALL_LIST_ELEMENTS_RO (vertex->Adj_N, pnode, adj))
+      if (adj->adj_state != ISIS_ADJ_UP)
+	return isis_spf_full (spftree, level, family, sysid);
+
+  /* Drop the prefixes of the last run */
+  for (ALL_LIST_ELEMENTS (spftree->paths, node, nnode, vertex))
+    {
+      if (vertex->type <= VTYPE_ES)
+	continue;
+      for (ALL_LIST_ELEMENTS_RO (vertex->parents, pnode, pvertex))
+	listnode_delete (pvertex->children, vertex);
+      hash_release (spftree->vertices, vertex);
+      list_delete_node (spftree->paths, node);
+      isis_vertex_del (vertex);
+    }
+
+  /* and offer them again, from the systems in the order they were
+   * reached */
+  retval = isis_spf_preload_root (spftree, level, family, sysid, root_vertex,
+				  1);
+  for (ALL_LIST_ELEMENTS_RO (spftree->paths, node, vertex))
+    {
+      if (vertex == root_vertex
+	  || (vertex->type != VTYPE_NONPSEUDO_IS
+	      && vertex->type != VTYPE_NONPSEUDO_TE_IS))
+	continue;
+      memcpy (lsp_id, vertex->N.id, ISIS_SYS_ID_LEN);
+      LSP_PSEUDO_ID (lsp_id) = 0;
+      LSP_FRAGMENT (lsp_id) = 0;
+      lsp = lsp_search (lsp_id, area->lspdb[level - 1]);
+      if (lsp && lsp->lsp_header->rem_lifetime != 0)
+	isis_spf_process_lsp (spftree, lsp, vertex->d_N, vertex->depth,
+			      family, sysid, vertex, 1);
+    }
+
+  isis_spf_run_tent (spftree, level, family, sysid);
+
+  return retval;
+}
+
+static int
+isis_run_spf (struct isis_area *area, int level, int family, u_char *sysid)
+{
+  int retval = ISIS_OK;
+  struct isis_spftree *spftree = NULL;
+  struct route_table *table = NULL;
+  struct timeval time_now;
+  unsigned long long start_time, end_time;
+
+  /* Get time that can't roll backwards. */
+  quagga_gettime(QUAGGA_CLK_MONOTONIC, &time_now);
+  start_time = time_now.tv_sec;
+  start_time = (start_time * 1000000) + time_now.tv_usec;
+
+  if (family == AF_INET)
+    spftree = area->spftree[level - 1];
+#ifdef HAVE_IPV6
+  else if (family == AF_INET6)
+    spftree = area->spftree6[level - 1];
+#endif
+  assert (spftree);
+  assert (sysid);
+
+  /* Make all routes in current route table inactive. */
+  if (family == AF_INET)
+    table = area->route_table[level - 1];
+#ifdef HAVE_IPV6
+  else if (family == AF_INET6)
+    table = area->route_table6[level - 1];
+#endif
+
+  isis_route_invalidate_table (area, table);
+
+  if (spftree->full || listcount (spftree->paths) == 0)
+    retval = isis_spf_full (spftree, level, family, sysid);
+  else
+    {
+      if (isis->debugs & DEBUG_SPF_EVENTS)
+	zlog_debug ("ISIS-Spf (%s) L%d only prefixes changed, partial route "
+		    "calculation", area->area_tag, level);
+      retval = isis_spf_prc (spftree, level, family, sysid);
+      spftree->prc_runcount++;
+    }
 
-out:
   isis_route_validate (area);
   spftree->pending = 0;
   spftree->runcount++;
@@ -1350,6 +1520,14 @@ isis_run_spf_l2 (struct thread *thread)
 
 int
 isis_spf_schedule (struct isis_area *area, int level)
+{
+  area->spftree[level - 1]->full = 1;
+  return isis_spf_schedule_prc (area, level);
+}
+
+/* Schedule the SPF for LSP changes in the prefixes only. */
+int
+isis_spf_schedule_prc (struct isis_area *area, int level)
 {
   struct isis_spftree *spftree = area->spftree[level - 1];
   time_t now = time (NULL);
@@ -1446,6 +1624,13 @@ isis_run_spf6_l2 (struct thread *thread)
 
 int
 isis_spf_schedule6 (struct isis_area *area, int level)
+{
+  area->spftree6[level - 1]->full = 1;
+  return isis_spf_schedule6_prc (area, level);
+}
+
+int
+isis_spf_schedule6_prc (struct isis_area *area, int level)
 {
   int retval = ISIS_OK;
   struct isis_spftree *spftree = area->spftree6[level - 1];
@@ -1690,6 +1875,92 @@ DEFUN (show_isis_topology_l2,
   return CMD_SUCCESS;
 }
 
+#ifdef TOPOLOGY_GENERATE
+/*
+ * SPF benchmark over the generated topology: the SPF runs on a tree of its
+ * own, rooted at the first generated system, so that the routing table is
+ * left alone.
+ */
+static void
+isis_spf_benchmark (struct vty *vty, struct isis_area *area, int level,
+		    u_char *sysid, int runs)
+{
+  struct isis_spftree *spftree;
+  struct timeval start, stop;
+  unsigned long usecs, min, max;
+  unsigned long long total;
+  int i, prc;
+
+  spftree = isis_spftree_new (area);
+
+  vty_out (vty, "Area %s L%d SPF rooted at %s, %d runs%s",
+	   area->area_tag, level, sysid_print (sysid), runs, VTY_NEWLINE);
+
+  for (prc = 0; prc <= 1; prc++)
+    {
+      min = ULONG_MAX;
+      max = 0;
+      total = 0;
+      for (i = 0; i < runs; i++)
+	{
+	  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+	  if (prc)
+	    isis_spf_prc (spftree, level, AF_INET, sysid);
+	  else
+	    isis_spf_full (spftree, level, AF_INET, sysid);
+	  quagga_gettime (QUAGGA_CLK_MONOTONIC, &stop);
+
+	  usecs = (stop.tv_sec - start.tv_sec) * 1000000
+		  + (stop.tv_usec - start.tv_usec);
+	  total += usecs;
+	  if (usecs < min)
+	    min = usecs;
+	  if (usecs > max)
+	    max = usecs;
+	}
+      vty_out (vty, "  %-14s %6d vertices, usecs min %lu avg %llu max %lu%s",
+	       prc ? "prefixes only" : "full SPF",
+	       listcount (spftree->paths), min, total / runs, max,
+	       VTY_NEWLINE);
+    }
+
+  isis_spftree_del (spftree);
+}
+
+DEFUN (show_isis_spf_benchmark,
+       show_isis_spf_benchmark_cmd,
+       "show isis spf-benchmark <1-10000>",
+       SHOW_STR
+       "IS-IS information\n"
+       "Time the SPF over the generated topology\n"
+       "Number of runs\n")
+{
+  struct listnode *node;
+  struct isis_area *area;
+  u_char sysid[ISIS_SYS_ID_LEN];
+  int runs;
+
+  if (!isis->area_list)
+    return CMD_SUCCESS;
+
+  runs = atoi (argv[0]);
+
+  for (ALL_LIST_ELEMENTS_RO (isis->area_list, node, area))
+    {
+      /* Topologies are generated for level 1 only. */
+      if (!area->topology || !area->spftree[0])
+	continue;
+
+      memcpy (sysid, area->topology_baseis, ISIS_SYS_ID_LEN);
+      sysid[ISIS_SYS_ID_LEN - 1] = 1;
+      sysid[ISIS_SYS_ID_LEN - 2] = 0;
+      isis_spf_benchmark (vty, area, IS_LEVEL_1, sysid, runs);
+    }
+
+  return CMD_SUCCESS;
+}
+#endif /* TOPOLOGY_GENERATE */
+
 void
 isis_spf_cmds_init ()
 {
@@ -1700,4 +1971,7 @@ isis_spf_cmds_init ()
   install_element (ENABLE_NODE, &show_isis_topology_cmd);
   install_element (ENABLE_NODE, &show_isis_topology_l1_cmd);
   install_element (ENABLE_NODE, &show_isis_topology_l2_cmd);
+#ifdef TOPOLOGY_GENERATE
+  install_element (ENABLE_NODE, &show_isis_spf_benchmark_cmd);
+#endif /* TOPOLOGY_GENERATE */
 }
@@ -59,16 +59,22 @@ struct isis_vertex
   struct list *Adj_N;		/* {Adj(N)} next hop or neighbor list */
   struct list *parents;         /* list of parents for ECMP */
   struct list *children;        /* list of children used for tree dump */
+  int tent_index;		/* position in TENT, -1 once in PATHS */
+  u_int32_t tent_seq;		/* order of entry into TENT, for ties */
 };
 
 struct isis_spftree
 {
   struct thread *t_spf;		/* spf threads */
   struct list *paths;		/* the SPT */
-  struct list *tents;		/* TENT */
+  struct pqueue *tents;		/* TENT, a heap on distance and type */
+  struct hash *vertices;	/* the vertices of TENT and PATHS */
+  u_int32_t tent_seq;		/* vertices added to TENT */
   struct isis_area *area;       /* back pointer to area */
   int pending;			/* already scheduled */
+  int full;			/* the SPT must be rebuilt, not just routes */
   unsigned int runcount;        /* number of runs since uptime */
+  unsigned int prc_runcount;	/* of which only recomputed the routes */
   time_t last_run_timestamp;    /* last run timestamp for scheduling */
   time_t last_run_duration;     /* last run duration in msec */
 };
@@ -82,8 +88,10 @@ void spftree_area_del (struct isis_area *area);
 void spftree_area_adj_del (struct isis_area *area,
                            struct isis_adjacency *adj);
 int isis_spf_schedule (struct isis_area *area, int level);
+int isis_spf_schedule_prc (struct isis_area *area, int level);
 void isis_spf_cmds_init (void);
 #ifdef HAVE_IPV6
 int isis_spf_schedule6 (struct isis_area *area, int level);
+int isis_spf_schedule6_prc (struct isis_area *area, int level);
 #endif
 #endif /* _ZEBRA_ISIS_SPF_H */
@@ -1283,6 +1283,9 @@ DEFUN (show_isis_summary,
       vty_out (vty, "      run count         : %d%s",
           spftree->runcount, VTY_NEWLINE);
 
+      vty_out (vty, "      prefixes only     : %d%s",
+          spftree->prc_runcount, VTY_NEWLINE);
+
 #ifdef HAVE_IPV6
       spftree = area->spftree6[level - 1];
       if (spftree->pending)
@@ -1302,6 +1305,9 @@ DEFUN (show_isis_summary,
 
       vty_out (vty, "      run count         : %d%s",
           spftree->runcount, VTY_NEWLINE);
+
+      vty_out (vty, "      prefixes only     : %d%s",
+          spftree->prc_runcount, VTY_NEWLINE);
 #endif
     }
   }
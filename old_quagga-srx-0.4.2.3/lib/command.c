@@ -30,6 +30,7 @@ Boston, MA 02111-1307, USA.  */
 #include "vty.h"
 #include "command.h"
 #include "workqueue.h"
+#include "hash.h"
 
 /* Command vector which includes some level of command lists. Normally
    each daemon maintains each own cmdvec. */
@@ -3580,6 +3581,8 @@ cmd_init (int terminal)
       install_element (ENABLE_NODE, &clear_thread_cpu_cmd);
       install_element (VIEW_NODE, &show_work_queues_cmd);
       install_element (ENABLE_NODE, &show_work_queues_cmd);
+      install_element (VIEW_NODE, &show_hash_stats_cmd);
+      install_element (ENABLE_NODE, &show_hash_stats_cmd);
     }
   srand(time(NULL));
 }
@@ -610,12 +610,41 @@ ALIAS (no_distribute_list_prefix, no_ipv6_distribute_list_prefix_cmd,
        "Filter outgoing routing updates\n"
        "Interface name\n")
 
+/* Arguments of the distribute hash walkers. */
+struct distribute_walk
+{
+  struct vty *vty;
+  enum distribute_type type;
+  int write;
+};
+
+static void
+distribute_show_ifname (struct hash_backet *mp, void *arg)
+{
+  struct distribute_walk *walk = arg;
+  struct vty *vty = walk->vty;
+  struct distribute *dist = mp->data;
+  enum distribute_type type = walk->type;
+
+  if (dist->ifname)
+    if (dist->list[type] || dist->prefix[type])
+      {
+	vty_out (vty, "    %s filtered by", dist->ifname);
+	if (dist->list[type])
+	  vty_out (vty, " %s", dist->list[type]);
+	if (dist->prefix[type])
+	  vty_out (vty, "%s (prefix-list) %s",
+		   dist->list[type] ? "," : "",
+		   dist->prefix[type]);
+	vty_out (vty, "%s", VTY_NEWLINE);
+      }
+}
+
 int
 config_show_distribute (struct vty *vty)
 {
-  unsigned int i;
-  struct hash_backet *mp;
   struct distribute *dist;
+  struct distribute_walk walk = { .vty = vty };
 
   /* Output filter configuration. */
   dist = distribute_lookup (NULL);
@@ -633,24 +662,8 @@ config_show_distribute (struct vty *vty)
   else
     vty_out (vty, "  Outgoing update filter list for all interface is not set%s", VTY_NEWLINE);
 
-  for (i = 0; i < disthash->size; i++)
-    for (mp = disthash->index[i]; mp; mp = mp->next)
-      {
-	dist = mp->data;
-	if (dist->ifname)
-	  if (dist->list[DISTRIBUTE_OUT] || dist->prefix[DISTRIBUTE_OUT])
-	    {
-	      vty_out (vty, "    %s filtered by", dist->ifname);
-	      if (dist->list[DISTRIBUTE_OUT])
-		vty_out (vty, " %s", dist->list[DISTRIBUTE_OUT]);
-	      if (dist->prefix[DISTRIBUTE_OUT])
-		vty_out (vty, "%s (prefix-list) %s",
-			 dist->list[DISTRIBUTE_OUT] ? "," : "",
-			 dist->prefix[DISTRIBUTE_OUT]);
-	      vty_out (vty, "%s", VTY_NEWLINE);
-	    }
-      }
-
+  walk.type = DISTRIBUTE_OUT;
+  hash_iterate (disthash, distribute_show_ifname, &walk);
 
   /* Input filter configuration. */
   dist = distribute_lookup (NULL);
@@ -668,79 +681,64 @@ config_show_distribute (struct vty *vty)
   else
     vty_out (vty, "  Incoming update filter list for all interface is not set%s", VTY_NEWLINE);
 
-  for (i = 0; i < disthash->size; i++)
-    for (mp = disthash->index[i]; mp; mp = mp->next)
-      {
-	dist = mp->data;
-	if (dist->ifname)
-	  if (dist->list[DISTRIBUTE_IN] || dist->prefix[DISTRIBUTE_IN])
-	    {
-	      vty_out (vty, "    %s filtered by", dist->ifname);
-	      if (dist->list[DISTRIBUTE_IN])
-		vty_out (vty, " %s", dist->list[DISTRIBUTE_IN]);
-	      if (dist->prefix[DISTRIBUTE_IN])
-		vty_out (vty, "%s (prefix-list) %s",
-			 dist->list[DISTRIBUTE_IN] ? "," : "",
-			 dist->prefix[DISTRIBUTE_IN]);
-	      vty_out (vty, "%s", VTY_NEWLINE);
-	    }
-      }
+  walk.type = DISTRIBUTE_IN;
+  hash_iterate (disthash, distribute_show_ifname, &walk);
+
   return 0;
 }
 
+static void
+distribute_config_write (struct hash_backet *mp, void *arg)
+{
+  struct distribute_walk *walk = arg;
+  struct vty *vty = walk->vty;
+  struct distribute *dist = mp->data;
+
+  if (dist->list[DISTRIBUTE_IN])
+    {
+      vty_out (vty, " distribute-list %s in %s%s", 
+	       dist->list[DISTRIBUTE_IN],
+	       dist->ifname ? dist->ifname : "",
+	       VTY_NEWLINE);
+      walk->write++;
+    }
+
+  if (dist->list[DISTRIBUTE_OUT])
+    {
+      vty_out (vty, " distribute-list %s out %s%s", 
+	       dist->list[DISTRIBUTE_OUT],
+	       dist->ifname ? dist->ifname : "",
+	       VTY_NEWLINE);
+      walk->write++;
+    }
+
+  if (dist->prefix[DISTRIBUTE_IN])
+    {
+      vty_out (vty, " distribute-list prefix %s in %s%s",
+	       dist->prefix[DISTRIBUTE_IN],
+	       dist->ifname ? dist->ifname : "",
+	       VTY_NEWLINE);
+      walk->write++;
+    }
+
+  if (dist->prefix[DISTRIBUTE_OUT])
+    {
+      vty_out (vty, " distribute-list prefix %s out %s%s",
+	       dist->prefix[DISTRIBUTE_OUT],
+	       dist->ifname ? dist->ifname : "",
+	       VTY_NEWLINE);
+      walk->write++;
+    }
+}
+
 /* Configuration write function. */
 int
 config_write_distribute (struct vty *vty)
 {
-  unsigned int i;
-  struct hash_backet *mp;
-  int write = 0;
+  struct distribute_walk walk = { .vty = vty, .write = 0 };
 
-  for (i = 0; i < disthash->size; i++)
-    for (mp = disthash->index[i]; mp; mp = mp->next)
-      {
-	struct distribute *dist;
-
-	dist = mp->data;
-
-	if (dist->list[DISTRIBUTE_IN])
-	  {
-	    vty_out (vty, " distribute-list %s in %s%s", 
-		     dist->list[DISTRIBUTE_IN],
-		     dist->ifname ? dist->ifname : "",
-		     VTY_NEWLINE);
-	    write++;
-	  }
-
-	if (dist->list[DISTRIBUTE_OUT])
-	  {
-	    vty_out (vty, " distribute-list %s out %s%s", 
-
-		     dist->list[DISTRIBUTE_OUT],
-		     dist->ifname ? dist->ifname : "",
-		     VTY_NEWLINE);
-	    write++;
-	  }
-
-	if (dist->prefix[DISTRIBUTE_IN])
-	  {
-	    vty_out (vty, " distribute-list prefix %s in %s%s",
-		     dist->prefix[DISTRIBUTE_IN],
-		     dist->ifname ? dist->ifname : "",
-		     VTY_NEWLINE);
-	    write++;
-	  }
-
-	if (dist->prefix[DISTRIBUTE_OUT])
-	  {
-	    vty_out (vty, " distribute-list prefix %s out %s%s",
-		     dist->prefix[DISTRIBUTE_OUT],
-		     dist->ifname ? dist->ifname : "",
-		     VTY_NEWLINE);
-	    write++;
-	  }
-      }
-  return write;
+  hash_iterate (disthash, distribute_config_write, &walk);
+  return walk.write;
 }
 
 /* Clear all distribute list. */
@@ -756,6 +754,7 @@ distribute_list_init (int node)
 {
   disthash = hash_create (distribute_hash_make,
                           (int (*) (const void *, const void *)) distribute_cmp);
+  hash_set_name (disthash, "Distribute lists");
 
   if(node==RIP_NODE) {
     install_element (node, &distribute_list_all_cmd);
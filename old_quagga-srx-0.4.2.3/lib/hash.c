@@ -23,6 +23,92 @@
 
 #include "hash.h"
 #include "memory.h"
+#include "linklist.h"
+#include "command.h"
+
+/* Hash tables listed by "show hash statistics". */
+static struct list *hash_list = NULL;
+
+/* Bucket of the given key.  The key is mixed first, the size is a power
+   of two and weak key functions would otherwise use only the low bits. */
+static inline unsigned int
+hash_index (unsigned int key, unsigned int size)
+{
+  key ^= key >> 16;
+  key *= 0x85ebca6b;
+  key ^= key >> 13;
+  key *= 0xc2b2ae35;
+  key ^= key >> 16;
+
+  return key & (size - 1);
+}
+
+/* Round the requested size up to a power of two. */
+static unsigned int
+hash_roundup_size (unsigned int size)
+{
+  unsigned int pow2 = 1;
+
+  while (pow2 < size && pow2 < HASH_MAX_SIZE)
+    pow2 <<= 1;
+
+  return pow2;
+}
+
+/* Move up to `steps' buckets of the previous table into the current
+   one. */
+static void
+hash_rehash_step (struct hash *hash, unsigned int steps)
+{
+  struct hash_backet *hb;
+  struct hash_backet *next;
+  unsigned int index;
+
+  if (hash->old_index == NULL || hash->walking)
+    return;
+
+  while (steps-- && hash->rehash_pos < hash->old_size)
+    {
+      for (hb = hash->old_index[hash->rehash_pos]; hb; hb = next)
+        {
+          next = hb->next;
+          index = hash_index (hb->key, hash->size);
+          hb->next = hash->index[index];
+          hash->index[index] = hb;
+        }
+      hash->old_index[hash->rehash_pos++] = NULL;
+    }
+
+  if (hash->rehash_pos == hash->old_size)
+    {
+      XFREE (MTYPE_HASH_INDEX, hash->old_index);
+      hash->old_index = NULL;
+      hash->old_size = 0;
+      hash->rehash_pos = 0;
+    }
+}
+
+/* Double the table.  The buckets are moved over a number of later
+   operations, see hash_rehash_step(). */
+static void
+hash_expand (struct hash *hash)
+{
+  if (hash->walking || hash->size >= HASH_MAX_SIZE)
+    return;
+
+  /* Finish the previous expansion first. */
+  if (hash->old_index)
+    hash_rehash_step (hash, hash->old_size);
+
+  hash->old_index = hash->index;
+  hash->old_size = hash->size;
+  hash->rehash_pos = 0;
+
+  hash->size <<= 1;
+  hash->index = XCALLOC (MTYPE_HASH_INDEX,
+                         sizeof (struct hash_backet *) * hash->size);
+  hash->expands++;
+}
 
 /* Allocate a new hash.  */
 struct hash *
@@ -31,7 +117,9 @@ hash_create_size (unsigned int size, unsigned int (*hash_key) (void *),
 {
   struct hash *hash;
 
-  hash = XMALLOC (MTYPE_HASH, sizeof (struct hash));
+  size = hash_roundup_size (size);
+
+  hash = XCALLOC (MTYPE_HASH, sizeof (struct hash));
   hash->index = XCALLOC (MTYPE_HASH_INDEX,
 			 sizeof (struct hash_backet *) * size);
   hash->size = size;
@@ -70,8 +158,20 @@ hash_get (struct hash *hash, void *data, void * (*alloc_func) (void *))
   void *newdata;
   struct hash_backet *backet;
 
+  hash_rehash_step (hash, HASH_REHASH_STEP);
+
   key = (*hash->hash_key) (data);
-  index = key % hash->size;
+
+  if (hash->old_index)
+    {
+      index = hash_index (key, hash->old_size);
+      for (backet = hash->old_index[index]; backet != NULL;
+           backet = backet->next)
+        if (backet->key == key && (*hash->hash_cmp) (backet->data, data))
+          return backet->data;
+    }
+
+  index = hash_index (key, hash->size);
 
   for (backet = hash->index[index]; backet != NULL; backet = backet->next) 
     if (backet->key == key && (*hash->hash_cmp) (backet->data, data))
@@ -83,6 +183,12 @@ hash_get (struct hash *hash, void *data, void * (*alloc_func) (void *))
       if (newdata == NULL)
 	return NULL;
 
+      if (hash->count + 1 > (unsigned long) hash->size * HASH_MAX_LOAD)
+        {
+          hash_expand (hash);
+          index = hash_index (key, hash->size);
+        }
+
       backet = XMALLOC (MTYPE_HASH_BACKET, sizeof (struct hash_backet));
       backet->data = newdata;
       backet->key = key;
@@ -112,27 +218,21 @@ unsigned int string_hash_make (const char *str)
   return hash;
 }
 
-/* This function release registered value from specified hash.  When
-   release is successfully finished, return the data pointer in the
-   hash backet.  */
-void *
-hash_release (struct hash *hash, void *data)
+/* Remove the matching backet from the chain and return its data. */
+static void *
+hash_release_chain (struct hash *hash, struct hash_backet **head,
+                    unsigned int key, void *data)
 {
   void *ret;
-  unsigned int key;
-  unsigned int index;
   struct hash_backet *backet;
   struct hash_backet *pp;
 
-  key = (*hash->hash_key) (data);
-  index = key % hash->size;
-
-  for (backet = pp = hash->index[index]; backet; backet = backet->next)
+  for (backet = pp = *head; backet; backet = backet->next)
     {
       if (backet->key == key && (*hash->hash_cmp) (backet->data, data)) 
 	{
 	  if (backet == pp) 
-	    hash->index[index] = backet->next;
+	    *head = backet->next;
 	  else 
 	    pp->next = backet->next;
 
@@ -146,17 +246,42 @@ hash_release (struct hash *hash, void *data)
   return NULL;
 }
 
-/* Iterator function for hash.  */
-void
-hash_iterate (struct hash *hash, 
-	      void (*func) (struct hash_backet *, void *), void *arg)
+/* This function release registered value from specified hash.  When
+   release is successfully finished, return the data pointer in the
+   hash backet.  */
+void *
+hash_release (struct hash *hash, void *data)
+{
+  void *ret = NULL;
+  unsigned int key;
+
+  hash_rehash_step (hash, HASH_REHASH_STEP);
+
+  key = (*hash->hash_key) (data);
+
+  if (hash->old_index)
+    ret = hash_release_chain (hash,
+                              &hash->old_index[hash_index (key,
+                                                           hash->old_size)],
+                              key, data);
+  if (ret == NULL)
+    ret = hash_release_chain (hash, &hash->index[hash_index (key, hash->size)],
+                              key, data);
+  return ret;
+}
+
+/* Call func for each backet of the given bucket array. */
+static void
+hash_iterate_index (struct hash_backet **index, unsigned int start,
+                    unsigned int size,
+                    void (*func) (struct hash_backet *, void *), void *arg)
 {
   unsigned int i;
   struct hash_backet *hb;
   struct hash_backet *hbnext;
 
-  for (i = 0; i < hash->size; i++)
-    for (hb = hash->index[i]; hb; hb = hbnext)
+  for (i = start; i < size; i++)
+    for (hb = index[i]; hb; hb = hbnext)
       {
 	/* get pointer to next hash backet here, in case (*func)
 	 * decides to delete hb by calling hash_release
@@ -166,17 +291,31 @@ hash_iterate (struct hash *hash,
       }
 }
 
-/* Clean up hash.  */
+/* Iterator function for hash.  */
 void
-hash_clean (struct hash *hash, void (*free_func) (void *))
+hash_iterate (struct hash *hash, 
+	      void (*func) (struct hash_backet *, void *), void *arg)
+{
+  hash->walking++;
+  if (hash->old_index)
+    hash_iterate_index (hash->old_index, hash->rehash_pos, hash->old_size,
+                        func, arg);
+  hash_iterate_index (hash->index, 0, hash->size, func, arg);
+  hash->walking--;
+}
+
+/* Free all backets of the given bucket array. */
+static void
+hash_clean_index (struct hash *hash, struct hash_backet **index,
+                  unsigned int size, void (*free_func) (void *))
 {
   unsigned int i;
   struct hash_backet *hb;
   struct hash_backet *next;
 
-  for (i = 0; i < hash->size; i++)
+  for (i = 0; i < size; i++)
     {
-      for (hb = hash->index[i]; hb; hb = next)
+      for (hb = index[i]; hb; hb = next)
 	{
 	  next = hb->next;
 	      
@@ -186,15 +325,121 @@ hash_clean (struct hash *hash, void (*free_func) (void *))
 	  XFREE (MTYPE_HASH_BACKET, hb);
 	  hash->count--;
 	}
-      hash->index[i] = NULL;
+      index[i] = NULL;
     }
 }
 
+/* Clean up hash.  */
+void
+hash_clean (struct hash *hash, void (*free_func) (void *))
+{
+  hash->walking++;
+  if (hash->old_index)
+    {
+      hash_clean_index (hash, hash->old_index, hash->old_size, free_func);
+      XFREE (MTYPE_HASH_INDEX, hash->old_index);
+      hash->old_index = NULL;
+      hash->old_size = 0;
+      hash->rehash_pos = 0;
+    }
+  hash_clean_index (hash, hash->index, hash->size, free_func);
+  hash->walking--;
+}
+
 /* Free hash memory.  You may call hash_clean before call this
    function.  */
 void
 hash_free (struct hash *hash)
 {
+  if (hash->name)
+    {
+      listnode_delete (hash_list, hash);
+      XFREE (MTYPE_HASH, hash->name);
+    }
+  if (hash->old_index)
+    XFREE (MTYPE_HASH_INDEX, hash->old_index);
   XFREE (MTYPE_HASH_INDEX, hash->index);
   XFREE (MTYPE_HASH, hash);
 }
+
+/* Name the hash and list it in "show hash statistics". */
+void
+hash_set_name (struct hash *hash, const char *name)
+{
+  if (hash_list == NULL)
+    hash_list = list_new ();
+
+  if (hash->name)
+    XFREE (MTYPE_HASH, hash->name);
+  else
+    listnode_add (hash_list, hash);
+
+  hash->name = XSTRDUP (MTYPE_HASH, name);
+}
+
+/* Chain statistics of one bucket array. */
+static void
+hash_chain_stats (struct hash_backet **index, unsigned int start,
+                  unsigned int size, unsigned int *empty,
+                  unsigned int *longest, double *sumsq)
+{
+  unsigned int i, len;
+  struct hash_backet *hb;
+
+  for (i = start; i < size; i++)
+    {
+      len = 0;
+      for (hb = index[i]; hb; hb = hb->next)
+        len++;
+      if (len == 0)
+        (*empty)++;
+      if (len > *longest)
+        *longest = len;
+      *sumsq += (double) len * len;
+    }
+}
+
+DEFUN (show_hash_stats,
+       show_hash_stats_cmd,
+       "show hash statistics",
+       SHOW_STR
+       "Hash tables\n"
+       "Hash table statistics\n")
+{
+  struct listnode *node;
+  struct hash *hash;
+  unsigned int empty, longest;
+  double sumsq, load, avg;
+
+  if (hash_list == NULL || list_isempty (hash_list))
+    {
+      vty_out (vty, "No hash tables in use.%s", VTY_NEWLINE);
+      return CMD_SUCCESS;
+    }
+
+  vty_out (vty, "%-26s %9s %9s %6s %7s %7s %6s %4s%s",
+           "Hash table", "Entries", "Buckets", "Load", "Empty%", "AvgLen",
+           "MaxLen", "Grew", VTY_NEWLINE);
+
+  for (ALL_LIST_ELEMENTS_RO (hash_list, node, hash))
+    {
+      empty = longest = 0;
+      sumsq = 0;
+      hash_chain_stats (hash->index, 0, hash->size, &empty, &longest, &sumsq);
+      if (hash->old_index)
+        hash_chain_stats (hash->old_index, hash->rehash_pos, hash->old_size,
+                          &empty, &longest, &sumsq);
+
+      load = (double) hash->count / hash->size;
+      /* Expected number of entries to compare in a successful lookup. */
+      avg = hash->count ? sumsq / hash->count : 0;
+
+      vty_out (vty, "%-26s %9lu %9u %6.2f %6.1f%% %7.2f %6u %4u%s%s",
+               hash->name, hash->count, hash->size, load,
+               100.0 * empty / (hash->size + hash->old_size - hash->rehash_pos),
+               avg, longest, hash->expands,
+               hash->old_index ? " (growing)" : "", VTY_NEWLINE);
+    }
+
+  return CMD_SUCCESS;
+}
@@ -24,6 +24,16 @@ Boston, MA 02111-1307, USA.  */
 /* Default hash table size.  */ 
 #define HASHTABSIZE     1024
 
+/* The table doubles once the average chain length exceeds this value. */
+#define HASH_MAX_LOAD   1
+
+/* Largest table size, tables do not grow beyond this. */
+#define HASH_MAX_SIZE   (1U << 28)
+
+/* Number of buckets of the previous table moved by each operation while
+   the table grows. */
+#define HASH_REHASH_STEP 4
+
 struct hash_backet
 {
   /* Linked list.  */
@@ -41,7 +51,7 @@ struct hash
   /* Hash backet. */
   struct hash_backet **index;
 
-  /* Hash table size. */
+  /* Hash table size, always a power of two. */
   unsigned int size;
 
   /* Key make function. */
@@ -52,6 +62,22 @@ struct hash
 
   /* Backet alloc. */
   unsigned long count;
+
+  /* While the table grows, the buckets of the previous table from
+     rehash_pos on are not yet moved into index. */
+  struct hash_backet **old_index;
+  unsigned int old_size;
+  unsigned int rehash_pos;
+
+  /* Set while hash_iterate() or hash_clean() walks the table, the
+     buckets must not move. */
+  int walking;
+
+  /* Number of times the table grew. */
+  unsigned int expands;
+
+  /* Name shown by "show hash statistics", NULL if not listed. */
+  char *name;
 };
 
 extern struct hash *hash_create (unsigned int (*) (void *), 
@@ -70,6 +96,9 @@ extern void hash_iterate (struct hash *,
 extern void hash_clean (struct hash *, void (*) (void *));
 extern void hash_free (struct hash *);
 
+extern void hash_set_name (struct hash *, const char *);
+extern struct cmd_element show_hash_stats_cmd;
+
 extern unsigned int string_hash_make (const char *);
 
 #endif /* _ZEBRA_HASH_H */
@@ -845,6 +845,9 @@ static const struct zebra_desc_table command_types[] = {
   DESC_ENTRY	(ZEBRA_ROUTER_ID_DELETE),
   DESC_ENTRY	(ZEBRA_ROUTER_ID_UPDATE),
   DESC_ENTRY	(ZEBRA_HELLO),
+  DESC_ENTRY	(ZEBRA_IPV4_ROUTE_BATCH_ADD),
+  DESC_ENTRY	(ZEBRA_IPV4_ROUTE_BATCH_DELETE),
+  DESC_ENTRY	(ZEBRA_CAPABILITIES),
 };
 #undef DESC_ENTRY
 
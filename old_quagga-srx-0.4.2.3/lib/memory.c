@@ -22,15 +22,19 @@
 
 #include <zebra.h>
 /* malloc.h is generally obsolete, however GNU Libc mallinfo wants it. */
-#if !defined(HAVE_STDLIB_H) || (defined(GNU_LINUX) && defined(HAVE_MALLINFO))
+#if !defined(HAVE_STDLIB_H) || (defined(GNU_LINUX) && defined(HAVE_MALLINFO)) \
+    || defined(HAVE_MALLOC_USABLE_SIZE)
 #include <malloc.h>
-#endif /* !HAVE_STDLIB_H || HAVE_MALLINFO */
+#endif /* !HAVE_STDLIB_H || HAVE_MALLINFO || HAVE_MALLOC_USABLE_SIZE */
 
 #include "log.h"
 #include "memory.h"
 
-static void alloc_inc (int);
-static void alloc_dec (int);
+static void alloc_inc (int, void *);
+static void alloc_dec (int, void *);
+static void *mcache_get (int, size_t);
+static int mcache_put (int, void *);
+static int mcache_cached (int);
 static void log_memstats(int log_priority);
 
 static const struct message mstr [] =
@@ -68,12 +72,13 @@ zmalloc (int type, size_t size)
 {
   void *memory;
 
-  memory = malloc (size);
+  if ((memory = mcache_get (type, size)) == NULL)
+    memory = malloc (size);
 
   if (memory == NULL)
     zerror ("malloc", type, size);
 
-  alloc_inc (type);
+  alloc_inc (type, memory);
 
   return memory;
 }
@@ -86,12 +91,15 @@ zcalloc (int type, size_t size)
 {
   void *memory;
 
-  memory = calloc (1, size);
+  if ((memory = mcache_get (type, size)) != NULL)
+    memset (memory, 0, size);
+  else
+    memory = calloc (1, size);
 
   if (memory == NULL)
     zerror ("calloc", type, size);
 
-  alloc_inc (type);
+  alloc_inc (type, memory);
 
   return memory;
 }
@@ -108,11 +116,14 @@ zrealloc (int type, void *ptr, size_t size)
 {
   void *memory;
 
+  assert (!mcache_cached (type));
+
+  if (ptr != NULL)
+    alloc_dec (type, ptr);
   memory = realloc (ptr, size);
   if (memory == NULL)
     zerror ("realloc", type, size);
-  if (ptr == NULL)
-    alloc_inc (type);
+  alloc_inc (type, memory);
 
   return memory;
 }
@@ -128,8 +139,9 @@ zfree (int type, void *ptr)
 {
   if (ptr != NULL)
     {
-      alloc_dec (type);
-      free (ptr);
+      alloc_dec (type, ptr);
+      if (!mcache_put (type, ptr))
+        free (ptr);
     }
 }
 
@@ -147,7 +159,7 @@ zstrdup (int type, const char *str)
   dup = strdup (str);
   if (dup == NULL)
     zerror ("strdup", type, strlen (str));
-  alloc_inc (type);
+  alloc_inc (type, dup);
   return dup;
 }
 
@@ -156,6 +168,10 @@ static struct
 {
   const char *name;
   long alloc;
+  long alloc_max;
+  unsigned long bytes;
+  unsigned long bytes_max;
+  long cached;
   unsigned long t_malloc;
   unsigned long c_malloc;
   unsigned long t_calloc;
@@ -243,21 +259,128 @@ static struct
 {
   char *name;
   long alloc;
+  long alloc_max;
+  unsigned long bytes;
+  unsigned long bytes_max;
+  long cached;
 } mstat [MTYPE_MAX];
 #endif /* MEMORY_LOG */
 
+/* Bytes taken by an allocation, as far as the allocator tells. */
+#ifdef HAVE_MALLOC_USABLE_SIZE
+#define MEMORY_SIZE(ptr) malloc_usable_size (ptr)
+#else
+#define MEMORY_SIZE(ptr) 0
+#endif /* HAVE_MALLOC_USABLE_SIZE */
+
 /* Increment allocation counter. */
 static void
-alloc_inc (int type)
+alloc_inc (int type, void *ptr)
 {
-  mstat[type].alloc++;
+  if (++mstat[type].alloc > mstat[type].alloc_max)
+    mstat[type].alloc_max = mstat[type].alloc;
+
+  mstat[type].bytes += MEMORY_SIZE (ptr);
+  if (mstat[type].bytes > mstat[type].bytes_max)
+    mstat[type].bytes_max = mstat[type].bytes;
 }
 
 /* Decrement allocation counter. */
 static void
-alloc_dec (int type)
+alloc_dec (int type, void *ptr)
 {
   mstat[type].alloc--;
+  mstat[type].bytes -= MEMORY_SIZE (ptr);
+}
+
+/*
+ * Allocation cache.
+ *
+ * Objects of the types listed in memory_cache_types[] are not handed
+ * back to malloc when freed but kept on a free list of the freeing
+ * thread, up to MCACHE_DEPTH of them per type, and reused by the next
+ * allocation of that type on the same thread.  This takes the allocator
+ * out of the alloc/free churn of routes and attributes during
+ * convergence.  The objects stay ordinary malloc()ed blocks, so the
+ * cache may always give up on one and free() it instead.
+ *
+ * A cached type must always be allocated with the same size, which is
+ * taken from its first allocation.
+ */
+#define MCACHE_DEPTH 512
+
+struct mcache
+{
+  void *head;
+  unsigned int count;
+};
+
+/* Object size of each cached type, 0 for types that aren't cached,
+ * (size_t) -1 until the first allocation. */
+static size_t mcache_size[MTYPE_MAX];
+static int mcache_ready;
+
+static __thread struct mcache mcache[MTYPE_MAX];
+
+static void
+mcache_setup (void)
+{
+  int *type;
+
+  for (type = memory_cache_types; *type >= 0; type++)
+    mcache_size[*type] = (size_t) -1;
+  mcache_ready = 1;
+}
+
+static void *
+mcache_get (int type, size_t size)
+{
+  struct mcache *mc;
+  void *obj;
+
+  if (!mcache_ready)
+    mcache_setup ();
+  if (!mcache_size[type])
+    return NULL;
+  if (mcache_size[type] != size)
+    {
+      assert (mcache_size[type] == (size_t) -1);
+      mcache_size[type] = size;
+    }
+
+  mc = &mcache[type];
+  if ((obj = mc->head) == NULL)
+    return NULL;
+  mc->head = *(void **) obj;
+  mc->count--;
+  mstat[type].cached--;
+  return obj;
+}
+
+static int
+mcache_cached (int type)
+{
+  if (!mcache_ready)
+    mcache_setup ();
+  return mcache_size[type] != 0;
+}
+
+static int
+mcache_put (int type, void *obj)
+{
+  struct mcache *mc;
+
+  if (!mcache_size[type])
+    return 0;
+
+  mc = &mcache[type];
+  if (mc->count >= MCACHE_DEPTH)
+    return 0;
+  *(void **) obj = mc->head;
+  mc->head = obj;
+  mc->count++;
+  mstat[type].cached++;
+  return 1;
 }
 
 /* Looking up memory status from vty interface. */
@@ -333,6 +456,11 @@ show_memory_vty (struct vty *vty, struct memory_list *list)
 {
   struct memory_list *m;
   int needsep = 0;
+  int header = 0;
+#ifdef HAVE_MALLOC_USABLE_SIZE
+  char buf[MTYPE_MEMSTR_LEN];
+  char buf_max[MTYPE_MEMSTR_LEN];
+#endif /* HAVE_MALLOC_USABLE_SIZE */
 
   for (m = list; m->index >= 0; m++)
     if (m->index == 0)
@@ -343,10 +471,26 @@ show_memory_vty (struct vty *vty, struct memory_list *list)
 	    needsep = 0;
 	  }
       }
-    else if (mstat[m->index].alloc)
+    else if (mstat[m->index].alloc || mstat[m->index].cached)
       {
-	vty_out (vty, "%-30s: %10ld\r\n", m->format, mstat[m->index].alloc);
-	needsep = 1;
+#ifdef HAVE_MALLOC_USABLE_SIZE
+	if (!header)
+	  vty_out (vty, "%-30s  %10s %10s %10s %6s\r\n",
+		   "Type", "Count", "Bytes", "Peak", "Cached");
+	vty_out (vty, "%-30s: %10ld %10s %10s",
+		 m->format, mstat[m->index].alloc,
+		 mtype_memstr (buf, sizeof (buf), mstat[m->index].bytes),
+		 mtype_memstr (buf_max, sizeof (buf_max),
+			       mstat[m->index].bytes_max));
+#else
+	if (!header)
+	  vty_out (vty, "%-30s  %10s %6s\r\n", "Type", "Count", "Cached");
+	vty_out (vty, "%-30s: %10ld", m->format, mstat[m->index].alloc);
+#endif /* HAVE_MALLOC_USABLE_SIZE */
+	if (mcache_size[m->index])
+	  vty_out (vty, " %6ld", mstat[m->index].cached);
+	vty_out (vty, "\r\n");
+	needsep = header = 1;
       }
   return needsep;
 }
@@ -627,3 +771,15 @@ mtype_stats_alloc (int type)
 {
   return mstat[type].alloc;
 }
+
+unsigned long
+mtype_stats_bytes (int type)
+{
+  return mstat[type].bytes;
+}
+
+unsigned long
+mtype_stats_bytes_max (int type)
+{
+  return mstat[type].bytes_max;
+}
@@ -38,6 +38,7 @@ struct mlist {
 #include "lib/memtypes.h"
 
 extern struct mlist mlists[];
+extern int memory_cache_types[];
 
 /* #define MEMORY_LOG */
 #ifdef MEMORY_LOG
@@ -90,6 +91,11 @@ extern void log_memstats_stderr (const char *);
 /* return number of allocations outstanding for the type */
 extern unsigned long mtype_stats_alloc (int);
 
+/* return number of bytes outstanding for the type, and their high-water
+ * mark; 0 if the allocator can't tell the size of an allocation */
+extern unsigned long mtype_stats_bytes (int);
+extern unsigned long mtype_stats_bytes_max (int);
+
 /* Human friendly string for given byte count */
 #define MTYPE_MEMSTR_LEN 20
 extern const char *mtype_memstr (char *, size_t, unsigned long);
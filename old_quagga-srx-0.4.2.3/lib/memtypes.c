@@ -21,6 +21,7 @@ struct memory_list memory_list_lib[] =
   { MTYPE_THREAD,		"Thread"			},
   { MTYPE_THREAD_MASTER,	"Thread master"			},
   { MTYPE_THREAD_STATS,		"Thread stats"			},
+  { MTYPE_THREAD_POLL,		"Thread poll info"		},
   { MTYPE_VTY,			"VTY"				},
   { MTYPE_VTY_OUT_BUF,		"VTY output buffer"		},
   { MTYPE_VTY_HIST,		"VTY history"			},
@@ -40,6 +41,9 @@ struct memory_list memory_list_lib[] =
   { MTYPE_HASH_INDEX,		"Hash Index"			},
   { MTYPE_ROUTE_TABLE,		"Route table"			},
   { MTYPE_ROUTE_NODE,		"Route node"			},
+  { MTYPE_ROUTE_TRIE,		"Route trie"			},
+  { MTYPE_ROUTE_TRIE_CHUNK,	"Route trie nodes"		},
+  { MTYPE_ROUTE_TRIE_ENTRIES,	"Route trie entries"		},
   { MTYPE_DISTRIBUTE,		"Distribute list"		},
   { MTYPE_DISTRIBUTE_IFNAME,	"Dist-list ifname"		},
   { MTYPE_ACCESS_LIST,		"Access List"			},
@@ -48,6 +52,7 @@ struct memory_list memory_list_lib[] =
   { MTYPE_PREFIX_LIST,		"Prefix List"			},
   { MTYPE_PREFIX_LIST_ENTRY,	"Prefix List Entry"		},
   { MTYPE_PREFIX_LIST_STR,	"Prefix List Str"		},
+  { MTYPE_PREFIX_LIST_TRIE,	"Prefix List Trie"		},
   { MTYPE_ROUTE_MAP,		"Route map"			},
   { MTYPE_ROUTE_MAP_NAME,	"Route map name"		},
   { MTYPE_ROUTE_MAP_INDEX,	"Route map index"		},
@@ -102,6 +107,7 @@ struct memory_list memory_list_bgp[] =
   { MTYPE_AS_SEG,		"BGP aspath seg"		},
   { MTYPE_AS_SEG_DATA,		"BGP aspath segment data"	},
   { MTYPE_AS_STR,		"BGP aspath str"		},
+  { MTYPE_AS_PATH_MEMO,		"BGP aspath filter memo"	},
   { 0, NULL },
   { MTYPE_BGP_TABLE,		"BGP table"			},
   { MTYPE_BGP_NODE,		"BGP node"			},
@@ -150,6 +156,7 @@ struct memory_list memory_list_bgp[] =
   { MTYPE_BGP_DAMP_INFO,	"Dampening info"		},
   { MTYPE_BGP_DAMP_ARRAY,	"BGP Dampening array"		},
   { MTYPE_BGP_REGEXP,		"BGP regexp"			},
+  { MTYPE_BGP_REGEXP_DFA,	"BGP regexp DFA"		},
   { MTYPE_BGP_AGGREGATE,	"BGP aggregate"			},
   { MTYPE_BGP_ADDR,		"BGP own address"		},
 #ifdef USE_SRX
@@ -160,11 +167,8 @@ struct memory_list memory_list_bgp[] =
   { MTYPE_BGP_INFO_HASH,       "BGP info hash" },
   { MTYPE_BGP_INFO_HASH_ITEM,  "BGP info hash item" },
   { MTYPE_BGP_INFO_HASH_MUTEX, ""},
-  { MTYPE_BGPSEC_SIGNATURE,    "BGPSEC signature"},
   { MTYPE_BGPSEC_PATH,         "BGPSEC PATH structure"},
-  { MTYPE_BGPSEC_PATH_SEG,     "BGPSEC PATH segment" },
-  { MTYPE_BGPSEC_SIG_SEG,      "Signal segment"},
-  { MTYPE_BGPSEC_SIG_BLK,      "Signal block"},  
+  { MTYPE_BGPSEC_VAL_QUEUE,    "BGPSEC validation queue"},
 #endif /* USE_SRX */
   { -1, NULL }
 };
@@ -276,6 +280,32 @@ struct memory_list memory_list_vtysh[] =
   { -1, NULL },
 };
 
+/* Types whose freed objects are kept in a per-thread cache and handed
+ * out again by the next allocation, see memory.c.  Every allocation of
+ * such a type must be of the same size and it may not be reallocated.
+ * One type per line and first on the line, memtypes.awk must not take
+ * these for definitions.
+ */
+int memory_cache_types[] =
+{
+  MTYPE_LINK_NODE,
+  MTYPE_HASH_BACKET,
+  MTYPE_RIB,
+  MTYPE_NEXTHOP,
+  MTYPE_BGP_NODE,
+  MTYPE_BGP_ROUTE,
+  MTYPE_BGP_ROUTE_EXTRA,
+  MTYPE_ATTR,
+  MTYPE_ATTR_EXTRA,
+  MTYPE_AS_PATH,
+  MTYPE_AS_SEG,
+  MTYPE_BGP_ADJ_IN,
+  MTYPE_BGP_ADJ_OUT,
+  MTYPE_BGP_ADVERTISE,
+  MTYPE_BGP_ADVERTISE_ATTR,
+  -1
+};
+
 struct mlist mlists[] __attribute__ ((unused)) = {
   { memory_list_lib,	"LIB"	},
   { memory_list_zebra,	"ZEBRA"	},
@@ -15,6 +15,7 @@ enum
   MTYPE_THREAD,
   MTYPE_THREAD_MASTER,
   MTYPE_THREAD_STATS,
+  MTYPE_THREAD_POLL,
   MTYPE_VTY,
   MTYPE_VTY_OUT_BUF,
   MTYPE_VTY_HIST,
@@ -34,6 +35,9 @@ enum
   MTYPE_HASH_INDEX,
   MTYPE_ROUTE_TABLE,
   MTYPE_ROUTE_NODE,
+  MTYPE_ROUTE_TRIE,
+  MTYPE_ROUTE_TRIE_CHUNK,
+  MTYPE_ROUTE_TRIE_ENTRIES,
   MTYPE_DISTRIBUTE,
   MTYPE_DISTRIBUTE_IFNAME,
   MTYPE_ACCESS_LIST,
@@ -42,6 +46,7 @@ enum
   MTYPE_PREFIX_LIST,
   MTYPE_PREFIX_LIST_ENTRY,
   MTYPE_PREFIX_LIST_STR,
+  MTYPE_PREFIX_LIST_TRIE,
   MTYPE_ROUTE_MAP,
   MTYPE_ROUTE_MAP_NAME,
   MTYPE_ROUTE_MAP_INDEX,
@@ -86,6 +91,7 @@ enum
   MTYPE_AS_SEG,
   MTYPE_AS_SEG_DATA,
   MTYPE_AS_STR,
+  MTYPE_AS_PATH_MEMO,
   MTYPE_BGP_TABLE,
   MTYPE_BGP_NODE,
   MTYPE_BGP_ROUTE,
@@ -125,6 +131,7 @@ enum
   MTYPE_BGP_DAMP_INFO,
   MTYPE_BGP_DAMP_ARRAY,
   MTYPE_BGP_REGEXP,
+  MTYPE_BGP_REGEXP_DFA,
   MTYPE_BGP_AGGREGATE,
   MTYPE_BGP_ADDR,
 #ifdef USE_SRX
@@ -135,10 +142,7 @@ enum
   // see Bugzilla #20
   MTYPE_BGP_INFO_HASH_MUTEX,
   MTYPE_BGPSEC_PATH,
-  MTYPE_BGPSEC_SIGNATURE,
-  MTYPE_BGPSEC_PATH_SEG,
-  MTYPE_BGPSEC_SIG_SEG,
-  MTYPE_BGPSEC_SIG_BLK,
+  MTYPE_BGPSEC_VAL_QUEUE,
 #endif /* USE_SRX */
   MTYPE_RIP,
   MTYPE_RIP_INFO,
@@ -46,10 +46,43 @@ struct prefix_list_entry
   unsigned long refcnt;
   unsigned long hitcnt;
 
+  /* Trie lookups which matched this entry since the last refcnt
+     update, see prefix_list_refcnt_sync(). */
+  unsigned long matchcnt;
+
   struct prefix_list_entry *next;
   struct prefix_list_entry *prev;
+
+  /* Next entry on the same trie node, in seq order. */
+  struct prefix_list_entry *trie_next;
+};
+
+/* Binary trie on the prefix bits of all entries of a prefix-list.  Every
+   entry hangs off the node of its prefix, in seq order, so the matching
+   entry with the lowest seq on the path of a prefix is the one the linear
+   walk over the list returns.  The trie is built by prefix_list_apply()
+   and dropped whenever the list changes. */
+struct prefix_list_trie_node
+{
+  /* Index of the child nodes, 0 if none.  The root is never a child. */
+  u_int32_t child[2];
+
+  struct prefix_list_entry *entries;
 };
 
+struct prefix_list_trie
+{
+  struct prefix_list_trie_node *nodes;
+  u_int32_t count;
+  u_int32_t size;
+
+  /* Lookups without a match since the last refcnt update. */
+  unsigned long misscnt;
+};
+
+/* Shorter lists are walked linearly. */
+#define PREFIX_LIST_TRIE_MIN 16
+
 /* List of struct prefix_list. */
 struct prefix_list_list
 {
@@ -284,6 +317,97 @@ prefix_list_get (afi_t afi, const char *name)
   return plist;
 }
 
+/* A trie lookup evaluates, as far as refcnt is concerned, every entry up
+   to the one it matched, or all of them if none matched.  Fold the
+   lookups counted since the last call into refcnt. */
+static void
+prefix_list_refcnt_sync (struct prefix_list *plist)
+{
+  struct prefix_list_entry *pentry;
+  unsigned long seen;
+
+  if (! plist->trie)
+    return;
+
+  seen = plist->trie->misscnt;
+  for (pentry = plist->tail; pentry; pentry = pentry->prev)
+    {
+      seen += pentry->matchcnt;
+      pentry->refcnt += seen;
+      pentry->matchcnt = 0;
+    }
+  plist->trie->misscnt = 0;
+}
+
+/* Drop the trie of a prefix-list which is about to change. */
+static void
+prefix_list_trie_reset (struct prefix_list *plist)
+{
+  if (! plist->trie)
+    return;
+
+  prefix_list_refcnt_sync (plist);
+
+  XFREE (MTYPE_PREFIX_LIST_TRIE, plist->trie->nodes);
+  XFREE (MTYPE_PREFIX_LIST_TRIE, plist->trie);
+  plist->trie = NULL;
+}
+
+static u_int32_t
+prefix_list_trie_node_new (struct prefix_list_trie *trie)
+{
+  if (trie->count == trie->size)
+    {
+      trie->size *= 2;
+      trie->nodes = XREALLOC (MTYPE_PREFIX_LIST_TRIE, trie->nodes,
+			      trie->size * sizeof (struct prefix_list_trie_node));
+    }
+  memset (&trie->nodes[trie->count], 0, sizeof (struct prefix_list_trie_node));
+
+  return trie->count++;
+}
+
+#define PREFIX_LIST_BIT(P,D) (((P)[(D) / 8] >> (7 - (D) % 8)) & 1)
+
+static struct prefix_list_trie *
+prefix_list_trie_build (struct prefix_list *plist)
+{
+  struct prefix_list_trie *trie;
+  struct prefix_list_entry *pentry;
+  const u_char *bits;
+  u_int32_t node, next;
+  int depth, bit;
+
+  trie = XCALLOC (MTYPE_PREFIX_LIST_TRIE, sizeof (struct prefix_list_trie));
+  trie->size = 64;
+  trie->nodes = XMALLOC (MTYPE_PREFIX_LIST_TRIE,
+			 trie->size * sizeof (struct prefix_list_trie_node));
+  prefix_list_trie_node_new (trie);
+
+  /* Walk backwards, prepending keeps the entries of a node in seq order. */
+  for (pentry = plist->tail; pentry; pentry = pentry->prev)
+    {
+      bits = (const u_char *) &pentry->prefix.u.prefix;
+      node = 0;
+
+      for (depth = 0; depth < pentry->prefix.prefixlen; depth++)
+	{
+	  bit = PREFIX_LIST_BIT (bits, depth);
+	  if (! trie->nodes[node].child[bit])
+	    {
+	      next = prefix_list_trie_node_new (trie);
+	      trie->nodes[node].child[bit] = next;
+	    }
+	  node = trie->nodes[node].child[bit];
+	}
+
+      pentry->trie_next = trie->nodes[node].entries;
+      trie->nodes[node].entries = pentry;
+    }
+
+  return trie;
+}
+
 /* Delete prefix-list from prefix_list_master and free it. */
 static void
 prefix_list_delete (struct prefix_list *plist)
@@ -293,6 +417,8 @@ prefix_list_delete (struct prefix_list *plist)
   struct prefix_list_entry *pentry;
   struct prefix_list_entry *next;
 
+  prefix_list_trie_reset (plist);
+
   /* If prefix-list contain prefix_list_entry free all of it. */
   for (pentry = plist->head; pentry; pentry = next)
     {
@@ -437,6 +563,9 @@ prefix_list_entry_delete (struct prefix_list *plist,
 {
   if (plist == NULL || pentry == NULL)
     return;
+
+  prefix_list_trie_reset (plist);
+
   if (pentry->prev)
     pentry->prev->next = pentry->next;
   else
@@ -469,6 +598,8 @@ prefix_list_entry_add (struct prefix_list *plist,
   struct prefix_list_entry *replace;
   struct prefix_list_entry *point;
 
+  prefix_list_trie_reset (plist);
+
   /* Automatic asignment of seq no. */
   if (pentry->seq == -1)
     pentry->seq = prefix_new_seq_get (plist);
@@ -532,34 +663,80 @@ prefix_list_type_str (struct prefix_list_entry *pentry)
     }
 }
 
+/* Check the prefix length against the entry's le and ge. */
 static int
-prefix_list_entry_match (struct prefix_list_entry *pentry, struct prefix *p)
+prefix_list_entry_len_match (struct prefix_list_entry *pentry, int prefixlen)
 {
-  int ret;
-
-  ret = prefix_match (&pentry->prefix, p);
-  if (! ret)
-    return 0;
-  
   /* In case of le nor ge is specified, exact match is performed. */
   if (! pentry->le && ! pentry->ge)
     {
-      if (pentry->prefix.prefixlen != p->prefixlen)
+      if (pentry->prefix.prefixlen != prefixlen)
 	return 0;
     }
   else
     {  
       if (pentry->le)
-	if (p->prefixlen > pentry->le)
+	if (prefixlen > pentry->le)
 	  return 0;
 
       if (pentry->ge)
-	if (p->prefixlen < pentry->ge)
+	if (prefixlen < pentry->ge)
 	  return 0;
     }
   return 1;
 }
 
+static int
+prefix_list_entry_match (struct prefix_list_entry *pentry, struct prefix *p)
+{
+  int ret;
+
+  ret = prefix_match (&pentry->prefix, p);
+  if (! ret)
+    return 0;
+  
+  return prefix_list_entry_len_match (pentry, p->prefixlen);
+}
+
+/* Return the first entry matching the prefix, walking the trie along the
+   prefix bits. */
+static struct prefix_list_entry *
+prefix_list_trie_match (struct prefix_list_trie *trie, struct prefix *p)
+{
+  struct prefix_list_trie_node *node;
+  struct prefix_list_entry *pentry;
+  struct prefix_list_entry *best = NULL;
+  const u_char *bits;
+  u_int32_t next;
+  int depth;
+
+  bits = (const u_char *) &p->u.prefix;
+  node = &trie->nodes[0];
+
+  for (depth = 0; ; depth++)
+    {
+      for (pentry = node->entries; pentry; pentry = pentry->trie_next)
+	{
+	  if (best && pentry->seq >= best->seq)
+	    break;
+	  if (prefix_list_entry_len_match (pentry, p->prefixlen))
+	    {
+	      best = pentry;
+	      break;
+	    }
+	}
+
+      if (depth == p->prefixlen)
+	break;
+      next = node->child[PREFIX_LIST_BIT (bits, depth)];
+      if (! next)
+	break;
+      node = &trie->nodes[next];
+    }
+
+  return best;
+}
+
 enum prefix_list_type
 prefix_list_apply (struct prefix_list *plist, void *object)
 {
@@ -574,6 +751,22 @@ prefix_list_apply (struct prefix_list *plist, void *object)
   if (plist->count == 0)
     return PREFIX_PERMIT;
 
+  if (plist->count >= PREFIX_LIST_TRIE_MIN)
+    {
+      if (! plist->trie)
+	plist->trie = prefix_list_trie_build (plist);
+
+      pentry = prefix_list_trie_match (plist->trie, p);
+      if (! pentry)
+	{
+	  plist->trie->misscnt++;
+	  return PREFIX_DENY;
+	}
+      pentry->matchcnt++;
+      pentry->hitcnt++;
+      return pentry->type;
+    }
+
   for (pentry = plist->head; pentry; pentry = pentry->next)
     {
       pentry->refcnt++;
@@ -955,6 +1148,8 @@ vty_show_prefix_entry (struct vty *vty, afi_t afi, struct prefix_list *plist,
 
   if (dtype != summary_display)
     {
+      prefix_list_refcnt_sync (plist);
+
       for (pentry = plist->head; pentry; pentry = pentry->next)
 	{
 	  if (dtype == sequential_display && pentry->seq != seqnum)
@@ -1061,6 +1256,8 @@ vty_show_prefix_list_prefix (struct vty *vty, afi_t afi, const char *name,
       return CMD_WARNING;
     }
 
+  prefix_list_refcnt_sync (plist);
+
   for (pentry = plist->head; pentry; pentry = pentry->next)
     {
       match = 0;
@@ -52,6 +52,9 @@ struct prefix_list
   struct prefix_list_entry *head;
   struct prefix_list_entry *tail;
 
+  /* Lookup trie, built on demand by prefix_list_apply(). */
+  struct prefix_list_trie *trie;
+
   struct prefix_list *next;
   struct prefix_list *prev;
 };
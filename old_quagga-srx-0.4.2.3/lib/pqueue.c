@@ -168,3 +168,22 @@ pqueue_dequeue (struct pqueue *queue)
   trickle_down (0, queue);
   return data;
 }
+
+/* Remove the node at the given position, the update() callback must be
+   used to keep track of the position of the nodes. */
+void
+pqueue_remove_at (int index, struct pqueue *queue)
+{
+  queue->array[index] = queue->array[--queue->size];
+
+  /* the last node was removed */
+  if (index == queue->size)
+    return;
+
+  if (index > 0
+      && (*queue->cmp) (queue->array[index],
+                        queue->array[PARENT_OF (index)]) < 0)
+    trickle_up (index, queue);
+  else
+    trickle_down (index, queue);
+}
@@ -29,6 +29,17 @@
 
 static void route_node_delete (struct route_node *);
 static void route_table_free (struct route_table *);
+static void route_trie_free (struct route_table *);
+static struct route_node *route_trie_match (const struct route_trie *,
+					    const struct prefix *, int, int);
+static struct route_node *route_trie_lookup (const struct route_trie *,
+					     const struct prefix *);
+static struct route_node *route_trie_get (struct route_table *,
+					  struct prefix *);
+static void route_trie_delete (struct route_node *);
+static struct route_node *route_trie_next (struct route_node *);
+static struct route_node *route_trie_get_next (const struct route_table *,
+					       struct prefix *);
 
 
 /*
@@ -88,6 +99,9 @@ route_table_free (struct route_table *rt)
   if (rt == NULL)
     return;
 
+  if (rt->trie)
+    route_trie_free (rt);
+
   node = rt->top;
 
   /* Bulk deletion of nodes remaining in this table.  This function is not
@@ -191,6 +205,20 @@ route_lock_node (struct route_node *node)
   return node;
 }
 
+/* Nearest node above this one: its parent in the patricia tree, the
+   longest node covering it in a trie table.  Not locked. */
+struct route_node *
+route_node_parent (struct route_node *node)
+{
+  if (node->table->trie == NULL)
+    return node->parent;
+
+  if (node->p.prefixlen == 0)
+    return NULL;
+  return route_trie_match (node->table->trie, &node->p,
+			   node->p.prefixlen - 1, 0);
+}
+
 /* Unlock node. */
 void
 route_unlock_node (struct route_node *node)
@@ -209,6 +237,12 @@ route_node_match (const struct route_table *table, const struct prefix *p)
   struct route_node *node;
   struct route_node *matched;
 
+  if (table->trie)
+    {
+      matched = route_trie_match (table->trie, p, p->prefixlen, 1);
+      return matched ? route_lock_node (matched) : NULL;
+    }
+
   matched = NULL;
   node = table->top;
 
@@ -271,6 +305,12 @@ route_node_lookup (const struct route_table *table, struct prefix *p)
   u_char prefixlen = p->prefixlen;
   const u_char *prefix = &p->u.prefix;
 
+  if (table->trie)
+    {
+      node = route_trie_lookup (table->trie, p);
+      return node && node->info ? route_lock_node (node) : NULL;
+    }
+
   node = table->top;
 
   while (node && node->p.prefixlen <= prefixlen &&
@@ -295,6 +335,9 @@ route_node_get (struct route_table *const table, struct prefix *p)
   u_char prefixlen = p->prefixlen;
   const u_char *prefix = &p->u.prefix;
 
+  if (table->trie)
+    return route_trie_get (table, p);
+
   match = NULL;
   node = table->top;
   while (node && node->p.prefixlen <= prefixlen &&
@@ -352,6 +395,12 @@ route_node_delete (struct route_node *node)
   assert (node->lock == 0);
   assert (node->info == NULL);
 
+  if (node->table->trie)
+    {
+      route_trie_delete (node);
+      return;
+    }
+
   if (node->l_left && node->l_right)
     return;
 
@@ -408,6 +457,15 @@ route_next (struct route_node *node)
   /* Node may be deleted from route_unlock_node so we have to preserve
      next node's pointer. */
 
+  if (node->table->trie)
+    {
+      next = route_trie_next (node);
+      if (next)
+	route_lock_node (next);
+      route_unlock_node (node);
+      return next;
+    }
+
   if (node->l_left)
     {
       next = node->l_left;
@@ -449,6 +507,17 @@ route_next_until (struct route_node *node, struct route_node *limit)
   /* Node may be deleted from route_unlock_node so we have to preserve
      next node's pointer. */
 
+  if (node->table->trie)
+    {
+      next = route_trie_next (node);
+      if (next && ! prefix_match (&limit->p, &next->p))
+	next = NULL;
+      if (next)
+	route_lock_node (next);
+      route_unlock_node (node);
+      return next;
+    }
+
   if (node->l_left)
     {
       next = node->l_left;
@@ -529,6 +598,762 @@ route_table_init (void)
   return route_table_init_with_delegate (&default_delegate);
 }
 
+/*
+ * Multibit trie.
+ *
+ * A table created by route_table_init_trie keeps its nodes in a trie
+ * that resolves ROUTE_TRIE_STRIDE bits of the key per level instead of
+ * one.  A trie node at depth d (a multiple of the stride) holds the
+ * route nodes of lengths d+1 to d+STRIDE below its key, and up to
+ * 2^STRIDE children for the longer ones.  Trie nodes holding no route
+ * node and a single child are left out (path compression), the key of
+ * a child tells which bits were skipped.  The route nodes and children
+ * of a trie node are kept in one array in iteration order, indexed
+ * through a bitmap so that a node only takes room for what it holds.
+ *
+ * Route nodes never move between trie nodes and there are no glue
+ * route nodes, so count is the number of route nodes and a node goes
+ * away as soon as its lock drops to zero.  Iteration gives the same
+ * order as the patricia tree, and top is kept at the first node in
+ * that order.
+ *
+ * Trie nodes are allocated from chunks owned by the trie; a chunk is
+ * given back once none of its nodes is in use.
+ */
+#define ROUTE_TRIE_STRIDE	4
+#define ROUTE_TRIE_FANOUT	(1 << ROUTE_TRIE_STRIDE)
+#define ROUTE_TRIE_SLOTS	(2 * ROUTE_TRIE_FANOUT - 2)
+#define ROUTE_TRIE_ENTRIES	(ROUTE_TRIE_SLOTS + ROUTE_TRIE_FANOUT)
+#define ROUTE_TRIE_KEYLEN	16
+#define ROUTE_TRIE_CHUNK_NODES	256
+
+/* Positions of the children, see route_trie_rank. */
+#define ROUTE_TRIE_CHILDREN	0x294528528a50ULL
+
+struct route_trie_node
+{
+  /* Parent trie node, next free node while in a chunk's free list. */
+  struct route_trie_node *parent;
+
+  /* Route nodes and children in iteration order.  A single entry is
+     kept in place of the array. */
+  union
+  {
+    void *one;
+    void **many;
+  } entry;
+
+  /* Entries present, by position, see route_trie_rank. */
+  u_int64_t present;
+
+  /* Chunk this node was allocated from. */
+  u_int32_t chunk;
+
+  /* Bits of key above this node, and index in the parent. */
+  u_char depth;
+  u_char pos;
+
+  u_char key[ROUTE_TRIE_KEYLEN];
+};
+
+struct route_trie_chunk
+{
+  /* List of chunks with free nodes. */
+  struct route_trie_chunk *next;
+  struct route_trie_chunk *prev;
+
+  struct route_trie_node *free;
+  unsigned int used;
+  unsigned int index;
+
+  struct route_trie_node node[ROUTE_TRIE_CHUNK_NODES];
+};
+
+struct route_trie
+{
+  struct route_trie_node *root;
+
+  /* Route node of length zero, it has no slot. */
+  struct route_node *zero;
+
+  /* Chunks by index, and those with free nodes. */
+  struct route_trie_chunk **chunk;
+  unsigned int chunk_max;
+  struct route_trie_chunk *partial;
+};
+
+/* Position of each entry of a trie node in iteration order: the slot
+   of a route node comes before those of its more specifics, and the
+   slot of a route node of length d+STRIDE is followed by the child for
+   its bits.  Slots are 0 to ROUTE_TRIE_SLOTS - 1, see route_trie_slot,
+   children follow.  For a stride of 4. */
+static const u_char route_trie_rank[ROUTE_TRIE_ENTRIES] =
+{
+   0, 23,  1, 12, 24, 35,  2,  7, 13, 18, 25, 30, 36, 41,  3,  5,
+   8, 10, 14, 16, 19, 21, 26, 28, 31, 33, 37, 39, 42, 44,  4,  6,
+   9, 11, 15, 17, 20, 22, 27, 29, 32, 34, 38, 40, 43, 45
+};
+
+/* Get len (at most STRIDE) bits of key at offset off, a multiple of
+   STRIDE. */
+static inline unsigned int
+route_trie_bits (const u_char *key, int off, int len)
+{
+  unsigned int bits = key[off / 8];
+
+  if (off % 8 == 0)
+    bits >>= 4;
+  return (bits & 0x0f) >> (ROUTE_TRIE_STRIDE - len);
+}
+
+/* Slot of the route node len bits below the trie node, 1 <= len <=
+   STRIDE. */
+static inline unsigned int
+route_trie_slot (int len, unsigned int bits)
+{
+  return (1 << len) - 2 + bits;
+}
+
+/* Check the first len bits of two keys are the same. */
+static int
+route_trie_key_match (const u_char *a, const u_char *b, int len)
+{
+  int offset = len / 8;
+
+  if (len % 8 && maskbit[len % 8] & (a[offset] ^ b[offset]))
+    return 0;
+  return memcmp (a, b, offset) == 0;
+}
+
+/* Number of leading bits two keys have in common, up to len. */
+static int
+route_trie_key_common (const u_char *a, const u_char *b, int len)
+{
+  int i;
+  u_char diff;
+
+  for (i = 0; i * 8 < len; i++)
+    if ((diff = a[i] ^ b[i]) != 0)
+      {
+	len = MIN (len, i * 8 + __builtin_clz (diff) - 24);
+	break;
+      }
+  return len;
+}
+
+static inline unsigned int
+route_trie_entry_count (const struct route_trie_node *tn)
+{
+  return __builtin_popcountll (tn->present);
+}
+
+/* Entry at position pos, NULL if absent. */
+static inline void *
+route_trie_entry (const struct route_trie_node *tn, unsigned int pos)
+{
+  u_int64_t below = tn->present & ((1ULL << pos) - 1);
+
+  if (! (tn->present & (1ULL << pos)))
+    return NULL;
+  if (tn->present == (1ULL << pos))
+    return tn->entry.one;
+  return tn->entry.many[__builtin_popcountll (below)];
+}
+
+static inline struct route_node *
+route_trie_slot_get (const struct route_trie_node *tn, unsigned int slot)
+{
+  return route_trie_entry (tn, route_trie_rank[slot]);
+}
+
+static inline struct route_trie_node *
+route_trie_child (const struct route_trie_node *tn, unsigned int pos)
+{
+  return route_trie_entry (tn, route_trie_rank[ROUTE_TRIE_SLOTS + pos]);
+}
+
+/* Add an entry at position pos. */
+static void
+route_trie_entry_add (struct route_trie_node *tn, unsigned int pos,
+		      void *entry)
+{
+  unsigned int count = route_trie_entry_count (tn);
+  unsigned int index = __builtin_popcountll (tn->present
+					     & ((1ULL << pos) - 1));
+  void **many;
+
+  if (count == 0)
+    many = NULL;
+  else if (count == 1)
+    {
+      many = XMALLOC (MTYPE_ROUTE_TRIE_ENTRIES, 2 * sizeof (void *));
+      many[0] = tn->entry.one;
+    }
+  else
+    many = XREALLOC (MTYPE_ROUTE_TRIE_ENTRIES, tn->entry.many,
+		     (count + 1) * sizeof (void *));
+
+  tn->present |= 1ULL << pos;
+  if (many == NULL)
+    {
+      tn->entry.one = entry;
+      return;
+    }
+
+  memmove (&many[index + 1], &many[index], (count - index) * sizeof (void *));
+  many[index] = entry;
+  tn->entry.many = many;
+}
+
+/* Remove the entry at position pos. */
+static void
+route_trie_entry_remove (struct route_trie_node *tn, unsigned int pos)
+{
+  unsigned int count = route_trie_entry_count (tn);
+  unsigned int index = __builtin_popcountll (tn->present
+					     & ((1ULL << pos) - 1));
+  void **many = tn->entry.many;
+
+  tn->present &= ~(1ULL << pos);
+
+  if (count == 1)
+    return;
+
+  if (count == 2)
+    {
+      tn->entry.one = many[! index];
+      XFREE (MTYPE_ROUTE_TRIE_ENTRIES, many);
+      return;
+    }
+
+  memmove (&many[index], &many[index + 1],
+	   (count - index - 1) * sizeof (void *));
+  tn->entry.many = XREALLOC (MTYPE_ROUTE_TRIE_ENTRIES, many,
+			     (count - 1) * sizeof (void *));
+}
+
+/* Replace the entry at position pos. */
+static void
+route_trie_entry_set (struct route_trie_node *tn, unsigned int pos,
+		      void *entry)
+{
+  if (tn->present == (1ULL << pos))
+    tn->entry.one = entry;
+  else
+    tn->entry.many[__builtin_popcountll (tn->present
+					 & ((1ULL << pos) - 1))] = entry;
+}
+
+static void
+route_trie_child_add (struct route_trie_node *tn, unsigned int pos,
+		      struct route_trie_node *child)
+{
+  route_trie_entry_add (tn, route_trie_rank[ROUTE_TRIE_SLOTS + pos], child);
+  child->parent = tn;
+  child->pos = pos;
+}
+
+static void
+route_trie_child_replace (struct route_trie_node *tn, unsigned int pos,
+			  struct route_trie_node *child)
+{
+  route_trie_entry_set (tn, route_trie_rank[ROUTE_TRIE_SLOTS + pos], child);
+  child->parent = tn;
+  child->pos = pos;
+}
+
+static void
+route_trie_chunk_link (struct route_trie *trie, struct route_trie_chunk *ch)
+{
+  ch->prev = NULL;
+  ch->next = trie->partial;
+  if (ch->next)
+    ch->next->prev = ch;
+  trie->partial = ch;
+}
+
+static void
+route_trie_chunk_unlink (struct route_trie *trie, struct route_trie_chunk *ch)
+{
+  if (ch->prev)
+    ch->prev->next = ch->next;
+  else
+    trie->partial = ch->next;
+  if (ch->next)
+    ch->next->prev = ch->prev;
+  ch->next = ch->prev = NULL;
+}
+
+static struct route_trie_chunk *
+route_trie_chunk_new (struct route_trie *trie)
+{
+  struct route_trie_chunk *ch;
+  unsigned int index;
+  int i;
+
+  for (index = 0; index < trie->chunk_max; index++)
+    if (trie->chunk[index] == NULL)
+      break;
+
+  if (index == trie->chunk_max)
+    {
+      trie->chunk_max = trie->chunk_max ? trie->chunk_max * 2 : 16;
+      trie->chunk = XREALLOC (MTYPE_ROUTE_TRIE, trie->chunk,
+			      trie->chunk_max * sizeof (*trie->chunk));
+      memset (&trie->chunk[index], 0,
+	      (trie->chunk_max - index) * sizeof (*trie->chunk));
+    }
+
+  ch = XMALLOC (MTYPE_ROUTE_TRIE_CHUNK, sizeof (struct route_trie_chunk));
+  ch->free = NULL;
+  for (i = ROUTE_TRIE_CHUNK_NODES - 1; i >= 0; i--)
+    {
+      ch->node[i].parent = ch->free;
+      ch->free = &ch->node[i];
+    }
+  ch->used = 0;
+  ch->index = index;
+  trie->chunk[index] = ch;
+  route_trie_chunk_link (trie, ch);
+
+  return ch;
+}
+
+/* Allocate a trie node with the first depth bits of key. */
+static struct route_trie_node *
+route_trie_node_new (struct route_trie *trie, const u_char *key, int depth)
+{
+  struct route_trie_chunk *ch;
+  struct route_trie_node *tn;
+
+  ch = trie->partial;
+  if (ch == NULL)
+    ch = route_trie_chunk_new (trie);
+
+  tn = ch->free;
+  ch->free = tn->parent;
+  if (ch->free == NULL)
+    route_trie_chunk_unlink (trie, ch);
+  ch->used++;
+
+  memset (tn, 0, sizeof (struct route_trie_node));
+  tn->chunk = ch->index;
+  tn->depth = depth;
+  if (depth)
+    memcpy (tn->key, key, (depth + 7) / 8);
+  if (depth % 8)
+    tn->key[depth / 8] &= maskbit[depth % 8];
+
+  return tn;
+}
+
+/* Give a trie node back to its chunk, and the chunk back to the system
+   when it is empty and not the only one with free nodes. */
+static void
+route_trie_node_free (struct route_trie *trie, struct route_trie_node *tn)
+{
+  struct route_trie_chunk *ch = trie->chunk[tn->chunk];
+
+  if (route_trie_entry_count (tn) > 1)
+    XFREE (MTYPE_ROUTE_TRIE_ENTRIES, tn->entry.many);
+
+  if (ch->free == NULL)
+    route_trie_chunk_link (trie, ch);
+  tn->parent = ch->free;
+  ch->free = tn;
+  ch->used--;
+
+  if (ch->used == 0 && (ch->prev || ch->next))
+    {
+      route_trie_chunk_unlink (trie, ch);
+      trie->chunk[ch->index] = NULL;
+      XFREE (MTYPE_ROUTE_TRIE_CHUNK, ch);
+    }
+}
+
+static struct route_trie *
+route_trie_new (void)
+{
+  struct route_trie *trie;
+
+  trie = XCALLOC (MTYPE_ROUTE_TRIE, sizeof (struct route_trie));
+  trie->root = route_trie_node_new (trie, NULL, 0);
+  return trie;
+}
+
+/* Free the route nodes below a trie node, and the trie nodes. */
+static void
+route_trie_free_subtree (struct route_table *table, struct route_trie_node *tn)
+{
+  u_int64_t present = tn->present;
+  struct route_node *node;
+  unsigned int pos;
+
+  for (; present; present &= present - 1)
+    {
+      pos = __builtin_ctzll (present);
+      if (ROUTE_TRIE_CHILDREN & (1ULL << pos))
+	{
+	  route_trie_free_subtree (table, route_trie_entry (tn, pos));
+	  continue;
+	}
+
+      node = route_trie_entry (tn, pos);
+      table->count--;
+      node->lock = 0;  /* to cause assert if unlocked after this */
+      route_node_free (table, node);
+    }
+
+  route_trie_node_free (table->trie, tn);
+}
+
+/* Bulk deletion, see route_table_free. */
+static void
+route_trie_free (struct route_table *table)
+{
+  struct route_trie *trie = table->trie;
+  unsigned int i;
+
+  if (trie->zero)
+    {
+      table->count--;
+      trie->zero->lock = 0;
+      route_node_free (table, trie->zero);
+    }
+  route_trie_free_subtree (table, trie->root);
+  table->top = NULL;
+
+  for (i = 0; i < trie->chunk_max; i++)
+    if (trie->chunk[i])
+      XFREE (MTYPE_ROUTE_TRIE_CHUNK, trie->chunk[i]);
+  if (trie->chunk)
+    XFREE (MTYPE_ROUTE_TRIE, trie->chunk);
+  XFREE (MTYPE_ROUTE_TRIE, trie);
+  table->trie = NULL;
+}
+
+/* First route node at or after position pos of a trie node, in
+   iteration order, going up the trie when the node has no more. */
+static struct route_node *
+route_trie_walk (struct route_trie *trie, struct route_trie_node *tn,
+		 unsigned int pos)
+{
+  u_int64_t rest;
+
+  for (;;)
+    {
+      rest = (pos < ROUTE_TRIE_ENTRIES) ? tn->present >> pos << pos : 0;
+      if (rest)
+	{
+	  pos = __builtin_ctzll (rest);
+	  if (! (ROUTE_TRIE_CHILDREN & (1ULL << pos)))
+	    return route_trie_entry (tn, pos);
+	  tn = route_trie_entry (tn, pos);
+	  pos = 0;
+	  continue;
+	}
+
+      if (tn == trie->root)
+	return NULL;
+
+      pos = route_trie_rank[ROUTE_TRIE_SLOTS + tn->pos] + 1;
+      tn = tn->parent;
+    }
+}
+
+/* Slot of a route node in its trie node. */
+static unsigned int
+route_trie_node_slot (const struct route_node *node)
+{
+  int len = node->p.prefixlen - node->trie->depth;
+
+  return route_trie_slot (len, route_trie_bits (&node->p.u.prefix,
+						 node->trie->depth, len));
+}
+
+/* Node following the given one in iteration order, not locked. */
+static struct route_node *
+route_trie_next (struct route_node *node)
+{
+  struct route_trie *trie = node->table->trie;
+
+  if (node->p.prefixlen == 0)
+    return route_trie_walk (trie, trie->root, 0);
+
+  return route_trie_walk (trie, node->trie,
+			  route_trie_rank[route_trie_node_slot (node)] + 1);
+}
+
+/* Longest node covering p with a length up to len, with info when
+   with_info is set. */
+static struct route_node *
+route_trie_match (const struct route_trie *trie, const struct prefix *p,
+		  int len, int with_info)
+{
+  const u_char *key = &p->u.prefix;
+  struct route_trie_node *tn;
+  struct route_node *node;
+  struct route_node *matched;
+  int depth;
+  int i;
+
+  matched = NULL;
+  if (trie->zero && (! with_info || trie->zero->info))
+    matched = trie->zero;
+
+  tn = trie->root;
+  while (tn && (depth = tn->depth) < len
+	 && route_trie_key_match (tn->key, key, depth))
+    {
+      for (i = MIN (ROUTE_TRIE_STRIDE, len - depth); i > 0; i--)
+	{
+	  node = route_trie_slot_get (tn, route_trie_slot (i,
+			 route_trie_bits (key, depth, i)));
+	  if (node && (! with_info || node->info))
+	    {
+	      matched = node;
+	      break;
+	    }
+	}
+
+      if (len <= depth + ROUTE_TRIE_STRIDE)
+	break;
+      tn = route_trie_child (tn, route_trie_bits (key, depth,
+						  ROUTE_TRIE_STRIDE));
+    }
+
+  return matched;
+}
+
+/* Route node of prefix p, NULL when there is none. */
+static struct route_node *
+route_trie_lookup (const struct route_trie *trie, const struct prefix *p)
+{
+  const u_char *key = &p->u.prefix;
+  struct route_trie_node *tn;
+  int len = p->prefixlen;
+  int depth;
+
+  if (len == 0)
+    return trie->zero;
+
+  depth = (len - 1) / ROUTE_TRIE_STRIDE * ROUTE_TRIE_STRIDE;
+  tn = trie->root;
+  while (tn->depth < depth)
+    {
+      tn = route_trie_child (tn, route_trie_bits (key, tn->depth,
+						  ROUTE_TRIE_STRIDE));
+      if (tn == NULL || tn->depth > depth)
+	return NULL;
+    }
+
+  /* Only the bits skipped on the way down are left to check. */
+  if (! route_trie_key_match (tn->key, key, depth))
+    return NULL;
+
+  return route_trie_slot_get (tn, route_trie_slot (len - depth,
+			      route_trie_bits (key, depth, len - depth)));
+}
+
+/* Trie node at depth holding the slots of p, created if needed. */
+static struct route_trie_node *
+route_trie_node_get (struct route_trie *trie, const struct prefix *p,
+		     int depth)
+{
+  const u_char *key = &p->u.prefix;
+  struct route_trie_node *tn;
+  struct route_trie_node *child;
+  struct route_trie_node *new;
+  unsigned int pos;
+  int common;
+
+  tn = trie->root;
+  while (tn->depth < depth)
+    {
+      pos = route_trie_bits (key, tn->depth, ROUTE_TRIE_STRIDE);
+      child = route_trie_child (tn, pos);
+
+      if (child == NULL)
+	{
+	  new = route_trie_node_new (trie, key, depth);
+	  route_trie_child_add (tn, pos, new);
+	  return new;
+	}
+
+      if (child->depth <= depth
+	  && route_trie_key_match (child->key, key, child->depth))
+	{
+	  tn = child;
+	  continue;
+	}
+
+      /* The child skips bits where p goes its own way, or goes below
+	 depth: put a trie node where they part. */
+      common = route_trie_key_common (child->key, key,
+				      MIN (child->depth, depth));
+      new = route_trie_node_new (trie, key,
+				 common - common % ROUTE_TRIE_STRIDE);
+      route_trie_child_replace (tn, pos, new);
+      route_trie_child_add (new, route_trie_bits (child->key, new->depth,
+						  ROUTE_TRIE_STRIDE), child);
+      tn = new;
+    }
+
+  return tn;
+}
+
+/* Add node to a trie table, see route_node_get. */
+static struct route_node *
+route_trie_get (struct route_table *table, struct prefix *p)
+{
+  struct route_trie *trie = table->trie;
+  struct route_trie_node *tn;
+  struct route_node *new;
+  int depth;
+
+  assert (p->prefixlen <= ROUTE_TRIE_KEYLEN * 8);
+
+  new = route_trie_lookup (trie, p);
+  if (new)
+    return route_lock_node (new);
+
+  new = route_node_set (table, p);
+  if (p->prefixlen == 0)
+    {
+      new->trie = trie->root;
+      trie->zero = new;
+    }
+  else
+    {
+      depth = (p->prefixlen - 1) / ROUTE_TRIE_STRIDE * ROUTE_TRIE_STRIDE;
+      tn = route_trie_node_get (trie, p, depth);
+      new->trie = tn;
+      route_trie_entry_add (tn, route_trie_rank[route_trie_node_slot (new)],
+			    new);
+    }
+
+  if (table->top == NULL
+      || route_table_prefix_iter_cmp (&new->p, &table->top->p) < 0)
+    table->top = new;
+  table->count++;
+
+  return route_lock_node (new);
+}
+
+/* Delete node from a trie table, see route_node_delete. */
+static void
+route_trie_delete (struct route_node *node)
+{
+  struct route_table *table = node->table;
+  struct route_trie *trie = table->trie;
+  struct route_trie_node *tn = node->trie;
+  struct route_trie_node *parent;
+  unsigned int pos;
+
+  if (table->top == node)
+    table->top = route_trie_next (node);
+
+  if (node->p.prefixlen == 0)
+    trie->zero = NULL;
+  else
+    {
+      route_trie_entry_remove (tn,
+			       route_trie_rank[route_trie_node_slot (node)]);
+
+      /* Drop the trie nodes left with nothing to hold, and the one left
+	 with a single child. */
+      while (tn != trie->root && ! (tn->present & ~ROUTE_TRIE_CHILDREN))
+	{
+	  parent = tn->parent;
+	  pos = route_trie_rank[ROUTE_TRIE_SLOTS + tn->pos];
+	  if (tn->present == 0)
+	    route_trie_entry_remove (parent, pos);
+	  else if (route_trie_entry_count (tn) == 1)
+	    route_trie_child_replace (parent, tn->pos, tn->entry.one);
+	  else
+	    break;
+	  route_trie_node_free (trie, tn);
+	  tn = parent;
+	}
+    }
+
+  table->count--;
+  route_node_free (table, node);
+}
+
+/* Node following p in iteration order, see route_table_get_next. */
+static struct route_node *
+route_trie_get_next (const struct route_table *table, struct prefix *p)
+{
+  struct route_trie *trie = table->trie;
+  struct route_trie_node *tn;
+  struct route_trie_node *child;
+  struct route_node *node;
+  struct prefix subtree;
+  u_int64_t present;
+  unsigned int pos;
+
+  /* The first entry following p, descending into the subtrees that
+     hold p. */
+  tn = trie->root;
+  present = tn->present;
+  while (present)
+    {
+      pos = __builtin_ctzll (present);
+      present &= present - 1;
+
+      if (! (ROUTE_TRIE_CHILDREN & (1ULL << pos)))
+	{
+	  node = route_trie_entry (tn, pos);
+	  if (route_table_prefix_iter_cmp (&node->p, p) > 0)
+	    return node;
+	  continue;
+	}
+
+      child = route_trie_entry (tn, pos);
+      memset (&subtree, 0, sizeof (struct prefix));
+      subtree.family = p->family;
+      subtree.prefixlen = child->depth;
+      memcpy (&subtree.u.prefix, child->key, (child->depth + 7) / 8);
+
+      if (prefix_match (&subtree, p))
+	{
+	  tn = child;
+	  present = tn->present;
+	}
+      else if (route_table_prefix_iter_cmp (&subtree, p) > 0)
+	return route_trie_walk (trie, child, 0);
+    }
+
+  /* Everything below tn comes before p. */
+  if (tn == trie->root)
+    return NULL;
+  return route_trie_walk (trie, tn->parent,
+			  route_trie_rank[ROUTE_TRIE_SLOTS + tn->pos] + 1);
+}
+
+/*
+ * route_table_init_trie_with_delegate
+ */
+struct route_table *
+route_table_init_trie_with_delegate (route_table_delegate_t *delegate)
+{
+  struct route_table *rt;
+
+  rt = route_table_init_with_delegate (delegate);
+  rt->trie = route_trie_new ();
+  return rt;
+}
+
+/*
+ * route_table_init_trie
+ */
+struct route_table *
+route_table_init_trie (void)
+{
+  return route_table_init_trie_with_delegate (&default_delegate);
+}
+
 /**
  * route_table_prefix_iter_cmp
  *
@@ -629,6 +1454,9 @@ route_table_get_next_internal (const struct route_table *table,
   u_char prefixlen;
   int cmp;
 
+  if (table->trie)
+    return route_trie_get_next (table, p);
+
   prefixlen = p->prefixlen;
 
   node = table->top;
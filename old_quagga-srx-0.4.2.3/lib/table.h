@@ -28,6 +28,8 @@
  */
 struct route_node;
 struct route_table;
+struct route_trie;
+struct route_trie_node;
 
 /*
  * route_table_delegate_t
@@ -60,6 +62,12 @@ struct route_table
   route_table_delegate_t *delegate;
   
   unsigned long count;
+
+  /*
+   * Multibit trie holding the nodes, see route_table_init_trie.  NULL
+   * when the nodes are kept in the patricia tree.
+   */
+  struct route_trie *trie;
   
   /*
    * User data.
@@ -74,10 +82,17 @@ struct route_table
   /* Actual prefix of this radix. */		\
   struct prefix p;				\
 						\
-  /* Tree link. */				\
+  /* Tree link.  parent and link[] are only	\
+     kept by the patricia tree, a node of a	\
+     trie table points at its trie node and	\
+     route_node_parent() finds its parent. */	\
   struct route_table *table;			\
   struct route_node *parent;			\
-  struct route_node *link[2];			\
+  union						\
+  {						\
+    struct route_node *link[2];			\
+    struct route_trie_node *trie;		\
+  };						\
 						\
   /* Lock of this radix */			\
   unsigned int lock;				\
@@ -140,6 +155,9 @@ extern struct route_table *route_table_init (void);
 
 extern struct route_table *
 route_table_init_with_delegate (route_table_delegate_t *);
+extern struct route_table *route_table_init_trie (void);
+extern struct route_table *
+route_table_init_trie_with_delegate (route_table_delegate_t *);
 
 extern void route_table_finish (struct route_table *);
 extern void route_unlock_node (struct route_node *node);
@@ -152,6 +170,7 @@ extern struct route_node *route_node_get (struct route_table *const,
 extern struct route_node *route_node_lookup (const struct route_table *,
                                              struct prefix *);
 extern struct route_node *route_lock_node (struct route_node *node);
+extern struct route_node *route_node_parent (struct route_node *node);
 extern struct route_node *route_node_match (const struct route_table *,
                                             const struct prefix *);
 extern struct route_node *route_node_match_ipv4 (const struct route_table *,
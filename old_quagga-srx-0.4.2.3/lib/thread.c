@@ -29,6 +29,25 @@
 #include "hash.h"
 #include "command.h"
 #include "sigevent.h"
+#include "pqueue.h"
+
+#ifdef THREAD_EPOLL
+#include <sys/epoll.h>
+
+/* Number of events fetched by one epoll_wait() call. */
+#define THREAD_EPOLL_EVENTS 256
+
+/* Read and write thread scheduled for one file descriptor. */
+struct thread_fd
+{
+  struct thread *read;
+  struct thread *write;
+  u_int32_t events;		/* events armed with epoll */
+  u_char registered;		/* fd is in the epoll set */
+  u_char suspended;		/* read polling stopped, see thread_suspend_read */
+  u_char always;		/* not pollable (regular file), always ready */
+};
+#endif /* THREAD_EPOLL */
 
 #if defined HAVE_SNMP && defined SNMP_AGENTX
 #include <net-snmp/net-snmp-config.h>
@@ -513,29 +532,74 @@ thread_master_debug (struct thread_master *m)
   thread_list_debug (&m->read);
   printf ("writelist : ");
   thread_list_debug (&m->write);
-  printf ("timerlist : ");
-  thread_list_debug (&m->timer);
+  printf ("timerqueue: %d\n", m->timer->size);
   printf ("eventlist : ");
   thread_list_debug (&m->event);
   printf ("unuselist : ");
   thread_list_debug (&m->unuse);
-  printf ("bgndlist : ");
-  thread_list_debug (&m->background);
+  printf ("bgndqueue : %d\n", m->background->size);
   printf ("total alloc: [%ld]\n", m->alloc);
   printf ("-----------\n");
 }
 
+static int
+thread_timer_cmp (void *a, void *b)
+{
+  struct thread *thread_a = a;
+  struct thread *thread_b = b;
+  long cmp;
+
+  cmp = timeval_cmp (thread_a->u.sands, thread_b->u.sands);
+
+  if (cmp < 0)
+    return -1;
+  if (cmp > 0)
+    return 1;
+  return 0;
+}
+
+static void
+thread_timer_update (void *node, int actual_position)
+{
+  struct thread *thread = node;
+
+  thread->index = actual_position;
+}
+
 /* Allocate new thread master.  */
 struct thread_master *
 thread_master_create ()
 {
+  struct thread_master *m;
+
   if (cpu_record == NULL) 
-    cpu_record 
-      = hash_create_size (1011, (unsigned int (*) (void *))cpu_record_hash_key, 
-                          (int (*) (const void *, const void *))cpu_record_hash_cmp);
+    {
+      cpu_record 
+        = hash_create_size (1011, (unsigned int (*) (void *))cpu_record_hash_key, 
+                            (int (*) (const void *, const void *))cpu_record_hash_cmp);
+      hash_set_name (cpu_record, "Thread CPU records");
+    }
     
-  return (struct thread_master *) XCALLOC (MTYPE_THREAD_MASTER,
-					   sizeof (struct thread_master));
+  m = XCALLOC (MTYPE_THREAD_MASTER, sizeof (struct thread_master));
+
+  m->timer = pqueue_create ();
+  m->timer->cmp = thread_timer_cmp;
+  m->timer->update = thread_timer_update;
+
+  m->background = pqueue_create ();
+  m->background->cmp = thread_timer_cmp;
+  m->background->update = thread_timer_update;
+
+#ifdef THREAD_EPOLL
+  m->epoll_fd = epoll_create (THREAD_EPOLL_EVENTS);
+  if (m->epoll_fd < 0)
+    zlog_warn ("epoll_create() failed, falling back to select(): %s",
+               safe_strerror (errno));
+  else
+    fcntl (m->epoll_fd, F_SETFD, FD_CLOEXEC);
+#endif /* THREAD_EPOLL */
+
+  return m;
 }
 
 /* Add a new thread to the list.  */
@@ -552,22 +616,6 @@ thread_list_add (struct thread_list *list, struct thread *thread)
   list->count++;
 }
 
-/* Add a new thread just before the point.  */
-static void
-thread_list_add_before (struct thread_list *list, 
-			struct thread *point, 
-			struct thread *thread)
-{
-  thread->next = point;
-  thread->prev = point->prev;
-  if (point->prev)
-    point->prev->next = thread;
-  else
-    list->head = thread;
-  point->prev = thread;
-  list->count++;
-}
-
 /* Delete a thread from the list. */
 static struct thread *
 thread_list_delete (struct thread_list *list, struct thread *thread)
@@ -613,17 +661,36 @@ thread_list_free (struct thread_master *m, struct thread_list *list)
     }
 }
 
+static void
+thread_queue_free (struct thread_master *m, struct pqueue *queue)
+{
+  int i;
+
+  for (i = 0; i < queue->size; i++)
+    XFREE (MTYPE_THREAD, queue->array[i]);
+
+  m->alloc -= queue->size;
+  pqueue_delete (queue);
+}
+
 /* Stop thread scheduler. */
 void
 thread_master_free (struct thread_master *m)
 {
   thread_list_free (m, &m->read);
   thread_list_free (m, &m->write);
-  thread_list_free (m, &m->timer);
+  thread_queue_free (m, m->timer);
   thread_list_free (m, &m->event);
   thread_list_free (m, &m->ready);
   thread_list_free (m, &m->unuse);
-  thread_list_free (m, &m->background);
+  thread_queue_free (m, m->background);
+
+#ifdef THREAD_EPOLL
+  if (m->epoll_fd >= 0)
+    close (m->epoll_fd);
+  if (m->fds)
+    XFREE (MTYPE_THREAD_POLL, m->fds);
+#endif /* THREAD_EPOLL */
   
   XFREE (MTYPE_THREAD_MASTER, m);
 
@@ -711,6 +778,201 @@ thread_get (struct thread_master *m, u_char type,
   return thread;
 }
 
+#ifdef THREAD_EPOLL
+/* Get the thread slot of the file descriptor, grow the table if needed. */
+static struct thread_fd *
+thread_fd_get (struct thread_master *m, int fd)
+{
+  if (fd >= m->fd_size)
+    {
+      int size = m->fd_size ? m->fd_size : 64;
+
+      while (size <= fd)
+        size *= 2;
+      m->fds = XREALLOC (MTYPE_THREAD_POLL, m->fds,
+                         size * sizeof (struct thread_fd));
+      memset (m->fds + m->fd_size, 0,
+              (size - m->fd_size) * sizeof (struct thread_fd));
+      m->fd_size = size;
+    }
+  return &m->fds[fd];
+}
+
+/* Arm the events of the threads scheduled for fd with epoll.  The fd is
+   registered one-shot: epoll disarms it once it reports an event, but
+   keeps the registration.  A read handler that schedules itself again then
+   costs one EPOLL_CTL_MOD instead of a DEL and an ADD. */
+static void
+thread_epoll_update (struct thread_master *m, int fd)
+{
+  struct thread_fd *tfd = &m->fds[fd];
+  struct epoll_event ev;
+  u_int32_t events = 0;
+  int op;
+
+  if (tfd->read && ! tfd->suspended)
+    events |= EPOLLIN;
+  if (tfd->write)
+    events |= EPOLLOUT;
+
+  if (tfd->always)
+    {
+      tfd->events = events;
+      if (events == 0)
+        {
+          tfd->always = 0;
+          m->fd_always--;
+        }
+      return;
+    }
+
+  if (events == tfd->events)
+    return;
+
+  memset (&ev, 0, sizeof (struct epoll_event));
+  ev.events = events | EPOLLONESHOT;
+  ev.data.fd = fd;
+
+  if (events == 0)
+    op = EPOLL_CTL_DEL;
+  else
+    op = tfd->registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+
+  if (epoll_ctl (m->epoll_fd, op, fd, &ev) < 0)
+    {
+      /* The descriptor was closed while it was registered, and possibly
+         reused.  The kernel has dropped the old registration already. */
+      if (op == EPOLL_CTL_MOD && errno == ENOENT)
+        op = EPOLL_CTL_ADD;
+      else if (op == EPOLL_CTL_ADD && errno == EEXIST)
+        op = EPOLL_CTL_MOD;
+
+      if (op != EPOLL_CTL_DEL && epoll_ctl (m->epoll_fd, op, fd, &ev) < 0)
+        {
+          /* Regular files can not be polled, select() reports them
+             ready at all times. */
+          if (errno == EPERM)
+            {
+              tfd->always = 1;
+              m->fd_always++;
+            }
+          else
+            zlog_warn ("epoll_ctl() failed for fd %d: %s",
+                       fd, safe_strerror (errno));
+          tfd->registered = 0;
+          tfd->events = events;
+          return;
+        }
+    }
+  tfd->registered = (op != EPOLL_CTL_DEL);
+  tfd->events = events;
+}
+
+/* Move the thread of a ready file descriptor to the ready list. */
+static void
+thread_fd_ready (struct thread_list *list, struct thread *thread)
+{
+  thread_list_delete (list, thread);
+  thread_list_add (&thread->master->ready, thread);
+  thread->type = THREAD_READY;
+}
+
+/* Add the read and write threads of the file descriptors returned by
+   epoll_wait() to the ready list, read threads first. */
+static void
+thread_epoll_process (struct thread_master *m, struct epoll_event *events,
+                      int num)
+{
+  struct thread_fd *tfd;
+  int i, fd;
+
+  for (i = 0; i < num; i++)
+    {
+      fd = events[i].data.fd;
+      tfd = &m->fds[fd];
+      if (tfd->read && ! tfd->suspended
+          && (events[i].events & (EPOLLIN | EPOLLPRI | EPOLLERR | EPOLLHUP)))
+        {
+          thread_fd_ready (&m->read, tfd->read);
+          tfd->read = NULL;
+        }
+    }
+
+  for (i = 0; i < num; i++)
+    {
+      fd = events[i].data.fd;
+      tfd = &m->fds[fd];
+      if (tfd->write
+          && (events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP)))
+        {
+          thread_fd_ready (&m->write, tfd->write);
+          tfd->write = NULL;
+        }
+      /* epoll disarmed the fd.  It stays registered if no thread is left,
+         the handler most likely schedules the next read. */
+      tfd->events = 0;
+      if (tfd->read || tfd->write)
+        thread_epoll_update (m, fd);
+    }
+
+  if (m->fd_always)
+    for (fd = 0; fd < m->fd_size; fd++)
+      {
+        tfd = &m->fds[fd];
+        if (! tfd->always)
+          continue;
+        if (tfd->read && ! tfd->suspended)
+          {
+            thread_fd_ready (&m->read, tfd->read);
+            tfd->read = NULL;
+          }
+        if (tfd->write)
+          {
+            thread_fd_ready (&m->write, tfd->write);
+            tfd->write = NULL;
+          }
+        thread_epoll_update (m, fd);
+      }
+}
+
+/* Add a read or write thread for fd to the epoll backend. */
+static struct thread *
+thread_epoll_add (struct thread_master *m, u_char type,
+                  int (*func) (struct thread *), void *arg, int fd,
+                  const char *funcname)
+{
+  struct thread_fd *tfd;
+  struct thread **slot;
+  struct thread *thread;
+
+  if (fd < 0)
+    {
+      zlog (NULL, LOG_WARNING, "Invalid fd [%d]", fd);
+      return NULL;
+    }
+
+  tfd = thread_fd_get (m, fd);
+  slot = (type == THREAD_READ) ? &tfd->read : &tfd->write;
+  if (*slot)
+    {
+      zlog (NULL, LOG_WARNING, "There is already %s fd [%d]",
+            (type == THREAD_READ) ? "read" : "write", fd);
+      return NULL;
+    }
+
+  thread = thread_get (m, type, func, arg, funcname);
+  thread->u.fd = fd;
+  *slot = thread;
+  if (type == THREAD_READ)
+    tfd->suspended = 0;
+  thread_epoll_update (m, fd);
+
+  thread_list_add ((type == THREAD_READ) ? &m->read : &m->write, thread);
+
+  return thread;
+}
+#endif /* THREAD_EPOLL */
+
 /* Add new read thread. */
 struct thread *
 funcname_thread_add_read (struct thread_master *m, 
@@ -720,6 +982,11 @@ funcname_thread_add_read (struct thread_master *m,
 
   assert (m != NULL);
 
+#ifdef THREAD_EPOLL
+  if (m->epoll_fd >= 0)
+    return thread_epoll_add (m, THREAD_READ, func, arg, fd, funcname);
+#endif /* THREAD_EPOLL */
+
   if (FD_ISSET (fd, &m->readfd))
     {
       zlog (NULL, LOG_WARNING, "There is already read fd [%d]", fd);
@@ -743,6 +1010,11 @@ funcname_thread_add_write (struct thread_master *m,
 
   assert (m != NULL);
 
+#ifdef THREAD_EPOLL
+  if (m->epoll_fd >= 0)
+    return thread_epoll_add (m, THREAD_WRITE, func, arg, fd, funcname);
+#endif /* THREAD_EPOLL */
+
   if (FD_ISSET (fd, &m->writefd))
     {
       zlog (NULL, LOG_WARNING, "There is already write fd [%d]", fd);
@@ -766,16 +1038,15 @@ funcname_thread_add_timer_timeval (struct thread_master *m,
                                   const char* funcname)
 {
   struct thread *thread;
-  struct thread_list *list;
+  struct pqueue *queue;
   struct timeval alarm_time;
-  struct thread *tt;
 
   assert (m != NULL);
 
   assert (type == THREAD_TIMER || type == THREAD_BACKGROUND);
   assert (time_relative);
   
-  list = ((type == THREAD_TIMER) ? &m->timer : &m->background);
+  queue = ((type == THREAD_TIMER) ? m->timer : m->background);
   thread = thread_get (m, type, func, arg, funcname);
 
   /* Do we need jitter here? */
@@ -784,15 +1055,7 @@ funcname_thread_add_timer_timeval (struct thread_master *m,
   alarm_time.tv_usec = relative_time.tv_usec + time_relative->tv_usec;
   thread->u.sands = timeval_adjust(alarm_time);
 
-  /* Sort by timeval. */
-  for (tt = list->head; tt; tt = tt->next)
-    if (timeval_cmp (thread->u.sands, tt->u.sands) <= 0)
-      break;
-
-  if (tt)
-    thread_list_add_before (list, tt, thread);
-  else
-    thread_list_add (list, thread);
+  pqueue_enqueue (thread, queue);
 
   return thread;
 }
@@ -878,39 +1141,102 @@ funcname_thread_add_event (struct thread_master *m,
 void
 thread_cancel (struct thread *thread)
 {
-  struct thread_list *list;
+  struct thread_list *list = NULL;
+  struct pqueue *queue = NULL;
+  struct thread_master *m = thread->master;
   
   switch (thread->type)
     {
     case THREAD_READ:
-      assert (FD_ISSET (thread->u.fd, &thread->master->readfd));
-      FD_CLR (thread->u.fd, &thread->master->readfd);
-      list = &thread->master->read;
+#ifdef THREAD_EPOLL
+      if (m->epoll_fd >= 0)
+        {
+          struct thread_fd *tfd = &m->fds[thread->u.fd];
+
+          assert (tfd->read == thread);
+          tfd->read = NULL;
+          tfd->suspended = 0;
+          thread_epoll_update (m, thread->u.fd);
+        }
+      else
+#endif /* THREAD_EPOLL */
+      /* The descriptor is not set if thread_suspend_read() was used. */
+      FD_CLR (thread->u.fd, &m->readfd);
+      list = &m->read;
       break;
     case THREAD_WRITE:
-      assert (FD_ISSET (thread->u.fd, &thread->master->writefd));
-      FD_CLR (thread->u.fd, &thread->master->writefd);
-      list = &thread->master->write;
+#ifdef THREAD_EPOLL
+      if (m->epoll_fd >= 0)
+        {
+          struct thread_fd *tfd = &m->fds[thread->u.fd];
+
+          assert (tfd->write == thread);
+          tfd->write = NULL;
+          thread_epoll_update (m, thread->u.fd);
+        }
+      else
+#endif /* THREAD_EPOLL */
+      {
+        assert (FD_ISSET (thread->u.fd, &m->writefd));
+        FD_CLR (thread->u.fd, &m->writefd);
+      }
+      list = &m->write;
       break;
     case THREAD_TIMER:
-      list = &thread->master->timer;
+      queue = m->timer;
       break;
     case THREAD_EVENT:
-      list = &thread->master->event;
+      list = &m->event;
       break;
     case THREAD_READY:
-      list = &thread->master->ready;
+      list = &m->ready;
       break;
     case THREAD_BACKGROUND:
-      list = &thread->master->background;
+      queue = m->background;
       break;
     default:
       return;
       break;
     }
-  thread_list_delete (list, thread);
+
+  if (queue)
+    {
+      assert (thread->index >= 0 && thread->index < queue->size);
+      assert (thread == queue->array[thread->index]);
+      pqueue_remove_at (thread->index, queue);
+    }
+  else
+    thread_list_delete (list, thread);
+
   thread->type = THREAD_UNUSED;
-  thread_add_unuse (thread->master, thread);
+  thread_add_unuse (m, thread);
+}
+
+/* Stop polling fd for read readiness.  The read thread stays scheduled
+   until it is cancelled or added again.  Returns 1 if fd was polled. */
+int
+thread_suspend_read (struct thread_master *m, int fd)
+{
+#ifdef THREAD_EPOLL
+  if (m->epoll_fd >= 0)
+    {
+      struct thread_fd *tfd;
+
+      if (fd < 0 || fd >= m->fd_size)
+        return 0;
+      tfd = &m->fds[fd];
+      if (tfd->read == NULL || tfd->suspended)
+        return 0;
+      tfd->suspended = 1;
+      thread_epoll_update (m, fd);
+      return 1;
+    }
+#endif /* THREAD_EPOLL */
+
+  if (! FD_ISSET (fd, &m->readfd))
+    return 0;
+  FD_CLR (fd, &m->readfd);
+  return 1;
 }
 
 /* Delete all events which has argument value arg. */
@@ -958,11 +1284,12 @@ thread_cancel_event (struct thread_master *m, void *arg)
 }
 
 static struct timeval *
-thread_timer_wait (struct thread_list *tlist, struct timeval *timer_val)
+thread_timer_wait (struct pqueue *queue, struct timeval *timer_val)
 {
-  if (!thread_empty (tlist))
+  if (queue->size)
     {
-      *timer_val = timeval_subtract (tlist->head->u.sands, relative_time);
+      struct thread *next_timer = queue->array[0];
+      *timer_val = timeval_subtract (next_timer->u.sands, relative_time);
       return timer_val;
     }
   return NULL;
@@ -1006,18 +1333,17 @@ thread_process_fd (struct thread_list *list, fd_set *fdset, fd_set *mfdset)
 
 /* Add all timers that have popped to the ready list. */
 static unsigned int
-thread_timer_process (struct thread_list *list, struct timeval *timenow)
+thread_timer_process (struct pqueue *queue, struct timeval *timenow)
 {
   struct thread *thread;
-  struct thread *next;
   unsigned int ready = 0;
   
-  for (thread = list->head; thread; thread = next)
+  while (queue->size)
     {
-      next = thread->next;
+      thread = queue->array[0];
       if (timeval_cmp (*timenow, thread->u.sands) < 0)
         return ready;
-      thread_list_delete (list, thread);
+      pqueue_dequeue (queue);
       thread->type = THREAD_READY;
       thread_list_add (&thread->master->ready, thread);
       ready++;
@@ -1057,6 +1383,9 @@ thread_fetch (struct thread_master *m, struct thread *fetch)
   struct timeval timer_val_bg;
   struct timeval *timer_wait = &timer_val;
   struct timeval *timer_wait_bg;
+#ifdef THREAD_EPOLL
+  struct epoll_event events[THREAD_EPOLL_EVENTS];
+#endif /* THREAD_EPOLL */
 
   while (1)
     {
@@ -1093,8 +1422,8 @@ thread_fetch (struct thread_master *m, struct thread *fetch)
       if (m->ready.count == 0)
         {
           quagga_get_relative (NULL);
-          timer_wait = thread_timer_wait (&m->timer, &timer_val);
-          timer_wait_bg = thread_timer_wait (&m->background, &timer_val_bg);
+          timer_wait = thread_timer_wait (m->timer, &timer_val);
+          timer_wait_bg = thread_timer_wait (m->background, &timer_val_bg);
           
           if (timer_wait_bg &&
               (!timer_wait || (timeval_cmp (*timer_wait, *timer_wait_bg) > 0)))
@@ -1121,6 +1450,21 @@ thread_fetch (struct thread_master *m, struct thread *fetch)
             timer_wait = &snmp_timer_wait;
         }
 #endif
+#ifdef THREAD_EPOLL
+      if (m->epoll_fd >= 0)
+        {
+          int timeout = -1;
+
+          if (m->fd_always)
+            timeout = 0;
+          else if (timer_wait)
+            /* round up, do not wake up just before the timer expires */
+            timeout = timer_wait->tv_sec * 1000
+                      + (timer_wait->tv_usec + 999) / 1000;
+          num = epoll_wait (m->epoll_fd, events, THREAD_EPOLL_EVENTS, timeout);
+        }
+      else
+#endif /* THREAD_EPOLL */
       num = select (FD_SETSIZE, &readfd, &writefd, &exceptfd, timer_wait);
       
       /* Signals should get quick treatment */
@@ -1128,7 +1472,11 @@ thread_fetch (struct thread_master *m, struct thread *fetch)
         {
           if (errno == EINTR)
             continue; /* signal received - process it */
-          zlog_warn ("select() error: %s", safe_strerror (errno));
+          zlog_warn ("%s() error: %s",
+#ifdef THREAD_EPOLL
+                 m->epoll_fd >= 0 ? "epoll_wait" :
+#endif /* THREAD_EPOLL */
+                 "select", safe_strerror (errno));
             return NULL;
         }
 
@@ -1150,8 +1498,16 @@ thread_fetch (struct thread_master *m, struct thread *fetch)
          priority than I/O threads, so let's push them onto the ready
 	 list in front of the I/O threads. */
       quagga_get_relative (NULL);
-      thread_timer_process (&m->timer, &relative_time);
+      thread_timer_process (m->timer, &relative_time);
       
+#ifdef THREAD_EPOLL
+      if (m->epoll_fd >= 0)
+        {
+          if (num > 0 || m->fd_always)
+            thread_epoll_process (m, events, num);
+        }
+      else
+#endif /* THREAD_EPOLL */
       /* Got IO, process it */
       if (num > 0)
         {
@@ -1171,7 +1527,7 @@ thread_fetch (struct thread_master *m, struct thread *fetch)
 #endif
 
       /* Background timer/events, lowest priority */
-      thread_timer_process (&m->background, &relative_time);
+      thread_timer_process (m->background, &relative_time);
       
       if ((thread = thread_trim_head (&m->ready)) != NULL)
         return thread_run (m, thread, fetch);
@@ -36,6 +36,12 @@ struct rusage_t
 
 #define GETRUSAGE(X) thread_getrusage(X)
 
+/* File descriptor readiness is polled with epoll where available.  The
+ * AgentX integration hands fd_sets to net-snmp and keeps using select(). */
+#if defined (GNU_LINUX) && !(defined HAVE_SNMP && defined SNMP_AGENTX)
+#define THREAD_EPOLL
+#endif
+
 /* Linked list of thread. */
 struct thread_list
 {
@@ -49,14 +55,20 @@ struct thread_master
 {
   struct thread_list read;
   struct thread_list write;
-  struct thread_list timer;
+  struct pqueue *timer;
   struct thread_list event;
   struct thread_list ready;
   struct thread_list unuse;
-  struct thread_list background;
+  struct pqueue *background;
   fd_set readfd;
   fd_set writefd;
   fd_set exceptfd;
+#ifdef THREAD_EPOLL
+  int epoll_fd;			/* -1 if select() is used */
+  struct thread_fd *fds;	/* read/write threads by file descriptor */
+  int fd_size;
+  int fd_always;		/* descriptors epoll can not poll */
+#endif /* THREAD_EPOLL */
   unsigned long alloc;
 };
 
@@ -81,6 +93,7 @@ struct thread
     struct timeval sands;	/* rest of time sands value. */
   } u;
   struct timeval real;
+  int index;			/* position in the timer queue */
   struct cpu_thread_history *hist; /* cache pointer to cpu_history */
   char funcname[FUNCNAME_LEN];
 };
@@ -201,6 +214,7 @@ extern struct thread *funcname_thread_execute (struct thread_master *,
                                                void *, int, const char *);
 extern void thread_cancel (struct thread *);
 extern unsigned int thread_cancel_event (struct thread_master *, void *);
+extern int thread_suspend_read (struct thread_master *, int);
 extern struct thread *thread_fetch (struct thread_master *, struct thread *);
 extern void thread_call (struct thread *);
 extern unsigned long thread_timer_remain_second (struct thread *);
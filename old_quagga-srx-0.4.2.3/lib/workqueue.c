@@ -243,6 +243,7 @@ work_queue_run (struct thread *thread)
   unsigned int cycles = 0;
   struct listnode *node, *nnode;
   char yielded = 0;
+  char blocked = 0;
 
   wq = THREAD_ARG (thread);
   wq->thread = NULL;
@@ -300,6 +301,7 @@ work_queue_run (struct thread *thread)
            * specific error, and fall through to WQ_RETRY_LATER
            */
           item->ran--;
+          blocked = 1;
         }
       case WQ_RETRY_LATER:
 	{
@@ -372,9 +374,10 @@ stats:
             __func__, cycles, wq->cycles.best, wq->cycles.granularity);
 #endif
   
-  /* Is the queue done yet? If it is, call the completion callback. */
+  /* Is the queue done yet? If it is, call the completion callback.
+   * A blocked queue is looked at again after the hold time. */
   if (listcount (wq->items) > 0)
-    work_queue_schedule (wq, 0);
+    work_queue_schedule (wq, blocked ? wq->spec.hold : 0);
   else if (wq->spec.completion_func)
     wq->spec.completion_func (wq);
   
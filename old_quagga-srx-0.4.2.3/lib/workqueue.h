@@ -37,7 +37,8 @@ typedef enum
   WQ_REQUEUE,		/* requeue item, continue processing work queue */
   WQ_QUEUE_BLOCKED,	/* Queue cant be processed at this time.
                          * Similar to WQ_RETRY_LATER, but doesn't penalise
-                         * the particular item.. */
+                         * the particular item, the queue is run again
+                         * after spec.hold. */
 } wq_item_status;
 
 /* A single work queue item, unsurprisingly */
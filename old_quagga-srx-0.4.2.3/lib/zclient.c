@@ -55,6 +55,7 @@ zclient_new ()
 
   zclient->ibuf = stream_new (ZEBRA_MAX_PACKET_SIZ);
   zclient->obuf = stream_new (ZEBRA_MAX_PACKET_SIZ);
+  zclient->batch = stream_new (ZEBRA_MAX_PACKET_SIZ);
   zclient->wb = buffer_new(0);
 
   return zclient;
@@ -72,6 +73,8 @@ zclient_free (struct zclient *zclient)
     stream_free(zclient->ibuf);
   if (zclient->obuf)
     stream_free(zclient->obuf);
+  if (zclient->batch)
+    stream_free(zclient->batch);
   if (zclient->wb)
     buffer_free(zclient->wb);
 
@@ -121,10 +124,16 @@ zclient_stop (struct zclient *zclient)
   THREAD_OFF(zclient->t_read);
   THREAD_OFF(zclient->t_connect);
   THREAD_OFF(zclient->t_write);
+  THREAD_OFF(zclient->t_batch);
 
   /* Reset streams. */
   stream_reset(zclient->ibuf);
   stream_reset(zclient->obuf);
+  stream_reset(zclient->batch);
+  zclient->batch_count = 0;
+
+  /* Capabilities are negotiated again on the next connection. */
+  zclient->capabilities = 0;
 
   /* Empty the write buffer. */
   buffer_reset(zclient->wb);
@@ -268,13 +277,13 @@ zclient_flush_data(struct thread *thread)
   return 0;
 }
 
-int
-zclient_send_message(struct zclient *zclient)
+static int
+zclient_write (struct zclient *zclient, struct stream *s)
 {
   if (zclient->sock < 0)
     return -1;
-  switch (buffer_write(zclient->wb, zclient->sock, STREAM_DATA(zclient->obuf),
-		       stream_get_endp(zclient->obuf)))
+  switch (buffer_write(zclient->wb, zclient->sock, STREAM_DATA(s),
+		       stream_get_endp(s)))
     {
     case BUFFER_ERROR:
       zlog_warn("%s: buffer_write failed to zclient fd %d, closing",
@@ -292,6 +301,43 @@ zclient_send_message(struct zclient *zclient)
   return 0;
 }
 
+int
+zclient_batch_flush (struct zclient *zclient)
+{
+  struct stream *s = zclient->batch;
+  int ret;
+
+  THREAD_OFF(zclient->t_batch);
+  if (!zclient->batch_count)
+    return 0;
+
+  stream_putw_at (s, ZEBRA_HEADER_SIZE, zclient->batch_count);
+  stream_putw_at (s, 0, stream_get_endp (s));
+  zclient->batch_count = 0;
+
+  ret = zclient_write (zclient, s);
+  stream_reset (s);
+  return ret;
+}
+
+static int
+zclient_batch_event (struct thread *thread)
+{
+  struct zclient *zclient = THREAD_ARG (thread);
+
+  zclient->t_batch = NULL;
+  return zclient_batch_flush (zclient);
+}
+
+int
+zclient_send_message(struct zclient *zclient)
+{
+  /* Keep the order of messages, the batched routes go first. */
+  if (zclient->batch_count && zclient_batch_flush (zclient) < 0)
+    return -1;
+  return zclient_write (zclient, zclient->obuf);
+}
+
 void
 zclient_create_header (struct stream *s, uint16_t command)
 {
@@ -330,6 +376,8 @@ zebra_hello_send (struct zclient *zclient)
 
       zclient_create_header (s, ZEBRA_HELLO);
       stream_putc (s, zclient->redist_default);
+      /* Older zebra daemons ignore the offer and never confirm it. */
+      stream_putl (s, ZCLIENT_CAPABILITIES);
       stream_putw_at (s, 0, stream_get_endp (s));
       return zclient_send_message(zclient);
     }
@@ -414,6 +462,122 @@ zclient_connect (struct thread *t)
   return zclient_start (zclient);
 }
 
+static void
+zapi_ipv4_put_nexthops (struct stream *s, struct zapi_ipv4 *api)
+{
+  int i;
+
+  if (CHECK_FLAG (api->flags, ZEBRA_FLAG_BLACKHOLE))
+    {
+      stream_putc (s, 1);
+      stream_putc (s, ZEBRA_NEXTHOP_BLACKHOLE);
+      /* XXX assert(api->nexthop_num == 0); */
+      /* XXX assert(api->ifindex_num == 0); */
+    }
+  else
+    stream_putc (s, api->nexthop_num + api->ifindex_num);
+
+  for (i = 0; i < api->nexthop_num; i++)
+    {
+      stream_putc (s, ZEBRA_NEXTHOP_IPV4);
+      stream_put_in_addr (s, api->nexthop[i]);
+    }
+  for (i = 0; i < api->ifindex_num; i++)
+    {
+      stream_putc (s, ZEBRA_NEXTHOP_IFINDEX);
+      stream_putl (s, api->ifindex[i]);
+    }
+}
+
+/*
+ * Batched form of zapi_ipv4_route(), used once zebra confirmed
+ * ZCLIENT_CAP_ROUTE_BATCH. Consecutive routes with the same type, flags,
+ * message, SAFI, nexthops and distance are collected in zclient->batch
+ * and sent as one message when the attributes change, the message is
+ * full, another message is sent or the current thread returns.
+ *
+ *  0 1 2 3 4 5 6 7 8 9 A B C D E F 0 1 2 3 4 5 6 7 8 9 A B C D E F
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |            Length (2)         |    Marker     |    Version    |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |          Command (2)          |        Route count (2)        |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * | Route Type    | ZEBRA Flags   | Message Flags |   SAFI (2)    |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |               | Nexthop count | Nexthops as in ROUTE_ADD ...  |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * | Distance (if ZAPI_MESSAGE_DISTANCE)                           |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *
+ * followed by Route count times:
+ *
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * | Prefix length | Destination IPv4 Prefix for route             |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * | Metric (if ZAPI_MESSAGE_METRIC)                               |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ */
+static int
+zapi_ipv4_route_batch (u_char cmd, struct zclient *zclient,
+                       struct prefix_ipv4 *p, struct zapi_ipv4 *api)
+{
+  struct stream *s, *b;
+  size_t attrlen, routelen;
+  int psize;
+
+  /* Encode the shared part into obuf to compare it with the batch. */
+  s = zclient->obuf;
+  stream_reset (s);
+
+  zclient_create_header (s, cmd == ZEBRA_IPV4_ROUTE_ADD
+                            ? ZEBRA_IPV4_ROUTE_BATCH_ADD
+                            : ZEBRA_IPV4_ROUTE_BATCH_DELETE);
+  stream_putw (s, 0);
+  stream_putc (s, api->type);
+  stream_putc (s, api->flags);
+  stream_putc (s, api->message);
+  stream_putw (s, api->safi);
+  if (CHECK_FLAG (api->message, ZAPI_MESSAGE_NEXTHOP))
+    zapi_ipv4_put_nexthops (s, api);
+  if (CHECK_FLAG (api->message, ZAPI_MESSAGE_DISTANCE))
+    stream_putc (s, api->distance);
+  attrlen = stream_get_endp (s);
+
+  psize = PSIZE (p->prefixlen);
+  routelen = 1 + psize;
+  if (CHECK_FLAG (api->message, ZAPI_MESSAGE_METRIC))
+    routelen += 4;
+
+  /* The attribute block describes its own length, equal bytes up to
+   * its end mean equal attributes. */
+  b = zclient->batch;
+  if (zclient->batch_count
+      && (zclient->batch_count == UINT16_MAX
+          || stream_get_endp (b) + routelen > STREAM_SIZE (b)
+          || memcmp (STREAM_DATA (b) + 4, STREAM_DATA (s) + 4, 2)
+          || memcmp (STREAM_DATA (b) + ZEBRA_HEADER_SIZE + 2,
+                     STREAM_DATA (s) + ZEBRA_HEADER_SIZE + 2,
+                     attrlen - ZEBRA_HEADER_SIZE - 2)))
+    if (zclient_batch_flush (zclient) < 0)
+      return -1;
+
+  if (!zclient->batch_count)
+    {
+      stream_reset (b);
+      stream_write (b, STREAM_DATA (s), attrlen);
+      if (!zclient->t_batch)
+        zclient->t_batch = thread_add_event (master, zclient_batch_event,
+                                             zclient, 0);
+    }
+
+  stream_putc (b, p->prefixlen);
+  stream_write (b, (u_char *) & p->prefix, psize);
+  if (CHECK_FLAG (api->message, ZAPI_MESSAGE_METRIC))
+    stream_putl (b, api->metric);
+  zclient->batch_count++;
+  return 0;
+}
+
  /* 
   * "xdr_encode"-like interface that allows daemon (client) to send
   * a message to zebra server for a route that needs to be
@@ -462,10 +626,13 @@ int
 zapi_ipv4_route (u_char cmd, struct zclient *zclient, struct prefix_ipv4 *p,
                  struct zapi_ipv4 *api)
 {
-  int i;
   int psize;
   struct stream *s;
 
+  if (CHECK_FLAG (zclient->capabilities, ZCLIENT_CAP_ROUTE_BATCH)
+      && (cmd == ZEBRA_IPV4_ROUTE_ADD || cmd == ZEBRA_IPV4_ROUTE_DELETE))
+    return zapi_ipv4_route_batch (cmd, zclient, p, api);
+
   /* Reset stream. */
   s = zclient->obuf;
   stream_reset (s);
@@ -485,28 +652,7 @@ zapi_ipv4_route (u_char cmd, struct zclient *zclient, struct prefix_ipv4 *p,
 
   /* Nexthop, ifindex, distance and metric information. */
   if (CHECK_FLAG (api->message, ZAPI_MESSAGE_NEXTHOP))
-    {
-      if (CHECK_FLAG (api->flags, ZEBRA_FLAG_BLACKHOLE))
-        {
-          stream_putc (s, 1);
-          stream_putc (s, ZEBRA_NEXTHOP_BLACKHOLE);
-          /* XXX assert(api->nexthop_num == 0); */
-          /* XXX assert(api->ifindex_num == 0); */
-        }
-      else
-        stream_putc (s, api->nexthop_num + api->ifindex_num);
-
-      for (i = 0; i < api->nexthop_num; i++)
-        {
-          stream_putc (s, ZEBRA_NEXTHOP_IPV4);
-          stream_put_in_addr (s, api->nexthop[i]);
-        }
-      for (i = 0; i < api->ifindex_num; i++)
-        {
-          stream_putc (s, ZEBRA_NEXTHOP_IFINDEX);
-          stream_putl (s, api->ifindex[i]);
-        }
-    }
+    zapi_ipv4_put_nexthops (s, api);
 
   if (CHECK_FLAG (api->message, ZAPI_MESSAGE_DISTANCE))
     stream_putc (s, api->distance);
@@ -957,6 +1103,12 @@ zclient_read (struct thread *thread)
       if (zclient->ipv6_route_delete)
 	(*zclient->ipv6_route_delete) (command, zclient, length);
       break;
+    case ZEBRA_CAPABILITIES:
+      zclient->capabilities = stream_getl (zclient->ibuf)
+                              & ZCLIENT_CAPABILITIES;
+      if (zclient_debug)
+        zlog_debug ("zclient capabilities 0x%x", zclient->capabilities);
+      break;
     default:
       break;
     }
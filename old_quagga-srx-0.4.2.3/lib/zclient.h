@@ -63,6 +63,14 @@ struct zclient
   /* Thread to write buffered data to zebra. */
   struct thread *t_write;
 
+  /* Capabilities agreed on with zebra, ZCLIENT_CAP_*. */
+  u_int32_t capabilities;
+
+  /* Route message being batched, its route count and flush event. */
+  struct stream *batch;
+  u_int16_t batch_count;
+  struct thread *t_batch;
+
   /* Redistribute information. */
   u_char redist_default;
   u_char redist[ZEBRA_ROUTE_MAX];
@@ -90,6 +98,13 @@ struct zclient
 #define ZAPI_MESSAGE_DISTANCE 0x04
 #define ZAPI_MESSAGE_METRIC   0x08
 
+/* Capabilities offered in ZEBRA_HELLO and confirmed by ZEBRA_CAPABILITIES.
+ *
+ * ZCLIENT_CAP_ROUTE_BATCH: IPv4 routes sharing type, flags, nexthops and
+ * distance go in one ZEBRA_IPV4_ROUTE_BATCH_ADD/DELETE message. */
+#define ZCLIENT_CAP_ROUTE_BATCH  0x00000001
+#define ZCLIENT_CAPABILITIES     (ZCLIENT_CAP_ROUTE_BATCH)
+
 /* Zserv protocol message header */
 struct zserv_header
 {
@@ -148,6 +163,9 @@ extern void zclient_redistribute_default (int command, struct zclient *);
    Returns 0 for success or -1 on an I/O error. */
 extern int zclient_send_message(struct zclient *);
 
+/* Send out the pending route batch, if any. */
+extern int zclient_batch_flush (struct zclient *);
+
 /* create header for command, length to be filled in by user later */
 extern void zclient_create_header (struct stream *, uint16_t);
 
@@ -263,7 +263,7 @@ ospf_asbr_status_update (struct ospf *ospf, u_char status)
     }
 
   /* Transition from/to status ASBR, schedule timer. */
-  ospf_spf_calculate_schedule (ospf);
+  ospf_spf_calculate_schedule (ospf, OSPF_SPF_FLAG_ASBR_STATUS_CHANGE);
   ospf_router_lsa_update (ospf);
 }
 
@@ -325,6 +325,9 @@ ospf_if_free (struct ospf_interface *oi)
   
   ospf_delete_from_if (oi->ifp, oi);
 
+  /* The nexthops of the area's shortest-path tree may use the interface */
+  ospf_spf_tree_free (oi->area);
+
   listnode_delete (oi->ospf->oiflist, oi);
   listnode_delete (oi->area->oiflist, oi);
 
@@ -2374,7 +2374,7 @@ ospf_external_lsa_refresh (struct ospf *ospf, struct ospf_lsa *lsa,
 /* Install router-LSA to an area. */
 static struct ospf_lsa *
 ospf_router_lsa_install (struct ospf *ospf, struct ospf_lsa *new,
-                         int rt_recalc)
+                         u_int32_t spf_reason)
 {
   struct ospf_area *area = new->area;
 
@@ -2399,8 +2399,8 @@ ospf_router_lsa_install (struct ospf *ospf, struct ospf_lsa *new,
 
       ospf_refresher_register_lsa (ospf, new);
     }
-  if (rt_recalc)
-    ospf_spf_calculate_schedule (ospf);
+  if (spf_reason)
+    ospf_spf_calculate_schedule (ospf, spf_reason);
 
   return new;
 }
@@ -2435,7 +2435,7 @@ ospf_network_lsa_install (struct ospf *ospf,
       ospf_refresher_register_lsa (ospf, new);
     }
   if (rt_recalc)
-    ospf_spf_calculate_schedule (ospf);
+    ospf_spf_calculate_schedule (ospf, OSPF_SPF_FLAG_NETWORK_LSA_INSTALL);
 
   return new;
 }
@@ -2458,7 +2458,7 @@ ospf_summary_lsa_install (struct ospf *ospf, struct ospf_lsa *new,
       /* This doesn't exist yet... */
       ospf_summary_incremental_update(new); */
 #else /* #if 0 */
-      ospf_spf_calculate_schedule (ospf);
+      ospf_spf_calculate_schedule (ospf, OSPF_SPF_FLAG_SUMMARY_LSA_INSTALL);
 #endif /* #if 0 */
  
       if (IS_DEBUG_OSPF (lsa, LSA_INSTALL))
@@ -2491,7 +2491,8 @@ ospf_summary_asbr_lsa_install (struct ospf *ospf, struct ospf_lsa *new,
 	 - RFC 2328 Section 16.5 implies it should be */
       /* ospf_ase_calculate_schedule(); */
 #else  /* #if 0 */
-      ospf_spf_calculate_schedule (ospf);
+      ospf_spf_calculate_schedule (ospf,
+                                   OSPF_SPF_FLAG_ASBR_SUMMARY_LSA_INSTALL);
 #endif /* #if 0 */
     }
 
@@ -2602,6 +2603,7 @@ ospf_lsa_install (struct ospf *ospf, struct ospf_interface *oi,
   struct ospf_lsa *old = NULL;
   struct ospf_lsdb *lsdb = NULL;
   int rt_recalc;
+  u_int32_t spf_reason = 0;
 
   /* Set LSDB. */
   switch (lsa->data->type)
@@ -2657,6 +2659,13 @@ ospf_lsa_install (struct ospf *ospf, struct ospf_interface *oi,
   if (  old == NULL || ospf_lsa_different(old, lsa))
     rt_recalc = 1;
 
+  /* A router-LSA may change only in ways which leave the shortest-path
+     tree as it is, in which case the routes can be recalculated from the
+     tree kept from the last SPF run. This needs the old LSA, so decide
+     it now. */
+  if (rt_recalc && lsa->data->type == OSPF_ROUTER_LSA)
+    spf_reason = ospf_spf_router_lsa_reason (lsa->area, old, lsa);
+
   /*
      Sequence number check (Section 14.1 of rfc 2328)
      "Premature aging is used when it is time for a self-originated
@@ -2713,7 +2722,7 @@ ospf_lsa_install (struct ospf *ospf, struct ospf_interface *oi,
   switch (lsa->data->type)
     {
     case OSPF_ROUTER_LSA:
-      new = ospf_router_lsa_install (ospf, lsa, rt_recalc);
+      new = ospf_router_lsa_install (ospf, lsa, spf_reason);
       break;
     case OSPF_NETWORK_LSA:
       assert (oi);
@@ -2998,7 +3007,7 @@ ospf_lsa_maxage_walker_remover (struct ospf *ospf, struct ospf_lsa *lsa)
 	    ospf_ase_incremental_update (ospf, lsa);
             break;
           default:
-	    ospf_spf_calculate_schedule (ospf);
+	    ospf_spf_calculate_schedule (ospf, OSPF_SPF_FLAG_MAXAGE);
             break;
           }
 	ospf_lsa_maxage (ospf, lsa);
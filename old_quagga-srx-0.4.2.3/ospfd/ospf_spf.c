@@ -23,6 +23,7 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "thread.h"
 #include "memory.h"
 #include "hash.h"
+#include "jhash.h"
 #include "linklist.h"
 #include "prefix.h"
 #include "if.h"
@@ -47,11 +48,11 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "ospfd/ospf_dump.h"
 
 static void ospf_vertex_free (void *);
-/* List of allocated vertices, to simplify cleanup of SPF.
- * Not thread-safe obviously. If it ever needs to be, it'd have to be
- * dynamically allocated at begin of ospf_spf_calculate
+/* List of vertices allocated by the SPF calculation in progress, ie the
+ * spf_vertices list of the area being calculated. The vertices are kept
+ * with the area until its next calculation, see ospf_spf_tree_free.
  */
-static struct list vertex_list = { .del = ospf_vertex_free };
+static struct list *vertex_list;
 
 /* Heap related functions, for the managment of the candidates, to
  * be used with pqueue. */
@@ -171,12 +172,13 @@ ospf_vertex_new (struct ospf_lsa *lsa)
   new->stat = &(lsa->stat);
   new->type = lsa->data->type;
   new->id = lsa->data->id;
+  new->adv_router = lsa->data->adv_router;
   new->lsa = lsa->data;
   new->children = list_new ();
   new->parents = list_new ();
   new->parents->del = vertex_parent_free;
   
-  listnode_add (&vertex_list, new);
+  listnode_add (vertex_list, new);
   
   if (IS_DEBUG_OSPF_EVENT)
     zlog_debug ("%s: Created %s vertex %s", __func__,
@@ -190,10 +192,11 @@ ospf_vertex_free (void *data)
 {
   struct vertex *v = data;
   
+  /* The LSA may be gone by now, the vertex may outlive its calculation */
   if (IS_DEBUG_OSPF_EVENT)
     zlog_debug ("%s: Free %s vertex %s", __func__,
                 v->type == OSPF_VERTEX_ROUTER ? "Router" : "Network",
-                inet_ntoa (v->lsa->id));
+                inet_ntoa (v->id));
   
   /* There should be no parents potentially holding references to this vertex
    * Children however may still be there, but presumably referenced by other
@@ -1124,6 +1127,315 @@ ospf_rtrs_print (struct route_table *rtrs)
 }
 #endif
 
+/* Free the shortest-path tree kept from the last calculation of an area. */
+void
+ospf_spf_tree_free (struct ospf_area *area)
+{
+  if (area->spf_vertices)
+    {
+      /* Free nexthop information, canonical versions of which are attached
+       * the first level of router vertices attached to the root vertex, see
+       * ospf_nexthop_calculation.
+       */
+      ospf_canonical_nexthops_free (area->spf);
+      list_delete (area->spf_tree);
+      list_delete (area->spf_vertices);
+    }
+  if (area->spf_vertex_hash)
+    {
+      hash_clean (area->spf_vertex_hash, NULL);
+      hash_free (area->spf_vertex_hash);
+    }
+  area->spf_tree = NULL;
+  area->spf_vertices = NULL;
+  area->spf_vertex_hash = NULL;
+  area->spf = NULL;
+}
+
+static unsigned int
+ospf_vertex_hash_key (void *data)
+{
+  struct vertex *v = data;
+
+  return jhash_2words (v->id.s_addr, v->type, 0);
+}
+
+static int
+ospf_vertex_hash_cmp (const void *a, const void *b)
+{
+  const struct vertex *v1 = a;
+  const struct vertex *v2 = b;
+
+  return v1->type == v2->type && IPV4_ADDR_SAME (&v1->id, &v2->id);
+}
+
+/* The tree kept for an area does not lock the LSAs of its vertices, they
+ * may be freed once the calculation is done. Forget them, the tree is
+ * only checked against the LSAs in the database from then on.
+ */
+static void
+ospf_spf_tree_release_lsas (struct ospf_area *area)
+{
+  struct listnode *node;
+  struct vertex *v;
+
+  for (ALL_LIST_ELEMENTS_RO (area->spf_vertices, node, v))
+    {
+      v->lsa = NULL;
+      v->stat = NULL;
+    }
+}
+
+/* Index the vertices of the tree kept for an area by type and id. Vertices
+ * which never joined the tree, for want of a nexthop, are dropped.
+ */
+static void
+ospf_spf_tree_index (struct ospf_area *area)
+{
+  struct listnode *node, *nnode;
+  struct vertex *v;
+
+  if (area->spf_vertex_hash)
+    {
+      hash_clean (area->spf_vertex_hash, NULL);
+      hash_free (area->spf_vertex_hash);
+    }
+
+  for (ALL_LIST_ELEMENTS (area->spf_vertices, node, nnode, v))
+    if (v != area->spf && listcount (v->parents) == 0)
+      {
+        list_delete_node (area->spf_vertices, node);
+        ospf_vertex_free (v);
+      }
+
+  area->spf_vertex_hash = hash_create_size (listcount (area->spf_vertices),
+                                            ospf_vertex_hash_key,
+                                            ospf_vertex_hash_cmp);
+  for (ALL_LIST_ELEMENTS_RO (area->spf_vertices, node, v))
+    hash_get (area->spf_vertex_hash, v, hash_alloc_intern);
+}
+
+/* Find a vertex in the tree kept for an area. */
+static struct vertex *
+ospf_spf_vertex_lookup (struct ospf_area *area, u_char type,
+                        struct in_addr id)
+{
+  struct vertex key;
+
+  key.type = type;
+  key.id = id;
+  return hash_lookup (area->spf_vertex_hash, &key);
+}
+
+static int
+ospf_vertex_has_parent (struct vertex *v, struct vertex *parent)
+{
+  struct listnode *node;
+  struct vertex_parent *vp;
+
+  for (ALL_LIST_ELEMENTS_RO (v->parents, node, vp))
+    if (vp->parent == parent)
+      return 1;
+
+  return 0;
+}
+
+/* Is link l, of another instance of the router-LSA, also in rl? */
+static int
+ospf_router_lsa_link_present (struct router_lsa *rl,
+                              struct router_lsa_link *l)
+{
+  u_char *p, *lim;
+  struct router_lsa_link *l2;
+  size_t len = OSPF_ROUTER_LSA_LINK_SIZE
+               + l->m[0].tos_count * OSPF_ROUTER_LSA_TOS_SIZE;
+
+  p = ((u_char *) rl) + OSPF_LSA_HEADER_SIZE + 4;
+  lim = ((u_char *) rl) + ntohs (rl->header.length);
+
+  while (p < lim)
+    {
+      l2 = (struct router_lsa_link *) p;
+      p += (OSPF_ROUTER_LSA_LINK_SIZE +
+            (l2->m[0].tos_count * OSPF_ROUTER_LSA_TOS_SIZE));
+
+      if (memcmp (l, l2, len) == 0)
+        return 1;
+    }
+
+  return 0;
+}
+
+/* Lowest metric of the links of router w to router id, or -1 */
+static long
+ospf_router_lsa_link_metric (struct lsa_header *w, struct in_addr id)
+{
+  u_char *p, *lim;
+  struct router_lsa_link *l;
+  long metric = -1;
+
+  p = ((u_char *) w) + OSPF_LSA_HEADER_SIZE + 4;
+  lim = ((u_char *) w) + ntohs (w->length);
+
+  while (p < lim)
+    {
+      l = (struct router_lsa_link *) p;
+      p += (OSPF_ROUTER_LSA_LINK_SIZE +
+            (l->m[0].tos_count * OSPF_ROUTER_LSA_TOS_SIZE));
+
+      if ((l->m[0].type == LSA_LINK_TYPE_POINTOPOINT
+           || l->m[0].type == LSA_LINK_TYPE_VIRTUALLINK)
+          && IPV4_ADDR_SAME (&l->link_id, &id)
+          && (metric < 0 || ntohs (l->m[0].metric) < metric))
+        metric = ntohs (l->m[0].metric);
+    }
+
+  return metric;
+}
+
+/* Link l of router r (NULL if r is not in the tree) is withdrawn. If one
+ * end of the link is the parent of the other in the tree, the edge and
+ * the nexthops taken from it are gone: mark the child, the subtree below
+ * it has to be calculated again, see ospf_spf_subtree_detach. Returns 0
+ * if the tree is unaffected.
+ */
+static int
+ospf_spf_link_removal (struct ospf_area *area, struct vertex *r,
+                       struct router_lsa_link *l)
+{
+  struct vertex *w;
+  int marked = 0;
+
+  if (r == NULL)
+    return 0;
+
+  w = ospf_spf_vertex_lookup (area, l->m[0].type == LSA_LINK_TYPE_TRANSIT
+                                    ? OSPF_VERTEX_NETWORK : OSPF_VERTEX_ROUTER,
+                              l->link_id);
+  if (w == NULL)
+    return 0;
+
+  if (ospf_vertex_has_parent (w, r))
+    {
+      SET_FLAG (w->flags, OSPF_VERTEX_AFFECTED);
+      marked = 1;
+    }
+  if (ospf_vertex_has_parent (r, w))
+    {
+      SET_FLAG (r->flags, OSPF_VERTEX_AFFECTED);
+      marked = 1;
+    }
+
+  return marked;
+}
+
+/* Can link l be added to router r (NULL if r is not in the tree) without
+ * changing the tree? Only if both ends are in the tree, or neither is, and
+ * the new edges, in either direction, are strictly longer than the paths
+ * the tree already has, so that they can't even add an equal-cost parent.
+ * As links are only withdrawn otherwise, no path gets shorter than it is
+ * in the tree, which is what allows ospf_spf_subtree_calculate to keep the
+ * unmarked part of the tree.
+ */
+static int
+ospf_spf_link_addition_ok (struct ospf_area *area, struct vertex *r,
+                           struct router_lsa_link *l)
+{
+  struct vertex *w;
+  struct ospf_lsa *lsa;
+  long back;
+
+  w = ospf_spf_vertex_lookup (area, l->m[0].type == LSA_LINK_TYPE_TRANSIT
+                                    ? OSPF_VERTEX_NETWORK : OSPF_VERTEX_ROUTER,
+                              l->link_id);
+  if (r == NULL || w == NULL)
+    return r == w;
+
+  if (r->distance + ntohs (l->m[0].metric) <= w->distance)
+    return 0;
+
+  /* The edge back from w: free from a network, as costly as the cheapest
+   * link back from a router, if it has one. Its links are taken from the
+   * router-LSA now in the database, see ospf_spf_tree_release_lsas. */
+  if (w->type == OSPF_VERTEX_NETWORK)
+    back = 0;
+  else
+    {
+      lsa = ospf_lsdb_lookup_by_id (area->lsdb, w->type, w->id,
+                                    w->adv_router);
+      if (lsa == NULL || IS_LSA_MAXAGE (lsa))
+        return 0;
+      back = ospf_router_lsa_link_metric (lsa->data, r->id);
+    }
+
+  return back < 0 || w->distance + back > r->distance;
+}
+
+/* Classify the installation of router-LSA new over old in area: returns
+ * OSPF_SPF_FLAG_STUB_CHANGE if the shortest-path tree kept for the area
+ * is unaffected by it, OSPF_SPF_FLAG_SUBTREE_CHANGE if it only withdraws
+ * edges of the tree, whose subtrees are then marked to be calculated
+ * again, OSPF_SPF_FLAG_ROUTER_LSA_INSTALL otherwise. Must be called before
+ * old is discarded.
+ */
+u_int32_t
+ospf_spf_router_lsa_reason (struct ospf_area *area, struct ospf_lsa *old,
+                            struct ospf_lsa *new)
+{
+  struct router_lsa *ol, *nl;
+  struct router_lsa_link *l;
+  struct vertex *r;
+  u_char *p, *lim;
+  u_int32_t reason = OSPF_SPF_FLAG_STUB_CHANGE;
+
+  if (area == NULL || area->spf_vertices == NULL || old == NULL
+      || IS_LSA_SELF (new) || IS_LSA_MAXAGE (old) || IS_LSA_MAXAGE (new))
+    return OSPF_SPF_FLAG_ROUTER_LSA_INSTALL;
+
+  ol = (struct router_lsa *) old->data;
+  nl = (struct router_lsa *) new->data;
+
+  /* The flags decide on ABR/ASBR routes and virtual links. */
+  if (ol->flags != nl->flags || ol->header.options != nl->header.options)
+    return OSPF_SPF_FLAG_ROUTER_LSA_INSTALL;
+
+  r = ospf_spf_vertex_lookup (area, OSPF_VERTEX_ROUTER, nl->header.id);
+  if (r == area->spf && r != NULL)
+    return OSPF_SPF_FLAG_ROUTER_LSA_INSTALL;
+
+  /* Links withdrawn. */
+  p = ((u_char *) ol) + OSPF_LSA_HEADER_SIZE + 4;
+  lim = ((u_char *) ol) + ntohs (ol->header.length);
+  while (p < lim)
+    {
+      l = (struct router_lsa_link *) p;
+      p += (OSPF_ROUTER_LSA_LINK_SIZE +
+            (l->m[0].tos_count * OSPF_ROUTER_LSA_TOS_SIZE));
+
+      if (l->m[0].type != LSA_LINK_TYPE_STUB
+          && !ospf_router_lsa_link_present (nl, l)
+          && ospf_spf_link_removal (area, r, l))
+        reason = OSPF_SPF_FLAG_SUBTREE_CHANGE;
+    }
+
+  /* Links added. */
+  p = ((u_char *) nl) + OSPF_LSA_HEADER_SIZE + 4;
+  lim = ((u_char *) nl) + ntohs (nl->header.length);
+  while (p < lim)
+    {
+      l = (struct router_lsa_link *) p;
+      p += (OSPF_ROUTER_LSA_LINK_SIZE +
+            (l->m[0].tos_count * OSPF_ROUTER_LSA_TOS_SIZE));
+
+      if (l->m[0].type != LSA_LINK_TYPE_STUB
+          && !ospf_router_lsa_link_present (ol, l)
+          && !ospf_spf_link_addition_ok (area, r, l))
+        return OSPF_SPF_FLAG_ROUTER_LSA_INSTALL;
+    }
+
+  return reason;
+}
+
 /* Calculating the shortest-path tree for an area. */
 static void
 ospf_spf_calculate (struct ospf_area *area, struct route_table *new_table,
@@ -1139,6 +1451,9 @@ ospf_spf_calculate (struct ospf_area *area, struct route_table *new_table,
                  inet_ntoa (area->area_id));
     }
 
+  /* Drop the tree of the previous calculation. */
+  ospf_spf_tree_free (area);
+
   /* Check router-lsa-self.  If self-router-lsa is not yet allocated,
      return this area's calculation. */
   if (!area->router_lsa_self)
@@ -1161,10 +1476,16 @@ ospf_spf_calculate (struct ospf_area *area, struct route_table *new_table,
   candidate->cmp = cmp;
   candidate->update = update_stat;
 
+  area->spf_vertices = list_new ();
+  area->spf_vertices->del = ospf_vertex_free;
+  area->spf_tree = list_new ();
+  vertex_list = area->spf_vertices;
+
   /* Initialize the shortest-path tree to only the root (which is the
      router doing the calculation). */
   ospf_spf_init (area);
   v = area->spf;
+  listnode_add (area->spf_tree, v);
   /* Set LSA position to LSA_SPF_IN_SPFTREE. This vertex is the root of the
    * spanning tree. */
   *(v->stat) = LSA_SPF_IN_SPFTREE;
@@ -1195,6 +1516,7 @@ ospf_spf_calculate (struct ospf_area *area, struct route_table *new_table,
       *(v->stat) = LSA_SPF_IN_SPFTREE;
 
       ospf_vertex_add_parent (v);
+      listnode_add (area->spf_tree, v);
 
       /* RFC2328 16.1. (4). */
       if (v->type == OSPF_VERTEX_ROUTER)
@@ -1220,44 +1542,314 @@ ospf_spf_calculate (struct ospf_area *area, struct route_table *new_table,
   pqueue_delete (candidate);
   
   ospf_vertex_dump (__func__, area->spf, 0, 1);
-  /* Free nexthop information, canonical versions of which are attached
-   * the first level of router vertices attached to the root vertex, see
-   * ospf_nexthop_calculation.
-   */
-  ospf_canonical_nexthops_free (area->spf);
-  
-  /* Free SPF vertices, but not the list. List has ospf_vertex_free
-   * as deconstructor.
+
+  /* The tree, with its nexthops, stays with the area, so that the routes
+   * can be recalculated without another run of Dijkstra when only leaves
+   * of the tree change, see ospf_spf_partial.
    */
-  list_delete_all_node (&vertex_list);
+  ospf_spf_tree_index (area);
+  ospf_spf_tree_release_lsas (area);
+  vertex_list = NULL;
   
   /* Increment SPF Calculation Counter. */
   area->spf_calculation++;
 
-  quagga_gettime (QUAGGA_CLK_MONOTONIC, &area->ospf->ts_spf);
-
   if (IS_DEBUG_OSPF_EVENT)
     zlog_debug ("ospf_spf_calculate: Stop. %ld vertices",
                 mtype_stats_alloc(MTYPE_OSPF_VERTEX));
 }
 
-/* Timer for SPF calculation. */
+/* Is the nexthop of a vertex through parent vp one of the canonical
+ * nexthops, freed with the tree by ospf_canonical_nexthops_free?
+ */
 static int
-ospf_spf_calculate_timer (struct thread *thread)
+ospf_vertex_nexthop_canonical (struct ospf_area *area,
+                               struct vertex_parent *vp)
+{
+  return vp->parent == area->spf
+         || (vp->parent->type == OSPF_VERTEX_NETWORK
+             && ospf_vertex_has_parent (vp->parent, area->spf));
+}
+
+/* Add the kept vertex of type and id to the boundary, unless it is
+ * affected itself or already there.
+ */
+static void
+ospf_spf_boundary_add (struct ospf_area *area, struct list *boundary,
+                       u_char type, struct in_addr id)
+{
+  struct vertex *w;
+
+  w = ospf_spf_vertex_lookup (area, type, id);
+  if (w == NULL
+      || CHECK_FLAG (w->flags, OSPF_VERTEX_AFFECTED | OSPF_VERTEX_BOUNDARY))
+    return;
+
+  SET_FLAG (w->flags, OSPF_VERTEX_BOUNDARY);
+  listnode_add (boundary, w);
+}
+
+/* Take the vertices marked by ospf_spf_link_removal, and all vertices
+ * below them, out of the tree kept for an area and free them. Returns the
+ * kept vertices they have links to, from which Dijkstra is started again
+ * by ospf_spf_subtree_calculate, or NULL if nothing is marked.
+ */
+static struct list *
+ospf_spf_subtree_detach (struct ospf_area *area)
+{
+  struct list *affected, *boundary;
+  struct listnode *node, *nnode, *pnode;
+  struct vertex_parent *vp;
+  struct vertex *v;
+  struct ospf_lsa *lsa;
+  struct router_lsa_link *l;
+  u_char *p, *lim;
+
+  /* The tree lists the parents of a vertex before the vertex. */
+  affected = list_new ();
+  for (ALL_LIST_ELEMENTS (area->spf_tree, node, nnode, v))
+    {
+      if (!CHECK_FLAG (v->flags, OSPF_VERTEX_AFFECTED))
+        for (ALL_LIST_ELEMENTS_RO (v->parents, pnode, vp))
+          if (CHECK_FLAG (vp->parent->flags, OSPF_VERTEX_AFFECTED))
+            {
+              SET_FLAG (v->flags, OSPF_VERTEX_AFFECTED);
+              break;
+            }
+
+      if (CHECK_FLAG (v->flags, OSPF_VERTEX_AFFECTED))
+        {
+          list_delete_node (area->spf_tree, node);
+          listnode_add (affected, v);
+        }
+    }
+
+  if (listcount (affected) == 0)
+    {
+      list_delete (affected);
+      return NULL;
+    }
+
+  if (IS_DEBUG_OSPF_EVENT)
+    zlog_debug ("ospf_spf_subtree_detach: %u of %u vertices of area %s",
+                listcount (affected), listcount (area->spf_vertices),
+                inet_ntoa (area->area_id));
+
+  /* Unlink them from the kept part of the tree. Their parents are
+   * still there to tell which nexthops they own. */
+  for (ALL_LIST_ELEMENTS_RO (affected, node, v))
+    for (ALL_LIST_ELEMENTS_RO (v->parents, pnode, vp))
+      {
+        if (ospf_vertex_nexthop_canonical (area, vp))
+          vertex_nexthop_free (vp->nexthop);
+        if (!CHECK_FLAG (vp->parent->flags, OSPF_VERTEX_AFFECTED))
+          listnode_delete (vp->parent->children, v);
+      }
+
+  /* A kept vertex can only reach an affected one over a link the current
+   * LSA of the latter has back to it, see ospf_lsa_has_link. */
+  boundary = list_new ();
+  for (ALL_LIST_ELEMENTS_RO (affected, node, v))
+    {
+      lsa = ospf_lsdb_lookup_by_id (area->lsdb, v->type, v->id,
+                                    v->adv_router);
+      if (lsa == NULL || IS_LSA_MAXAGE (lsa))
+        continue;
+
+      p = ((u_char *) lsa->data) + OSPF_LSA_HEADER_SIZE + 4;
+      lim = ((u_char *) lsa->data) + ntohs (lsa->data->length);
+      while (p < lim)
+        {
+          if (v->type == OSPF_VERTEX_NETWORK)
+            {
+              ospf_spf_boundary_add (area, boundary, OSPF_VERTEX_ROUTER,
+                                     *(struct in_addr *) p);
+              p += sizeof (struct in_addr);
+              continue;
+            }
+
+          l = (struct router_lsa_link *) p;
+          p += (OSPF_ROUTER_LSA_LINK_SIZE +
+                (l->m[0].tos_count * OSPF_ROUTER_LSA_TOS_SIZE));
+
+          if (l->m[0].type == LSA_LINK_TYPE_TRANSIT)
+            ospf_spf_boundary_add (area, boundary, OSPF_VERTEX_NETWORK,
+                                   l->link_id);
+          else if (l->m[0].type != LSA_LINK_TYPE_STUB)
+            ospf_spf_boundary_add (area, boundary, OSPF_VERTEX_ROUTER,
+                                   l->link_id);
+        }
+    }
+
+  for (ALL_LIST_ELEMENTS (area->spf_vertices, node, nnode, v))
+    if (CHECK_FLAG (v->flags, OSPF_VERTEX_AFFECTED))
+      {
+        hash_release (area->spf_vertex_hash, v);
+        list_delete_node (area->spf_vertices, node);
+        ospf_vertex_free (v);
+      }
+
+  list_delete (affected);
+  return boundary;
+}
+
+/* Run Dijkstra again for the vertices taken out of the tree of an area by
+ * ospf_spf_subtree_detach, starting from the kept vertices next to them.
+ * The kept vertices can't get shorter paths through the affected ones,
+ * see ospf_spf_link_addition_ok, so they stay as they are. Their LSAs
+ * must be set.
+ */
+static void
+ospf_spf_subtree_calculate (struct ospf_area *area, struct list *boundary)
+{
+  struct pqueue *candidate;
+  struct listnode *node;
+  struct vertex *v;
+
+  ospf_lsdb_clean_stat (area->lsdb);
+  for (ALL_LIST_ELEMENTS_RO (area->spf_tree, node, v))
+    *(v->stat) = LSA_SPF_IN_SPFTREE;
+
+  candidate = pqueue_create ();
+  candidate->cmp = cmp;
+  candidate->update = update_stat;
+  vertex_list = area->spf_vertices;
+
+  /* RFC2328 16.1. (2), for every kept vertex which had a link to a vertex
+   * now out of the tree. */
+  for (ALL_LIST_ELEMENTS_RO (boundary, node, v))
+    {
+      UNSET_FLAG (v->flags, OSPF_VERTEX_BOUNDARY);
+      ospf_spf_next (v, area, candidate);
+    }
+
+  /* RFC2328 16.1. (3) to (5), the routes are added by the caller. */
+  while (candidate->size)
+    {
+      v = (struct vertex *) pqueue_dequeue (candidate);
+      *(v->stat) = LSA_SPF_IN_SPFTREE;
+
+      ospf_vertex_add_parent (v);
+      listnode_add (area->spf_tree, v);
+
+      ospf_spf_next (v, area, candidate);
+    }
+
+  pqueue_delete (candidate);
+  vertex_list = NULL;
+
+  ospf_spf_tree_index (area);
+  area->spf_calculation++;
+}
+
+/* Recalculate the intra-area routes of an area from the tree kept from
+ * its last calculation, taking the stub links from the current LSAs.
+ * Subtrees marked by ospf_spf_router_lsa_reason are calculated again
+ * first. Returns 0 if the tree refers to LSAs which are gone.
+ */
+static int
+ospf_spf_partial (struct ospf_area *area, struct route_table *new_table,
+                  struct route_table *new_rtrs)
+{
+  struct listnode *node;
+  struct list *boundary;
+  struct vertex *v;
+  struct ospf_lsa *lsa;
+
+  if (IS_DEBUG_OSPF_EVENT)
+    zlog_debug ("ospf_spf_partial: routes from the tree of area %s",
+                inet_ntoa (area->area_id));
+
+  boundary = ospf_spf_subtree_detach (area);
+
+  for (ALL_LIST_ELEMENTS_RO (area->spf_tree, node, v))
+    {
+      lsa = ospf_lsdb_lookup_by_id (area->lsdb, v->type, v->id,
+                                    v->adv_router);
+      if (lsa == NULL || IS_LSA_MAXAGE (lsa))
+        {
+          if (boundary)
+            list_delete (boundary);
+          return 0;
+        }
+
+      v->lsa = lsa->data;
+      v->stat = &lsa->stat;
+      UNSET_FLAG (v->flags, OSPF_VERTEX_PROCESSED);
+    }
+
+  if (boundary)
+    {
+      ospf_spf_subtree_calculate (area, boundary);
+      list_delete (boundary);
+    }
+
+  area->abr_count = 0;
+  area->asbr_count = 0;
+  area->shortcut_capability = 1;
+
+  /* Same order as Dijkstra added them, RFC2328 16.1. (4). */
+  for (ALL_LIST_ELEMENTS_RO (area->spf_tree, node, v))
+    {
+      if (v == area->spf)
+        continue;
+
+      if (v->type == OSPF_VERTEX_ROUTER)
+        ospf_intra_add_router (new_rtrs, v, area);
+      else
+        ospf_intra_add_transit (new_table, v, area);
+    }
+
+  ospf_spf_process_stubs (area, area->spf, new_table, 0);
+  ospf_spf_tree_release_lsas (area);
+
+  return 1;
+}
+
+/* Can the pending calculation reuse the trees of the last one, or parts
+ * of them? */
+static int
+ospf_spf_partial_ok (struct ospf *ospf, u_int32_t reason)
+{
+  struct listnode *node;
+  struct ospf_area *area;
+
+  if (reason == 0 || (reason & ~OSPF_SPF_FLAG_INCREMENTAL))
+    return 0;
+
+  /* Virtual links are brought up during the calculation. */
+  if (listcount (ospf->vlinks))
+    return 0;
+
+  for (ALL_LIST_ELEMENTS_RO (ospf->areas, node, area))
+    if (area->router_lsa_self && !area->spf_vertices)
+      return 0;
+
+  return 1;
+}
+
+/* Calculate the intra-area routes of every area, backbone last. */
+static int
+ospf_spf_calculate_areas (struct ospf *ospf, int type,
+                          struct route_table *new_table,
+                          struct route_table *new_rtrs)
 {
-  struct ospf *ospf = THREAD_ARG (thread);
-  struct route_table *new_table, *new_rtrs;
   struct ospf_area *area;
   struct listnode *node, *nnode;
 
-  if (IS_DEBUG_OSPF_EVENT)
-    zlog_debug ("SPF: Timer (SPF calculation expire)");
+  if (type != OSPF_SPF_FULL)
+    {
+      for (ALL_LIST_ELEMENTS (ospf->areas, node, nnode, area))
+        if (area != ospf->backbone && area->spf_vertices
+            && !ospf_spf_partial (area, new_table, new_rtrs))
+          return 0;
 
-  ospf->t_spf_calc = NULL;
+      if (ospf->backbone && ospf->backbone->spf_vertices
+          && !ospf_spf_partial (ospf->backbone, new_table, new_rtrs))
+        return 0;
 
-  /* Allocate new table tree. */
-  new_table = route_table_init ();
-  new_rtrs = route_table_init ();
+      return 1;
+    }
 
   ospf_vl_unapprove (ospf);
 
@@ -1279,6 +1871,51 @@ ospf_spf_calculate_timer (struct thread *thread)
   
   ospf_vl_shut_unapproved (ospf);
 
+  return 1;
+}
+
+/* Timer for SPF calculation. */
+static int
+ospf_spf_calculate_timer (struct thread *thread)
+{
+  struct ospf *ospf = THREAD_ARG (thread);
+  struct route_table *new_table, *new_rtrs;
+  struct timeval start, stop, result;
+  unsigned long usecs;
+  u_int32_t reason;
+  int type;
+
+  if (IS_DEBUG_OSPF_EVENT)
+    zlog_debug ("SPF: Timer (SPF calculation expire)");
+
+  ospf->t_spf_calc = NULL;
+  reason = ospf->spf_reason;
+  ospf->spf_reason = 0;
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
+
+  /* Allocate new table tree. */
+  new_table = route_table_init ();
+  new_rtrs = route_table_init ();
+
+  type = OSPF_SPF_FULL;
+  if (ospf_spf_partial_ok (ospf, reason))
+    type = CHECK_FLAG (reason, OSPF_SPF_FLAG_SUBTREE_CHANGE)
+           ? OSPF_SPF_INCREMENTAL : OSPF_SPF_PARTIAL;
+  if (!ospf_spf_calculate_areas (ospf, type, new_table, new_rtrs))
+    {
+      if (IS_DEBUG_OSPF_EVENT)
+        zlog_debug ("SPF: tree out of date, full calculation");
+
+      ospf_route_table_free (new_table);
+      ospf_rtrs_free (new_rtrs);
+      new_table = route_table_init ();
+      new_rtrs = route_table_init ();
+
+      type = OSPF_SPF_FULL;
+      ospf_spf_calculate_areas (ospf, type, new_table, new_rtrs);
+    }
+
   ospf_ia_routing (ospf, new_table, new_rtrs);
 
   ospf_prune_unreachable_networks (new_table);
@@ -1310,26 +1947,89 @@ ospf_spf_calculate_timer (struct thread *thread)
   if (IS_OSPF_ABR (ospf))
     ospf_abr_task (ospf);
 
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &stop);
+  ospf->ts_spf = stop;
+
+  result = tv_sub (stop, start);
+  usecs = result.tv_sec * 1000000 + result.tv_usec;
+  ospf->spf_last_reason = reason;
+  ospf->spf_last_type = type;
+  ospf->spf_stats[type].runs++;
+  ospf->spf_stats[type].usecs_last = usecs;
+  ospf->spf_stats[type].usecs_total += usecs;
+  if (usecs > ospf->spf_stats[type].usecs_max)
+    ospf->spf_stats[type].usecs_max = usecs;
+
   if (IS_DEBUG_OSPF_EVENT)
-    zlog_debug ("SPF: calculation complete");
+    zlog_debug ("SPF: %s calculation complete in %lu usecs",
+                ospf_spf_type_str (type), usecs);
 
   return 0;
 }
 
+/* Describe the OSPF_SPF_FLAG_* in reason. */
+const char *
+ospf_spf_reason_str (u_int32_t reason, char *buf, size_t size)
+{
+  static const struct
+  {
+    u_int32_t flag;
+    const char *str;
+  } reasons[] =
+  {
+    { OSPF_SPF_FLAG_ROUTER_LSA_INSTALL,       "router-lsa" },
+    { OSPF_SPF_FLAG_NETWORK_LSA_INSTALL,      "network-lsa" },
+    { OSPF_SPF_FLAG_SUMMARY_LSA_INSTALL,      "summary-lsa" },
+    { OSPF_SPF_FLAG_ASBR_SUMMARY_LSA_INSTALL, "asbr-summary-lsa" },
+    { OSPF_SPF_FLAG_MAXAGE,                   "maxage" },
+    { OSPF_SPF_FLAG_ABR_STATUS_CHANGE,        "abr-status" },
+    { OSPF_SPF_FLAG_ASBR_STATUS_CHANGE,       "asbr-status" },
+    { OSPF_SPF_FLAG_CONFIG_CHANGE,            "config" },
+    { OSPF_SPF_FLAG_STUB_CHANGE,              "stub-change" },
+    { OSPF_SPF_FLAG_SUBTREE_CHANGE,           "subtree-change" },
+  };
+  size_t i, len = 0;
+
+  buf[0] = '\0';
+  for (i = 0; i < sizeof (reasons) / sizeof (reasons[0]); i++)
+    if (CHECK_FLAG (reason, reasons[i].flag) && len < size)
+      len += snprintf (buf + len, size - len, "%s%s",
+                       len ? ", " : "", reasons[i].str);
+
+  return buf;
+}
+
+/* Name of an OSPF_SPF_* calculation type. */
+const char *
+ospf_spf_type_str (int type)
+{
+  switch (type)
+    {
+    case OSPF_SPF_PARTIAL:
+      return "partial";
+    case OSPF_SPF_INCREMENTAL:
+      return "incremental";
+    default:
+      return "full";
+    }
+}
+
 /* Add schedule for SPF calculation.  To avoid frequenst SPF calc, we
    set timer for SPF calc. */
 void
-ospf_spf_calculate_schedule (struct ospf *ospf)
+ospf_spf_calculate_schedule (struct ospf *ospf, u_int32_t reason)
 {
   unsigned long delay, elapsed, ht;
   struct timeval result;
 
   if (IS_DEBUG_OSPF_EVENT)
-    zlog_debug ("SPF: calculation timer scheduled");
+    zlog_debug ("SPF: calculation timer scheduled (reason 0x%x)", reason);
 
   /* OSPF instance does not exist. */
   if (ospf == NULL)
     return;
+
+  ospf->spf_reason |= reason;
   
   /* SPF calculation timer is already scheduled. */
   if (ospf->t_spf_calc)
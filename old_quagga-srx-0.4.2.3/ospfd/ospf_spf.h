@@ -29,6 +29,8 @@
 
 /* values for vertex->flags */
 #define OSPF_VERTEX_PROCESSED      0x01
+#define OSPF_VERTEX_AFFECTED       0x02  /* subtree to calculate again */
+#define OSPF_VERTEX_BOUNDARY       0x04  /* kept, next to an affected one */
 
 /* The "root" is the node running the SPF calculation */
 
@@ -38,6 +40,7 @@ struct vertex
   u_char flags;
   u_char type;		/* copied from LSA header */
   struct in_addr id;	/* copied from LSA header */
+  struct in_addr adv_router; /* copied from LSA header */
   struct lsa_header *lsa; /* Router or Network LSA */
   int *stat;		/* Link to LSA status. */
   u_int32_t distance;	/* from root to this vertex */  
@@ -59,7 +62,41 @@ struct vertex_parent
   int backlink;			/* index back to parent for router-lsa's */
 };
 
-extern void ospf_spf_calculate_schedule (struct ospf *);
+/* Reasons for scheduling the SPF calculation, see ospf->spf_reason */
+#define OSPF_SPF_FLAG_ROUTER_LSA_INSTALL        0x0001
+#define OSPF_SPF_FLAG_NETWORK_LSA_INSTALL       0x0002
+#define OSPF_SPF_FLAG_SUMMARY_LSA_INSTALL       0x0004
+#define OSPF_SPF_FLAG_ASBR_SUMMARY_LSA_INSTALL  0x0008
+#define OSPF_SPF_FLAG_MAXAGE                    0x0010
+#define OSPF_SPF_FLAG_ABR_STATUS_CHANGE         0x0020
+#define OSPF_SPF_FLAG_ASBR_STATUS_CHANGE        0x0040
+#define OSPF_SPF_FLAG_CONFIG_CHANGE             0x0080
+/* Router-LSA changed only in its stub links, or in links which can't
+ * alter the shortest-path tree. */
+#define OSPF_SPF_FLAG_STUB_CHANGE               0x0100
+/* Router-LSA withdrew links of the shortest-path tree, the subtrees below
+ * them are marked OSPF_VERTEX_AFFECTED. */
+#define OSPF_SPF_FLAG_SUBTREE_CHANGE            0x0200
+
+/* Reasons which leave the shortest-path trees intact, so that the routing
+ * table can be recalculated from the trees kept from the last full run
+ * (partial route calculation). */
+#define OSPF_SPF_FLAG_PARTIAL \
+  (OSPF_SPF_FLAG_SUMMARY_LSA_INSTALL | OSPF_SPF_FLAG_ASBR_SUMMARY_LSA_INSTALL \
+   | OSPF_SPF_FLAG_STUB_CHANGE)
+
+/* Reasons which leave the trees intact but for some subtrees, which only
+ * need Dijkstra to be run again for their vertices (incremental SPF). */
+#define OSPF_SPF_FLAG_INCREMENTAL \
+  (OSPF_SPF_FLAG_PARTIAL | OSPF_SPF_FLAG_SUBTREE_CHANGE)
+
+extern void ospf_spf_calculate_schedule (struct ospf *, u_int32_t);
+extern u_int32_t ospf_spf_router_lsa_reason (struct ospf_area *,
+                                             struct ospf_lsa *,
+                                             struct ospf_lsa *);
+extern void ospf_spf_tree_free (struct ospf_area *);
+extern const char *ospf_spf_reason_str (u_int32_t, char *, size_t);
+extern const char *ospf_spf_type_str (int);
 extern void ospf_rtrs_free (struct route_table *);
 
 /* void ospf_spf_calculate_timer_add (); */
@@ -771,7 +771,7 @@ ospf_find_vl_data (struct ospf *ospf, struct ospf_vl_config_data *vl_config)
 	{
 	  vl_data->vl_oi = ospf_vl_new (ospf, vl_data);
 	  ospf_vl_add (ospf, vl_data);
-	  ospf_spf_calculate_schedule (ospf);
+	  ospf_spf_calculate_schedule (ospf, OSPF_SPF_FLAG_CONFIG_CHANGE);
 	}
     }
   return vl_data;
@@ -2170,7 +2170,7 @@ DEFUN (ospf_compatible_rfc1583,
   if (!CHECK_FLAG (ospf->config, OSPF_RFC1583_COMPATIBLE))
     {
       SET_FLAG (ospf->config, OSPF_RFC1583_COMPATIBLE);
-      ospf_spf_calculate_schedule (ospf);
+      ospf_spf_calculate_schedule (ospf, OSPF_SPF_FLAG_CONFIG_CHANGE);
     }
   return CMD_SUCCESS;
 }
@@ -2187,7 +2187,7 @@ DEFUN (no_ospf_compatible_rfc1583,
   if (CHECK_FLAG (ospf->config, OSPF_RFC1583_COMPATIBLE))
     {
       UNSET_FLAG (ospf->config, OSPF_RFC1583_COMPATIBLE);
-      ospf_spf_calculate_schedule (ospf);
+      ospf_spf_calculate_schedule (ospf, OSPF_SPF_FLAG_CONFIG_CHANGE);
     }
   return CMD_SUCCESS;
 }
@@ -2683,6 +2683,8 @@ DEFUN (show_ip_ospf,
   struct ospf *ospf;
   struct timeval result;
   char timebuf[OSPF_TIME_DUMP_SIZE];
+  char reasonbuf[128];
+  int i;
 
   /* Check OSPF is enable. */
   ospf = ospf_lookup ();
@@ -2750,6 +2752,20 @@ DEFUN (show_ip_ospf,
     }
   else
     vty_out (vty, "has not been run%s", VTY_NEWLINE);
+  if (ospf->spf_last_reason)
+    vty_out (vty, " Last SPF was %s, due to %s%s",
+             ospf_spf_type_str (ospf->spf_last_type),
+             ospf_spf_reason_str (ospf->spf_last_reason, reasonbuf,
+                                  sizeof (reasonbuf)), VTY_NEWLINE);
+  for (i = 0; i < OSPF_SPF_TYPE_MAX; i++)
+    vty_out (vty, " SPF %s runs %u, usecs last %lu, max %lu, average %lu%s",
+             ospf_spf_type_str (i),
+             ospf->spf_stats[i].runs, ospf->spf_stats[i].usecs_last,
+             ospf->spf_stats[i].usecs_max,
+             ospf->spf_stats[i].runs
+               ? (unsigned long) (ospf->spf_stats[i].usecs_total
+                                  / ospf->spf_stats[i].runs) : 0UL,
+             VTY_NEWLINE);
   vty_out (vty, " SPF timer %s%s%s",
            (ospf->t_spf_calc ? "due in " : "is "),
            ospf_timer_dump (ospf->t_spf_calc, timebuf, sizeof (timebuf)),
@@ -606,6 +606,8 @@ ospf_area_free (struct ospf_area *area)
   struct route_node *rn;
   struct ospf_lsa *lsa;
 
+  ospf_spf_tree_free (area);
+
   /* Free LSDBs. */
   LSDB_LOOP (ROUTER_LSDB (area), rn, lsa)
     ospf_discard_from_db (area->ospf, area->lsdb, lsa);
@@ -206,6 +206,22 @@ struct ospf
   unsigned int spf_holdtime;		/* SPF hold time. */
   unsigned int spf_max_holdtime;	/* SPF maximum-holdtime */
   unsigned int spf_hold_multiplier;	/* Adaptive multiplier for hold time */
+  u_int32_t spf_reason;			/* OSPF_SPF_FLAG_* of pending SPF */
+
+  /* SPF statistics, by type of the calculation. */
+#define OSPF_SPF_FULL		0	/* Dijkstra for every area. */
+#define OSPF_SPF_PARTIAL	1	/* Routes from the retained trees. */
+#define OSPF_SPF_INCREMENTAL	2	/* Dijkstra for changed subtrees only. */
+#define OSPF_SPF_TYPE_MAX	3
+  struct
+  {
+    u_int32_t runs;
+    unsigned long usecs_last;
+    unsigned long usecs_max;
+    unsigned long long usecs_total;
+  } spf_stats[OSPF_SPF_TYPE_MAX];
+  u_int32_t spf_last_reason;		/* OSPF_SPF_FLAG_* of last SPF */
+  int spf_last_type;			/* OSPF_SPF_* of last SPF */
   
   int default_originate;		/* Default information originate. */
 #define DEFAULT_ORIGINATE_NONE		0
@@ -436,6 +452,9 @@ struct ospf_area
 
   /* Shortest Path Tree. */
   struct vertex *spf;
+  struct list *spf_vertices;	/* All vertices of the tree. */
+  struct list *spf_tree;	/* Vertices in the order they joined it. */
+  struct hash *spf_vertex_hash;	/* Vertices of the tree by type and id. */
 
   /* Threads. */
   struct thread *t_stub_router;    /* Stub-router timer */
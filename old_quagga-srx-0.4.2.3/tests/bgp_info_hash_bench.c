@@ -0,0 +1,271 @@
+/*
+ * BGP info hash benchmark
+ *
+ * This file is part of Quagga
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Compares the flat Robin Hood index of bgp_info_hash.c against the former
+ * uthash based implementation (one allocated item per identifier).
+ *
+ * Usage: bgpinfohashbench [number of identifiers] [lookup rounds]
+ *
+ * For each implementation the programme reports the time to register all
+ * identifiers, the lookup rate for random known identifiers, the rate of
+ * the localID -> updateID swap (register + unregister) done for each
+ * validation result, and the memory used by the index.
+ */
+#include <zebra.h>
+
+#include "vty.h"
+#include "prefix.h"
+#include "privs.h"
+#include "memory.h"
+#include "zclient.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_table.h"
+#include "bgpd/bgp_route.h"
+#include "bgpd/bgp_info_hash.h"
+
+#ifdef USE_SRX
+
+/* Memory accounting for the uthash tables and items. */
+static size_t uthash_bytes = 0;
+#define uthash_malloc(SZ)    (uthash_bytes += (SZ), malloc (SZ))
+#define uthash_free(PTR, SZ) do { uthash_bytes -= (SZ); free (PTR); } while (0)
+#include <uthash.h>
+
+/* need these to link in libbgp */
+struct thread_master *master = NULL;
+struct zclient *zclient;
+struct zebra_privs_t bgpd_privs =
+{
+  .user = NULL,
+  .group = NULL,
+  .vty_group = NULL,
+};
+
+#define BENCH_DEFAULT_IDS    1000000
+#define BENCH_DEFAULT_ROUNDS 4
+
+/* The former bgp_info_hash item. */
+struct old_item
+{
+  uint32_t        identifier;
+  struct bgp_info *info;
+  UT_hash_handle  hh;
+};
+
+static double
+bench_now (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+bench_report (const char *impl, const char *what, unsigned long ops,
+              double secs)
+{
+  printf ("%-8s %-10s %10lu ops %8.3f s %12.0f ops/s\n",
+          impl, what, ops, secs, secs > 0 ? ops / secs : 0.0);
+}
+
+/* Distinct, non zero, random looking identifiers similar to the srx-server
+ * update identifiers. The murmur3 finalizer is a bijection, therefore
+ * different sequence numbers never result in the same identifier. */
+static uint32_t *
+bench_make_ids (unsigned long first, unsigned long count)
+{
+  uint32_t *ids = malloc (count * sizeof (uint32_t));
+  unsigned long idx;
+  uint32_t h;
+
+  for (idx = 0; idx < count; idx++)
+    {
+      h = (uint32_t) (first + idx + 1);
+      h ^= h >> 16;
+      h *= 0x85ebca6b;
+      h ^= h >> 13;
+      h *= 0xc2b2ae35;
+      h ^= h >> 16;
+      ids[idx] = h;
+    }
+  return ids;
+}
+
+static void
+bench_old (struct bgp_info *infos, uint32_t *ids, uint32_t *swapIds,
+           unsigned long count, int rounds)
+{
+  struct old_item *table = NULL;
+  struct old_item *item, *tmp;
+  unsigned long idx, found = 0;
+  size_t items;
+  double start;
+  int round;
+
+  uthash_bytes = 0;
+
+  start = bench_now ();
+  for (idx = 0; idx < count; idx++)
+    {
+      item = calloc (1, sizeof (struct old_item));
+      item->identifier = ids[idx];
+      item->info = &infos[idx];
+      HASH_ADD (hh, table, identifier, sizeof (uint32_t), item);
+    }
+  bench_report ("uthash", "register", count, bench_now () - start);
+
+  start = bench_now ();
+  for (round = 0; round < rounds; round++)
+    for (idx = 0; idx < count; idx++)
+      {
+        uint32_t id = ids[(idx * 7919) % count];
+        HASH_FIND (hh, table, &id, sizeof (uint32_t), item);
+        if (item)
+          found++;
+      }
+  bench_report ("uthash", "fetch", found, bench_now () - start);
+
+  /* localID -> updateID swap, re-registers the item under a new key */
+  start = bench_now ();
+  for (idx = 0; idx < count; idx++)
+    {
+      HASH_FIND (hh, table, &ids[idx], sizeof (uint32_t), item);
+      tmp = calloc (1, sizeof (struct old_item));
+      tmp->identifier = swapIds[idx];
+      tmp->info = item->info;
+      HASH_ADD (hh, table, identifier, sizeof (uint32_t), tmp);
+      HASH_DEL (table, item);
+      free (item);
+    }
+  bench_report ("uthash", "swap", count, bench_now () - start);
+
+  items = HASH_COUNT (table) * sizeof (struct old_item);
+  printf ("%-8s memory %lu bytes (%.1f bytes per identifier)\n", "uthash",
+          (unsigned long) (uthash_bytes + items),
+          (double) (uthash_bytes + items) / count);
+
+  HASH_ITER (hh, table, item, tmp)
+    {
+      HASH_DEL (table, item);
+      free (item);
+    }
+}
+
+static void
+bench_new (struct bgp_info *infos, uint32_t *ids, uint32_t *swapIds,
+           unsigned long count, int rounds, uint32_t expected)
+{
+  struct bgp_info_hash *hash = bgp_info_hash_init (expected);
+  unsigned long idx, found = 0;
+  size_t bytes;
+  double start;
+  int round;
+
+  start = bench_now ();
+  for (idx = 0; idx < count; idx++)
+    bgp_info_register (hash, &infos[idx], ids[idx]);
+  bench_report (expected ? "flat/rib" : "flat", "register", count,
+                bench_now () - start);
+
+  start = bench_now ();
+  for (round = 0; round < rounds; round++)
+    for (idx = 0; idx < count; idx++)
+      if (bgp_info_fetch (hash, ids[(idx * 7919) % count]) != NULL)
+        found++;
+  bench_report (expected ? "flat/rib" : "flat", "fetch", found,
+                bench_now () - start);
+
+  start = bench_now ();
+  for (idx = 0; idx < count; idx++)
+    {
+      struct bgp_info *info = bgp_info_fetch (hash, ids[idx]);
+      bgp_info_register (hash, info, swapIds[idx]);
+      bgp_info_unregister (hash, ids[idx]);
+    }
+  bench_report (expected ? "flat/rib" : "flat", "swap", count,
+                bench_now () - start);
+
+  bytes = sizeof (struct bgp_info_hash)
+          + hash->size * (sizeof (uint32_t) + sizeof (struct bgp_info *));
+  printf ("%-8s memory %lu bytes (%.1f bytes per identifier)\n",
+          expected ? "flat/rib" : "flat", (unsigned long) bytes,
+          (double) bytes / count);
+
+  /* verify the content after the swap */
+  for (idx = 0; idx < count; idx++)
+    if (bgp_info_fetch (hash, swapIds[idx]) != &infos[idx]
+        || bgp_info_fetch (hash, ids[idx]) != NULL)
+      {
+        printf ("flat index lost identifier 0x%08X\n", ids[idx]);
+        exit (1);
+      }
+
+  bgp_info_hash_finish (&hash);
+}
+
+int
+main (int argc, char **argv)
+{
+  unsigned long count = BENCH_DEFAULT_IDS;
+  int rounds = BENCH_DEFAULT_ROUNDS;
+  struct bgp_info *infos;
+  uint32_t *ids, *swapIds;
+
+  if (argc > 1)
+    count = strtoul (argv[1], NULL, 10);
+  if (argc > 2)
+    rounds = atoi (argv[2]);
+  if (count == 0 || rounds <= 0)
+    {
+      fprintf (stderr, "usage: %s [identifiers] [lookup rounds]\n", argv[0]);
+      return 1;
+    }
+
+  master = thread_master_create ();
+  ids = bench_make_ids (0, count);
+  swapIds = bench_make_ids (count, count);
+  infos = calloc (count, sizeof (struct bgp_info));
+
+  printf ("%lu identifiers, %d lookup rounds\n", count, rounds);
+  bench_old (infos, ids, swapIds, count, rounds);
+  bench_new (infos, ids, swapIds, count, rounds, 0);
+  /* sized from the RIB, no resize while registering */
+  bench_new (infos, ids, swapIds, count, rounds, count);
+
+  free (infos);
+  free (ids);
+  free (swapIds);
+  thread_master_free (master);
+  return 0;
+}
+
+#else /* USE_SRX */
+
+int
+main (void)
+{
+  printf ("bgp info hash benchmark requires SRx support\n");
+  return 0;
+}
+
+#endif /* USE_SRX */
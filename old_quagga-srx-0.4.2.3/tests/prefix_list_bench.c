@@ -0,0 +1,223 @@
+/*
+ * Prefix list benchmark
+ *
+ * This file is part of Quagga
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Compares prefix_list_apply(), which matches through the prefix-list
+ * trie, against the former linear walk over the entries.
+ *
+ * Usage: plistbench [number of entries] [number of lookups]
+ *
+ * The entries are random IPv4 prefixes, a mix of exact, le and ge
+ * entries, installed the way BGP ORF does.  Half of the looked up
+ * prefixes are covered by an entry, the other half are random.  Every
+ * result is checked against the linear walk.
+ */
+#include <zebra.h>
+
+#include "vty.h"
+#include "command.h"
+#include "prefix.h"
+#include "plist.h"
+
+/* need this to link in libzebra */
+struct thread_master *master;
+
+#define BENCH_DEFAULT_ENTRIES 20000
+#define BENCH_DEFAULT_LOOKUPS 100000
+
+static double
+bench_now (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+bench_report (const char *impl, const char *what, unsigned long ops,
+              double secs)
+{
+  printf ("%-8s %-8s %10lu ops %8.3f s %12.0f ops/s\n",
+          impl, what, ops, secs, secs > 0 ? ops / secs : 0.0);
+}
+
+static void
+bench_random_prefix (struct prefix *p, int prefixlen)
+{
+  memset (p, 0, sizeof (struct prefix));
+  p->family = AF_INET;
+  p->prefixlen = prefixlen;
+  p->u.prefix4.s_addr = htonl ((random () << 1) ^ random ());
+  apply_mask (p);
+}
+
+/* The former prefix_list_apply(). */
+static enum prefix_list_type
+bench_linear (struct orf_prefix *entries, int *permit, int count,
+              struct prefix *p)
+{
+  int i;
+
+  for (i = 0; i < count; i++)
+    {
+      struct orf_prefix *e = &entries[i];
+
+      if (! prefix_match (&e->p, p))
+        continue;
+      if (! e->le && ! e->ge)
+        {
+          if (e->p.prefixlen != p->prefixlen)
+            continue;
+        }
+      else
+        {
+          if (e->le && p->prefixlen > e->le)
+            continue;
+          if (e->ge && p->prefixlen < e->ge)
+            continue;
+        }
+      return permit[i] ? PREFIX_PERMIT : PREFIX_DENY;
+    }
+  return PREFIX_DENY;
+}
+
+int
+main (int argc, char **argv)
+{
+  char name[] = "bench";
+  unsigned long lookups = BENCH_DEFAULT_LOOKUPS;
+  int count = BENCH_DEFAULT_ENTRIES;
+  struct orf_prefix *entries;
+  struct prefix *prefixes;
+  struct prefix_list *plist;
+  enum prefix_list_type *expect;
+  unsigned long idx, permits = 0;
+  int *permit;
+  int i, n, len;
+  double start;
+
+  if (argc > 1)
+    count = atoi (argv[1]);
+  if (argc > 2)
+    lookups = strtoul (argv[2], NULL, 10);
+  if (count <= 0 || lookups == 0)
+    {
+      fprintf (stderr, "usage: %s [entries] [lookups]\n", argv[0]);
+      return 1;
+    }
+
+  srandom (1);
+  entries = calloc (count, sizeof (struct orf_prefix));
+  permit = calloc (count, sizeof (int));
+
+  for (i = 0, n = 0; i < count; i++)
+    {
+      struct orf_prefix *e = &entries[n];
+
+      len = 8 + random () % 17;
+      bench_random_prefix (&e->p, len);
+      e->seq = (n + 1) * 5;
+      switch (random () % 4)
+        {
+        case 0:
+          e->le = len + 1 + random () % (32 - len);
+          break;
+        case 1:
+          e->ge = len + 1 + random () % (32 - len);
+          break;
+        case 2:
+          e->ge = len + 1 + random () % (32 - len);
+          e->le = e->ge + random () % (33 - e->ge);
+          break;
+        }
+      permit[n] = random () % 2;
+
+      if (prefix_bgp_orf_set (name, AFI_IP, e, permit[n], 1) == CMD_SUCCESS)
+        n++;
+    }
+  count = n;
+
+  plist = prefix_list_lookup (AFI_ORF_PREFIX, name);
+  if (plist == NULL || plist->count != count)
+    {
+      printf ("prefix-list has %d entries, expected %d\n",
+              plist ? plist->count : 0, count);
+      return 1;
+    }
+
+  prefixes = calloc (lookups, sizeof (struct prefix));
+  for (idx = 0; idx < lookups; idx++)
+    {
+      if (idx % 2)
+        {
+          bench_random_prefix (&prefixes[idx], 8 + random () % 25);
+          continue;
+        }
+      /* a more specific of an entry */
+      i = random () % count;
+      len = entries[i].p.prefixlen + random () % (33 - entries[i].p.prefixlen);
+      bench_random_prefix (&prefixes[idx], len);
+      prefixes[idx].u.prefix4.s_addr
+        = (entries[i].p.u.prefix4.s_addr
+           & htonl (0xffffffff << (32 - entries[i].p.prefixlen)))
+          | (prefixes[idx].u.prefix4.s_addr
+             & ~htonl (0xffffffff << (32 - entries[i].p.prefixlen)));
+    }
+
+  printf ("%d entries, %lu lookups\n", count, lookups);
+
+  expect = calloc (lookups, sizeof (enum prefix_list_type));
+  start = bench_now ();
+  for (idx = 0; idx < lookups; idx++)
+    expect[idx] = bench_linear (entries, permit, count, &prefixes[idx]);
+  bench_report ("linear", "apply", lookups, bench_now () - start);
+
+  /* the first lookup builds the trie */
+  start = bench_now ();
+  prefix_list_apply (plist, &prefixes[0]);
+  bench_report ("trie", "build", 1, bench_now () - start);
+
+  start = bench_now ();
+  for (idx = 0; idx < lookups; idx++)
+    if (prefix_list_apply (plist, &prefixes[idx]) == PREFIX_PERMIT)
+      permits++;
+  bench_report ("trie", "apply", lookups, bench_now () - start);
+
+  for (idx = 0; idx < lookups; idx++)
+    if (prefix_list_apply (plist, &prefixes[idx]) != expect[idx])
+      {
+        char buf[INET_ADDRSTRLEN];
+
+        printf ("trie and linear walk differ for %s/%d\n",
+                inet_ntop (AF_INET, &prefixes[idx].u.prefix4, buf,
+                           sizeof (buf)),
+                prefixes[idx].prefixlen);
+        return 1;
+      }
+  printf ("%lu permitted, results identical\n", permits);
+
+  prefix_bgp_orf_remove_all (name);
+  free (expect);
+  free (prefixes);
+  free (permit);
+  free (entries);
+  return 0;
+}
@@ -0,0 +1,207 @@
+/*
+ * Route table benchmark
+ *
+ * This file is part of Quagga
+ *
+ * Quagga is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * Quagga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quagga; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Times the operations of a route table on a full-size IPv4 table.
+ *
+ * Usage: tablebench [number of prefixes] [number of lookups]
+ *
+ * The prefixes are random IPv4 prefixes with a length distribution
+ * roughly like that of a full BGP table.  The benchmark times inserting
+ * all of them, exact lookups, longest prefix matches of random
+ * addresses, a full walk and deleting everything again, first on the
+ * patricia tree and then on a trie table.
+ */
+#include <zebra.h>
+
+#include "prefix.h"
+#include "table.h"
+
+/* need this to link in libzebra */
+struct thread_master *master;
+
+#define BENCH_DEFAULT_PREFIXES 1000000
+#define BENCH_DEFAULT_LOOKUPS 1000000
+
+static double
+bench_now (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+bench_report (const char *what, unsigned long ops, double secs)
+{
+  printf ("%-8s %10lu ops %8.3f s %12.0f ops/s\n",
+          what, ops, secs, secs > 0 ? ops / secs : 0.0);
+}
+
+static u_int32_t
+bench_random_addr (void)
+{
+  return (random () << 1) ^ random ();
+}
+
+static void
+bench_random_prefix (struct prefix *p)
+{
+  long r = random () % 100;
+  int prefixlen;
+
+  if (r < 55)
+    prefixlen = 24;
+  else if (r < 90)
+    prefixlen = 16 + random () % 8;
+  else if (r < 97)
+    prefixlen = 8 + random () % 8;
+  else
+    prefixlen = 25 + random () % 8;
+
+  memset (p, 0, sizeof (struct prefix));
+  p->family = AF_INET;
+  p->prefixlen = prefixlen;
+  p->u.prefix4.s_addr = htonl (bench_random_addr ());
+  apply_mask (p);
+}
+
+/* Runs all phases over one table, returns 0 on success. */
+static int
+bench_run (const char *name, struct route_table *(*table_init) (void),
+           struct prefix *prefixes, unsigned long count,
+           struct in_addr *addrs, unsigned long lookups)
+{
+  struct route_table *table;
+  struct route_node *rn;
+  unsigned long i, found = 0, walked = 0;
+  double start;
+
+  printf ("%s:\n", name);
+  table = table_init ();
+
+  start = bench_now ();
+  for (i = 0; i < count; i++)
+    {
+      rn = route_node_get (table, &prefixes[i]);
+      if (rn->info)
+        route_unlock_node (rn);
+      else
+        rn->info = &prefixes[i];
+    }
+  bench_report ("insert", count, bench_now () - start);
+
+  start = bench_now ();
+  for (i = 0; i < lookups; i++)
+    {
+      rn = route_node_lookup (table, &prefixes[i % count]);
+      if (rn)
+        {
+          found++;
+          route_unlock_node (rn);
+        }
+    }
+  bench_report ("lookup", lookups, bench_now () - start);
+  if (found != lookups)
+    {
+      fprintf (stderr, "%lu of %lu lookups failed\n",
+               lookups - found, lookups);
+      return 1;
+    }
+
+  start = bench_now ();
+  for (i = 0; i < lookups; i++)
+    {
+      rn = route_node_match_ipv4 (table, &addrs[i]);
+      if (rn)
+        route_unlock_node (rn);
+    }
+  bench_report ("match", lookups, bench_now () - start);
+
+  start = bench_now ();
+  for (rn = route_top (table); rn; rn = route_next (rn))
+    if (rn->info)
+      walked++;
+  bench_report ("walk", walked, bench_now () - start);
+
+  start = bench_now ();
+  for (i = 0; i < count; i++)
+    {
+      rn = route_node_lookup (table, &prefixes[i]);
+      if (! rn)
+        continue;
+      rn->info = NULL;
+      route_unlock_node (rn);
+      route_unlock_node (rn);
+    }
+  bench_report ("delete", count, bench_now () - start);
+
+  if (route_table_count (table) != 0)
+    {
+      fprintf (stderr, "%lu nodes left\n", route_table_count (table));
+      return 1;
+    }
+  route_table_finish (table);
+
+  return 0;
+}
+
+int
+main (int argc, char **argv)
+{
+  unsigned long count = BENCH_DEFAULT_PREFIXES;
+  unsigned long lookups = BENCH_DEFAULT_LOOKUPS;
+  struct prefix *prefixes;
+  struct in_addr *addrs;
+  unsigned long i;
+  int ret;
+
+  if (argc > 1)
+    count = strtoul (argv[1], NULL, 10);
+  if (argc > 2)
+    lookups = strtoul (argv[2], NULL, 10);
+  if (count == 0)
+    count = 1;
+
+  srandom (1);
+  prefixes = calloc (count, sizeof (struct prefix));
+  addrs = calloc (lookups ? lookups : 1, sizeof (struct in_addr));
+  if (!prefixes || !addrs)
+    {
+      perror ("calloc");
+      return 1;
+    }
+  for (i = 0; i < count; i++)
+    bench_random_prefix (&prefixes[i]);
+  for (i = 0; i < lookups; i++)
+    addrs[i].s_addr = htonl (bench_random_addr ());
+
+  printf ("%lu prefixes, %lu lookups\n", count, lookups);
+  ret = bench_run ("patricia", route_table_init,
+                   prefixes, count, addrs, lookups);
+  if (ret == 0)
+    ret = bench_run ("trie", route_table_init_trie,
+                     prefixes, count, addrs, lookups);
+
+  free (prefixes);
+  free (addrs);
+  return ret;
+}
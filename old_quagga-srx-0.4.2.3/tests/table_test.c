@@ -43,6 +43,21 @@ typedef struct test_node_t_
 
 struct thread_master *master;
 
+/*
+ * Whether the tests run on trie tables rather than on the patricia
+ * tree.
+ */
+static int test_trie;
+
+/*
+ * test_table_init
+ */
+static struct route_table *
+test_table_init (void)
+{
+  return test_trie ? route_table_init_trie () : route_table_init ();
+}
+
 /*
  * add_node
  *
@@ -149,6 +164,7 @@ static void
 print_table (struct route_table *table)
 {
   struct route_node *rn;
+  char buf[INET_ADDRSTRLEN + 4];
 
   rn = table->top;
 
@@ -158,7 +174,20 @@ print_table (struct route_table *table)
       return;
     }
 
-  print_subtree (rn, "Top", 0);
+  if (!table->trie)
+    {
+      print_subtree (rn, "Top", 0);
+      return;
+    }
+
+  /*
+   * A trie table has no links to follow, print the nodes in order.
+   */
+  for (rn = route_top (table); rn; rn = route_next (rn))
+    {
+      prefix2str (&rn->p, buf, sizeof (buf));
+      printf ("Node: %s\n", buf);
+    }
 }
 
 /*
@@ -291,7 +320,7 @@ test_get_next (void)
   struct route_table *table;
 
   printf ("\n\nTesting route_table_get_next()\n");
-  table = route_table_init ();
+  table = test_table_init ();
 
   /*
    * Target exists in tree, but has no successor.
@@ -522,7 +551,7 @@ test_iter_pause (void)
   num_prefixes = sizeof (prefixes) / sizeof (prefixes[0]);
 
   printf ("\n\nTesting that route_table_iter_pause() works as expected\n");
-  table = route_table_init ();
+  table = test_table_init ();
   for (i = 0; i < num_prefixes; i++)
     {
       add_nodes (table, prefixes[i], NULL);
@@ -534,6 +563,211 @@ test_iter_pause (void)
   route_table_finish (table);
 }
 
+/*
+ * random_prefix
+ *
+ * Make a random prefix, the addresses are drawn from a small space so
+ * that the prefixes nest.
+ */
+static void
+random_prefix (struct prefix *p, int family)
+{
+  int bitlen = (family == AF_INET) ? IPV4_MAX_BITLEN : IPV6_MAX_BITLEN;
+  u_char *bytes = &p->u.prefix;
+  int i;
+
+  memset (p, 0, sizeof (struct prefix));
+  p->family = family;
+  p->prefixlen = random () % (bitlen + 1);
+  for (i = 0; i < bitlen / 8; i++)
+    bytes[i] = (i % 4 == 0) ? random () % 4 : random () % 2;
+  apply_mask (p);
+}
+
+/*
+ * verify_same_node
+ *
+ * Check a node of the trie table and one of the patricia table are
+ * for the same prefix.
+ */
+static void
+verify_same_node (struct route_node *trie_rn, struct route_node *rn)
+{
+  assert (!trie_rn == !rn);
+  if (rn)
+    assert (!prefix_cmp (&trie_rn->p, &rn->p));
+}
+
+/*
+ * verify_trie_against_tree
+ *
+ * Check a trie table gives the same answers as a patricia table with
+ * the same prefixes.
+ */
+static void
+verify_trie_against_tree (struct route_table *trie, struct route_table *tree,
+			  int family)
+{
+  struct route_node *trie_rn, *rn, *parent, *trie_match, *match;
+  struct prefix p;
+  unsigned long count = 0;
+  int i;
+
+  /*
+   * Same nodes in the same order, glue nodes of the patricia tree
+   * aside, and the same parents.
+   */
+  trie_rn = route_top (trie);
+  assert (trie_rn == trie->top);
+  for (rn = route_top (tree); rn; rn = route_next (rn))
+    {
+      if (!rn->info)
+	continue;
+
+      verify_same_node (trie_rn, rn);
+      assert (trie_rn->info == rn->info);
+
+      for (parent = route_node_parent (rn); parent && !parent->info;
+	   parent = route_node_parent (parent))
+	;
+      verify_same_node (route_node_parent (trie_rn), parent);
+
+      count++;
+      trie_rn = route_next (trie_rn);
+    }
+  assert (trie_rn == NULL);
+  assert (route_table_count (trie) == count);
+
+  /*
+   * Same matches, lookups and successors.
+   */
+  for (i = 0; i < 1000; i++)
+    {
+      random_prefix (&p, family);
+
+      trie_match = route_node_match (trie, &p);
+      match = route_node_match (tree, &p);
+      verify_same_node (trie_match, match);
+
+      trie_rn = route_node_lookup (trie, &p);
+      rn = route_node_lookup (tree, &p);
+      verify_same_node (trie_rn, rn);
+
+      if (trie_rn)
+	{
+	  assert (trie_rn == trie_match);
+	  route_unlock_node (trie_rn);
+	  route_unlock_node (rn);
+	}
+      if (trie_match)
+	{
+	  route_unlock_node (trie_match);
+	  route_unlock_node (match);
+	}
+
+      trie_rn = route_table_get_next (trie, &p);
+      rn = route_table_get_next (tree, &p);
+      while (rn && !rn->info)
+	{
+	  rn = route_next (rn);
+	}
+      verify_same_node (trie_rn, rn);
+      if (trie_rn)
+	{
+	  route_unlock_node (trie_rn);
+	  route_unlock_node (rn);
+	}
+    }
+}
+
+/*
+ * test_trie_against_tree
+ *
+ * Adds and removes random prefixes from a trie table and a patricia
+ * table, checking they agree along the way.
+ */
+static void
+test_trie_against_tree (int family)
+{
+  struct route_table *trie, *tree;
+  struct route_node *trie_rn, *rn;
+  struct prefix *prefixes;
+  int i, round, num_prefixes = 2000;
+
+  printf ("\n\nTesting trie tables against the patricia tree (%s)\n",
+	  family == AF_INET ? "IPv4" : "IPv6");
+
+  trie = route_table_init_trie ();
+  tree = route_table_init ();
+  prefixes = calloc (num_prefixes, sizeof (struct prefix));
+  assert (prefixes);
+
+  for (round = 0; round < 4; round++)
+    {
+      /*
+       * Add prefixes, then remove about half of them.
+       */
+      for (i = 0; i < num_prefixes; i++)
+	{
+	  random_prefix (&prefixes[i], family);
+	  trie_rn = route_node_get (trie, &prefixes[i]);
+	  rn = route_node_get (tree, &prefixes[i]);
+	  if (rn->info)
+	    {
+	      route_unlock_node (trie_rn);
+	      route_unlock_node (rn);
+	      continue;
+	    }
+	  trie_rn->info = rn->info = &prefixes[i];
+	}
+      verify_trie_against_tree (trie, tree, family);
+
+      for (i = 0; i < num_prefixes; i++)
+	{
+	  if (random () % 2)
+	    continue;
+
+	  trie_rn = route_node_lookup (trie, &prefixes[i]);
+	  rn = route_node_lookup (tree, &prefixes[i]);
+	  verify_same_node (trie_rn, rn);
+	  if (!rn)
+	    continue;
+
+	  trie_rn->info = rn->info = NULL;
+	  route_unlock_node (trie_rn);
+	  route_unlock_node (trie_rn);
+	  route_unlock_node (rn);
+	  route_unlock_node (rn);
+	}
+      verify_trie_against_tree (trie, tree, family);
+    }
+
+  /*
+   * Remove what is left.
+   */
+  for (trie_rn = route_top (trie); trie_rn; trie_rn = route_next (trie_rn))
+    {
+      trie_rn->info = NULL;
+      route_unlock_node (trie_rn);
+    }
+  for (rn = route_top (tree); rn; rn = route_next (rn))
+    {
+      if (!rn->info)
+	continue;
+      rn->info = NULL;
+      route_unlock_node (rn);
+    }
+  verify_trie_against_tree (trie, tree, family);
+
+  assert (route_table_count (trie) == 0);
+  assert (trie->top == NULL);
+
+  route_table_finish (trie);
+  route_table_finish (tree);
+  free (prefixes);
+  printf ("Verified %d rounds of %d prefixes\n", round, num_prefixes);
+}
+
 /*
  * run_tests
  */
@@ -552,4 +786,13 @@ int
 main (void)
 {
   run_tests ();
+
+  printf ("\n\nRunning the tests on trie tables\n");
+  test_trie = 1;
+  run_tests ();
+
+  test_trie_against_tree (AF_INET);
+#ifdef HAVE_IPV6
+  test_trie_against_tree (AF_INET6);
+#endif /* HAVE_IPV6 */
 }
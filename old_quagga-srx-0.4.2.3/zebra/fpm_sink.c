@@ -0,0 +1,259 @@
+/*
+ * Loopback receiver for the zebra FPM interface.
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Stands in for a Forwarding Plane Manager so that the zebra FPM
+ * interface can be benchmarked without an external controller.
+ *
+ * Usage: fpmsink [-p port] [-i interval] [-n routes] [-d usecs]
+ *
+ * The sink listens on the loopback address, accepts one connection from
+ * zebra at a time and decodes the route messages it receives. Every
+ * interval it prints the number of route adds and deletes, the route
+ * rate and the largest gap between two reads. With -n it exits after
+ * the given number of routes and reports the time it took from the
+ * first message; -d sleeps after each read to emulate a slow FPM and
+ * exercise zebra's flow control.
+ */
+#include <zebra.h>
+
+#include "fpm/fpm.h"
+
+#define SINK_BUF_SIZE (64 * FPM_MAX_MSG_LEN)
+
+struct sink_stats
+{
+  unsigned long msgs;
+  unsigned long adds;
+  unsigned long dels;
+  unsigned long others;
+  unsigned long bytes;
+  unsigned long reads;
+  double max_gap;
+};
+
+static double
+sink_now (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Account for one FPM message. */
+static void
+sink_message (struct sink_stats *st, fpm_msg_hdr_t *hdr)
+{
+  st->msgs++;
+
+#ifdef HAVE_NETLINK
+  if (hdr->msg_type == FPM_MSG_TYPE_NETLINK
+      && fpm_msg_data_len (hdr) >= sizeof (struct nlmsghdr))
+    {
+      struct nlmsghdr *n = (struct nlmsghdr *) fpm_msg_data (hdr);
+
+      if (n->nlmsg_type == RTM_NEWROUTE)
+        st->adds++;
+      else if (n->nlmsg_type == RTM_DELROUTE)
+        st->dels++;
+      else
+        st->others++;
+      return;
+    }
+#endif /* HAVE_NETLINK */
+
+  st->others++;
+}
+
+static void
+sink_report (const char *what, struct sink_stats *st, double secs)
+{
+  unsigned long routes = st->adds + st->dels;
+
+  printf ("%-8s %9lu adds %9lu dels %6lu other %11lu bytes %7lu reads "
+          "%10.0f routes/s  max gap %.3f ms\n",
+          what, st->adds, st->dels, st->others, st->bytes, st->reads,
+          secs > 0 ? routes / secs : 0.0, st->max_gap * 1000);
+  fflush (stdout);
+}
+
+/* Read messages from zebra until the connection closes. Returns 1 once
+ * 'limit' routes have been seen. */
+static int
+sink_serve (int sock, double interval, unsigned long limit,
+            unsigned int delay)
+{
+  static unsigned char buf[SINK_BUF_SIZE];
+  struct sink_stats total, ivl;
+  double first = 0, last_read = 0, ivl_start, now;
+  size_t have = 0, len;
+  ssize_t nbyte;
+  fpm_msg_hdr_t *hdr;
+
+  memset (&total, 0, sizeof (total));
+  memset (&ivl, 0, sizeof (ivl));
+  ivl_start = sink_now ();
+
+  while ((nbyte = read (sock, buf + have, sizeof (buf) - have)) != 0)
+    {
+      if (nbyte < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          fprintf (stderr, "read: %s\n", strerror (errno));
+          break;
+        }
+
+      now = sink_now ();
+      if (!first)
+        first = now;
+      else if (now - last_read > ivl.max_gap)
+        ivl.max_gap = now - last_read;
+      last_read = now;
+
+      ivl.reads++;
+      ivl.bytes += nbyte;
+      have += nbyte;
+
+      /* decode all complete messages */
+      hdr = (fpm_msg_hdr_t *) buf;
+      len = have;
+      while (len >= FPM_MSG_HDR_LEN && len >= fpm_msg_len (hdr))
+        {
+          if (!fpm_msg_hdr_ok (hdr))
+            {
+              fprintf (stderr, "invalid FPM message header\n");
+              return 0;
+            }
+          sink_message (&ivl, hdr);
+          hdr = fpm_msg_next (hdr, &len);
+        }
+      if (len)
+        memmove (buf, hdr, len);
+      have = len;
+
+      if (limit && total.adds + total.dels + ivl.adds + ivl.dels >= limit)
+        break;
+
+      if (now - ivl_start >= interval)
+        {
+          sink_report ("ivl", &ivl, now - ivl_start);
+          total.msgs += ivl.msgs;
+          total.adds += ivl.adds;
+          total.dels += ivl.dels;
+          total.others += ivl.others;
+          total.bytes += ivl.bytes;
+          total.reads += ivl.reads;
+          if (ivl.max_gap > total.max_gap)
+            total.max_gap = ivl.max_gap;
+          memset (&ivl, 0, sizeof (ivl));
+          ivl_start = now;
+        }
+
+      if (delay)
+        usleep (delay);
+    }
+
+  total.msgs += ivl.msgs;
+  total.adds += ivl.adds;
+  total.dels += ivl.dels;
+  total.others += ivl.others;
+  total.bytes += ivl.bytes;
+  total.reads += ivl.reads;
+  if (ivl.max_gap > total.max_gap)
+    total.max_gap = ivl.max_gap;
+  sink_report ("total", &total, first ? last_read - first : 0);
+
+  return limit && total.adds + total.dels >= limit;
+}
+
+int
+main (int argc, char **argv)
+{
+  struct sockaddr_in sin;
+  int port = FPM_DEFAULT_PORT;
+  double interval = 1.0;
+  unsigned long limit = 0;
+  unsigned int delay = 0;
+  int lsock, sock, opt, on = 1;
+
+  while ((opt = getopt (argc, argv, "p:i:n:d:")) != -1)
+    switch (opt)
+      {
+      case 'p':
+        port = atoi (optarg);
+        break;
+      case 'i':
+        interval = atof (optarg);
+        break;
+      case 'n':
+        limit = strtoul (optarg, NULL, 10);
+        break;
+      case 'd':
+        delay = strtoul (optarg, NULL, 10);
+        break;
+      default:
+        fprintf (stderr, "usage: %s [-p port] [-i interval] [-n routes] "
+                 "[-d usecs]\n", argv[0]);
+        return 1;
+      }
+
+  lsock = socket (AF_INET, SOCK_STREAM, 0);
+  if (lsock < 0)
+    {
+      perror ("socket");
+      return 1;
+    }
+  setsockopt (lsock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof (on));
+
+  memset (&sin, 0, sizeof (sin));
+  sin.sin_family = AF_INET;
+  sin.sin_port = htons (port);
+#ifdef HAVE_STRUCT_SOCKADDR_IN_SIN_LEN
+  sin.sin_len = sizeof (struct sockaddr_in);
+#endif /* HAVE_STRUCT_SOCKADDR_IN_SIN_LEN */
+  sin.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+
+  if (bind (lsock, (struct sockaddr *) &sin, sizeof (sin)) < 0
+      || listen (lsock, 1) < 0)
+    {
+      perror ("bind");
+      return 1;
+    }
+
+  printf ("waiting for zebra on port %d\n", port);
+  fflush (stdout);
+
+  while ((sock = accept (lsock, NULL, NULL)) >= 0)
+    {
+      int done;
+
+      printf ("zebra connected\n");
+      done = sink_serve (sock, interval, limit, delay);
+      close (sock);
+      if (done)
+        break;
+      printf ("zebra disconnected\n");
+    }
+
+  close (lsock);
+  return 0;
+}
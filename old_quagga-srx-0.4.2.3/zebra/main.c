@@ -40,6 +40,7 @@
 #include "zebra/irdp.h"
 #include "zebra/rtadv.h"
 #include "zebra/zebra_fpm.h"
+#include "zebra/rt_netlink.h"
 
 /* Zebra instance */
 struct zebra_t zebrad =
@@ -170,6 +171,9 @@ sigint (void)
 
   if (!retain_mode)
     rib_close ();
+#ifdef HAVE_NETLINK
+  netlink_batch_sync ();
+#endif /* HAVE_NETLINK */
 #ifdef HAVE_IRDP
   irdp_finish();
 #endif
@@ -74,11 +74,16 @@ struct rib
   /* RIB internal status */
   u_char status;
 #define RIB_ENTRY_REMOVED	(1 << 0)
+#define RIB_ENTRY_RETRIED	(1 << 1)
 
   /* Nexthop information. */
   u_char nexthop_num;
   u_char nexthop_active_num;
   u_char nexthop_fib_num;
+
+  /* Sequence number of the last netlink request for this route, the
+     kernel's answer is matched back by it. */
+  u_int32_t nl_seq;
 };
 
 /* meta-queue structure:
@@ -89,10 +94,26 @@ struct rib
  * sub-queue 4: any other origin (if any)
  */
 #define MQ_SIZE 5
+
+/* Queueing latency histogram buckets: below 1ms, below 2ms, ... below
+ * 1024ms and everything above. */
+#define MQ_HIST_SIZE 12
+
+struct meta_queue_stats
+{
+  unsigned long queued;     /* route_nodes pushed into the sub-queue */
+  unsigned long merged;     /* updates folded into an already queued node */
+  unsigned long processed;  /* rib_process() runs */
+  unsigned long skipped;    /* nodes already processed from another queue */
+  unsigned long max_ms;     /* highest queueing latency seen */
+  unsigned long hist[MQ_HIST_SIZE];
+};
+
 struct meta_queue
 {
   struct list *subq[MQ_SIZE];
   u_int32_t size; /* sum of lengths of all subqueues */
+  struct meta_queue_stats stats[MQ_SIZE];
 };
 
 /*
@@ -117,6 +138,20 @@ typedef struct rib_dest_t_
    */
   u_int32_t flags;
 
+  /*
+   * Update generation, bumped each time the node is handed to the
+   * meta-queue, and the generation last seen by rib_process(). A node
+   * sitting in several sub-queues is processed only once per change.
+   */
+  u_int32_t gen;
+  u_int32_t done_gen;
+
+  /*
+   * Time of the first update since the node was last processed, not
+   * set while no update is pending.
+   */
+  struct timeval queued;
+
   /*
    * Linkage to put dest on the FPM processing queue.
    */
@@ -412,6 +447,7 @@ static_delete_ipv6 (struct prefix *p, u_char type, struct in6_addr *gate,
 #endif /* HAVE_IPV6 */
 
 extern int rib_gc_dest (struct route_node *rn);
+extern void rib_kernel_failed (struct prefix *p, u_int32_t seq);
 extern struct route_table *rib_tables_iter_next (rib_tables_iter_t *iter);
 
 /*
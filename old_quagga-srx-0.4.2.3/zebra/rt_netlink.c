@@ -36,6 +36,8 @@
 #include "rib.h"
 #include "thread.h"
 #include "privs.h"
+#include "command.h"
+#include "vty.h"
 
 #include "zebra/zserv.h"
 #include "zebra/rt.h"
@@ -220,6 +222,9 @@ netlink_request (int family, int type, struct nlsock *nl)
       return -1;
     }
 
+  if (nl == &netlink_cmd)
+    netlink_batch_sync ();
+
   memset (&snl, 0, sizeof snl);
   snl.nl_family = AF_NETLINK;
 
@@ -1291,6 +1296,336 @@ netlink_talk_filter (struct sockaddr_nl *snl, struct nlmsghdr *h)
   return 0;
 }
 
+/* Route changes are not sent one by one.  netlink_batch_add() packs them
+ * into one buffer which is sent with a single sendmsg() NL_BATCH_DELAY
+ * milliseconds after the first one was queued, or as soon as half a
+ * window is queued.  The RIB work queue hands over one route per run, so
+ * the delay is what lets a batch build up.  Every message asks for an
+ * ACK, the ACKs and errors are read from the command socket later on and
+ * matched back to the routes by their sequence number.  At most
+ * NL_BATCH_WINDOW requests are outstanding, the ACKs of a larger window
+ * would overrun the socket receive buffer.
+ */
+#define NL_BATCH_BUF_SIZE (16 * NL_PKT_BUF_SIZE)
+#define NL_BATCH_WINDOW   256
+#define NL_BATCH_DELAY    5
+
+struct nl_batch_req
+{
+  u_int32_t seq;
+  u_int16_t cmd;
+  u_char used;
+  u_char sent;
+  struct prefix p;
+};
+
+static struct
+{
+  char buf[NL_BATCH_BUF_SIZE];
+  size_t len;
+
+  /* Requests in buf or waiting for their ACK, indexed by seq. */
+  struct nl_batch_req req[NL_BATCH_WINDOW];
+  unsigned int pending;
+  unsigned int queued;
+
+  struct thread *t_flush;
+  struct thread *t_read;
+
+  /* Statistics. */
+  unsigned long batches;
+  unsigned long msgs;
+  unsigned long acks;
+  unsigned long errors;
+  unsigned long window_full;
+  unsigned long lost;
+  unsigned int max_pending;
+} nl_batch;
+
+static int netlink_batch_read_thread (struct thread *);
+
+/* The kernel answered request SEQ, ERROR is 0 for an ACK. */
+static void
+netlink_batch_done (u_int32_t seq, int error)
+{
+  struct nl_batch_req *req = &nl_batch.req[seq % NL_BATCH_WINDOW];
+  char buf[BUFSIZ];
+
+  if (! req->used || req->seq != seq)
+    {
+      zlog_warn ("%s: unexpected answer, seq=%u", netlink_cmd.name, seq);
+      return;
+    }
+  req->used = 0;
+  nl_batch.pending--;
+  nl_batch.acks++;
+
+  if (! error)
+    return;
+
+  prefix2str (&req->p, buf, sizeof buf);
+
+  /* Races in link handling, see netlink_parse_info(). */
+  if ((req->cmd == RTM_DELROUTE && (error == ENODEV || error == ESRCH))
+      || (req->cmd == RTM_NEWROUTE && error == EEXIST))
+    {
+      if (IS_ZEBRA_DEBUG_KERNEL)
+	zlog_debug ("%s: error: %s type=%s(%u), seq=%u, %s",
+		    netlink_cmd.name, safe_strerror (error),
+		    lookup (nlmsg_str, req->cmd), req->cmd, seq, buf);
+      return;
+    }
+
+  nl_batch.errors++;
+  zlog_err ("%s error: %s, type=%s(%u), seq=%u, %s",
+	    netlink_cmd.name, safe_strerror (error),
+	    lookup (nlmsg_str, req->cmd), req->cmd, seq, buf);
+
+  if (req->cmd != RTM_NEWROUTE)
+    return;
+
+  rib_kernel_failed (&req->p, seq);
+}
+
+/* Forget the requests which were sent, their answers are lost. */
+static void
+netlink_batch_reset (void)
+{
+  int i;
+
+  for (i = 0; i < NL_BATCH_WINDOW; i++)
+    if (nl_batch.req[i].used && nl_batch.req[i].sent)
+      {
+	nl_batch.req[i].used = 0;
+	nl_batch.pending--;
+	nl_batch.lost++;
+      }
+}
+
+/* Read the answers available on the command socket, waiting for at least
+   one if BLOCK is set. */
+static void
+netlink_batch_read (int block)
+{
+  char buf[NL_PKT_BUF_SIZE];
+  struct iovec iov = { buf, sizeof buf };
+  struct sockaddr_nl snl;
+  struct msghdr msg = { (void *) &snl, sizeof snl, &iov, 1, NULL, 0, 0 };
+  struct nlmsghdr *h;
+  struct nlmsgerr *err;
+  int status;
+
+  while (nl_batch.pending)
+    {
+      status = recvmsg (netlink_cmd.sock, &msg, block ? 0 : MSG_DONTWAIT);
+      if (status < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  if (errno == EWOULDBLOCK || errno == EAGAIN)
+	    return;
+	  zlog_err ("%s recvmsg overrun: %s", netlink_cmd.name,
+		    safe_strerror (errno));
+	  if (errno == ENOBUFS)
+	    netlink_batch_reset ();
+	  return;
+	}
+      if (status == 0)
+	{
+	  zlog_err ("%s EOF", netlink_cmd.name);
+	  netlink_batch_reset ();
+	  return;
+	}
+
+      for (h = (struct nlmsghdr *) buf; NLMSG_OK (h, (unsigned int) status);
+	   h = NLMSG_NEXT (h, status))
+	{
+	  if (h->nlmsg_type != NLMSG_ERROR)
+	    {
+	      netlink_talk_filter (&snl, h);
+	      continue;
+	    }
+	  if (h->nlmsg_len < NLMSG_LENGTH (sizeof (struct nlmsgerr)))
+	    {
+	      zlog_err ("%s error: message truncated", netlink_cmd.name);
+	      continue;
+	    }
+	  err = (struct nlmsgerr *) NLMSG_DATA (h);
+	  netlink_batch_done (err->msg.nlmsg_seq, -err->error);
+	}
+
+      /* Got something, do not wait any longer. */
+      block = 0;
+    }
+}
+
+/* Send the requests collected in the buffer. */
+static void
+netlink_batch_send (void)
+{
+  struct sockaddr_nl snl;
+  struct iovec iov = { nl_batch.buf, nl_batch.len };
+  struct msghdr msg = { (void *) &snl, sizeof snl, &iov, 1, NULL, 0, 0 };
+  int status;
+  int save_errno;
+  int i;
+
+  if (nl_batch.len == 0)
+    return;
+
+  memset (&snl, 0, sizeof snl);
+  snl.nl_family = AF_NETLINK;
+
+  /* linux checks the capabilities once per sendmsg(), not per message */
+  if (zserv_privs.change (ZPRIVS_RAISE))
+    zlog (NULL, LOG_ERR, "Can't raise privileges");
+  status = sendmsg (netlink_cmd.sock, &msg, 0);
+  save_errno = errno;
+  if (zserv_privs.change (ZPRIVS_LOWER))
+    zlog (NULL, LOG_ERR, "Can't lower privileges");
+
+  nl_batch.len = 0;
+  nl_batch.queued = 0;
+  nl_batch.batches++;
+
+  if (nl_batch.t_flush)
+    {
+      thread_cancel (nl_batch.t_flush);
+      nl_batch.t_flush = NULL;
+    }
+
+  for (i = 0; i < NL_BATCH_WINDOW; i++)
+    if (nl_batch.req[i].used && ! nl_batch.req[i].sent)
+      {
+	if (status < 0)
+	  netlink_batch_done (nl_batch.req[i].seq, save_errno);
+	else
+	  nl_batch.req[i].sent = 1;
+      }
+
+  if (status < 0)
+    {
+      zlog (NULL, LOG_ERR, "netlink_batch_send sendmsg() error: %s",
+	    safe_strerror (save_errno));
+      return;
+    }
+
+  if (nl_batch.pending && ! nl_batch.t_read)
+    nl_batch.t_read = thread_add_read (zebrad.master,
+				       netlink_batch_read_thread, NULL,
+				       netlink_cmd.sock);
+}
+
+static int
+netlink_batch_flush_thread (struct thread *thread)
+{
+  nl_batch.t_flush = NULL;
+  netlink_batch_send ();
+  return 0;
+}
+
+static int
+netlink_batch_read_thread (struct thread *thread)
+{
+  nl_batch.t_read = NULL;
+  netlink_batch_read (0);
+  if (nl_batch.pending && ! nl_batch.t_read)
+    nl_batch.t_read = thread_add_read (zebrad.master,
+				       netlink_batch_read_thread, NULL,
+				       netlink_cmd.sock);
+  return 0;
+}
+
+/* Queue a route change for the kernel.  P is the route's prefix, used to
+   find the rib again when the kernel refuses it. */
+static int
+netlink_batch_add (struct nlmsghdr *n, struct prefix *p, struct rib *rib)
+{
+  struct nl_batch_req *req;
+
+  if (nl_batch.pending >= NL_BATCH_WINDOW)
+    {
+      nl_batch.window_full++;
+      netlink_batch_send ();
+      while (nl_batch.pending >= NL_BATCH_WINDOW)
+	netlink_batch_read (1);
+    }
+
+  if (nl_batch.len + NLMSG_ALIGN (n->nlmsg_len) > NL_BATCH_BUF_SIZE
+      || nl_batch.queued >= NL_BATCH_WINDOW / 2)
+    netlink_batch_send ();
+
+  n->nlmsg_seq = ++netlink_cmd.seq;
+  n->nlmsg_flags |= NLM_F_ACK;
+  rib->nl_seq = n->nlmsg_seq;
+
+  if (IS_ZEBRA_DEBUG_KERNEL)
+    zlog_debug ("netlink_batch_add: %s type %s(%u), seq=%u", netlink_cmd.name,
+		lookup (nlmsg_str, n->nlmsg_type), n->nlmsg_type,
+		n->nlmsg_seq);
+
+  memcpy (nl_batch.buf + nl_batch.len, n, n->nlmsg_len);
+  nl_batch.len += NLMSG_ALIGN (n->nlmsg_len);
+
+  req = &nl_batch.req[n->nlmsg_seq % NL_BATCH_WINDOW];
+  req->seq = n->nlmsg_seq;
+  req->cmd = n->nlmsg_type;
+  req->used = 1;
+  req->sent = 0;
+  prefix_copy (&req->p, p);
+
+  nl_batch.msgs++;
+  nl_batch.pending++;
+  nl_batch.queued++;
+  if (nl_batch.pending > nl_batch.max_pending)
+    nl_batch.max_pending = nl_batch.pending;
+
+  if (! nl_batch.t_flush)
+    nl_batch.t_flush = thread_add_timer_msec (zebrad.master,
+					      netlink_batch_flush_thread,
+					      NULL, NL_BATCH_DELAY);
+  return 0;
+}
+
+/* Send all queued route changes and wait for the kernel's answers.  Must
+   be done before anything else uses the command socket, and before
+   exiting. */
+void
+netlink_batch_sync (void)
+{
+  if (netlink_cmd.sock < 0)
+    return;
+
+  netlink_batch_send ();
+  while (nl_batch.pending)
+    netlink_batch_read (1);
+}
+
+DEFUN (show_zebra_netlink_stats,
+       show_zebra_netlink_stats_cmd,
+       "show zebra netlink stats",
+       SHOW_STR
+       "Zebra information\n"
+       "Kernel netlink interface\n"
+       "Statistics\n")
+{
+  vty_out (vty, "%-40s %10lu%s", "Batches sent", nl_batch.batches,
+	   VTY_NEWLINE);
+  vty_out (vty, "%-40s %10lu%s", "Route messages", nl_batch.msgs,
+	   VTY_NEWLINE);
+  vty_out (vty, "%-40s %10lu%s", "Answers", nl_batch.acks, VTY_NEWLINE);
+  vty_out (vty, "%-40s %10lu%s", "Errors", nl_batch.errors, VTY_NEWLINE);
+  vty_out (vty, "%-40s %10lu%s", "Lost answers", nl_batch.lost,
+	   VTY_NEWLINE);
+  vty_out (vty, "%-40s %10u%s", "Outstanding requests", nl_batch.pending,
+	   VTY_NEWLINE);
+  vty_out (vty, "%-40s %10u%s", "Max outstanding requests",
+	   nl_batch.max_pending, VTY_NEWLINE);
+  vty_out (vty, "%-40s %10lu%s", "Waits for a full window",
+	   nl_batch.window_full, VTY_NEWLINE);
+  return CMD_SUCCESS;
+}
+
 /* sendmsg() to netlink socket then recvmsg(). */
 static int
 netlink_talk (struct nlmsghdr *n, struct nlsock *nl)
@@ -1304,6 +1639,10 @@ netlink_talk (struct nlmsghdr *n, struct nlsock *nl)
   memset (&snl, 0, sizeof snl);
   snl.nl_family = AF_NETLINK;
 
+  /* The answer must not be mixed up with those of queued routes. */
+  if (nl == &netlink_cmd)
+    netlink_batch_sync ();
+
   n->nlmsg_seq = ++nl->seq;
 
   /* Request an acknowledgement by setting NLM_F_ACK */
@@ -1834,8 +2173,8 @@ skip:
   memset (&snl, 0, sizeof snl);
   snl.nl_family = AF_NETLINK;
 
-  /* Talk to netlink socket. */
-  return netlink_talk (&req.n, &netlink_cmd);
+  /* Queue for the netlink socket. */
+  return netlink_batch_add (&req.n, p, rib);
 }
 
 int
@@ -1993,6 +2332,23 @@ kernel_init (void)
   netlink_socket (&netlink, groups);
   netlink_socket (&netlink_cmd, 0);
 
+  if (netlink_cmd.sock > 0)
+    {
+#ifdef NETLINK_CAP_ACK
+      int one = 1;
+
+      /* Errors need not carry a copy of the whole request. */
+      setsockopt (netlink_cmd.sock, SOL_NETLINK, NETLINK_CAP_ACK,
+		  &one, sizeof one);
+#endif /* NETLINK_CAP_ACK */
+
+      /* The answers of a full batch window queue up in there. */
+      if (nl_rcvbufsize)
+	netlink_recvbuf (&netlink_cmd, nl_rcvbufsize);
+    }
+
+  install_element (ENABLE_NODE, &show_zebra_netlink_stats_cmd);
+
   /* Register kernel socket. */
   if (netlink.sock > 0)
     {
@@ -40,6 +40,8 @@ nl_msg_type_to_str (uint16_t msg_type);
 extern const char *
 nl_rtproto_to_str (u_char rtproto);
 
+extern void netlink_batch_sync (void);
+
 
 #endif /* HAVE_NETLINK */
 
@@ -0,0 +1,192 @@
+/* Test of the RIB handling of a route the kernel refused.
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "command.h"
+#include "thread.h"
+#include "prefix.h"
+#include "table.h"
+#include "workqueue.h"
+#include "log.h"
+#include "memory.h"
+
+#include "zebra/rib.h"
+#include "zebra/zserv.h"
+#include "zebra/rt.h"
+#include "zebra/connected.h"
+
+struct zebra_t zebrad =
+{
+  .rtm_table_default = 0,
+};
+
+struct thread_master *master;
+
+/* The kernel methods record the install like netlink does: the request
+ * gets a sequence number and the nexthops are flagged as in the FIB
+ * before the kernel answered. */
+static u_int32_t test_seq;
+static int test_installs;
+
+int
+kernel_add_ipv4 (struct prefix *p, struct rib *rib)
+{
+  struct nexthop *nexthop;
+
+  rib->nl_seq = ++test_seq;
+  for (nexthop = rib->nexthop; nexthop; nexthop = nexthop->next)
+    SET_FLAG (nexthop->flags, NEXTHOP_FLAG_FIB);
+  test_installs++;
+  return 0;
+}
+
+int
+kernel_delete_ipv4 (struct prefix *p, struct rib *rib)
+{
+  struct nexthop *nexthop;
+
+  for (nexthop = rib->nexthop; nexthop; nexthop = nexthop->next)
+    UNSET_FLAG (nexthop->flags, NEXTHOP_FLAG_FIB);
+  return 0;
+}
+
+int kernel_add_ipv6 (struct prefix *a, struct rib *b) { return 0; }
+int kernel_delete_ipv6 (struct prefix *a, struct rib *b) { return 0; }
+
+int kernel_delete_ipv6_old (struct prefix_ipv6 *dest, struct in6_addr *gate,
+                            unsigned int index, int flags, int table)
+{ return 0; }
+
+int kernel_add_route (struct prefix_ipv4 *a, struct in_addr *b, int c, int d)
+{ return 0; }
+
+int kernel_address_add_ipv4 (struct interface *a, struct connected *b)
+{ return 0; }
+int kernel_address_delete_ipv4 (struct interface *a, struct connected *b)
+{ return 0; }
+
+void kernel_init (void) { return; }
+void route_read (void) { return; }
+
+/* Run the RIB work queue until it is empty. */
+static void
+run_queue (void)
+{
+  struct thread thread;
+
+  while (zebrad.ribq->items->count)
+    if (thread_fetch (zebrad.master, &thread))
+      thread_call (&thread);
+}
+
+static struct rib *
+lookup_rib (safi_t safi, struct prefix_ipv4 *p)
+{
+  struct route_node *rn;
+  struct rib *rib;
+
+  rn = route_node_lookup (vrf_table (AFI_IP, safi, 0), (struct prefix *) p);
+  assert (rn);
+  RNODE_FOREACH_RIB (rn, rib)
+    if (! CHECK_FLAG (rib->status, RIB_ENTRY_REMOVED))
+      break;
+  route_unlock_node (rn);
+  assert (rib);
+  return rib;
+}
+
+static int
+rib_in_fib (struct rib *rib)
+{
+  struct nexthop *nexthop;
+
+  for (nexthop = rib->nexthop; nexthop; nexthop = nexthop->next)
+    if (CHECK_FLAG (nexthop->flags, NEXTHOP_FLAG_FIB))
+      return 1;
+  return 0;
+}
+
+/*
+ * test_failed_install
+ *
+ * A refused install clears the FIB flags and requeues the node, the
+ * route is installed once more.  A second failure is not retried.
+ */
+static void
+test_failed_install (safi_t safi, const char *str)
+{
+  struct prefix_ipv4 p;
+  struct rib *rib;
+  int installs;
+
+  printf ("Testing failed install of %s in %s table\n", str,
+	  safi == SAFI_UNICAST ? "unicast" : "multicast");
+
+  assert (str2prefix_ipv4 (str, &p));
+  rib = XCALLOC (MTYPE_RIB, sizeof (struct rib));
+  rib->type = ZEBRA_ROUTE_STATIC;
+  rib->distance = 1;
+  rib->uptime = time (NULL);
+  nexthop_blackhole_add (rib);
+  rib_add_ipv4_multipath (&p, rib, safi);
+  installs = test_installs;
+  run_queue ();
+  assert (test_installs == installs + 1);
+
+  rib = lookup_rib (safi, &p);
+  assert (rib_in_fib (rib));
+
+  /* An answer for an older request does not touch the route. */
+  rib_kernel_failed ((struct prefix *) &p, rib->nl_seq - 1);
+  assert (rib_in_fib (rib));
+  assert (zebrad.ribq->items->count == 0);
+
+  /* The route is retried... */
+  rib_kernel_failed ((struct prefix *) &p, rib->nl_seq);
+  assert (! rib_in_fib (rib));
+  assert (zebrad.ribq->items->count == 1);
+  run_queue ();
+  assert (test_installs == installs + 2);
+  assert (rib_in_fib (rib));
+
+  /* ...but only once. */
+  rib_kernel_failed ((struct prefix *) &p, rib->nl_seq);
+  assert (! rib_in_fib (rib));
+  assert (zebrad.ribq->items->count == 0);
+  assert (test_installs == installs + 2);
+}
+
+int
+main (void)
+{
+  master = zebrad.master = thread_master_create ();
+  cmd_init (1);
+  rib_init ();
+  zebrad.ribq->spec.hold = 0;
+
+  /* The same prefix in both tables, the answer must find the route of
+     the table it was installed from. */
+  test_failed_install (SAFI_UNICAST, "10.0.0.0/24");
+  test_failed_install (SAFI_MULTICAST, "10.0.0.0/24");
+
+  printf ("OK\n");
+  return 0;
+}
@@ -36,6 +36,12 @@
 #include "zebra_fpm.h"
 #include "zebra_fpm_private.h"
 
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#include <poll.h>
+#include <sys/uio.h>
+#endif /* HAVE_LIBPTHREAD */
+
 /*
  * Interval at which we attempt to connect to the FPM.
  */
@@ -59,6 +65,27 @@
  */
 #define ZFPM_STATS_IVL_SECS        10
 
+#ifdef HAVE_LIBPTHREAD
+/*
+ * The writer thread gets encoded messages from the main thread in
+ * chunks of this size. The number of chunks (a power of two) bounds
+ * the amount of data queued towards the FPM.
+ */
+#define ZFPM_CHUNK_SIZE  (16 * FPM_MAX_MSG_LEN)
+#define ZFPM_NUM_CHUNKS  64
+
+/*
+ * The maximum number of chunks handed to one writev() call.
+ */
+#define ZFPM_MAX_IOV     16
+
+/*
+ * Milliseconds the writer thread waits for the socket to become
+ * writable before checking whether it should stop.
+ */
+#define ZFPM_WRITER_POLL_MSECS 100
+#endif /* HAVE_LIBPTHREAD */
+
 /*
  * Structure that holds state for iterating over all route_node
  * structures that are candidates for being communicated to the FPM.
@@ -105,8 +132,112 @@ typedef struct zfpm_stats_t_ {
   unsigned long t_conn_up_aborts;
   unsigned long t_conn_up_finishes;
 
+  /*
+   * Writer thread counters, folded in from the writer by
+   * zfpm_writer_fold().
+   */
+  unsigned long writer_chunks;
+  unsigned long writer_bytes;
+  unsigned long writer_socket_waits;
+  unsigned long writer_latency_usecs;
+  unsigned long writer_stalls;
+
 } zfpm_stats_t;
 
+#ifdef HAVE_LIBPTHREAD
+/*
+ * A buffer of encoded FPM messages on its way to the writer thread.
+ */
+typedef struct zfpm_chunk_t_
+{
+  struct stream *s;
+
+  /*
+   * Time at which the main thread handed the chunk to the writer.
+   */
+  struct timeval sealed;
+} zfpm_chunk_t;
+
+/*
+ * Single producer, single consumer ring of chunks. 'tail' is only
+ * written by the producer and 'head' only by the consumer.
+ */
+typedef struct zfpm_ring_t_
+{
+  zfpm_chunk_t *slot[ZFPM_NUM_CHUNKS];
+  unsigned long head;
+  unsigned long tail;
+} zfpm_ring_t;
+
+/*
+ * State of the writer thread.
+ *
+ * Routes are still encoded on the main thread, as the RIB is not
+ * thread safe, but the socket writes happen on a thread of their
+ * own. Filled chunks travel to the writer on the 'full' ring, written
+ * chunks come back on the 'free' ring.
+ */
+typedef struct zfpm_writer_t_
+{
+  int running;
+  pthread_t thread;
+
+  zfpm_chunk_t chunks[ZFPM_NUM_CHUNKS];
+  zfpm_ring_t full;
+  zfpm_ring_t free;
+
+  /*
+   * Chunk the main thread is currently filling. It is handed over
+   * when it is full, or as soon as the writer has nothing else to do.
+   */
+  zfpm_chunk_t *fill;
+
+  /*
+   * The writer sleeps on 'cond' when there is nothing to write.
+   */
+  pthread_mutex_t mtx;
+  pthread_cond_t cond;
+  int sleeping;
+  int stop;
+
+  /*
+   * Set by the main thread when it runs out of free chunks, or when
+   * it holds back a partially filled chunk. The writer then pokes
+   * 'notify' once it has freed a chunk, or has written everything.
+   */
+  int want_free;
+  int want_idle;
+
+  /*
+   * errno of a failed write, reported through 'notify' as well.
+   */
+  int error;
+
+  int notify[2];
+  struct thread *t_notify;
+
+  /*
+   * Counters maintained by the writer, and the values that have
+   * already been folded into the main statistics.
+   */
+  unsigned long chunks_done;
+  unsigned long bytes;
+  unsigned long writev_calls;
+  unsigned long partial_writes;
+  unsigned long socket_waits;
+  unsigned long latency_usecs;
+  unsigned long latency_max_usecs;
+  struct {
+    unsigned long chunks_done;
+    unsigned long bytes;
+    unsigned long writev_calls;
+    unsigned long partial_writes;
+    unsigned long socket_waits;
+    unsigned long latency_usecs;
+  } folded;
+} zfpm_writer_t;
+#endif /* HAVE_LIBPTHREAD */
+
 /*
  * States for the FPM state machine.
  */
@@ -231,6 +362,13 @@ typedef struct zfpm_glob_t_
    */
   time_t last_stats_clear_time;
 
+#ifdef HAVE_LIBPTHREAD
+  /*
+   * Thread writing to the FPM socket.
+   */
+  zfpm_writer_t writer;
+#endif /* HAVE_LIBPTHREAD */
+
 } zfpm_glob_t;
 
 static zfpm_glob_t zfpm_glob_space;
@@ -243,6 +381,12 @@ static void zfpm_set_state (zfpm_state_t state, const char *reason);
 static void zfpm_start_connect_timer (const char *reason);
 static void zfpm_start_stats_timer (void);
 
+#ifdef HAVE_LIBPTHREAD
+static void zfpm_writer_start (void);
+static void zfpm_writer_stop (void);
+static void zfpm_writer_fold (void);
+#endif /* HAVE_LIBPTHREAD */
+
 /*
  * zfpm_thread_should_yield
  */
@@ -493,6 +637,20 @@ zfpm_write_on (void)
   assert (!zfpm_g->t_write);
   assert (zfpm_g->sock >= 0);
 
+#ifdef HAVE_LIBPTHREAD
+  /*
+   * The writer thread owns the socket, we only need to run to fill
+   * chunks for it. Doing so in the background lets updates accumulate
+   * while the RIB is being processed.
+   */
+  if (zfpm_g->writer.running)
+    {
+      zfpm_g->t_write = thread_add_background (zfpm_g->master,
+					       zfpm_write_cb, 0, 0);
+      return;
+    }
+#endif /* HAVE_LIBPTHREAD */
+
   THREAD_WRITE_ON (zfpm_g->master, zfpm_g->t_write, zfpm_write_cb, 0,
 		   zfpm_g->sock);
 }
@@ -581,6 +739,9 @@ zfpm_connection_up (const char *detail)
 {
   assert (zfpm_g->sock >= 0);
   zfpm_read_on ();
+#ifdef HAVE_LIBPTHREAD
+  zfpm_writer_start ();
+#endif
   zfpm_write_on ();
   zfpm_set_state (ZFPM_STATE_ESTABLISHED, detail);
 
@@ -716,6 +877,10 @@ zfpm_connection_down (const char *detail)
   zfpm_read_off ();
   zfpm_write_off ();
 
+#ifdef HAVE_LIBPTHREAD
+  zfpm_writer_stop ();
+#endif
+
   stream_reset (zfpm_g->ibuf);
   stream_reset (zfpm_g->obuf);
 
@@ -904,13 +1069,12 @@ zfpm_route_for_update (rib_dest_t *dest)
 /*
  * zfpm_build_updates
  *
- * Process the outgoing queue and write messages to the outbound
+ * Process the outgoing queue and append messages to the given
  * buffer.
  */
 static void
-zfpm_build_updates (void)
+zfpm_build_updates (struct stream *s)
 {
-  struct stream *s;
   rib_dest_t *dest;
   unsigned char *buf, *data, *buf_end;
   size_t msg_len;
@@ -919,10 +1083,6 @@ zfpm_build_updates (void)
   struct rib *rib;
   int is_add, write_msg;
 
-  s = zfpm_g->obuf;
-
-  assert (stream_empty (s));
-
   do {
 
     /*
@@ -1003,6 +1163,502 @@ zfpm_build_updates (void)
 
 }
 
+#ifdef HAVE_LIBPTHREAD
+
+/*
+ * zfpm_ring_push
+ *
+ * Called by the producer side of the ring only.
+ */
+static inline void
+zfpm_ring_push (zfpm_ring_t *ring, zfpm_chunk_t *chunk)
+{
+  unsigned long tail;
+
+  tail = __atomic_load_n (&ring->tail, __ATOMIC_RELAXED);
+  assert (tail - __atomic_load_n (&ring->head, __ATOMIC_ACQUIRE)
+	  < ZFPM_NUM_CHUNKS);
+
+  ring->slot[tail % ZFPM_NUM_CHUNKS] = chunk;
+  __atomic_store_n (&ring->tail, tail + 1, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * zfpm_ring_peek
+ *
+ * Returns the chunk at the given offset from the head of the ring,
+ * or NULL if there is no such chunk. Called by the consumer only.
+ */
+static inline zfpm_chunk_t *
+zfpm_ring_peek (zfpm_ring_t *ring, unsigned long offset)
+{
+  unsigned long head;
+
+  head = __atomic_load_n (&ring->head, __ATOMIC_RELAXED);
+  if (__atomic_load_n (&ring->tail, __ATOMIC_SEQ_CST) - head <= offset)
+    return NULL;
+
+  return ring->slot[(head + offset) % ZFPM_NUM_CHUNKS];
+}
+
+/*
+ * zfpm_ring_empty
+ */
+static inline int
+zfpm_ring_empty (zfpm_ring_t *ring)
+{
+  return (__atomic_load_n (&ring->head, __ATOMIC_SEQ_CST)
+	  == __atomic_load_n (&ring->tail, __ATOMIC_SEQ_CST));
+}
+
+/*
+ * zfpm_ring_pop
+ *
+ * Called by the consumer side of the ring only.
+ */
+static inline zfpm_chunk_t *
+zfpm_ring_pop (zfpm_ring_t *ring)
+{
+  zfpm_chunk_t *chunk;
+
+  chunk = zfpm_ring_peek (ring, 0);
+  if (chunk)
+    __atomic_store_n (&ring->head, ring->head + 1, __ATOMIC_SEQ_CST);
+
+  return chunk;
+}
+
+/*
+ * zfpm_writer_gettime
+ *
+ * Monotonic time that is safe to take on the writer thread, unlike
+ * quagga_gettime() which updates the library's cached time.
+ */
+static inline void
+zfpm_writer_gettime (struct timeval *tv)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  tv->tv_sec = ts.tv_sec;
+  tv->tv_usec = ts.tv_nsec / 1000;
+}
+
+/*
+ * zfpm_writer_notify
+ *
+ * Wake up the main thread. Called on the writer thread.
+ */
+static void
+zfpm_writer_notify (zfpm_writer_t *w)
+{
+  char c = 0;
+
+  /*
+   * If the pipe is full the main thread has a wakeup pending anyway.
+   */
+  if (write (w->notify[1], &c, 1) < 0)
+    return;
+}
+
+/*
+ * zfpm_writer_wait_chunk
+ *
+ * Block until the main thread hands over a chunk, or until the writer
+ * is told to stop. Returns FALSE in the latter case.
+ */
+static int
+zfpm_writer_wait_chunk (zfpm_writer_t *w)
+{
+  int ready;
+
+  if (zfpm_ring_peek (&w->full, 0))
+    return 1;
+
+  /*
+   * Announce that we are going to sleep before looking at the ring
+   * again, so that either we see the new chunk or the main thread
+   * sees the flag and signals us.
+   */
+  __atomic_store_n (&w->sleeping, 1, __ATOMIC_SEQ_CST);
+
+  pthread_mutex_lock (&w->mtx);
+  while (!(ready = (zfpm_ring_peek (&w->full, 0) != NULL))
+	 && !__atomic_load_n (&w->stop, __ATOMIC_SEQ_CST))
+    pthread_cond_wait (&w->cond, &w->mtx);
+  pthread_mutex_unlock (&w->mtx);
+
+  __atomic_store_n (&w->sleeping, 0, __ATOMIC_SEQ_CST);
+  return ready;
+}
+
+/*
+ * zfpm_writer_complete
+ *
+ * Account for 'written' bytes taken out of the chunks at the head of
+ * the full ring, moving chunks that are done to the free ring.
+ */
+static void
+zfpm_writer_complete (zfpm_writer_t *w, size_t written)
+{
+  zfpm_chunk_t *chunk;
+  struct timeval now;
+  unsigned long usecs;
+  size_t left;
+  int freed = 0, notify;
+
+  zfpm_writer_gettime (&now);
+
+  while (written && (chunk = zfpm_ring_peek (&w->full, 0)))
+    {
+      left = stream_get_endp (chunk->s) - stream_get_getp (chunk->s);
+      if (written < left)
+	{
+	  stream_forward_getp (chunk->s, written);
+	  __atomic_add_fetch (&w->partial_writes, 1, __ATOMIC_RELAXED);
+	  break;
+	}
+
+      written -= left;
+
+      usecs = (now.tv_sec - chunk->sealed.tv_sec) * 1000000
+	+ (now.tv_usec - chunk->sealed.tv_usec);
+      __atomic_add_fetch (&w->latency_usecs, usecs, __ATOMIC_RELAXED);
+      if (usecs > __atomic_load_n (&w->latency_max_usecs, __ATOMIC_RELAXED))
+	__atomic_store_n (&w->latency_max_usecs, usecs, __ATOMIC_RELAXED);
+      __atomic_add_fetch (&w->chunks_done, 1, __ATOMIC_RELAXED);
+
+      zfpm_ring_pop (&w->full);
+      stream_reset (chunk->s);
+      zfpm_ring_push (&w->free, chunk);
+      freed = 1;
+    }
+
+  if (!freed)
+    return;
+
+  notify = __atomic_exchange_n (&w->want_free, 0, __ATOMIC_SEQ_CST);
+  if (zfpm_ring_empty (&w->full)
+      && __atomic_exchange_n (&w->want_idle, 0, __ATOMIC_SEQ_CST))
+    notify = 1;
+
+  if (notify)
+    zfpm_writer_notify (w);
+}
+
+/*
+ * zfpm_writer_thread
+ *
+ * Main loop of the writer thread: hand all queued chunks to the
+ * kernel in as few writev() calls as possible.
+ */
+static void *
+zfpm_writer_thread (void *arg)
+{
+  zfpm_writer_t *w = arg;
+  struct iovec iov[ZFPM_MAX_IOV];
+  struct pollfd pfd;
+  zfpm_chunk_t *chunk;
+  ssize_t nbyte;
+  int cnt;
+
+  pfd.fd = zfpm_g->sock;
+  pfd.events = POLLOUT;
+
+  while (zfpm_writer_wait_chunk (w))
+    {
+      for (cnt = 0; cnt < ZFPM_MAX_IOV; cnt++)
+	{
+	  if (!(chunk = zfpm_ring_peek (&w->full, cnt)))
+	    break;
+
+	  iov[cnt].iov_base = STREAM_PNT (chunk->s);
+	  iov[cnt].iov_len = stream_get_endp (chunk->s)
+	    - stream_get_getp (chunk->s);
+	}
+
+      nbyte = writev (pfd.fd, iov, cnt);
+      __atomic_add_fetch (&w->writev_calls, 1, __ATOMIC_RELAXED);
+
+      if (nbyte < 0)
+	{
+	  if (!ERRNO_IO_RETRY (errno))
+	    {
+	      __atomic_store_n (&w->error, errno, __ATOMIC_SEQ_CST);
+	      zfpm_writer_notify (w);
+	      break;
+	    }
+
+	  /*
+	   * The FPM does not keep up, wait for the socket to drain.
+	   */
+	  __atomic_add_fetch (&w->socket_waits, 1, __ATOMIC_RELAXED);
+	  while (poll (&pfd, 1, ZFPM_WRITER_POLL_MSECS) == 0
+		 && !__atomic_load_n (&w->stop, __ATOMIC_SEQ_CST))
+	    ;
+	  if (__atomic_load_n (&w->stop, __ATOMIC_SEQ_CST))
+	    break;
+	  continue;
+	}
+
+      __atomic_add_fetch (&w->bytes, nbyte, __ATOMIC_RELAXED);
+      zfpm_writer_complete (w, nbyte);
+    }
+
+  return NULL;
+}
+
+/*
+ * zfpm_writer_wakeup
+ *
+ * Called on the main thread after a chunk has been queued.
+ */
+static inline void
+zfpm_writer_wakeup (zfpm_writer_t *w)
+{
+  if (!__atomic_load_n (&w->sleeping, __ATOMIC_SEQ_CST))
+    return;
+
+  pthread_mutex_lock (&w->mtx);
+  pthread_cond_signal (&w->cond);
+  pthread_mutex_unlock (&w->mtx);
+}
+
+/*
+ * zfpm_writer_seal
+ *
+ * Hand the chunk being filled over to the writer thread.
+ */
+static void
+zfpm_writer_seal (zfpm_writer_t *w)
+{
+  zfpm_chunk_t *chunk = w->fill;
+
+  w->fill = NULL;
+  zfpm_writer_gettime (&chunk->sealed);
+  zfpm_ring_push (&w->full, chunk);
+  zfpm_writer_wakeup (w);
+}
+
+/*
+ * zfpm_writer_fill
+ *
+ * Write callback while the writer thread is running: encode queued
+ * updates into free chunks and pass them on to the writer.
+ */
+static int
+zfpm_writer_fill (struct thread *thread)
+{
+  zfpm_writer_t *w = &zfpm_g->writer;
+
+  while (!TAILQ_EMPTY (&zfpm_g->dest_q))
+    {
+      if (!w->fill && !(w->fill = zfpm_ring_pop (&w->free)))
+	{
+	  /*
+	   * All chunks are queued to the writer. Ask it to let us know
+	   * when one becomes free, checking again in case it did so
+	   * just now.
+	   */
+	  __atomic_store_n (&w->want_free, 1, __ATOMIC_SEQ_CST);
+	  if (!(w->fill = zfpm_ring_pop (&w->free)))
+	    {
+	      zfpm_g->stats.writer_stalls++;
+	      return 0;
+	    }
+	  __atomic_store_n (&w->want_free, 0, __ATOMIC_SEQ_CST);
+	}
+
+      zfpm_build_updates (w->fill->s);
+
+      if (STREAM_WRITEABLE (w->fill->s) < FPM_MAX_MSG_LEN)
+	zfpm_writer_seal (w);
+
+      if (zfpm_thread_should_yield (thread))
+	{
+	  zfpm_g->stats.t_write_yields++;
+	  break;
+	}
+    }
+
+  /*
+   * Keep adding to a partially filled chunk while the writer is busy,
+   * but don't let the writer sit idle while we have something for it.
+   * The flag is raised before looking at the ring, so that either we
+   * see the ring empty or the writer sees the flag once it empties it.
+   */
+  if (w->fill && !stream_empty (w->fill->s))
+    {
+      __atomic_store_n (&w->want_idle, 1, __ATOMIC_SEQ_CST);
+      if (zfpm_ring_empty (&w->full))
+	{
+	  __atomic_store_n (&w->want_idle, 0, __ATOMIC_SEQ_CST);
+	  zfpm_writer_seal (w);
+	}
+    }
+
+  if (zfpm_writes_pending ())
+    zfpm_write_on ();
+
+  return 0;
+}
+
+/*
+ * zfpm_writer_notify_cb
+ *
+ * Runs on the main thread when the writer has freed up a chunk we
+ * were waiting for, or when it failed to write to the socket.
+ */
+static int
+zfpm_writer_notify_cb (struct thread *thread)
+{
+  zfpm_writer_t *w = &zfpm_g->writer;
+  char buf[64];
+  int error;
+
+  assert (w->t_notify);
+  w->t_notify = NULL;
+
+  while (read (w->notify[0], buf, sizeof (buf)) > 0)
+    ;
+
+  zfpm_writer_fold ();
+
+  if ((error = __atomic_load_n (&w->error, __ATOMIC_SEQ_CST)))
+    {
+      zlog_warn ("FPM: writer thread failed to write to socket: %s",
+		 safe_strerror (error));
+      zfpm_connection_down ("failed to write to socket");
+      return 0;
+    }
+
+  w->t_notify = thread_add_read (zfpm_g->master, zfpm_writer_notify_cb,
+				 0, w->notify[0]);
+
+  if (!zfpm_g->t_write && (zfpm_writes_pending () || w->fill))
+    zfpm_write_on ();
+
+  return 0;
+}
+
+/*
+ * zfpm_writer_start
+ *
+ * Start the writer thread for a freshly established connection. We
+ * keep writing from the main thread if that is not possible.
+ */
+static void
+zfpm_writer_start (void)
+{
+  zfpm_writer_t *w = &zfpm_g->writer;
+  sigset_t all, old;
+  int i;
+
+  assert (!w->running);
+
+  memset (&w->full, 0, sizeof (w->full));
+  memset (&w->free, 0, sizeof (w->free));
+  for (i = 0; i < ZFPM_NUM_CHUNKS; i++)
+    {
+      stream_reset (w->chunks[i].s);
+      zfpm_ring_push (&w->free, &w->chunks[i]);
+    }
+  w->fill = NULL;
+  w->sleeping = w->stop = w->error = 0;
+  w->want_free = w->want_idle = 0;
+
+  if (pipe (w->notify) < 0)
+    {
+      zlog_warn ("FPM: can't create notification pipe: %s",
+		 safe_strerror (errno));
+      return;
+    }
+  set_nonblocking (w->notify[0]);
+  set_nonblocking (w->notify[1]);
+
+  /*
+   * Signals are for the main thread, the writer inherits a blocked
+   * mask.
+   */
+  sigfillset (&all);
+  pthread_sigmask (SIG_SETMASK, &all, &old);
+  errno = pthread_create (&w->thread, NULL, zfpm_writer_thread, w);
+  pthread_sigmask (SIG_SETMASK, &old, NULL);
+
+  if (errno)
+    {
+      zlog_warn ("FPM: can't start writer thread: %s", safe_strerror (errno));
+      close (w->notify[0]);
+      close (w->notify[1]);
+      return;
+    }
+
+  w->running = 1;
+  w->t_notify = thread_add_read (zfpm_g->master, zfpm_writer_notify_cb,
+				 0, w->notify[0]);
+  zfpm_debug ("Started writer thread");
+}
+
+/*
+ * zfpm_writer_stop
+ *
+ * Stop the writer thread and throw away whatever it did not write.
+ */
+static void
+zfpm_writer_stop (void)
+{
+  zfpm_writer_t *w = &zfpm_g->writer;
+
+  if (!w->running)
+    return;
+
+  pthread_mutex_lock (&w->mtx);
+  __atomic_store_n (&w->stop, 1, __ATOMIC_SEQ_CST);
+  pthread_cond_signal (&w->cond);
+  pthread_mutex_unlock (&w->mtx);
+
+  pthread_join (w->thread, NULL);
+  w->running = 0;
+
+  THREAD_READ_OFF (w->t_notify);
+  close (w->notify[0]);
+  close (w->notify[1]);
+
+  zfpm_writer_fold ();
+  zfpm_debug ("Stopped writer thread");
+}
+
+/*
+ * zfpm_writer_fold
+ *
+ * Add what the writer counted since the last call to the statistics
+ * of the current interval.
+ */
+static void
+zfpm_writer_fold (void)
+{
+  zfpm_writer_t *w = &zfpm_g->writer;
+  unsigned long val;
+
+#define ZFPM_WRITER_FOLD(wfield, sfield)				\
+  do {									\
+    val = __atomic_load_n (&w->wfield, __ATOMIC_RELAXED);		\
+    zfpm_g->stats.sfield += val - w->folded.wfield;			\
+    w->folded.wfield = val;						\
+  } while (0)
+
+  ZFPM_WRITER_FOLD (chunks_done, writer_chunks);
+  ZFPM_WRITER_FOLD (bytes, writer_bytes);
+  ZFPM_WRITER_FOLD (writev_calls, write_calls);
+  ZFPM_WRITER_FOLD (partial_writes, partial_writes);
+  ZFPM_WRITER_FOLD (socket_waits, writer_socket_waits);
+  ZFPM_WRITER_FOLD (latency_usecs, writer_latency_usecs);
+
+#undef ZFPM_WRITER_FOLD
+}
+
+#endif /* HAVE_LIBPTHREAD */
+
 /*
  * zfpm_write_cb
  */
@@ -1028,6 +1684,11 @@ zfpm_write_cb (struct thread *thread)
   assert (zfpm_g->state == ZFPM_STATE_ESTABLISHED);
   assert (zfpm_g->sock >= 0);
 
+#ifdef HAVE_LIBPTHREAD
+  if (zfpm_g->writer.running)
+    return zfpm_writer_fill (thread);
+#endif
+
   num_writes = 0;
 
   do
@@ -1041,7 +1702,7 @@ zfpm_write_cb (struct thread *thread)
        */
       if (stream_empty (s))
 	{
-	  zfpm_build_updates ();
+	  zfpm_build_updates (s);
 	}
 
       bytes_to_write = stream_get_endp (s) - stream_get_getp (s);
@@ -1356,6 +2017,11 @@ zfpm_stats_timer_cb (struct thread *t)
   assert (zfpm_g->t_stats);
   zfpm_g->t_stats = NULL;
 
+#ifdef HAVE_LIBPTHREAD
+  if (zfpm_g->writer.running)
+    zfpm_writer_fold ();
+#endif
+
   /*
    * Remember the stats collected in the last interval for display
    * purposes.
@@ -1424,6 +2090,11 @@ zfpm_show_stats (struct vty *vty)
   vty_out (vty, "%s%-40s %10s     Last %2d secs%s%s", VTY_NEWLINE, "Counter",
 	   "Total", ZFPM_STATS_IVL_SECS, VTY_NEWLINE, VTY_NEWLINE);
 
+#ifdef HAVE_LIBPTHREAD
+  if (zfpm_g->writer.running)
+    zfpm_writer_fold ();
+#endif
+
   /*
    * Compute the total stats up to this instant.
    */
@@ -1454,6 +2125,21 @@ zfpm_show_stats (struct vty *vty)
   ZFPM_SHOW_STAT (t_conn_up_yields);
   ZFPM_SHOW_STAT (t_conn_up_aborts);
   ZFPM_SHOW_STAT (t_conn_up_finishes);
+  ZFPM_SHOW_STAT (writer_chunks);
+  ZFPM_SHOW_STAT (writer_bytes);
+  ZFPM_SHOW_STAT (writer_socket_waits);
+  ZFPM_SHOW_STAT (writer_stalls);
+
+#ifdef HAVE_LIBPTHREAD
+  vty_out (vty, "%sWriter thread %s, queue latency avg %lu usecs, "
+	   "max %lu usecs%s", VTY_NEWLINE,
+	   zfpm_g->writer.running ? "running" : "not running",
+	   total_stats.writer_chunks ?
+	     total_stats.writer_latency_usecs / total_stats.writer_chunks : 0,
+	   __atomic_load_n (&zfpm_g->writer.latency_max_usecs,
+			    __ATOMIC_RELAXED),
+	   VTY_NEWLINE);
+#endif /* HAVE_LIBPTHREAD */
 
   if (!zfpm_g->last_stats_clear_time)
     return;
@@ -1476,6 +2162,12 @@ zfpm_clear_stats (struct vty *vty)
       return;
     }
 
+#ifdef HAVE_LIBPTHREAD
+  if (zfpm_g->writer.running)
+    zfpm_writer_fold ();
+  __atomic_store_n (&zfpm_g->writer.latency_max_usecs, 0, __ATOMIC_RELAXED);
+#endif
+
   zfpm_stats_reset (&zfpm_g->stats);
   zfpm_stats_reset (&zfpm_g->last_ivl_stats);
   zfpm_stats_reset (&zfpm_g->cumulative_stats);
@@ -1574,6 +2266,17 @@ zfpm_init (struct thread_master *master, int enable, uint16_t port)
   zfpm_g->obuf = stream_new (ZFPM_OBUF_SIZE);
   zfpm_g->ibuf = stream_new (ZFPM_IBUF_SIZE);
 
+#ifdef HAVE_LIBPTHREAD
+  {
+    int i;
+
+    for (i = 0; i < ZFPM_NUM_CHUNKS; i++)
+      zfpm_g->writer.chunks[i].s = stream_new (ZFPM_CHUNK_SIZE);
+    pthread_mutex_init (&zfpm_g->writer.mtx, NULL);
+    pthread_cond_init (&zfpm_g->writer.cond, NULL);
+  }
+#endif /* HAVE_LIBPTHREAD */
+
   zfpm_start_stats_timer ();
   zfpm_start_connect_timer ("initialized");
 
@@ -1310,21 +1310,67 @@ end:
   rib_gc_dest (rn);
 }
 
+/* Milliseconds a route_node has been waiting in the meta-queue. */
+static unsigned long
+rib_queue_age (rib_dest_t *dest, struct timeval *now)
+{
+  long ms;
+
+  ms = (now->tv_sec - dest->queued.tv_sec) * 1000
+       + (now->tv_usec - dest->queued.tv_usec) / 1000;
+  return ms > 0 ? ms : 0;
+}
+
+static void
+rib_queue_account (struct meta_queue_stats *stats, unsigned long ms)
+{
+  unsigned int bucket = 0;
+
+  while (bucket < MQ_HIST_SIZE - 1 && ms >= (1UL << bucket))
+    bucket++;
+  stats->hist[bucket]++;
+  if (ms > stats->max_ms)
+    stats->max_ms = ms;
+}
+
 /* Take a list of route_node structs and return 1, if there was a record
  * picked from it and processed by rib_process(). Don't process more, 
  * than one RN record; operate only in the specified sub-queue.
+ *
+ * A node queued into several sub-queues is processed by the first one
+ * reaching it, the later ones only drop it unless it was updated again
+ * in between.
  */
 static unsigned int
-process_subq (struct list * subq, u_char qindex)
+process_subq (struct meta_queue *mq, u_char qindex)
 {
+  struct list *subq = mq->subq[qindex];
   struct listnode *lnode  = listhead (subq);
   struct route_node *rnode;
+  rib_dest_t *dest;
+  struct timeval now;
 
   if (!lnode)
     return 0;
 
   rnode = listgetdata (lnode);
-  rib_process (rnode);
+  dest = rib_dest_from_rnode (rnode);
+
+  if (dest && dest->done_gen == dest->gen)
+    mq->stats[qindex].skipped++;
+  else
+    {
+      if (dest)
+        {
+          quagga_gettime (QUAGGA_CLK_MONOTONIC, &now);
+          rib_queue_account (&mq->stats[qindex], rib_queue_age (dest, &now));
+          /* Updates arriving from within rib_process() need another run. */
+          dest->done_gen = dest->gen;
+          timerclear (&dest->queued);
+        }
+      mq->stats[qindex].processed++;
+      rib_process (rnode);
+    }
 
   if (rnode->info)
     UNSET_FLAG (rib_dest_from_rnode (rnode)->flags, RIB_ROUTE_QUEUED (qindex));
@@ -1345,15 +1391,35 @@ process_subq (struct list * subq, u_char qindex)
 /* Dispatch the meta queue by picking, processing and unlocking the next RN from
  * a non-empty sub-queue with lowest priority. wq is equal to zebra->ribq and data
  * is pointed to the meta queue structure.
+ *
+ * A route_node is left in the queue for at least rib_process_hold_time
+ * after its first update, so that a burst of changes to one prefix
+ * results in a single rib_process() and kernel operation.
  */
 static wq_item_status
-meta_queue_process (struct work_queue *dummy, void *data)
+meta_queue_process (struct work_queue *wq, void *data)
 {
   struct meta_queue * mq = data;
+  struct listnode *lnode;
+  rib_dest_t *dest;
+  struct timeval now;
   unsigned i;
 
   for (i = 0; i < MQ_SIZE; i++)
-    if (process_subq (mq->subq[i], i))
+    if ((lnode = listhead (mq->subq[i])) != NULL)
+      {
+        dest = rib_dest_from_rnode ((struct route_node *) listgetdata (lnode));
+        if (dest && dest->done_gen != dest->gen && wq->spec.hold)
+          {
+            quagga_gettime (QUAGGA_CLK_MONOTONIC, &now);
+            if (rib_queue_age (dest, &now) < wq->spec.hold)
+              return WQ_QUEUE_BLOCKED;
+          }
+        break;
+      }
+
+  for (i = 0; i < MQ_SIZE; i++)
+    if (process_subq (mq, i))
       {
 	mq->size--;
 	break;
@@ -1386,29 +1452,40 @@ static void
 rib_meta_queue_add (struct meta_queue *mq, struct route_node *rn)
 {
   struct rib *rib;
+  rib_dest_t *dest = rib_dest_from_rnode (rn);
+  u_int32_t seen = 0;
   char buf[INET6_ADDRSTRLEN];
 
   if (IS_ZEBRA_DEBUG_RIB_Q)
     inet_ntop (rn->p.family, &rn->p.u.prefix, buf, INET6_ADDRSTRLEN);
 
+  /* Invariant: at this point we always have rn->info set. */
+  dest->gen++;
+  if (!timerisset (&dest->queued))
+    quagga_gettime (QUAGGA_CLK_MONOTONIC, &dest->queued);
+
   RNODE_FOREACH_RIB (rn, rib)
     {
       u_char qindex = meta_queue_map[rib->type];
 
-      /* Invariant: at this point we always have rn->info set. */
-      if (CHECK_FLAG (rib_dest_from_rnode (rn)->flags,
-		      RIB_ROUTE_QUEUED (qindex)))
+      if (CHECK_FLAG (seen, RIB_ROUTE_QUEUED (qindex)))
+        continue;
+      SET_FLAG (seen, RIB_ROUTE_QUEUED (qindex));
+
+      if (CHECK_FLAG (dest->flags, RIB_ROUTE_QUEUED (qindex)))
 	{
+	  mq->stats[qindex].merged++;
 	  if (IS_ZEBRA_DEBUG_RIB_Q)
 	    zlog_debug ("%s: %s/%d: rn %p is already queued in sub-queue %u",
 			__func__, buf, rn->p.prefixlen, rn, qindex);
 	  continue;
 	}
 
-      SET_FLAG (rib_dest_from_rnode (rn)->flags, RIB_ROUTE_QUEUED (qindex));
+      SET_FLAG (dest->flags, RIB_ROUTE_QUEUED (qindex));
       listnode_add (mq->subq[qindex], rn);
       route_lock_node (rn);
       mq->size++;
+      mq->stats[qindex].queued++;
 
       if (IS_ZEBRA_DEBUG_RIB_Q)
 	zlog_debug ("%s: %s/%d: queued rn %p into sub-queue %u",
@@ -1465,6 +1542,56 @@ rib_queue_add (struct zebra_t *zebra, struct route_node *rn)
   return;
 }
 
+/* The kernel refused the install of P which was sent with sequence
+ * number SEQ.  The route is not in the FIB after all, same as for a
+ * failed synchronous install in rib_install_kernel().  Requeue the
+ * route node, rib_process() installs a selected route without FIB
+ * nexthops again.  A route is retried only once, a persistent error
+ * would requeue it forever.
+ */
+void
+rib_kernel_failed (struct prefix *p, u_int32_t seq)
+{
+  rib_tables_iter_t iter;
+  struct route_table *table;
+  struct route_node *rn;
+  struct nexthop *nexthop;
+  struct rib *rib;
+  afi_t afi;
+
+  afi = family2afi (p->family);
+  rib_tables_iter_init (&iter);
+  while ((table = rib_tables_iter_next (&iter)))
+    {
+      if (rib_table_info (table)->afi != afi)
+	continue;
+
+      rn = route_node_lookup (table, p);
+      if (! rn)
+	continue;
+
+      RNODE_FOREACH_RIB (rn, rib)
+	if (rib->nl_seq == seq)
+	  break;
+
+      if (rib)
+	{
+	  for (nexthop = rib->nexthop; nexthop; nexthop = nexthop->next)
+	    UNSET_FLAG (nexthop->flags, NEXTHOP_FLAG_FIB);
+
+	  if (! CHECK_FLAG (rib->status, RIB_ENTRY_RETRIED))
+	    {
+	      SET_FLAG (rib->status, RIB_ENTRY_RETRIED);
+	      rib_queue_add (&zebrad, rn);
+	    }
+	  route_unlock_node (rn);
+	  break;
+	}
+      route_unlock_node (rn);
+    }
+  rib_tables_iter_cleanup (&iter);
+}
+
 /* Create new meta queue.
    A destructor function doesn't seem to be necessary here.
  */
@@ -1514,6 +1641,63 @@ rib_queue_init (struct zebra_t *zebra)
   return;
 }
 
+static const char *meta_queue_name[MQ_SIZE] =
+{
+  "connected/kernel",
+  "static",
+  "IGP",
+  "BGP",
+  "other",
+};
+
+DEFUN (show_zebra_rib_queue,
+       show_zebra_rib_queue_cmd,
+       "show zebra rib queue",
+       SHOW_STR
+       "Zebra information\n"
+       "Routing Information Base\n"
+       "Meta-queue statistics and queueing latency\n")
+{
+  struct meta_queue *mq = zebrad.mq;
+  struct meta_queue_stats *stats;
+  unsigned int i, b;
+
+  if (!mq)
+    return CMD_SUCCESS;
+
+  vty_out (vty, "Batching window %ums, %u route nodes queued%s%s",
+	   zebrad.ribq ? zebrad.ribq->spec.hold : 0, mq->size,
+	   VTY_NEWLINE, VTY_NEWLINE);
+  vty_out (vty, "%-18s %7s %10s %10s %10s %10s %8s%s", "Sub-queue", "Length",
+	   "Queued", "Merged", "Processed", "Skipped", "Max ms", VTY_NEWLINE);
+  for (i = 0; i < MQ_SIZE; i++)
+    {
+      stats = &mq->stats[i];
+      vty_out (vty, "%-18s %7u %10lu %10lu %10lu %10lu %8lu%s",
+	       meta_queue_name[i], listcount (mq->subq[i]), stats->queued,
+	       stats->merged, stats->processed, stats->skipped, stats->max_ms,
+	       VTY_NEWLINE);
+    }
+
+  vty_out (vty, "%sQueueing latency of processed route nodes:%s",
+	   VTY_NEWLINE, VTY_NEWLINE);
+  vty_out (vty, "%-10s", "ms");
+  for (i = 0; i < MQ_SIZE; i++)
+    vty_out (vty, " %10.10s", meta_queue_name[i]);
+  vty_out (vty, "%s", VTY_NEWLINE);
+  for (b = 0; b < MQ_HIST_SIZE; b++)
+    {
+      if (b < MQ_HIST_SIZE - 1)
+	vty_out (vty, "< %-8lu", 1UL << b);
+      else
+	vty_out (vty, ">= %-7lu", 1UL << (b - 1));
+      for (i = 0; i < MQ_SIZE; i++)
+	vty_out (vty, " %10lu", mq->stats[i].hist[b]);
+      vty_out (vty, "%s", VTY_NEWLINE);
+    }
+  return CMD_SUCCESS;
+}
+
 /* RIB updates are processed via a queue of pointers to route_nodes.
  *
  * The queue length is bounded by the maximal size of the routing table,
@@ -3137,6 +3321,7 @@ void
 rib_init (void)
 {
   rib_queue_init (&zebrad);
+  install_element (ENABLE_NODE, &show_zebra_rib_queue_cmd);
   /* VRF initialization.  */
   vrf_init ();
 }
@@ -885,6 +885,184 @@ zread_ipv4_delete (struct zserv *client, u_short length)
   return 0;
 }
 
+/* Add the nexthops of a batch attribute block, checked by the caller. */
+static void
+zread_ipv4_batch_nexthops (struct rib *rib, const u_char *pnt, u_char num)
+{
+  struct in_addr nexthop;
+  u_int32_t ifindex;
+  u_char i;
+
+  for (i = 0; i < num; i++)
+    switch (*pnt++)
+      {
+      case ZEBRA_NEXTHOP_IFINDEX:
+        memcpy (&ifindex, pnt, 4);
+        nexthop_ifindex_add (rib, ntohl (ifindex));
+        pnt += 4;
+        break;
+      case ZEBRA_NEXTHOP_IFNAME:
+        pnt += 1 + *pnt;
+        break;
+      case ZEBRA_NEXTHOP_IPV4:
+        memcpy (&nexthop, pnt, 4);
+        nexthop_ipv4_add (rib, &nexthop, NULL);
+        pnt += 4;
+        break;
+      case ZEBRA_NEXTHOP_IPV4_IFINDEX:
+        memcpy (&nexthop, pnt, 4);
+        memcpy (&ifindex, pnt + 4, 4);
+        nexthop_ipv4_ifindex_add (rib, &nexthop, NULL, ntohl (ifindex));
+        pnt += 8;
+        break;
+      case ZEBRA_NEXTHOP_IPV6:
+        pnt += IPV6_MAX_BYTELEN;
+        break;
+      case ZEBRA_NEXTHOP_BLACKHOLE:
+        nexthop_blackhole_add (rib);
+        break;
+      }
+}
+
+/*
+ * Parse a ZEBRA_IPV4_ROUTE_BATCH_ADD/DELETE, see zapi_ipv4_route_batch().
+ * The message is walked in place in the input buffer: the attribute
+ * block is checked once, then each route only costs its prefix and
+ * metric. Parsing stops at the first malformed part.
+ */
+static int
+zread_ipv4_batch (struct zserv *client, u_short length, uint16_t command)
+{
+  struct stream *s = client->ibuf;
+  const u_char *pnt = STREAM_PNT (s);
+  const u_char *end = pnt + length;
+  const u_char *nexthops = NULL;
+  u_char type, flags, message, distance = 0;
+  u_char nexthop_num = 0, i;
+  u_int16_t count, safi;
+  struct in_addr nexthop, *nexthop_p = NULL;
+  u_int32_t ifindex = 0, metric;
+  struct prefix_ipv4 p;
+  struct rib *rib;
+  int psize;
+
+#define ZREAD_NEED(N) do { if (end - pnt < (N)) goto malformed; } while (0)
+
+  ZREAD_NEED (7);
+  count = (pnt[0] << 8) | pnt[1];
+  type = pnt[2];
+  flags = pnt[3];
+  message = pnt[4];
+  safi = (pnt[5] << 8) | pnt[6];
+  pnt += 7;
+
+  nexthop.s_addr = 0;
+  if (CHECK_FLAG (message, ZAPI_MESSAGE_NEXTHOP))
+    {
+      ZREAD_NEED (1);
+      nexthop_num = *pnt++;
+      nexthops = pnt;
+
+      /* Check the block, remember what a delete matches against. */
+      for (i = 0; i < nexthop_num; i++)
+        {
+          ZREAD_NEED (1);
+          switch (*pnt++)
+            {
+            case ZEBRA_NEXTHOP_IFINDEX:
+              ZREAD_NEED (4);
+              memcpy (&ifindex, pnt, 4);
+              ifindex = ntohl (ifindex);
+              pnt += 4;
+              break;
+            case ZEBRA_NEXTHOP_IFNAME:
+              ZREAD_NEED (1);
+              ZREAD_NEED (1 + *pnt);
+              pnt += 1 + *pnt;
+              break;
+            case ZEBRA_NEXTHOP_IPV4:
+              ZREAD_NEED (4);
+              memcpy (&nexthop, pnt, 4);
+              nexthop_p = &nexthop;
+              pnt += 4;
+              break;
+            case ZEBRA_NEXTHOP_IPV4_IFINDEX:
+              ZREAD_NEED (8);
+              memcpy (&nexthop, pnt, 4);
+              memcpy (&ifindex, pnt + 4, 4);
+              ifindex = ntohl (ifindex);
+              pnt += 8;
+              break;
+            case ZEBRA_NEXTHOP_IPV6:
+              ZREAD_NEED (IPV6_MAX_BYTELEN);
+              pnt += IPV6_MAX_BYTELEN;
+              break;
+            case ZEBRA_NEXTHOP_BLACKHOLE:
+              break;
+            default:
+              goto malformed;
+            }
+        }
+    }
+
+  if (CHECK_FLAG (message, ZAPI_MESSAGE_DISTANCE))
+    {
+      ZREAD_NEED (1);
+      distance = *pnt++;
+    }
+
+  memset (&p, 0, sizeof (struct prefix_ipv4));
+  p.family = AF_INET;
+
+  while (count--)
+    {
+      ZREAD_NEED (1);
+      if (*pnt > IPV4_MAX_BITLEN)
+        goto malformed;
+      p.prefixlen = *pnt++;
+      psize = PSIZE (p.prefixlen);
+      ZREAD_NEED (psize);
+      p.prefix.s_addr = 0;
+      memcpy (&p.prefix, pnt, psize);
+      pnt += psize;
+
+      metric = 0;
+      if (CHECK_FLAG (message, ZAPI_MESSAGE_METRIC))
+        {
+          ZREAD_NEED (4);
+          memcpy (&metric, pnt, 4);
+          metric = ntohl (metric);
+          pnt += 4;
+        }
+
+      if (command == ZEBRA_IPV4_ROUTE_BATCH_DELETE)
+        {
+          rib_delete_ipv4 (type, flags, &p, nexthop_p, ifindex,
+                           client->rtm_table, safi);
+          continue;
+        }
+
+      rib = XCALLOC (MTYPE_RIB, sizeof (struct rib));
+      rib->type = type;
+      rib->flags = flags;
+      rib->uptime = time (NULL);
+      if (nexthops)
+        zread_ipv4_batch_nexthops (rib, nexthops, nexthop_num);
+      rib->distance = distance;
+      rib->metric = metric;
+      rib->table = zebrad.rtm_table_default;
+      rib_add_ipv4_multipath (&p, rib, safi);
+    }
+#undef ZREAD_NEED
+
+  return 0;
+
+malformed:
+  zlog_warn ("%s: socket %d malformed %s, dropping the rest of it",
+             __func__, client->sock, zserv_command_string (command));
+  return -1;
+}
+
 /* Nexthop lookup for IPv4. */
 static int
 zread_ipv4_nexthop_lookup (struct zserv *client, u_short length)
@@ -1079,12 +1257,27 @@ zread_router_id_delete (struct zserv *client, u_short length)
 
 /* Tie up route-type and client->sock */
 static void
-zread_hello (struct zserv *client)
+zread_hello (struct zserv *client, u_short length)
 {
   /* type of protocol (lib/zebra.h) */
   u_char proto;
+  struct stream *s;
+
   proto = stream_getc (client->ibuf);
 
+  /* Newer clients offer capabilities, confirm those we support. */
+  if (length >= 5)
+    {
+      client->capabilities = stream_getl (client->ibuf) & ZCLIENT_CAPABILITIES;
+
+      s = client->obuf;
+      stream_reset (s);
+      zserv_create_header (s, ZEBRA_CAPABILITIES);
+      stream_putl (s, client->capabilities);
+      stream_putw_at (s, 0, stream_get_endp (s));
+      zebra_server_send_message (client);
+    }
+
   /* accept only dynamic routing protocols */
   if ((proto < ZEBRA_ROUTE_MAX)
   &&  (proto > ZEBRA_ROUTE_STATIC))
@@ -1302,6 +1495,10 @@ zebra_client_read (struct thread *thread)
     case ZEBRA_IPV4_ROUTE_DELETE:
       zread_ipv4_delete (client, length);
       break;
+    case ZEBRA_IPV4_ROUTE_BATCH_ADD:
+    case ZEBRA_IPV4_ROUTE_BATCH_DELETE:
+      zread_ipv4_batch (client, length, command);
+      break;
 #ifdef HAVE_IPV6
     case ZEBRA_IPV6_ROUTE_ADD:
       zread_ipv6_add (client, length);
@@ -1334,7 +1531,7 @@ zebra_client_read (struct thread *thread)
       zread_ipv4_import_lookup (client, length);
       break;
     case ZEBRA_HELLO:
-      zread_hello (client);
+      zread_hello (client, length);
       break;
     default:
       zlog_info ("Zebra received unknown command %d", command);
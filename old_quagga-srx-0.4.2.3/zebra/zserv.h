@@ -66,6 +66,9 @@ struct zserv
 
   /* Router-id information. */
   u_char ridinfo;
+
+  /* Capabilities agreed on in the hello, ZCLIENT_CAP_*. */
+  u_int32_t capabilities;
 };
 
 /* Zebra instance */
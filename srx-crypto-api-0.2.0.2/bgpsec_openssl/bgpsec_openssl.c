@@ -79,11 +79,14 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <setjmp.h>
+#include <pthread.h>
 
 
 /* general API header which will be public to the customer side */
 #include "../srx/srxcryptoapi.h"
 #include "key_storage.h"
+#include "sig_cache.h"
+#include "hot_keys.h"
 
 /** This define is used in init() to specify if configured keys should 
  * immediately be converted into EC_KEYs*/
@@ -97,6 +100,98 @@ static KeyStorage* BOSSL_pubKeys = NULL;
 /** contains the private key storage. The more keys the slower signing. */
 static KeyStorage* BOSSL_privKeys = NULL;
 
+/** The maximum number of validation threads that can be configured. */
+#define BOSSL_MAX_THREADS       64
+/** Batches with fewer signature segments are verified by the caller alone. */
+#define BOSSL_MIN_PARALLEL_JOBS 4
+/** Marks a job that is not the duplicate of another job. */
+#define BOSSL_NO_DUP            -1
+/** The default number of verified signature segments kept, see CACHE. */
+#define BOSSL_DEF_CACHE_SIZE    16384
+/** The maximum number of public keys with a verification table. */
+#define BOSSL_MAX_HOT_KEYS      1024
+
+/**
+ * The validation state of one update within a batch. All signature segment
+ * verifications (jobs) of the update point to it.
+ */
+typedef struct
+{
+  /** The validation data of the update. */
+  SCA_BGPSecValidationData* data;
+  /** Set as soon as one segment fails, the remaining jobs are skipped. */
+  volatile bool             failed;
+  /** Status information collected by the jobs. */
+  sca_status_t              status;
+  /** The index of the first job of the update. */
+  int                       firstJob;
+  /** The number of jobs of the update, segments found in the cache and the
+   * segments closer to the origin are not verified again. */
+  int                       noJobs;
+} BOSSL_Item;
+
+/**
+ * The verification of one signature segment: the digest over the hash message
+ * and the ECDSA verify with each key registered for the signer.
+ */
+typedef struct
+{
+  /** The update the segment belongs to. */
+  BOSSL_Item*         item;
+  /** The signed message and its signature. */
+  SCA_HashMessagePtr* hashMsg;
+  /** The digest of the signed message. */
+  u_int8_t            digest[SHA256_DIGEST_LENGTH];
+  /** The keys of the signer. */
+  EC_KEY**            ecdsa_key;
+  /** The number of keys. */
+  u_int16_t           noKeys;
+  /** The job with the same signature segment over the same message, or
+   * BOSSL_NO_DUP. A duplicate takes over the result of that job. */
+  int                 dupOf;
+  /** Set once the signature segment is verified. */
+  bool                done;
+  /** The result of the verification. */
+  bool                valid;
+  /** The status of the verification. */
+  sca_status_t        status;
+} BOSSL_Job;
+
+/**
+ * The pool of validation threads. The threads and the calling thread take the
+ * jobs of one batch in order until all are done.
+ */
+typedef struct
+{
+  pthread_t*      threads;
+  int             noThreads;
+  pthread_mutex_t mutex;
+  /** Signaled when a batch is handed to the pool or the pool shuts down. */
+  pthread_cond_t  jobsReady;
+  /** Signaled when the last job of the batch is finished. */
+  pthread_cond_t  jobsDone;
+  /** The batch in progress or NULL. */
+  BOSSL_Job*      jobs;
+  int             noJobs;
+  /** The next job to be taken. */
+  int             nextJob;
+  /** The number of jobs taken but not finished yet. */
+  int             busy;
+  bool            shutdown;
+} BOSSL_ThreadPool;
+
+/** The validation thread pool, NULL if validation is done by the caller. */
+static BOSSL_ThreadPool* BOSSL_pool = NULL;
+/** Protects the failed flag and status of the batch items. */
+static pthread_mutex_t BOSSL_itemMutex = PTHREAD_MUTEX_INITIALIZER;
+/** The verified signature segments, NULL if caching is disabled. */
+static SigCache* BOSSL_cache = NULL;
+/** The verification tables of frequently used public keys, NULL if
+ * disabled. */
+static HotKeys* BOSSL_hotKeys = NULL;
+
+static void* _validationThread(void* arg);
+
 /**
  * Read the given file and pre-load all keys. The following non error status 
  * can be set: 
@@ -230,6 +325,94 @@ static void _readKeyFile(char* fName, bool isPrivate, sca_status_t* status,
   }
 }
 
+/**
+ * Map the given key bundle and attach it to the public or private key storage
+ * depending on the bundle. The keys are not loaded before they are used.
+ *   API_STATUS_ERR_KEY_IO: The bundle could not be mapped.
+ *   API_STATUS_ERR_USER1: The bundle is invalid or does not contain ECDSA keys.
+ * 
+ * @param fName The name of the bundle ('\0' terminated String)
+ * @param status Set the status flag in case of an ERROR
+ */
+static void _openBundle(char* fName, sca_status_t* status)
+{
+  sca_status_t myStatus = API_STATUS_OK;
+  KeyBundle*   bundle   = kb_open(fName, &myStatus);
+
+  if (bundle != NULL)
+  {
+    if (ks_setBundle(bundle->isPrivate ? BOSSL_privKeys : BOSSL_pubKeys, 
+                     bundle, &myStatus) != API_SUCCESS)
+    {
+      sca_debugLog(LOG_ERR, "Key bundle '%s' does not match the key storage\n",
+                   fName);
+      kb_close(bundle);
+    }
+  }
+
+  *status |= myStatus;
+}
+
+/**
+ * Start the validation threads.
+ *
+ * @param noThreads The number of threads next to the calling thread.
+ */
+static void _startThreadPool(int noThreads)
+{
+  BOSSL_ThreadPool* pool = malloc(sizeof(BOSSL_ThreadPool));
+  int idx;
+
+  memset(pool, 0, sizeof(BOSSL_ThreadPool));
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->jobsReady, NULL);
+  pthread_cond_init(&pool->jobsDone, NULL);
+  pool->threads = malloc(noThreads * sizeof(pthread_t));
+
+  for (idx = 0; idx < noThreads; idx++)
+  {
+    if (pthread_create(&pool->threads[idx], NULL, _validationThread, pool) != 0)
+    {
+      sca_debugLog(LOG_WARNING, "Could only start %d of %d validation "
+                   "threads\n", idx, noThreads);
+      break;
+    }
+  }
+  pool->noThreads = idx;
+  BOSSL_pool = pool;
+}
+
+/**
+ * Stop the validation threads and free the pool.
+ */
+static void _stopThreadPool()
+{
+  BOSSL_ThreadPool* pool = BOSSL_pool;
+  int idx;
+
+  if (pool == NULL)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&pool->mutex);
+  pool->shutdown = true;
+  pthread_cond_broadcast(&pool->jobsReady);
+  pthread_mutex_unlock(&pool->mutex);
+
+  for (idx = 0; idx < pool->noThreads; idx++)
+  {
+    pthread_join(pool->threads[idx], NULL);
+  }
+
+  pthread_cond_destroy(&pool->jobsDone);
+  pthread_cond_destroy(&pool->jobsReady);
+  pthread_mutex_destroy(&pool->mutex);
+  free(pool->threads);
+  free(pool);
+  BOSSL_pool = NULL;
+}
+
 /**
  * The init method initialized the API. Only one failure can be imagined here,
  * a consecutive call of the init method. Next to the specified error status 
@@ -241,7 +424,16 @@ static void _readKeyFile(char* fName, bool isPrivate, sca_status_t* status,
  * 
  * In case value is not NULL it can contain the following string:
  * <type>:<filename>[;<type>:<filename>;] 
- * with type == PRIV for private keys and PUB == public keys.
+ * with type == PRIV for private keys and PUB == public keys. The type THREADS
+ * takes a number instead of a filename, the number of threads that verify
+ * signature segments in parallel (default 0, validation by the caller).
+ * The type CACHE takes the number of verified signature segments that are
+ * kept to skip their verification in later updates (default
+ * BOSSL_DEF_CACHE_SIZE, 0 disables the cache). The type HOTKEYS takes the
+ * number of frequently used public keys that get a precomputed verification
+ * table (default 0, about 150 KB each, see hot_keys.h). The type BUNDLE takes
+ * a key bundle created with srx_key_bundle, it is mapped into memory and its
+ * keys are loaded on first use (see key_bundle.h).
  * Each file must have the following content structure:
  * <ASN>-SKI: <SKI HEX VALUE>
  * 
@@ -275,6 +467,12 @@ int init(const char* value, int logLevel, sca_status_t* status)
   
   sca_status_t myStatus = BOSSL_initialized ? API_STATUS_ERR_USER1 
                                             : API_STATUS_OK;
+  // The number of validation threads, see THREADS
+  int noThreads = 0;
+  // The number of cached signature segments, see CACHE
+  int cacheSize = BOSSL_DEF_CACHE_SIZE;
+  // The number of public keys with a verification table, see HOTKEYS
+  int noHotKeys = 0;
   
   if (!BOSSL_initialized)
   {
@@ -284,6 +482,14 @@ int init(const char* value, int logLevel, sca_status_t* status)
     ks_init(BOSSL_privKeys, SCA_ECDSA_ALGORITHM, true);
     // used to determine which keys are contained in a possible file.
     bool isPrivate = false;
+    // used to determine if the value is the number of validation threads.
+    bool isThreads = false;
+    // used to determine if the value is the size of the cache.
+    bool isCache = false;
+    // used to determine if the value is the number of hot keys.
+    bool isHotKeys = false;
+    // used to determine if the value is a key bundle.
+    bool isBundle = false;
     
     char  string[MAX_CFGFILE_NAME];
     char* tmpValue = (char*)value;
@@ -291,11 +497,17 @@ int init(const char* value, int logLevel, sca_status_t* status)
     
     while (strLen > 0 && ((myStatus & API_STATUS_ERROR_MASK) == 0 ))
     {
-      int typeLen = strspn(tmpValue, "PUBRIV:");
+      // The type includes the ':'
+      int typeLen = strcspn(tmpValue, ":");
+      typeLen = (tmpValue[typeLen] == ':') ? typeLen + 1 : 0;
       if (typeLen != 0)
       {
         memset (&string, '\0', MAX_CFGFILE_NAME);
         memccpy(&string, tmpValue, MAX_CFGFILE_NAME-1, typeLen);
+        isThreads = false;
+        isCache   = false;
+        isHotKeys = false;
+        isBundle  = false;
         if (strcmp("PUB:\0", string) == 0)
         {
           isPrivate = false;
@@ -304,6 +516,22 @@ int init(const char* value, int logLevel, sca_status_t* status)
         {
           isPrivate = true;          
         }
+        else if (strcmp("THREADS:\0", string) == 0)
+        {
+          isThreads = true;
+        }
+        else if (strcmp("CACHE:\0", string) == 0)
+        {
+          isCache = true;
+        }
+        else if (strcmp("HOTKEYS:\0", string) == 0)
+        {
+          isHotKeys = true;
+        }
+        else if (strcmp("BUNDLE:\0", string) == 0)
+        {
+          isBundle = true;
+        }
         else
         {
           myStatus |= API_STATUS_ERR_USER2;
@@ -322,8 +550,39 @@ int init(const char* value, int logLevel, sca_status_t* status)
           strLen   -= fNameLength;
           tmpValue += fNameLength;
           
-          // Load the file and all the keys.
-          _readKeyFile(string, isPrivate, &myStatus, DO_CONVERT);
+          if (isThreads)
+          {
+            noThreads = atoi(string);
+            if (noThreads < 0 || noThreads > BOSSL_MAX_THREADS)
+            {
+              myStatus |= API_STATUS_ERR_USER2;
+            }
+          }
+          else if (isCache)
+          {
+            cacheSize = atoi(string);
+            if (cacheSize < 0)
+            {
+              myStatus |= API_STATUS_ERR_USER2;
+            }
+          }
+          else if (isHotKeys)
+          {
+            noHotKeys = atoi(string);
+            if (noHotKeys < 0 || noHotKeys > BOSSL_MAX_HOT_KEYS)
+            {
+              myStatus |= API_STATUS_ERR_USER2;
+            }
+          }
+          else if (isBundle)
+          {
+            _openBundle(string, &myStatus);
+          }
+          else
+          {
+            // Load the file and all the keys.
+            _readKeyFile(string, isPrivate, &myStatus, DO_CONVERT);
+          }
 
           if (strLen > 0)
           {
@@ -364,6 +623,21 @@ int init(const char* value, int logLevel, sca_status_t* status)
     ks_release(BOSSL_privKeys);
     ks_release(BOSSL_pubKeys);
   }
+  else
+  {
+    if (noThreads > 0 && BOSSL_pool == NULL)
+    {
+      _startThreadPool(noThreads);
+    }
+    if (cacheSize > 0 && BOSSL_cache == NULL)
+    {
+      BOSSL_cache = sc_create(cacheSize);
+    }
+    if (noHotKeys > 0 && BOSSL_hotKeys == NULL)
+    {
+      BOSSL_hotKeys = hk_create(noHotKeys);
+    }
+  }
   return BOSSL_initialized ? API_SUCCESS : API_FAILURE;
 }
 
@@ -401,16 +675,16 @@ int release(sca_status_t* status)
 {
   if (BOSSL_initialized)
   {
-    ks_empty(BOSSL_pubKeys);
-    free(BOSSL_pubKeys->head);
-    BOSSL_pubKeys->head = NULL;
-    free(BOSSL_pubKeys);
+    _stopThreadPool();
+    sc_free(BOSSL_cache);
+    BOSSL_cache = NULL;
+    hk_free(BOSSL_hotKeys);
+    BOSSL_hotKeys = NULL;
+
+    ks_release(BOSSL_pubKeys);
     BOSSL_pubKeys = NULL;
     
-    ks_empty(BOSSL_privKeys);
-    free(BOSSL_privKeys->head);
-    BOSSL_privKeys->head = NULL;
-    free(BOSSL_privKeys);
+    ks_release(BOSSL_privKeys);
     BOSSL_privKeys = NULL;
     
     BOSSL_initialized = false;    
@@ -501,6 +775,523 @@ static unsigned char* _createSha256Digest(const unsigned char* message,
   return digestBuff;
 }
 
+/**
+ * Verify the signature segment of the job against the digest of its message
+ * and store the result in the job.
+ *
+ * @param job The signature segment and the keys of its signer.
+ */
+static void _verifySegment(BOSSL_Job* job)
+{
+  SCA_BGPSEC_SignatureSegment* sigSeg = NULL;
+  u_int8_t* signature = NULL;
+  u_int16_t sigLength = 0;
+  sca_status_t myStatus = API_STATUS_OK;
+  bool valid = false;
+  int  ecIdx = 0;
+
+  // find the signature:
+  sigSeg    = (SCA_BGPSEC_SignatureSegment*)job->hashMsg->signaturePtr;
+  signature = job->hashMsg->signaturePtr + sizeof(SCA_BGPSEC_SignatureSegment);
+  sigLength = ntohs(sigSeg->siglen);
+
+  for (ecIdx=0; ecIdx < job->noKeys && !valid; ecIdx++)
+  {
+    if (job->ecdsa_key[ecIdx] != NULL)
+    { // Toggle through the keys
+      /* verify the signature */
+      if (BOSSL_hotKeys != NULL)
+      {
+        valid = hk_verify(BOSSL_hotKeys, job->ecdsa_key[ecIdx], job->digest,
+                          SHA256_DIGEST_LENGTH, signature, sigLength) == 1;
+      }
+      else
+      {
+        valid = ECDSA_verify(0, job->digest, SHA256_DIGEST_LENGTH,
+                             signature, sigLength, job->ecdsa_key[ecIdx]) == 1;
+      }
+    }
+    else
+    {
+      // Most likely a registration error!
+      myStatus |= API_STATUS_ERR_INVLID_KEY;
+      sca_debugLog(LOG_WARNING, "The key storage returned a NULL eckey\n");
+    }
+  }
+
+  if (!valid)
+  {
+    myStatus |= API_STATUS_INFO_SIGNATURE;
+  }
+
+  job->valid  = valid;
+  job->status = myStatus;
+  job->done   = true;
+}
+
+/**
+ * Add the result of a signature segment verification to its update.
+ *
+ * @param item The update.
+ * @param valid The result of the verification.
+ * @param status The status of the verification.
+ */
+static void _applyResult(BOSSL_Item* item, bool valid, sca_status_t status)
+{
+  if (status != API_STATUS_OK)
+  {
+    pthread_mutex_lock(&BOSSL_itemMutex);
+    item->status |= status;
+    item->failed  = item->failed || !valid;
+    pthread_mutex_unlock(&BOSSL_itemMutex);
+  }
+}
+
+/**
+ * Verify one signature segment unless another segment of the same update
+ * failed already. Duplicates are left to _resolveDuplicates.
+ *
+ * @param job The signature segment and the keys of its signer.
+ */
+static void _verifyJob(BOSSL_Job* job)
+{
+  if (job->dupOf != BOSSL_NO_DUP || job->item->failed)
+  {
+    return;
+  }
+
+  _verifySegment(job);
+  _applyResult(job->item, job->valid, job->status);
+}
+
+/**
+ * Take jobs of the current batch until none is left. Must be called with the
+ * pool mutex held, returns with it held.
+ *
+ * @param pool The thread pool.
+ */
+static void _takeJobs(BOSSL_ThreadPool* pool)
+{
+  BOSSL_Job* job = NULL;
+
+  while (pool->jobs != NULL && pool->nextJob < pool->noJobs)
+  {
+    job = &pool->jobs[pool->nextJob++];
+    pool->busy++;
+    pthread_mutex_unlock(&pool->mutex);
+
+    _verifyJob(job);
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->busy--;
+    if (pool->busy == 0 && pool->nextJob == pool->noJobs)
+    {
+      pthread_cond_signal(&pool->jobsDone);
+    }
+  }
+}
+
+/**
+ * The validation thread, it works on the batch handed to the pool.
+ *
+ * @param arg The thread pool.
+ *
+ * @return NULL
+ */
+static void* _validationThread(void* arg)
+{
+  BOSSL_ThreadPool* pool = (BOSSL_ThreadPool*)arg;
+
+  pthread_mutex_lock(&pool->mutex);
+  while (!pool->shutdown)
+  {
+    _takeJobs(pool);
+    pthread_cond_wait(&pool->jobsReady, &pool->mutex);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+
+  return NULL;
+}
+
+/**
+ * Run all jobs. Large batches are shared with the validation threads unless
+ * the pool is busy with the batch of another caller. The jobs of an update
+ * are adjacent and taken in order, so the remaining ones are skipped once one
+ * failed.
+ *
+ * @param jobs The jobs.
+ * @param noJobs The number of jobs.
+ */
+static void _runJobs(BOSSL_Job* jobs, int noJobs)
+{
+  BOSSL_ThreadPool* pool = BOSSL_pool;
+  int idx;
+
+  if (pool != NULL && noJobs >= BOSSL_MIN_PARALLEL_JOBS)
+  {
+    pthread_mutex_lock(&pool->mutex);
+    if (pool->jobs == NULL)
+    {
+      pool->jobs    = jobs;
+      pool->noJobs  = noJobs;
+      pool->nextJob = 0;
+      pthread_cond_broadcast(&pool->jobsReady);
+
+      _takeJobs(pool);
+      while (pool->busy > 0)
+      {
+        pthread_cond_wait(&pool->jobsDone, &pool->mutex);
+      }
+
+      pool->jobs   = NULL;
+      pool->noJobs = 0;
+      pthread_mutex_unlock(&pool->mutex);
+      return;
+    }
+    pthread_mutex_unlock(&pool->mutex);
+  }
+
+  for (idx = 0; idx < noJobs; idx++)
+  {
+    _verifyJob(&jobs[idx]);
+  }
+}
+
+/**
+ * Hand the results of verified signature segments to the updates that
+ * contain the same segment. If the segment was skipped because its own update
+ * failed already, it is verified now.
+ *
+ * @param jobs The jobs, all jobs must have been run.
+ * @param noJobs The number of jobs.
+ */
+static void _resolveDuplicates(BOSSL_Job* jobs, int noJobs)
+{
+  BOSSL_Job* orig = NULL;
+  int idx;
+
+  for (idx = 0; idx < noJobs; idx++)
+  {
+    if (jobs[idx].dupOf == BOSSL_NO_DUP || jobs[idx].item->failed)
+    {
+      continue;
+    }
+    orig = &jobs[jobs[idx].dupOf];
+    if (!orig->done)
+    {
+      _verifySegment(orig);
+    }
+    _applyResult(jobs[idx].item, orig->valid, orig->status);
+  }
+}
+
+/**
+ * Return the job that verifies the same signature segment over the same
+ * message digest as the given job or add the job to the lookup table. The table uses
+ * open addressing and must have more slots than there are jobs.
+ *
+ * @param jobs The jobs.
+ * @param jobIdx The index of the job to look up.
+ * @param table The lookup table, empty slots are BOSSL_NO_DUP.
+ * @param tableMask The number of slots - 1, the number of slots is a power
+ *                  of 2.
+ *
+ * @return The index of the job with the same segment or BOSSL_NO_DUP.
+ */
+static int _findDuplicate(BOSSL_Job* jobs, int jobIdx, int* table,
+                          u_int32_t tableMask)
+{
+  BOSSL_Job* job    = &jobs[jobIdx];
+  BOSSL_Job* other  = NULL;
+  SCA_BGPSEC_SignatureSegment* sigSeg
+                      = (SCA_BGPSEC_SignatureSegment*)job->hashMsg->signaturePtr;
+  int        segLen = LEN_SIGSEGMENT_HDR + ntohs(sigSeg->siglen);
+  u_int32_t  hash   = 0;
+  u_int32_t  slot   = 0;
+
+  // The digest is a SHA-256 hash, its first bytes are random enough.
+  memcpy(&hash, job->digest, sizeof(u_int32_t));
+
+  for (slot = hash & tableMask; table[slot] != BOSSL_NO_DUP;
+       slot = (slot + 1) & tableMask)
+  {
+    // Slots of jobs that were taken back (see _addJobs) are skipped.
+    other = &jobs[table[slot]];
+    if (   table[slot] < jobIdx
+        && ((SCA_BGPSEC_SignatureSegment*)other->hashMsg->signaturePtr)->siglen
+           == sigSeg->siglen
+        && memcmp(other->digest, job->digest, SHA256_DIGEST_LENGTH) == 0
+        && memcmp(other->hashMsg->signaturePtr, job->hashMsg->signaturePtr,
+                  segLen) == 0)
+    {
+      return table[slot];
+    }
+  }
+  table[slot] = jobIdx;
+
+  return BOSSL_NO_DUP;
+}
+
+/**
+ * Make sure the hash message of the update exists. The following error
+ * status codes can be set:
+ *
+ * API_STATUS_ERR_USER1: The hash input could not be generated
+ * API_STATUS_ERR_NO_DATA: No data to validate passed.
+ *
+ * @param data The validation data of the update.
+ *
+ * @return true if the signatures can be verified.
+ */
+static bool _prepareValidation(SCA_BGPSecValidationData* data)
+{
+  bool retVal = false;
+
+  data->status = API_STATUS_ERR_NO_DATA;
+  if (data->nlri != NULL)
+  {
+    if (data->bgpsec_path_attr != NULL)
+    {
+      // Generate the hash if none was generated prior.
+      if (data->hashMessage[0] == NULL)
+      {
+        if (sca_generateHashMessage(data, SCA_ECDSA_ALGORITHM, &data->status) > 0)
+        {
+          // Now reset the values to allow the validation to be performed.
+          data->status = API_STATUS_OK;
+          retVal       = true;
+        }
+        else
+        {
+          data->status = API_STATUS_ERR_USER1;
+        }
+      }
+      else
+      {
+        data->status = API_STATUS_OK;
+        retVal       = true;
+      }
+    }
+  }
+
+  return retVal;
+}
+
+/**
+ * Look up the signer keys of all signature segments of the update and add one
+ * job per segment. The key storage is only accessed from the calling thread.
+ * If a key is not found the update is invalid and no job is added.
+ * The segments are processed from the last signer towards the origin. Once a
+ * segment is found in the cache, it and all segments closer to the origin
+ * were verified before and no further jobs are added.
+ *
+ * @param item The update.
+ * @param jobs The job array to add to.
+ * @param noJobs IN/OUT the number of jobs in the array.
+ * @param table The duplicate lookup table (see _findDuplicate) or NULL.
+ * @param tableMask The number of slots in the table - 1.
+ */
+static void _addJobs(BOSSL_Item* item, BOSSL_Job* jobs, int* noJobs,
+                     int* table, u_int32_t tableMask)
+{
+  SCA_HashMessage* hashMessage = item->data->hashMessage[0];
+  SCA_BGPSEC_SignatureSegment* sigSeg = NULL;
+  u_int32_t* asn       = NULL;
+  EC_KEY**   ecdsa_key = NULL;
+  u_int16_t  noKeys    = 0;
+  int        first     = *noJobs;
+  int        idx       = 0;
+
+  item->firstJob = first;
+  for (; idx < hashMessage->segmentCount; idx++)
+  {
+    sigSeg = (SCA_BGPSEC_SignatureSegment*)
+                              hashMessage->hashMessageValPtr[idx]->signaturePtr;
+    // Generate the hash (messageDigest that is signed.)
+    _createSha256Digest(hashMessage->hashMessageValPtr[idx]->hashMessagePtr,
+                        hashMessage->hashMessageValPtr[idx]->hashMessageLength,
+                        jobs[*noJobs].digest);
+    if (BOSSL_cache != NULL
+        && sc_lookup(BOSSL_cache, jobs[*noJobs].digest, sigSeg,
+                     hashMessage->segmentCount - idx))
+    {
+      break;
+    }
+
+    // We want to have the signer key, This will be found in the next
+    // path segment.
+    if (idx+1 < hashMessage->segmentCount)
+    {
+      asn = (u_int32_t*)hashMessage->hashMessageValPtr[idx+1]->hashMessagePtr;
+    }
+    else
+    {
+      // Jump to the origin AS
+      asn = (u_int32_t*)(hashMessage->hashMessageValPtr[idx]->hashMessagePtr+6);
+    }
+
+    /* The OpenSSL encoded key. */
+    ecdsa_key = (EC_KEY**)ks_getKey(BOSSL_pubKeys, sigSeg->ski, *asn,
+                                    &noKeys, ks_eckey_e, &item->data->status);
+    if (ecdsa_key == NULL)
+    {
+      item->failed  = true;
+      item->status |= API_STATUS_INFO_KEY_NOTFOUND;
+      *noJobs = first; // No further validation needed
+      break;
+    }
+
+    jobs[*noJobs].item      = item;
+    jobs[*noJobs].hashMsg   = hashMessage->hashMessageValPtr[idx];
+    jobs[*noJobs].ecdsa_key = ecdsa_key;
+    jobs[*noJobs].noKeys    = noKeys;
+    jobs[*noJobs].dupOf     = BOSSL_NO_DUP;
+    jobs[*noJobs].done      = false;
+    if (table != NULL)
+    {
+      jobs[*noJobs].dupOf = _findDuplicate(jobs, *noJobs, table, tableMask);
+    }
+    (*noJobs)++;
+  }
+  item->noJobs = *noJobs - first;
+}
+
+/**
+ * Add the verified signature segments of all valid updates to the cache.
+ * Segments of invalid updates are not added, a cached segment always implies
+ * that all segments closer to the origin are valid as well.
+ *
+ * @param items The updates.
+ * @param numItems The number of updates.
+ * @param jobs The jobs, all jobs must have been run.
+ */
+static void _cacheResults(BOSSL_Item* items, int numItems, BOSSL_Job* jobs)
+{
+  SCA_BGPSEC_SignatureSegment* sigSeg = NULL;
+  int idx;
+  int jobIdx;
+
+  for (idx = 0; idx < numItems; idx++)
+  {
+    if (items[idx].failed)
+    {
+      continue;
+    }
+    for (jobIdx = items[idx].firstJob;
+         jobIdx < items[idx].firstJob + items[idx].noJobs; jobIdx++)
+    {
+      sigSeg = (SCA_BGPSEC_SignatureSegment*)jobs[jobIdx].hashMsg->signaturePtr;
+      sc_insert(BOSSL_cache, jobs[jobIdx].digest, sigSeg);
+    }
+  }
+}
+
+/**
+ * Perform BGPSEC path validation for a batch of updates. The signature
+ * segments of all updates are verified together, by the validation threads if
+ * configured (see init). The validation of an update stops at the first
+ * signature segment that fails. A signature segment that is contained in more
+ * than one update with the same signed data, e.g. a path announced for many
+ * prefixes, is verified only once. Signature segments verified in earlier
+ * calls are taken from the cache (see CACHE in init).
+ * The caller manages the memory and MUST assure the memory is intact until
+ * the function returns.
+ *
+ * The status of each update is set as described for validate.
+ *
+ * @param data The updates to validate.
+ * @param numData The number of updates.
+ * @param results Receives API_VALRESULT_VALID(1) or API_VALRESULT_INVALID(0)
+ *                for each update, can be NULL.
+ *
+ * @return The number of valid updates.
+ */
+int validateBatch(SCA_BGPSecValidationData** data, int numData, int* results)
+{
+  // @TODO: Currently we only deal with the first validation data result.
+  //       It needs to be modified in such that it uses both results [0] and [1]
+  BOSSL_Item* items     = NULL;
+  BOSSL_Job*  jobs      = NULL;
+  int*        table     = NULL;
+  u_int32_t   tableMask = 0;
+  u_int32_t   epoch     = 0;
+  int         noJobs    = 0;
+  int         valid     = 0;
+  int         idx       = 0;
+
+  if (numData <= 0)
+  {
+    return 0;
+  }
+
+  items = malloc(numData * sizeof(BOSSL_Item));
+  memset(items, 0, numData * sizeof(BOSSL_Item));
+
+  // Do some preliminary check
+  for (idx = 0; idx < numData; idx++)
+  {
+    items[idx].data   = data[idx];
+    items[idx].failed = (data[idx] == NULL) || !_prepareValidation(data[idx]);
+    if (!items[idx].failed)
+    {
+      noJobs += data[idx]->hashMessage[0]->segmentCount;
+    }
+  }
+
+  // Now find the keys and verify all signature segments. The keys stay valid
+  // until the read section ends, even if they are unregistered concurrently.
+  if (noJobs > 0)
+  {
+    epoch = ks_beginRead(BOSSL_pubKeys);
+    jobs = malloc(noJobs * sizeof(BOSSL_Job));
+    if (numData > 1)
+    {
+      // Keep the duplicate lookup table at most half full.
+      for (tableMask = 1; tableMask < (u_int32_t)noJobs * 2; tableMask <<= 1);
+      table = malloc(tableMask * sizeof(int));
+      memset(table, 0xff, tableMask * sizeof(int)); // all BOSSL_NO_DUP
+      tableMask--;
+    }
+    noJobs = 0;
+    for (idx = 0; idx < numData; idx++)
+    {
+      if (!items[idx].failed)
+      {
+        _addJobs(&items[idx], jobs, &noJobs, table, tableMask);
+      }
+    }
+    _runJobs(jobs, noJobs);
+    _resolveDuplicates(jobs, noJobs);
+    if (BOSSL_cache != NULL)
+    {
+      _cacheResults(items, numData, jobs);
+    }
+    ks_endRead(BOSSL_pubKeys, epoch);
+    free(table);
+    free(jobs);
+  }
+
+  for (idx = 0; idx < numData; idx++)
+  {
+    if (data[idx] != NULL)
+    {
+      data[idx]->status |= items[idx].status;
+    }
+    if (!items[idx].failed)
+    {
+      valid++;
+    }
+    if (results != NULL)
+    {
+      results[idx] = items[idx].failed ? API_VALRESULT_INVALID
+                                       : API_VALRESULT_VALID;
+    }
+  }
+  free(items);
+
+  return valid;
+}
+
 /**
  * Perform BGPSEC path validation. This function required the keys to be 
  * pre-registered to perform the validation. 
@@ -525,128 +1316,13 @@ static unsigned char* _createSha256Digest(const unsigned char* message,
  */
 int validate(SCA_BGPSecValidationData* data)
 {
-  // @TODO: Currently we only deal with the first validation data result.
-  //       It needs to be modified in such that it uses both results [0] and [1]
-  int retVal = API_VALRESULT_INVALID;
-  
-  // Do some preliminary check
-  if (data != NULL)
+  if (data == NULL)
   {
-    data->status = API_STATUS_ERR_NO_DATA;
-    if (data->nlri != NULL)
-    {
-      if (data->bgpsec_path_attr != NULL)
-      {
-        // Generate the hash if none was generated prior.
-        if (data->hashMessage[0] == NULL)
-        {
-          if (sca_generateHashMessage(data, SCA_ECDSA_ALGORITHM, &data->status) > 0)
-          {
-            // Now reset the values to allow the validation to be performed.
-            data->status = API_STATUS_OK;
-            retVal       = API_SUCCESS;
-          }
-          else
-          {
-            data->status = API_STATUS_ERR_USER1;
-            retVal       = API_VALRESULT_INVALID; 
-          }
-        }
-        else
-        {
-          data->status = API_STATUS_OK;
-          retVal       = API_VALRESULT_VALID;
-        }
-      }
-    }
+    return API_VALRESULT_INVALID;
   }
-    
-  // Now perform validation
-  if (retVal == API_VALRESULT_VALID)
-  {
-    // Now we can validate each signature -> This can be multi threaded
-    // in this case the variables below need to be declared in each thread
-    // separately.
-    u_int32_t* asn       = NULL;
-    EC_KEY**   ecdsa_key = NULL;
-    u_int8_t*  signature = NULL;
-    u_int16_t  sigLength = 0;
-    SCA_BGPSEC_SignatureSegment* sigSeg = NULL;
-    int idx = 0;
-
-    u_int16_t noKeys = 0;
-    int ecIdx = 0;
-
-    // Temporary space for the generated message digest (hash)
-    u_int8_t hashDigest[SHA256_DIGEST_LENGTH];
-
-    for (; idx < data->hashMessage[0]->segmentCount; idx++)
-    {
-      // We want to have the signer key, This will be found in the next 
-      // path segment.
-      if (idx+1 < data->hashMessage[0]->segmentCount)
-      {
-        asn = (u_int32_t*)data->hashMessage[0]->hashMessageValPtr[idx+1]->hashMessagePtr;
-      }
-      else
-      {
-        // Jump to the origin AS
-        asn = (u_int32_t*)(data->hashMessage[0]->hashMessageValPtr[idx]->hashMessagePtr+6);
-      }
-      sigSeg = (SCA_BGPSEC_SignatureSegment*)data->hashMessage[0]->hashMessageValPtr[idx]->signaturePtr;
 
-      /* The OpenSSL encoded key. */        
-      ecdsa_key = (EC_KEY**)ks_getKey(BOSSL_pubKeys, sigSeg->ski, *asn, 
-                            &noKeys, ks_eckey_e, &data->status);
-      if (ecdsa_key != NULL)
-      {
-        // Generate the hash (messageDigest that will be signed.)
-        _createSha256Digest (
-                 data->hashMessage[0]->hashMessageValPtr[idx]->hashMessagePtr, 
-                 data->hashMessage[0]->hashMessageValPtr[idx]->hashMessageLength,
-                 (u_int8_t*)&hashDigest);
-
-        signature = data->hashMessage[0]->hashMessageValPtr[idx]->signaturePtr 
-                    + sizeof(SCA_BGPSEC_SignatureSegment);
-        // find the signature:
-        sigLength = ntohs(sigSeg->siglen);
-
-        retVal = API_VALRESULT_INVALID;
-        for (ecIdx=0; ecIdx < noKeys && retVal==API_VALRESULT_INVALID; ecIdx++)
-        {
-          if (ecdsa_key[ecIdx] != NULL)
-          { // Toggle through the keys
-            /* verify the signature */            
-            if (ECDSA_verify(0, hashDigest, SHA256_DIGEST_LENGTH, 
-                             signature, sigLength, ecdsa_key[ecIdx])
-               == 1)
-            {
-              retVal = API_VALRESULT_VALID;
-            }
-          }
-          else
-          {
-            // Most likely a registration error!
-            data->status |= API_STATUS_ERR_INVLID_KEY;
-            sca_debugLog(LOG_WARNING, "The key storage returned a NULL eckey\n");              
-          }
-        }
-
-        if (retVal == API_VALRESULT_INVALID)
-        {
-          data->status |= API_STATUS_INFO_SIGNATURE;            
-        }
-      }
-      else
-      {
-        retVal = API_VALRESULT_INVALID;
-        data->status |= API_STATUS_INFO_KEY_NOTFOUND;
-        break; // No further validation needed
-      }     
-    }
-  }
-  
-  return retVal;
+  return validateBatch(&data, 1, NULL) == 1 ? API_VALRESULT_VALID
+                                            : API_VALRESULT_INVALID;
 }
 
   /**
@@ -723,6 +1399,7 @@ int validate(SCA_BGPSecValidationData* data)
     {
       // First find the key
       u_int16_t noKeys = 0;
+      u_int32_t epoch  = ks_beginRead(BOSSL_privKeys);
       bgpsec_data->status = API_STATUS_OK;
       EC_KEY** ec_keys = (EC_KEY**)ks_getKey(BOSSL_privKeys, bgpsec_data->ski, 
                                              bgpsec_data->myHost->asn, &noKeys, 
@@ -791,6 +1468,7 @@ int validate(SCA_BGPSecValidationData* data)
           retVal = API_SUCCESS;
         }
       }
+      ks_endRead(BOSSL_privKeys, epoch);
     }
     
     if (bgpsec_data != NULL)
@@ -879,7 +1557,8 @@ int validate(SCA_BGPSecValidationData* data)
   /**
    * Remove the registered key with the same ski and asn. (Optional)
    * This method allows to remove a particular key that is registered for the
-   * given SKI and ASN.
+   * given SKI and ASN. Signature segments verified with the key must not be
+   * accepted anymore, therefore the cache of verified segments is emptied.
    *
    * The following errors can be reported:
    *   See key_storage.ks_delKey()
@@ -891,5 +1570,24 @@ int validate(SCA_BGPSecValidationData* data)
    */
   u_int8_t unregisterPublicKey(BGPSecKey* key, sca_status_t* status)
   {
-    return ks_delKey(BOSSL_pubKeys, key, status);
+    u_int8_t retVal = ks_delKey(BOSSL_pubKeys, key, status);
+    sc_flush(BOSSL_cache);
+    return retVal;
+  }
+
+  /**
+   * Return the statistics of the cache of verified signature segments.
+   *
+   * @param stats The statistics object to be filled.
+   *
+   * @return false if the cache is disabled (see CACHE in init).
+   */
+  bool getCacheStatistics(SCA_CacheStatistics* stats)
+  {
+    if (BOSSL_cache == NULL || stats == NULL)
+    {
+      return false;
+    }
+    sc_getStatistics(BOSSL_cache, stats);
+    return true;
   }
\ No newline at end of file
@@ -0,0 +1,510 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * This file provides the implementation of the hot key tables.
+ *
+ * @version 0.2.0.2
+ */
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <syslog.h>
+#include <openssl/bn.h>
+#include <openssl/ecdsa.h>
+#include <openssl/opensslv.h>
+#include "../srx/srxcryptoapi.h"
+#include "hot_keys.h"
+
+/** The use counts are halved after this many uses per tracked key. */
+#define HK_AGE_USES_PER_ENTRY 64
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+/**
+ * ECDSA_SIG is opaque since OpenSSL 1.1.0, provide its accessor for older
+ * versions.
+ */
+static void ECDSA_SIG_get0(const ECDSA_SIG* sig, const BIGNUM** r,
+                           const BIGNUM** s)
+{
+  *r = sig->r;
+  *s = sig->s;
+}
+#endif
+
+/**
+ * Release one reference of the table. Does not require the hot keys to be
+ * locked, a verification releases its reference without taking the lock.
+ *
+ * @param table The table.
+ */
+static void _releaseTable(HK_Table* table)
+{
+  if (__atomic_sub_fetch(&table->refs, 1, __ATOMIC_ACQ_REL) == 0)
+  {
+    EC_GROUP_free(table->group);
+    EC_KEY_free(table->key);
+    free(table);
+  }
+}
+
+/**
+ * Compute the table for the given key. This takes some milliseconds and is
+ * done without holding the lock.
+ *
+ * @param key The public key.
+ *
+ * @return The table with one reference or NULL.
+ */
+static HK_Table* _createTable(EC_KEY* key)
+{
+  const EC_GROUP* curve = EC_KEY_get0_group(key);
+  HK_Table*       table = malloc(sizeof(HK_Table));
+  BN_CTX*         ctx   = BN_CTX_new();
+  BIGNUM*         order = BN_new();
+  BIGNUM*         cofac = BN_new();
+  bool            ok    = false;
+
+  if (table != NULL && ctx != NULL && order != NULL && cofac != NULL)
+  {
+    table->refs  = 1;
+    table->key   = key;
+    table->group = EC_GROUP_dup(curve);
+    ok =    table->group != NULL
+         && EC_GROUP_get_order(curve, order, ctx)
+         && EC_GROUP_get_cofactor(curve, cofac, ctx)
+         && EC_GROUP_set_generator(table->group, EC_KEY_get0_public_key(key),
+                                   order, cofac)
+         && EC_GROUP_precompute_mult(table->group, ctx);
+    if (ok)
+    {
+      EC_KEY_up_ref(key);
+    }
+    else
+    {
+      EC_GROUP_free(table->group);
+    }
+  }
+
+  if (!ok)
+  {
+    sca_debugLog(LOG_WARNING, "Could not compute the table of a public key\n");
+    free(table);
+    table = NULL;
+  }
+  BN_free(cofac);
+  BN_free(order);
+  BN_CTX_free(ctx);
+
+  return table;
+}
+
+/**
+ * Verify the signature using the table of the public key. Same as
+ * ECDSA_verify, except that u2 * Q is computed with the table.
+ *
+ * @param table The table of the public key.
+ * @param digest The signed digest.
+ * @param digestLen The length of the digest.
+ * @param signature The DER encoded signature.
+ * @param sigLen The length of the signature.
+ *
+ * @return 1 if valid, 0 if invalid, and -1 on error
+ */
+static int _verifyWithTable(HK_Table* table, const u_int8_t* digest,
+                            int digestLen, const u_int8_t* signature,
+                            int sigLen)
+{
+  const EC_GROUP* curve  = EC_KEY_get0_group(table->key);
+  const u_int8_t* ptr    = signature;
+  const BIGNUM*   r      = NULL;
+  const BIGNUM*   s      = NULL;
+  ECDSA_SIG*      sig    = NULL;
+  EC_POINT*       point  = NULL;
+  EC_POINT*       qPoint = NULL;
+  BN_CTX*         ctx    = NULL;
+  BIGNUM*         order  = NULL;
+  BIGNUM*         e      = NULL;
+  BIGNUM*         w      = NULL;
+  BIGNUM*         u1     = NULL;
+  BIGNUM*         u2     = NULL;
+  BIGNUM*         x      = NULL;
+  u_int8_t*       der    = NULL;
+  int             derLen = 0;
+  int             bits   = 0;
+  int             retVal = -1;
+
+  // Only accept the DER encoding of the signature, same as ECDSA_verify.
+  sig = d2i_ECDSA_SIG(NULL, &ptr, sigLen);
+  if (sig == NULL)
+  {
+    return -1;
+  }
+  derLen = i2d_ECDSA_SIG(sig, &der);
+  if (derLen != sigLen || memcmp(signature, der, derLen) != 0)
+  {
+    OPENSSL_free(der);
+    ECDSA_SIG_free(sig);
+    return -1;
+  }
+  OPENSSL_free(der);
+  ECDSA_SIG_get0(sig, &r, &s);
+
+  ctx = BN_CTX_new();
+  if (ctx == NULL)
+  {
+    ECDSA_SIG_free(sig);
+    return -1;
+  }
+  BN_CTX_start(ctx);
+  order = BN_CTX_get(ctx);
+  e     = BN_CTX_get(ctx);
+  w     = BN_CTX_get(ctx);
+  u1    = BN_CTX_get(ctx);
+  u2    = BN_CTX_get(ctx);
+  x     = BN_CTX_get(ctx);
+  point  = EC_POINT_new(curve);
+  qPoint = EC_POINT_new(table->group);
+
+  if (x != NULL && point != NULL && qPoint != NULL
+      && EC_GROUP_get_order(curve, order, ctx))
+  {
+    retVal = 0;
+    if (   !BN_is_zero(r) && !BN_is_negative(r) && BN_ucmp(r, order) < 0
+        && !BN_is_zero(s) && !BN_is_negative(s) && BN_ucmp(s, order) < 0)
+    {
+      retVal = -1;
+      // Use the leftmost bits of the digest if it is longer than the order.
+      bits = BN_num_bits(order);
+      if (digestLen * 8 > bits)
+      {
+        digestLen = (bits + 7) / 8;
+      }
+      if (   BN_bin2bn(digest, digestLen, e) != NULL
+          && (digestLen * 8 <= bits || BN_rshift(e, e, 8 - (bits & 7)))
+          && BN_mod_inverse(w, s, order, ctx) != NULL
+          && BN_mod_mul(u1, e, w, order, ctx)
+          && BN_mod_mul(u2, r, w, order, ctx)
+          // u1 * G with the table of the curve, u2 * Q with the key table
+          && EC_POINT_mul(curve, point, u1, NULL, NULL, ctx)
+          && EC_POINT_mul(table->group, qPoint, u2, NULL, NULL, ctx)
+          && EC_POINT_add(curve, point, point, qPoint, ctx))
+      {
+        retVal = 0;
+        if (!EC_POINT_is_at_infinity(curve, point)
+            && EC_POINT_get_affine_coordinates_GFp(curve, point, x, NULL, ctx)
+            && BN_nnmod(x, x, order, ctx))
+        {
+          retVal = BN_ucmp(x, r) == 0 ? 1 : 0;
+        }
+      }
+    }
+  }
+
+  EC_POINT_free(qPoint);
+  EC_POINT_free(point);
+  BN_CTX_end(ctx);
+  BN_CTX_free(ctx);
+  ECDSA_SIG_free(sig);
+
+  return retVal;
+}
+
+/**
+ * Advance the clock and halve all use counts regularly. Requires the hot keys
+ * to be locked.
+ *
+ * @param hotKeys The hot key tracking.
+ *
+ * @return The new time, never 0.
+ */
+static u_int32_t _tick(HotKeys* hotKeys)
+{
+  u_int32_t size = (hotKeys->setMask + 1) * HK_WAYS;
+  u_int32_t idx;
+
+  hotKeys->clock++;
+  if ((hotKeys->clock % (size * HK_AGE_USES_PER_ENTRY)) == 0)
+  {
+    for (idx = 0; idx < size; idx++)
+    {
+      hotKeys->entries[idx].hits >>= 1;
+      if (hotKeys->clock == 0)
+      {
+        // Wrap around, restart the LRU order.
+        hotKeys->entries[idx].used = 0;
+      }
+    }
+    if (hotKeys->clock == 0)
+    {
+      hotKeys->clock = 1;
+    }
+  }
+
+  return hotKeys->clock;
+}
+
+/**
+ * Remove the key of the entry from the tracking. Requires the hot keys to be
+ * locked.
+ *
+ * @param hotKeys The hot key tracking.
+ * @param entry The entry.
+ */
+static void _removeEntry(HotKeys* hotKeys, HK_Entry* entry)
+{
+  if (entry->table != NULL)
+  {
+    _releaseTable(entry->table);
+    hotKeys->noTables--;
+  }
+  EC_KEY_free(entry->key);
+  memset(entry, 0, sizeof(HK_Entry));
+}
+
+/**
+ * Find the entry of the key or add one, replacing the least recently used key
+ * of the set. Requires the hot keys to be locked.
+ *
+ * @param hotKeys The hot key tracking.
+ * @param key The key.
+ *
+ * @return The entry or NULL if all keys of the set are being promoted.
+ */
+static HK_Entry* _getEntry(HotKeys* hotKeys, EC_KEY* key)
+{
+  // The lower pointer bits are the same for all keys.
+  uintptr_t hash   = ((uintptr_t)key >> 4) ^ ((uintptr_t)key >> 12);
+  HK_Entry* set    = hotKeys->entries + ((hash & hotKeys->setMask) * HK_WAYS);
+  HK_Entry* victim = NULL;
+  int       way;
+
+  for (way = 0; way < HK_WAYS; way++)
+  {
+    if (set[way].key == key)
+    {
+      return &set[way];
+    }
+    if (!set[way].building
+        && (victim == NULL || set[way].used < victim->used))
+    {
+      victim = &set[way];
+    }
+  }
+
+  if (victim != NULL)
+  {
+    if (victim->key != NULL)
+    {
+      _removeEntry(hotKeys, victim);
+    }
+    // Keep the key alive, a deleted key must not share its address with a new
+    // key that is tracked.
+    EC_KEY_up_ref(key);
+    victim->key = key;
+  }
+
+  return victim;
+}
+
+/**
+ * Determine if the entry can get a table. If all tables are used, the key
+ * with the fewest uses loses its table if the entry has twice as many uses.
+ * Requires the hot keys to be locked.
+ *
+ * @param hotKeys The hot key tracking.
+ * @param entry The entry to be promoted.
+ * @param demote Receives the entry that has to lose its table or NULL.
+ *
+ * @return true if the entry can get a table.
+ */
+static bool _canPromote(HotKeys* hotKeys, HK_Entry* entry, HK_Entry** demote)
+{
+  u_int32_t size = (hotKeys->setMask + 1) * HK_WAYS;
+  u_int32_t idx;
+
+  *demote = NULL;
+  if (hotKeys->noTables < hotKeys->maxTables)
+  {
+    return true;
+  }
+
+  for (idx = 0; idx < size; idx++)
+  {
+    if (hotKeys->entries[idx].table != NULL
+        && (*demote == NULL || hotKeys->entries[idx].hits < (*demote)->hits))
+    {
+      *demote = &hotKeys->entries[idx];
+    }
+  }
+
+  return *demote != NULL && ((*demote)->hits * 2) < entry->hits;
+}
+
+/**
+ * Create the hot key tracking.
+ *
+ * @param maxTables The maximum number of keys with a precomputed table.
+ *
+ * @return The hot key tracking or NULL if maxTables is 0.
+ */
+HotKeys* hk_create(u_int32_t maxTables)
+{
+  HotKeys*  hotKeys = NULL;
+  u_int32_t noSets  = 1;
+
+  if (maxTables == 0)
+  {
+    return NULL;
+  }
+
+  while ((noSets * HK_WAYS) < (maxTables * HK_TRACKED_PER_TABLE))
+  {
+    noSets <<= 1;
+  }
+
+  hotKeys = malloc(sizeof(HotKeys));
+  if (hotKeys != NULL)
+  {
+    memset(hotKeys, 0, sizeof(HotKeys));
+    hotKeys->entries = calloc(noSets * HK_WAYS, sizeof(HK_Entry));
+    if (hotKeys->entries == NULL)
+    {
+      free(hotKeys);
+      return NULL;
+    }
+    hotKeys->setMask   = noSets - 1;
+    hotKeys->maxTables = maxTables;
+    pthread_mutex_init(&hotKeys->mutex, NULL);
+  }
+
+  return hotKeys;
+}
+
+/**
+ * Release all tables and key references.
+ *
+ * @param hotKeys The hot key tracking, can be NULL.
+ */
+void hk_free(HotKeys* hotKeys)
+{
+  u_int32_t idx;
+
+  if (hotKeys != NULL)
+  {
+    for (idx = 0; idx < (hotKeys->setMask + 1) * HK_WAYS; idx++)
+    {
+      if (hotKeys->entries[idx].key != NULL)
+      {
+        _removeEntry(hotKeys, &hotKeys->entries[idx]);
+      }
+    }
+    pthread_mutex_destroy(&hotKeys->mutex);
+    free(hotKeys->entries);
+    free(hotKeys);
+  }
+}
+
+/**
+ * Verify the signature with the given key. A precomputed table is used if the
+ * key has one, otherwise ECDSA_verify. The use of the key is counted and the
+ * table is computed once the key is used often enough.
+ *
+ * @param hotKeys The hot key tracking.
+ * @param key The public key.
+ * @param digest The signed digest.
+ * @param digestLen The length of the digest.
+ * @param signature The DER encoded signature.
+ * @param sigLen The length of the signature.
+ *
+ * @return 1 if valid, 0 if invalid, and -1 on error (see ECDSA_verify)
+ */
+int hk_verify(HotKeys* hotKeys, EC_KEY* key, const u_int8_t* digest,
+              int digestLen, const u_int8_t* signature, int sigLen)
+{
+  HK_Entry* entry   = NULL;
+  HK_Entry* demote  = NULL;
+  HK_Table* table   = NULL;
+  bool      promote = false;
+  int       retVal  = 0;
+
+  pthread_mutex_lock(&hotKeys->mutex);
+  entry = _getEntry(hotKeys, key);
+  if (entry != NULL)
+  {
+    entry->hits++;
+    entry->used = _tick(hotKeys);
+    table       = entry->table;
+    if (table != NULL)
+    {
+      // The entry holds a reference, the table can not be freed meanwhile.
+      __atomic_add_fetch(&table->refs, 1, __ATOMIC_RELAXED);
+    }
+    else if (!entry->building && entry->hits >= HK_PROMOTE_HITS)
+    {
+      promote = _canPromote(hotKeys, entry, &demote);
+      entry->building = promote;
+    }
+  }
+  pthread_mutex_unlock(&hotKeys->mutex);
+
+  if (promote)
+  {
+    // The entry is not replaced while it is being built.
+    table = _createTable(key);
+    pthread_mutex_lock(&hotKeys->mutex);
+    entry->building = false;
+    if (table != NULL)
+    {
+      if (_canPromote(hotKeys, entry, &demote))
+      {
+        if (demote != NULL)
+        {
+          _releaseTable(demote->table);
+          demote->table = NULL;
+          hotKeys->noTables--;
+        }
+        entry->table = table;
+        hotKeys->noTables++;
+        __atomic_add_fetch(&table->refs, 1, __ATOMIC_RELAXED);
+        sca_debugLog(LOG_INFO, "Precomputed the table of a public key\n");
+      }
+      else
+      {
+        _releaseTable(table);
+        table = NULL;
+      }
+    }
+    pthread_mutex_unlock(&hotKeys->mutex);
+  }
+
+  if (table != NULL)
+  {
+    retVal = _verifyWithTable(table, digest, digestLen, signature, sigLen);
+    _releaseTable(table);
+  }
+  else
+  {
+    retVal = ECDSA_verify(0, digest, digestLen, signature, sigLen, key);
+  }
+
+  return retVal;
+}
@@ -0,0 +1,132 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * This file provides precomputed verification tables for frequently used
+ * public keys. ECDSA_verify multiplies the public key point with a scalar for
+ * each signature, only the multiplication with the curve generator uses a
+ * precomputed table. The keys of a few transit ASes are part of nearly every
+ * path, for these a copy of the curve is created that uses the public key as
+ * generator and OpenSSL precomputes the multiples of it. The verification
+ * then performs two multiplications with precomputed tables.
+ *
+ * The keys are tracked by their use counts, which are halved regularly. A key
+ * is promoted once it is used HK_PROMOTE_HITS times, at most the configured
+ * number of keys keep a table. Each table has a fixed size determined by the
+ * curve (about 150 KB for P-256). All other keys are verified by OpenSSL.
+ * All functions are thread safe, the lock is only held to find or insert the
+ * entry of a key.
+ *
+ * @version 0.2.0.2
+ */
+#ifndef HOT_KEYS_H
+#define HOT_KEYS_H
+
+#include <sys/types.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <openssl/ec.h>
+
+/** The number of keys tracked per set. */
+#define HK_WAYS               4
+/** The number of keys tracked per table. */
+#define HK_TRACKED_PER_TABLE  8
+/** The number of uses after which a key gets a table. */
+#define HK_PROMOTE_HITS       256
+
+/** The verification table of one public key. */
+typedef struct
+{
+  /** The key, referenced as long as the table exists. */
+  EC_KEY*   key;
+  /** The curve of the key with the public key as generator. */
+  EC_GROUP* group;
+  /** The number of users, the table is freed when it drops to 0. Modified
+   * atomically, a user releases its reference without holding the lock. */
+  int       refs;
+} HK_Table;
+
+/** The use count of one key. */
+typedef struct
+{
+  /** The key, referenced as long as it is tracked, NULL for an empty entry. */
+  EC_KEY*   key;
+  /** The table of the key or NULL. */
+  HK_Table* table;
+  /** The number of uses, halved regularly. */
+  u_int32_t hits;
+  /** The time of the last use. */
+  u_int32_t used;
+  /** Set while the table of the key is computed. */
+  bool      building;
+} HK_Entry;
+
+typedef struct
+{
+  /** The tracked keys, HK_WAYS per set. */
+  HK_Entry*       entries;
+  /** The number of sets - 1, the number of sets is a power of 2. */
+  u_int32_t       setMask;
+  /** The maximum number of tables. */
+  u_int32_t       maxTables;
+  /** The number of tables. */
+  u_int32_t       noTables;
+  /** Counts the uses, used for the LRU replacement and aging. */
+  u_int32_t       clock;
+  /** Protects the entries, it is held to find or insert the entry of a key
+   * but not while a signature is verified. */
+  pthread_mutex_t mutex;
+} HotKeys;
+
+/**
+ * Create the hot key tracking.
+ *
+ * @param maxTables The maximum number of keys with a precomputed table.
+ *
+ * @return The hot key tracking or NULL if maxTables is 0.
+ */
+HotKeys* hk_create(u_int32_t maxTables);
+
+/**
+ * Release all tables and key references.
+ *
+ * @param hotKeys The hot key tracking, can be NULL.
+ */
+void hk_free(HotKeys* hotKeys);
+
+/**
+ * Verify the signature with the given key. A precomputed table is used if the
+ * key has one, otherwise ECDSA_verify. The use of the key is counted and the
+ * table is computed once the key is used often enough.
+ *
+ * @param hotKeys The hot key tracking.
+ * @param key The public key.
+ * @param digest The signed digest.
+ * @param digestLen The length of the digest.
+ * @param signature The DER encoded signature.
+ * @param sigLen The length of the signature.
+ *
+ * @return 1 if valid, 0 if invalid, and -1 on error (see ECDSA_verify)
+ */
+int hk_verify(HotKeys* hotKeys, EC_KEY* key, const u_int8_t* digest,
+              int digestLen, const u_int8_t* signature, int sigLen);
+
+#endif /* HOT_KEYS_H */
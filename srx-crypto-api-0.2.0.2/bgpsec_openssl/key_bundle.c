@@ -0,0 +1,282 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * This file provides the binary key bundle. Opening a bundle maps the file and
+ * checks the header only, the entries are checked when they are used.
+ *
+ * @version 0.2.0.2
+ */
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "key_bundle.h"
+
+/**
+ * Map the given bundle file and check its header. The keys are not read.
+ *
+ * Possible status values:
+ * API_STATUS_ERR_KEY_IO: The file could not be opened or mapped.
+ * API_STATUS_ERR_USER1: The file is not a valid bundle.
+ * API_STATUS_ERR_INSUF_KEYSTORAGE: Not enough memory.
+ *
+ * @param fileName The name of the bundle file.
+ * @param status An OUT parameter that receives the status flags, can be NULL.
+ *
+ * @return The bundle or NULL.
+ */
+KeyBundle* kb_open(const char* fileName, sca_status_t* status)
+{
+  sca_status_t myStatus = API_STATUS_OK;
+  KeyBundle*   bundle   = NULL;
+  KB_Header*   header   = NULL;
+  struct stat  fStat;
+  void*        map      = MAP_FAILED;
+  int          fd       = open(fileName, O_RDONLY);
+
+  if ((fd == -1) || (fstat(fd, &fStat) != 0))
+  {
+    myStatus = API_STATUS_ERR_KEY_IO;
+  }
+  else if ((size_t)fStat.st_size < sizeof(KB_Header))
+  {
+    myStatus = API_STATUS_ERR_USER1;
+  }
+  else
+  {
+    map = mmap(NULL, fStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+    {
+      myStatus = API_STATUS_ERR_KEY_IO;
+    }
+  }
+  if (fd != -1)
+  {
+    // The mapping stays valid after the file is closed.
+    close(fd);
+  }
+
+  if (map != MAP_FAILED)
+  {
+    header = (KB_Header*)map;
+    if (   (memcmp(header->magic, KB_MAGIC, KB_MAGIC_LEN) != 0)
+        || (ntohs(header->version) != KB_VERSION)
+        || (  ((size_t)fStat.st_size - sizeof(KB_Header)) / sizeof(KB_Entry)
+            < ntohl(header->noKeys)))
+    {
+      myStatus = API_STATUS_ERR_USER1;
+    }
+    else
+    {
+      bundle = malloc(sizeof(KeyBundle));
+      if (bundle != NULL)
+      {
+        memset(bundle, 0, sizeof(KeyBundle));
+        bundle->map       = (u_int8_t*)map;
+        bundle->size      = fStat.st_size;
+        bundle->algoID    = header->algoID;
+        bundle->isPrivate = header->isPrivate != 0;
+        bundle->noKeys    = ntohl(header->noKeys);
+        bundle->entries   = (KB_Entry*)(header + 1);
+        bundle->derKeys   = calloc(bundle->noKeys + 1, sizeof(BGPSecKey*));
+        bundle->ecKeys    = calloc(bundle->noKeys + 1, sizeof(EC_KEY*));
+        if ((bundle->derKeys == NULL) || (bundle->ecKeys == NULL))
+        {
+          free(bundle->derKeys);
+          free(bundle->ecKeys);
+          free(bundle);
+          bundle = NULL;
+        }
+      }
+      if (bundle == NULL)
+      {
+        myStatus = API_STATUS_ERR_INSUF_KEYSTORAGE;
+      }
+    }
+    if (bundle == NULL)
+    {
+      munmap(map, fStat.st_size);
+    }
+  }
+
+  if (bundle == NULL)
+  {
+    sca_debugLog(LOG_ERR, "Could not open the key bundle '%s' [0x%04X]\n",
+                 fileName, myStatus);
+  }
+  if (status != NULL)
+  {
+    *status = myStatus;
+  }
+
+  return bundle;
+}
+
+/**
+ * Release the bundle, the converted keys, and unmap the file.
+ *
+ * @param bundle The bundle, can be NULL.
+ */
+void kb_close(KeyBundle* bundle)
+{
+  u_int32_t idx;
+
+  if (bundle == NULL)
+  {
+    return;
+  }
+
+  for (idx = 0; idx < bundle->noKeys; idx++)
+  {
+    // The DER data is part of the mapping.
+    free(bundle->derKeys[idx]);
+    if (bundle->ecKeys[idx] != NULL)
+    {
+      EC_KEY_free(bundle->ecKeys[idx]);
+    }
+  }
+  free(bundle->derKeys);
+  free(bundle->ecKeys);
+  munmap(bundle->map, bundle->size);
+  free(bundle);
+}
+
+/**
+ * Compare the ASN and SKI of the given entry with the given values.
+ *
+ * @param entry The bundle entry.
+ * @param asn The ASN in network format.
+ * @param ski The SKI.
+ *
+ * @return <0, 0, >0 like memcmp.
+ */
+static int _kb_compare(KB_Entry* entry, u_int32_t asn, u_int8_t* ski)
+{
+  int cmp = memcmp(&entry->asn, &asn, sizeof(u_int32_t));
+
+  return (cmp != 0) ? cmp : memcmp(entry->ski, ski, SKI_LENGTH);
+}
+
+/**
+ * Find the keys with the given ASN and SKI. Thread safe.
+ *
+ * @param bundle The bundle.
+ * @param asn The ASN in network format.
+ * @param ski The SKI (SKI_LENGTH).
+ * @param first An OUT parameter, receives the index of the first key found.
+ *
+ * @return The number of keys found.
+ */
+u_int16_t kb_find(KeyBundle* bundle, u_int32_t asn, u_int8_t* ski,
+                  u_int32_t* first)
+{
+  u_int32_t low   = 0;
+  u_int32_t high  = bundle->noKeys;
+  u_int32_t mid;
+  u_int16_t count = 0;
+
+  // Find the first entry that is not smaller
+  while (low < high)
+  {
+    mid = low + (high - low) / 2;
+    if (_kb_compare(&bundle->entries[mid], asn, ski) < 0)
+    {
+      low = mid + 1;
+    }
+    else
+    {
+      high = mid;
+    }
+  }
+
+  while (   (low + count < bundle->noKeys) && (count < UINT16_MAX)
+         && (_kb_compare(&bundle->entries[low + count], asn, ski) == 0))
+  {
+    count++;
+  }
+  *first = low;
+
+  return count;
+}
+
+/**
+ * Return the DER keys starting with the given index, the keys are created on
+ * first use. Thread safe.
+ *
+ * @param bundle The bundle.
+ * @param first The index of the first key.
+ * @param noKeys The number of keys.
+ *
+ * @return The array of keys, an element is NULL if the entry is invalid or
+ *         not enough memory is available.
+ */
+BGPSecKey** kb_getDerKeys(KeyBundle* bundle, u_int32_t first,
+                          u_int16_t noKeys)
+{
+  BGPSecKey* key;
+  BGPSecKey* expected;
+  KB_Entry*  entry;
+  u_int32_t  offset;
+  u_int16_t  length;
+  u_int32_t  idx;
+
+  for (idx = first; idx < first + noKeys; idx++)
+  {
+    if (__atomic_load_n(&bundle->derKeys[idx], __ATOMIC_ACQUIRE) != NULL)
+    {
+      continue;
+    }
+    entry  = &bundle->entries[idx];
+    offset = ntohl(entry->offset);
+    length = ntohs(entry->length);
+    if (   (offset > bundle->size) || (length > bundle->size - offset)
+        || (length == 0))
+    {
+      sca_debugLog(LOG_WARNING, "Invalid entry %u in the key bundle\n", idx);
+      continue;
+    }
+    key = malloc(sizeof(BGPSecKey));
+    if (key == NULL)
+    {
+      continue;
+    }
+    key->algoID    = bundle->algoID;
+    key->asn       = entry->asn;
+    memcpy(key->ski, entry->ski, SKI_LENGTH);
+    key->keyLength = length;
+    key->keyData   = bundle->map + offset;
+    expected = NULL;
+    if (!__atomic_compare_exchange_n(&bundle->derKeys[idx], &expected, key,
+                                     false, __ATOMIC_ACQ_REL,
+                                     __ATOMIC_ACQUIRE))
+    {
+      // Created by a concurrent lookup already.
+      free(key);
+    }
+  }
+
+  return &bundle->derKeys[first];
+}
@@ -0,0 +1,151 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * This file provides the binary key bundle. A bundle contains the DER keys of
+ * a complete key set in one file, generated by srx_key_bundle from a key
+ * volt and a ski list. The file is mapped into memory, the keys are taken
+ * from it on first use.
+ *
+ * File layout, all numbers in network format:
+ *   KB_Header
+ *   KB_Entry[noKeys]  - sorted by ASN and SKI (memcmp of both)
+ *   DER keys          - referenced by the entries
+ *
+ * @version 0.2.0.2
+ */
+#ifndef KEY_BUNDLE_H
+#define KEY_BUNDLE_H
+
+#include <sys/types.h>
+#include <stdbool.h>
+#include <openssl/ec.h>
+#include "../srx/srxcryptoapi.h"
+
+/** The magic number at the start of a bundle. */
+#define KB_MAGIC      "SKB\n"
+/** The length of the magic number. */
+#define KB_MAGIC_LEN  4
+/** The current format version. */
+#define KB_VERSION    1
+/** The number of bytes of an entry that are used for sorting. */
+#define KB_KEY_LEN    (sizeof(u_int32_t) + SKI_LENGTH)
+
+/** The header of the bundle file. */
+typedef struct {
+  /** KB_MAGIC */
+  char      magic[KB_MAGIC_LEN];
+  /** The format version, KB_VERSION */
+  u_int16_t version;
+  /** The algorithm ID of all keys. */
+  u_int8_t  algoID;
+  /** 1 if the keys are private keys, otherwise 0. */
+  u_int8_t  isPrivate;
+  /** The number of entries. */
+  u_int32_t noKeys;
+  /** Reserved, must be 0. */
+  u_int32_t reserved;
+} __attribute__((packed)) KB_Header;
+
+/** One key of the bundle. */
+typedef struct {
+  /** The ASN of the key. */
+  u_int32_t asn;
+  /** The SKI of the key. */
+  u_int8_t  ski[SKI_LENGTH];
+  /** The offset of the DER key from the start of the file. */
+  u_int32_t offset;
+  /** The length of the DER key. */
+  u_int16_t length;
+  /** Reserved, must be 0. */
+  u_int16_t reserved;
+} __attribute__((packed)) KB_Entry;
+
+/** A mapped bundle. */
+typedef struct {
+  /** The mapped file. */
+  u_int8_t*   map;
+  /** The size of the mapped file. */
+  size_t      size;
+  /** The algorithm ID of all keys. */
+  u_int8_t    algoID;
+  /** Indicates if the keys are private. */
+  bool        isPrivate;
+  /** The number of keys. */
+  u_int32_t   noKeys;
+  /** The entries within the mapped file. */
+  KB_Entry*   entries;
+  /** The keys referencing the mapped DER keys, created on first use. */
+  BGPSecKey** derKeys;
+  /** The converted keys, created on first use. */
+  EC_KEY**    ecKeys;
+} KeyBundle;
+
+/**
+ * Map the given bundle file and check its header. The keys are not read.
+ *
+ * Possible status values:
+ * API_STATUS_ERR_KEY_IO: The file could not be opened or mapped.
+ * API_STATUS_ERR_USER1: The file is not a valid bundle.
+ * API_STATUS_ERR_INSUF_KEYSTORAGE: Not enough memory.
+ *
+ * @param fileName The name of the bundle file.
+ * @param status An OUT parameter that receives the status flags, can be NULL.
+ *
+ * @return The bundle or NULL.
+ */
+KeyBundle* kb_open(const char* fileName, sca_status_t* status);
+
+/**
+ * Release the bundle, the converted keys, and unmap the file.
+ *
+ * @param bundle The bundle, can be NULL.
+ */
+void kb_close(KeyBundle* bundle);
+
+/**
+ * Find the keys with the given ASN and SKI. Thread safe.
+ *
+ * @param bundle The bundle.
+ * @param asn The ASN in network format.
+ * @param ski The SKI (SKI_LENGTH).
+ * @param first An OUT parameter, receives the index of the first key found.
+ *
+ * @return The number of keys found.
+ */
+u_int16_t kb_find(KeyBundle* bundle, u_int32_t asn, u_int8_t* ski,
+                  u_int32_t* first);
+
+/**
+ * Return the DER keys starting with the given index, the keys are created on
+ * first use. Thread safe.
+ *
+ * @param bundle The bundle.
+ * @param first The index of the first key.
+ * @param noKeys The number of keys.
+ *
+ * @return The array of keys, an element is NULL if the entry is invalid or
+ *         not enough memory is available.
+ */
+BGPSecKey** kb_getDerKeys(KeyBundle* bundle, u_int32_t first,
+                          u_int16_t noKeys);
+
+#endif /* KEY_BUNDLE_H */
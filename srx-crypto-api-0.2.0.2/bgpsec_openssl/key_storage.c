@@ -39,31 +39,50 @@
  *            * Created Key Storage
  */
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
 #include <syslog.h>
-#include <uthash.h>
 #include <sys/types.h>
 #include <openssl/ec.h>
 #include <openssl/x509.h>
 #include "../srx/srxcryptoapi.h"
 #include "key_storage.h"
 
-#define KS_BUCKETS 256
+/** Marks a slot whose element was deleted, the probing continues past it. */
+#define KS_DELETED ((KS_Key_Element*)1)
 
 /**
- * REturn the bucket of the given ASN
+ * Calculate the hash of the given ASN and SKI. The SKI is a SHA-1 hash itself
+ * but all of it is used in case it is not.
  * 
  * @param asn The AS number - format not important.
+ * @param ski The SKI (SKI_LENGTH)
  * 
- * @return The bucket number of the ASN
+ * @return The hash value.
  */
-static u_int8_t _ks_getBucket(u_int32_t asn)
-{      
-  u_int8_t bucket = (asn >> 24) + ((asn >> 16) & 0xFF) + ((asn >> 8) & 0xFF)
-                    + (asn & 0xFF);
-  bucket = bucket & 255;
-  return bucket;
-}
+static u_int32_t _ks_hash(u_int32_t asn, u_int8_t* ski)
+{
+  u_int32_t hash = asn;
+  u_int32_t word;
+  int       idx;
+
+  for (idx = 0; idx + sizeof(u_int32_t) <= SKI_LENGTH; 
+       idx += sizeof(u_int32_t))
+  {
+    memcpy(&word, ski + idx, sizeof(u_int32_t));
+    hash = (hash ^ word) * 0x9E3779B1;
+    hash ^= hash >> 15;
+  }
+  // Final mix (MurmurHash3)
+  hash ^= hash >> 16;
+  hash *= 0x85EBCA6B;
+  hash ^= hash >> 13;
+  hash *= 0xC2B2AE35;
+  hash ^= hash >> 16;
 
+  return hash;
+}
 
 /**
  * Create a clone of the provided key.
@@ -75,9 +94,9 @@ static u_int8_t _ks_getBucket(u_int32_t asn)
 static BGPSecKey* _ks_clone(BGPSecKey* key)
 {
   BGPSecKey* clone = malloc(sizeof(BGPSecKey));
-  memset (clone, 0, sizeof(BGPSecKey));
   if (clone != NULL)
   {
+    memset (clone, 0, sizeof(BGPSecKey));
     clone->algoID    = key->algoID;
     clone->asn       = key->asn;
     memcpy(&clone->ski, &key->ski, SKI_LENGTH);
@@ -88,7 +107,6 @@ static BGPSecKey* _ks_clone(BGPSecKey* key)
       if (clone->keyData != NULL)
       {
         memcpy(clone->keyData, key->keyData, key->keyLength);      
-        memcpy(clone->ski, key->ski, SKI_LENGTH);
       }
       else
       {
@@ -101,6 +119,20 @@ static BGPSecKey* _ks_clone(BGPSecKey* key)
   return clone;  
 }
 
+/**
+ * Destroy the BGPSec Key
+ * 
+ * @param key The BGPSecKey to be destroyed.
+ */
+static void _ks_freeKey(BGPSecKey* key)
+{
+  if (key != NULL)
+  {
+    free(key->keyData);
+    free(key);
+  }
+}
+
 /**
  * Convert the DER key stored in the keyData into an EC_KEY.
  * The following status will be returned:
@@ -152,268 +184,477 @@ static EC_KEY* _ks_convertKey(u_int8_t* keyData, u_int16_t keyLength,
 }
 
 /**
- * Retrieve the EC_KEY associated to the given ski and asn
- * 
- * Possible USER return values:
- * 
- * API_STATUS_INFO_KEY_NOTFOUND : Key not found
- * API_STATUS_ERR_USER1: A DER key element is NULL (BUG IN List).
- * API_STATUS_ERR_NO_DATA: No data provided to find the key.
- * 
- * @param storage The storage where the key is stored in
- * @param ski The SKI of the key (SKI_LENGTH)
- * @param asn The as number of the key in network format
- * @paran noKeys An OUT variable contains the size of the returned array. 
- * @param kType The type of the keys requested, EC or DER
- * @param status is an OUT parameter that if given will provide more information.
- *        API_STATUS_INFO_USER1 is used to indicate that additional keys are
- *        available at a higher position
+ * Convert the DER keys into EC keys unless they are converted already. Thread
+ * safe, each key is set only once.
  * 
- * @return the array of EC_Keys/DER_Keys or NULL of not found. if NULL check 
- *         status value.
+ * @param ecKeys The EC keys.
+ * @param derKeys The DER keys.
+ * @param noKeys The number of keys.
+ * @param isPrivate indicate if the keys are private
+ * @param status Adds return information in case something goes wrong.
  */
-void** ks_getKey(KeyStorage* storage, u_int8_t* ski, u_int32_t asn, 
-                 u_int16_t* noKeys, KS_Key_Type kType, sca_status_t* status)
+static void _ks_convertAll(EC_KEY** ecKeys, BGPSecKey** derKeys, 
+                           u_int16_t noKeys, bool isPrivate, 
+                           sca_status_t* status)
 {
-  void** keys   = NULL;
-  sca_status_t myStatus = (storage != NULL && ski != NULL && noKeys != NULL)
-                          ? API_STATUS_OK
-                          : API_STATUS_ERR_NO_DATA;
-  
-  if (myStatus == API_STATUS_OK)
+  EC_KEY* ec_key;
+  EC_KEY* expected;
+  int     idx = 0;
+
+  for(; idx < noKeys; idx++)
   {
-    // find the correct elem list
-    int bucket = _ks_getBucket(asn);    
-    KS_Key_Element* elem = storage->head[bucket];
-    
-    while (elem != NULL)
+    if (__atomic_load_n(&ecKeys[idx], __ATOMIC_ACQUIRE) != NULL)
     {
-      if (elem->asn < asn)
-      {
-        // Move forward in the list
-        elem = elem->next;
-        continue;
-      }
-      if (elem->asn > asn)
-      {
-        // Key Not found
-        myStatus = API_STATUS_INFO_KEY_NOTFOUND;
-        elem = NULL;
-        break;
-      }
-      // ASN Element found - check ski
-      if (memcmp(elem->ski, ski, SKI_LENGTH) != 0)
-      {
-        // No match, move on
-        elem = elem->next;
-        continue;
-      }
-      
-      // ASN and ski match
-      int idx = 0;
-      if (kType == ks_eckey_e) 
+      continue;
+    }
+    // Load the key
+    if (derKeys[idx] != NULL)
+    {
+      ec_key = _ks_convertKey(derKeys[idx]->keyData, derKeys[idx]->keyLength,
+                              isPrivate, status);
+      if (*status & API_STATUS_ERR_NO_DATA)
       {
-        keys = (void**)elem->ec_key;
+        *status |= API_STATUS_ERR_USER1;
       }
-      else
+      expected = NULL;
+      if (   (ec_key != NULL)
+          && !__atomic_compare_exchange_n(&ecKeys[idx], &expected, ec_key, 
+                                          false, __ATOMIC_ACQ_REL,
+                                          __ATOMIC_ACQUIRE))
       {
-        keys = (void**)elem->derKey;
+        // Converted by a concurrent lookup already.
+        EC_KEY_free(ec_key);
       }
+      continue;
+    }
+    // DER Key not found
+    *status |= API_STATUS_ERR_USER1;
+  }
+}
 
-      if (kType == ks_eckey_e)
-      {
-        for(; idx < elem->noKeys; idx++)
-        {
-          if (elem->ec_key[idx] != NULL)
-          {
-            continue;
-          }
-          // Load the key
-          if (elem->derKey[idx] != NULL)
-          {
-            elem->ec_key[idx] = _ks_convertKey(elem->derKey[idx]->keyData,
-                                               elem->derKey[idx]->keyLength,
-                                               storage->isPrivate, &myStatus);
-            if (myStatus & API_STATUS_ERR_NO_DATA)
-            {
-              myStatus |= API_STATUS_ERR_USER1;
-            }
-            continue;
-          }
-          // DER Key not found
-          myStatus |= API_STATUS_ERR_USER1;
-        }      
-      }
-      // Found the key
-      *noKeys = elem->noKeys;
-      break;
-    }     
+/**
+ * Allocate an element for the given number of keys. The key arrays are part 
+ * of the same allocation and are initialized with NULL.
+ * 
+ * @param asn The ASN of the keys.
+ * @param ski The SKI of the keys.
+ * @param noKeys The number of keys.
+ * 
+ * @return The element or NULL if not enough memory is available.
+ */
+static KS_Key_Element* _ks_newElement(u_int32_t asn, u_int8_t* ski, 
+                                      u_int16_t noKeys)
+{
+  size_t          size = sizeof(KS_Key_Element)
+                         + noKeys * (sizeof(BGPSecKey*) + sizeof(EC_KEY*));
+  KS_Key_Element* elem = malloc(size);
+
+  if (elem != NULL)
+  {
+    memset(elem, 0, size);
+    elem->asn    = asn;
+    memcpy(elem->ski, ski, SKI_LENGTH);
+    elem->noKeys = noKeys;
+    elem->derKey = (BGPSecKey**)(elem + 1);
+    elem->ec_key = (EC_KEY**)(elem->derKey + noKeys);
   }
-  
-  if (status != NULL)
+
+  return elem;
+}
+
+/**
+ * Free the element including all its keys. The element must not be reachable
+ * by any read section anymore.
+ * 
+ * @param elem The element to be freed.
+ */
+static void _ks_freeElement(KS_Key_Element* elem)
+{
+  int kIdx = 0;
+  for (; kIdx < elem->noKeys; kIdx++)
   {
-    if (keys == NULL)
+    _ks_freeKey(elem->derKey[kIdx]);
+    if (elem->ec_key[kIdx] != NULL)
     {
-      myStatus |= API_STATUS_INFO_KEY_NOTFOUND;
+      EC_KEY_free(elem->ec_key[kIdx]);
     }
-    *status = myStatus;
   }
-  return keys;
+  free(elem);
 }
 
 /**
- * Destroy the BGPSec Key
+ * Copy the given key into the element at the given position. If the key does 
+ * not contain the DER key it is loaded using the srxCryptoAPI's sca_loadKey.
  * 
- * @param key The BGPSecKey to be destroyed.
+ * API_STATUS_ERR_INSUF_KEYSTORAGE: Not enough memory.
+ * Also see sca_loadKey and _ks_convertKey.
+ * 
+ * @param elem The element.
+ * @param kIdx The position of the key in the element.
+ * @param key The key to be copied.
+ * @param convert if true then convert the DER key into the EC_KEY
+ * @param isPrivate indicate if the key is private
+ * @param status Adds return information in case something goes wrong.
+ * 
+ * @return true if the key was added.
  */
-static void _ks_freeKey(BGPSecKey* key)
+static bool _ks_setKey(KS_Key_Element* elem, int kIdx, BGPSecKey* key,
+                       bool convert, bool isPrivate, sca_status_t* status)
 {
-  if (key != NULL)
+  BGPSecKey* clone  = _ks_clone(key);
+  EC_KEY*    ec_key = NULL;
+
+  if (clone == NULL)
   {
-    free(key->keyData);
-    free(key);
+    *status |= API_STATUS_ERR_INSUF_KEYSTORAGE;
+    return false;
+  }
+
+  if (clone->keyData == NULL)
+  {
+    if (sca_loadKey(clone, isPrivate, status) != API_SUCCESS)
+    {
+      _ks_freeKey(clone);
+      return false;
+    }
+  }
+
+  if (convert)
+  {
+    ec_key = _ks_convertKey(clone->keyData, clone->keyLength, isPrivate, 
+                            status);
+    if (ec_key == NULL)
+    {
+      _ks_freeKey(clone);
+      return false;
+    }
   }
+
+  elem->derKey[kIdx] = clone;
+  elem->ec_key[kIdx] = ec_key;
+
+  return true;
 }
 
-/** 
- * Generate a KeyStorage element.
+/**
+ * Copy the given element with room for a different number of keys. All keys 
+ * except the one at position skip are cloned, EC keys that are already 
+ * converted are shared with the original element.
  * 
- * @param key The key to be added. Here a copy of the Key will be stored!
- * @param status The status of the generation.
+ * @param elem The element to copy.
+ * @param noKeys The number of keys of the copy.
+ * @param skip The position of the key that is not copied or -1.
  * 
- * @return a new key storage element or NULL if an error occurred - see status.
+ * @return The copy or NULL if not enough memory is available.
  */
-static KS_Key_Element* _ks_createKS_Element(BGPSecKey* key, bool convert,
-                                            bool isPrivate, sca_status_t* status)
-{  
-  KS_Key_Element* elem = malloc(sizeof(KS_Key_Element));
-  sca_status_t myStatus = API_STATUS_OK;
-  
-  if (elem != NULL)
+static KS_Key_Element* _ks_copyElement(KS_Key_Element* elem, u_int16_t noKeys,
+                                       int skip)
+{
+  KS_Key_Element* copy = _ks_newElement(elem->asn, elem->ski, noKeys);
+  EC_KEY*         ec_key;
+  int             kIdx;
+  int             cIdx = 0;
+
+  if (copy == NULL)
+  {
+    return NULL;
+  }
+
+  for (kIdx = 0; kIdx < elem->noKeys && cIdx < noKeys; kIdx++)
+  {
+    if (kIdx == skip)
+    {
+      continue;
+    }
+    copy->derKey[cIdx] = _ks_clone(elem->derKey[kIdx]);
+    if (copy->derKey[cIdx] == NULL)
+    {
+      _ks_freeElement(copy);
+      return NULL;
+    }
+    ec_key = __atomic_load_n(&elem->ec_key[kIdx], __ATOMIC_ACQUIRE);
+    if (ec_key != NULL)
+    {
+      EC_KEY_up_ref(ec_key);
+      copy->ec_key[cIdx] = ec_key;
+    }
+    cIdx++;
+  }
+
+  return copy;
+}
+
+/**
+ * Find the position of the given DER key within the element.
+ * 
+ * @param elem The element.
+ * @param noKeys The number of keys to search.
+ * @param key The key containing the DER key.
+ * 
+ * @return The position or -1 if not found.
+ */
+static int _ks_findDerKey(KS_Key_Element* elem, u_int16_t noKeys, 
+                          BGPSecKey* key)
+{
+  int kIdx = 0;
+
+  for (; kIdx < noKeys; kIdx++)
+  {
+    if (   (elem->derKey[kIdx]->keyLength == key->keyLength)
+        && (memcmp(elem->derKey[kIdx]->keyData, key->keyData, 
+                   key->keyLength) == 0))
+    {
+      return kIdx;
+    }
+  }
+
+  return -1;
+}
+
+/**
+ * Create an element with the keys the bundle contains for the given ASN and
+ * SKI. The DER keys are cloned, EC keys that are already converted are shared
+ * with the bundle. Invalid entries of the bundle are skipped. Requires the 
+ * storage to be locked.
+ * 
+ * @param storage The key storage.
+ * @param asn The ASN.
+ * @param ski The SKI.
+ * @param extra The number of empty positions added after the keys.
+ * @param elem An OUT parameter, receives the element or NULL if the bundle does
+ *             not contain any key with this ASN and SKI.
+ * 
+ * @return false if not enough memory is available.
+ */
+static bool _ks_loadBundle(KeyStorage* storage, u_int32_t asn, u_int8_t* ski,
+                           u_int16_t extra, KS_Key_Element** elem)
+{
+  KeyBundle*  bundle  = storage->bundle;
+  BGPSecKey** derKeys = NULL;
+  EC_KEY*     ec_key  = NULL;
+  u_int32_t   first   = 0;
+  u_int16_t   noKeys  = 0;
+  u_int16_t   kIdx;
+  u_int16_t   eIdx    = 0;
+
+  *elem = NULL;
+  if (bundle != NULL)
   {
-    memset(elem, 0, sizeof(KS_Key_Element));
-    // Store the minimal information.
-    elem->asn = key->asn;
-    memcpy(elem->ski, key->ski, SKI_LENGTH);
-    
-    elem->derKey = malloc(sizeof(BGPSecKey*));
-    if (elem->derKey != NULL)
-    {
-      // Now copy the key into it.
-      elem->derKey[0] = _ks_clone(key);
-      if (elem->derKey[0] != NULL)
+    noKeys = kb_find(bundle, asn, ski, &first);
+  }
+  if (noKeys == 0)
+  {
+    return true;
+  }
+
+  *elem = _ks_newElement(asn, ski, noKeys + extra);
+  if (*elem == NULL)
+  {
+    return false;
+  }
+  derKeys = kb_getDerKeys(bundle, first, noKeys);
+  for (kIdx = 0; kIdx < noKeys; kIdx++)
+  {
+    if (derKeys[kIdx] == NULL)
+    {
+      continue;
+    }
+    (*elem)->derKey[eIdx] = _ks_clone(derKeys[kIdx]);
+    if ((*elem)->derKey[eIdx] == NULL)
+    {
+      _ks_freeElement(*elem);
+      *elem = NULL;
+      return false;
+    }
+    ec_key = __atomic_load_n(&bundle->ecKeys[first + kIdx], __ATOMIC_ACQUIRE);
+    if (ec_key != NULL)
+    {
+      EC_KEY_up_ref(ec_key);
+      (*elem)->ec_key[eIdx] = ec_key;
+    }
+    eIdx++;
+  }
+  (*elem)->noKeys = eIdx + extra;
+
+  return true;
+}
+
+/**
+ * Allocate an empty hash table.
+ * 
+ * @param noSlots The number of slots, a power of 2.
+ * 
+ * @return The table or NULL if not enough memory is available.
+ */
+static KS_Table* _ks_newTable(u_int32_t noSlots)
+{
+  KS_Table* table = calloc(1, sizeof(KS_Table) + noSlots * sizeof(KS_Slot));
+
+  if (table != NULL)
+  {
+    table->mask = noSlots - 1;
+  }
+
+  return table;
+}
+
+/**
+ * Find the slot of the element with the given ASN and SKI. Can be used within 
+ * a read section or with the storage locked.
+ * 
+ * @param table The hash table.
+ * @param hash The hash of asn and ski.
+ * @param asn The ASN.
+ * @param ski The SKI.
+ * @param found An OUT parameter, can be NULL. Receives the element as it was 
+ *              found, the slot might be modified concurrently.
+ * @param freeSlot An OUT parameter, can be NULL. If the element is not found
+ *                 it receives the slot an element with this ASN and SKI has 
+ *                 to be stored in.
+ * 
+ * @return The slot of the element or NULL if not found.
+ */
+static KS_Slot* _ks_findSlot(KS_Table* table, u_int32_t hash, u_int32_t asn, 
+                             u_int8_t* ski, KS_Key_Element** found,
+                             KS_Slot** freeSlot)
+{
+  KS_Slot*        slot  = NULL;
+  KS_Slot*        avail = NULL;
+  KS_Key_Element* elem  = NULL;
+  u_int32_t       idx   = hash & table->mask;
+
+  while (true)
+  {
+    slot = &table->slots[idx];
+    elem = __atomic_load_n(&slot->elem, __ATOMIC_ACQUIRE);
+    if (elem == NULL)
+    {
+      break;
+    }
+    if (elem == KS_DELETED)
+    {
+      if (avail == NULL)
       {
-        elem->noKeys = 1;
-        // create the array space for the ec_key
-        elem->ec_key = malloc(sizeof(EC_KEY*));
-        if (elem->ec_key != NULL)
-        {
-          elem->ec_key[0] = NULL;
-          if (convert)
-          {
-            if (elem->derKey[0]->keyData != NULL)
-            {
-              if (sca_loadKey(elem->derKey[0], isPrivate, &myStatus) == API_SUCCESS)
-              {  
-                elem->ec_key[0] = _ks_convertKey(elem->derKey[0]->keyData, 
-                                                 elem->derKey[0]->keyLength, 
-                                                 isPrivate, &myStatus);
-              }
-              if (elem->ec_key[0] == NULL)
-              {
-                _ks_freeKey(elem->derKey[0]);
-                free(elem->derKey);
-                free(elem->ec_key);
-                free(elem);
-                elem = NULL;
-              }
-            }
-          }
-          else
-          {
-            elem->ec_key[0] = NULL;
-          }
-        }
-        else // Could not generate the ec_key array - free the key array and elem
-        {      
-          free(elem->derKey);
-          elem->derKey = NULL;
-          free(elem);
-          elem = NULL;
-          myStatus |= API_STATUS_ERR_INSUF_KEYSTORAGE;                
-        }
-      }
-      else // could not clone the BGPSecKey - clean elem-key and elem
-      {        
-        free(elem->derKey);
-        elem->derKey = NULL;
-        free(elem);
-        elem = NULL;
-        myStatus |= API_STATUS_ERR_INSUF_KEYSTORAGE;                
+        avail = slot;
       }
     }
-    else // Could not generate the key array - free elem
+    else if (   (__atomic_load_n(&slot->hash, __ATOMIC_RELAXED) == hash)
+             && (elem->asn == asn) 
+             && (memcmp(elem->ski, ski, SKI_LENGTH) == 0))
     {
-      free(elem);
-      elem = NULL;
-      myStatus |= API_STATUS_ERR_INSUF_KEYSTORAGE;
+      if (found != NULL)
+      {
+        *found = elem;
+      }
+      return slot;
     }
+    idx = (idx + 1) & table->mask;
   }
-  else
+
+  if (freeSlot != NULL)
   {
-    myStatus |= API_STATUS_ERR_INSUF_KEYSTORAGE;
+    *freeSlot = (avail != NULL) ? avail : slot;
   }
-  
-  if (status != NULL)
+
+  return NULL;
+}
+
+/**
+ * Wait until all read sections that started before this call ended. Requires
+ * the storage to be locked.
+ * 
+ * @param storage The key storage.
+ */
+static void _ks_synchronize(KeyStorage* storage)
+{
+  u_int32_t epoch = __atomic_fetch_add(&storage->epoch, 1, __ATOMIC_SEQ_CST);
+
+  while (__atomic_load_n(&storage->readers[epoch & 1], __ATOMIC_SEQ_CST) != 0)
   {
-    *status = myStatus;
+    sched_yield();
   }
-  
-  return elem;
 }
 
 /**
- * Remove the element from the storage
+ * Make sure the hash table has room for one more element, it is kept at most
+ * three quarters full including the deleted slots. A new table is published
+ * if necessary. Requires the storage to be locked.
+ * 
+ * @param storage The key storage.
  * 
- * @param storage The key storage
- * @param head The head index.
- * @param elem The element to be removed
+ * @return false if not enough memory is available.
  */
-static void _ks_freeKS_Elem(KeyStorage* storage, int head,
-                            KS_Key_Element* elem)
+static bool _ks_reserve(KeyStorage* storage)
 {
-  storage->size -= elem->noKeys;
-  
-  if (elem->prev != NULL) // elem is the head
+  KS_Table*       table    = storage->table;
+  KS_Table*       newTable = NULL;
+  KS_Key_Element* elem     = NULL;
+  KS_Slot*        slot     = NULL;
+  u_int32_t       noSlots  = KS_MIN_SLOTS;
+  u_int32_t       noElems  = 0;
+  u_int32_t       idx;
+
+  if ((table->used + 1) * 4 <= (table->mask + 1) * 3)
   {
-    elem->prev = elem->next;
+    return true;
   }
-  else
+
+  for (idx = 0; idx <= table->mask; idx++)
   {
-    storage->head[head] = elem->next; // move head to the next one
+    elem = table->slots[idx].elem;
+    if ((elem != NULL) && (elem != KS_DELETED))
+    {
+      noElems++;
+    }
   }
-  
-  if (elem->next != NULL) 
+  // Rebuild at most half full
+  while (noSlots < (noElems + 1) * 2)
   {
-    elem->next->prev = elem->prev;
+    noSlots <<= 1;
   }
- 
-  // Now free the allocated memory
-  int kIdx = 0;
-  for (; kIdx < elem->noKeys; kIdx++)
+
+  newTable = _ks_newTable(noSlots);
+  if (newTable == NULL)
   {
-    _ks_freeKey(elem->derKey[kIdx]);
-    elem->derKey[kIdx] = NULL;
-    if (elem->ec_key[kIdx] != NULL)
+    return false;
+  }
+  for (idx = 0; idx <= table->mask; idx++)
+  {
+    elem = table->slots[idx].elem;
+    if ((elem != NULL) && (elem != KS_DELETED))
     {
-      EC_KEY_free(elem->ec_key[kIdx]);
-      elem->ec_key[kIdx] = NULL;
+      _ks_findSlot(newTable, table->slots[idx].hash, elem->asn, elem->ski, 
+                   NULL, &slot);
+      slot->hash = table->slots[idx].hash;
+      slot->elem = elem;
+      newTable->used++;
     }
   }
-  free(elem->derKey);
-  free(elem->ec_key);
-  memset(elem, 0, sizeof(KS_Key_Element));
-  free(elem);
+
+  __atomic_store_n(&storage->table, newTable, __ATOMIC_RELEASE);
+  _ks_synchronize(storage);
+  free(table);
+
+  return true;
+}
+
+/**
+ * Store the element in the given free slot. Requires the storage to be locked.
+ * 
+ * @param table The hash table.
+ * @param slot The slot returned by _ks_findSlot.
+ * @param hash The hash of the element.
+ * @param elem The element.
+ */
+static void _ks_publish(KS_Table* table, KS_Slot* slot, u_int32_t hash,
+                        KS_Key_Element* elem)
+{
+  if (slot->elem == NULL)
+  {
+    table->used++;
+  }
+  __atomic_store_n(&slot->hash, hash, __ATOMIC_RELAXED);
+  __atomic_store_n(&slot->elem, elem, __ATOMIC_RELEASE);
 }
 
 /**
@@ -427,30 +668,144 @@ void ks_init(KeyStorage* storage, u_int8_t algoID, bool isPrivate)
 {
   if (storage != NULL)
   {
+    memset(storage, 0, sizeof(KeyStorage));
     storage->algorithmID = algoID;
     storage->isPrivate = isPrivate;
     storage->size = 0;
-    storage->head = malloc(sizeof(KS_Key_Element*) * KS_BUCKETS);
-    memset (storage->head, 0, sizeof(KS_Key_Element*) * KS_BUCKETS);
+    storage->table = _ks_newTable(KS_MIN_SLOTS);
+    pthread_mutex_init(&storage->mutex, NULL);
   }
 }
 
 /**
- * Empty the storage if necessary and free the allocated memory.
+ * Start a read section. The keys returned by ks_getKey stay valid until the
+ * read section ends, even if they are deleted concurrently. Read sections
+ * must be short, modifications wait for them to end, and must not call any
+ * function that modifies the storage.
  * 
- * @param storage The storage to be freed.
+ * @param storage The key storage.
+ * 
+ * @return The epoch of the read section, required by ks_endRead.
  */
-void ks_release(KeyStorage* storage)
+u_int32_t ks_beginRead(KeyStorage* storage)
 {
-  if (storage != NULL)
+  u_int32_t epoch;
+
+  while (true)
   {
-    ks_empty(storage);
-    if (storage->head != NULL)
+    epoch = __atomic_load_n(&storage->epoch, __ATOMIC_SEQ_CST);
+    __atomic_fetch_add(&storage->readers[epoch & 1], 1, __ATOMIC_SEQ_CST);
+    // If a modification started in between, it might not wait for us.
+    if (__atomic_load_n(&storage->epoch, __ATOMIC_SEQ_CST) == epoch)
     {
-      free (storage->head);
-    }      
-    free(storage);
+      break;
+    }
+    __atomic_fetch_sub(&storage->readers[epoch & 1], 1, __ATOMIC_SEQ_CST);
   }
+
+  return epoch;
+}
+
+/**
+ * End a read section started with ks_beginRead.
+ * 
+ * @param storage The key storage.
+ * @param epoch The value returned by ks_beginRead.
+ */
+void ks_endRead(KeyStorage* storage, u_int32_t epoch)
+{
+  __atomic_fetch_sub(&storage->readers[epoch & 1], 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Retrieve the EC_KEY associated to the given ski and asn. Must be called 
+ * within a read section (see ks_beginRead). Thread safe, DER keys are converted
+ * into EC keys on first use. Keys not found in the hash table are taken from
+ * the key bundle.
+ * 
+ * Possible USER return values:
+ * 
+ * API_STATUS_INFO_KEY_NOTFOUND : Key not found
+ * API_STATUS_ERR_USER1: A DER key element is NULL (BUG IN List or invalid
+ *                       bundle entry).
+ * API_STATUS_ERR_NO_DATA: No data provided to find the key.
+ * 
+ * @param storage The storage where the key is stored in
+ * @param ski The SKI of the key (SKI_LENGTH)
+ * @param asn The as number of the key in network format
+ * @paran noKeys An OUT variable contains the size of the returned array. 
+ * @param kType The type of the keys requested, EC or DER
+ * @param status is an OUT parameter that if given will provide more information.
+ *        API_STATUS_INFO_USER1 is used to indicate that additional keys are
+ *        available at a higher position
+ * 
+ * @return the array of EC_Keys/DER_Keys or NULL of not found. if NULL check 
+ *         status value.
+ */
+void** ks_getKey(KeyStorage* storage, u_int8_t* ski, u_int32_t asn, 
+                 u_int16_t* noKeys, KS_Key_Type kType, sca_status_t* status)
+{
+  void** keys   = NULL;
+  sca_status_t myStatus = (storage != NULL && ski != NULL && noKeys != NULL)
+                          ? API_STATUS_OK
+                          : API_STATUS_ERR_NO_DATA;
+  
+  if (myStatus == API_STATUS_OK)
+  {
+    KS_Table*       table   = __atomic_load_n(&storage->table, 
+                                              __ATOMIC_ACQUIRE);
+    KeyBundle*      bundle  = __atomic_load_n(&storage->bundle, 
+                                              __ATOMIC_ACQUIRE);
+    KS_Key_Element* elem    = NULL;
+    BGPSecKey**     derKeys = NULL;
+    EC_KEY**        ecKeys  = NULL;
+    u_int32_t       first   = 0;
+    u_int16_t       count   = 0;
+
+    // The element is not freed before the read section ends, even if it is
+    // removed from the table concurrently.
+    if (_ks_findSlot(table, _ks_hash(asn, ski), asn, ski, &elem, NULL) != NULL)
+    {
+      // An element without keys hides the keys of the bundle.
+      count   = elem->noKeys;
+      derKeys = elem->derKey;
+      ecKeys  = elem->ec_key;
+    }
+    else if (bundle != NULL)
+    {
+      count = kb_find(bundle, asn, ski, &first);
+      if (count != 0)
+      {
+        derKeys = kb_getDerKeys(bundle, first, count);
+        ecKeys  = &bundle->ecKeys[first];
+      }
+    }
+
+    if (count != 0)
+    {
+      if (kType == ks_eckey_e)
+      {
+        _ks_convertAll(ecKeys, derKeys, count, storage->isPrivate, &myStatus);
+        keys = (void**)ecKeys;
+      }
+      else
+      {
+        keys = (void**)derKeys;
+      }
+      // Found the key
+      *noKeys = count;
+    }
+  }
+  
+  if (status != NULL)
+  {
+    if (keys == NULL)
+    {
+      myStatus |= API_STATUS_INFO_KEY_NOTFOUND;
+    }
+    *status = myStatus;
+  }
+  return keys;
 }
 
 /**
@@ -458,154 +813,132 @@ void ks_release(KeyStorage* storage)
  * contain algoID, ASN, and SKI all keys found with this match are deleted. In 
  * case a stored DER key is part of the key, only the stored version with a 100%
  * binary match will be deleted.
- * the key parameter will not be modified as long as it is different from the 
- * stored version. In case it is the same instance, it will be changed / 
- * deleted,
+ * The key parameter will not be modified. The function returns once no read
+ * section uses the deleted keys anymore.
  * 
  * the following USER status can be returned:
  * 
  * API_STATUS_ERR_USER1: Key algorithm ID does not match the storage Algorithm ID
  * API_STATUS_ERR_NO_DATA: One of the provided parameter was NULL
+ * API_STATUS_ERR_INSUF_KEYSTORAGE: Not enough memory.
+ * API_STATUS_INFO_KEY_NOTFOUND: The key is not stored.
  * 
  * @param storage The storage where the key is stored in
  * @param key The BGPSecKey to be deleted - the given key will not be touched, 
- *            the stored version will. If both are the exact same, then the 
- *            provided key is deleted as well. 
+ *            the stored version will.
  * @param status an OUT value that provides more information.
  * 
  * @return API_SUCESS (1) otherwise API_FAILED (0 - see status). 
  */
 int ks_delKey(KeyStorage* storage, BGPSecKey* key, sca_status_t* status)
 {
-  int retVal = API_SUCCESS; 
-  int myStatus = API_STATUS_OK;
-  int             bucket = 0;
-  KS_Key_Element* elem   = NULL;
+  sca_status_t    myStatus   = API_STATUS_OK;
+  KS_Slot*        slot       = NULL;
+  KS_Key_Element* elem       = NULL;
+  KS_Key_Element* copy       = KS_DELETED;
+  bool            fromBundle = false;
+  u_int32_t       hash       = 0;
+  u_int32_t       first      = 0;
+  int             idx        = 0;
   
-  if (storage != NULL && key != NULL)
-  {
-    if (key->algoID == storage->algorithmID)
-    {
-      bucket = _ks_getBucket(key->asn);
-      elem = storage->head[bucket];
-    }
-    else
-    {
-      // Algorithm ID does not match.
-      myStatus = API_STATUS_ERR_USER1;
-    }
-  }
-  else
+  if (storage == NULL || key == NULL)
   {
     // Some data missing.
     myStatus = API_STATUS_ERR_NO_DATA;
   }
-    
-  if (elem != NULL)
+  else if (key->algoID != storage->algorithmID)
+  {
+    // Algorithm ID does not match.
+    myStatus = API_STATUS_ERR_USER1;
+  }
+  else
   {
-    bool deleted = false;
-    while (elem != NULL)
+    hash = _ks_hash(key->asn, key->ski);
+    pthread_mutex_lock(&storage->mutex);
+    slot = _ks_findSlot(storage->table, hash, key->asn, key->ski, &elem, NULL);
+    if (slot == NULL)
     {
-      if (elem->asn < key->asn)
+      // Keys of the bundle are deleted by hiding them in the hash table.
+      fromBundle = true;
+      if (!_ks_loadBundle(storage, key->asn, key->ski, 0, &elem))
       {
-        // Move forward in the list
-        elem = elem->next;
-        continue;
+        myStatus = API_STATUS_ERR_INSUF_KEYSTORAGE;
       }
-      if (elem->asn > key->asn)
+    }
+    if (myStatus != API_STATUS_OK)
+    {
+      // Nothing to do
+    }
+    else if ((elem == NULL) || (elem->noKeys == 0))
+    {
+      // Not stored or hidden already.
+      myStatus = API_STATUS_INFO_KEY_NOTFOUND;
+    }
+    else if (key->keyData != NULL)
+    {
+      // Delete only the matching DER key.
+      idx = _ks_findDerKey(elem, elem->noKeys, key);
+      if (idx == -1)
       {
-        // Key Not found
         myStatus = API_STATUS_INFO_KEY_NOTFOUND;
-        elem = NULL;
-        break;
-      }
-
-      // ASN Element found - check ski
-      if (memcmp(elem->ski, key->ski, SKI_LENGTH) != 0)
-      {
-        // No match, move on
-        elem = elem->next;
-        continue;
       }
-      
-      // ASN and ski match
-      // Now if key has a DER key delete only the DER portion, otherwise delete 
-      // the complete element.
-      int idx = 0;
-      if (key->keyData != NULL)
+      else if (elem->noKeys > 1)
       {
-        //Find the correct key version to delete.
-        for (; idx < elem->noKeys; idx++)
-        {
-          if (deleted)
-          {
-            // move the current key to the previous emptied position
-            elem->derKey[idx-1] = elem->derKey[idx];
-            elem->ec_key[idx-1] = elem->ec_key[idx];
-            elem->derKey[idx] = NULL;
-            elem->ec_key[idx] = NULL;
-          }
-          else
-          {  
-            if (elem->derKey[idx]->keyLength == key->keyLength)
-            {
-              if (memcmp(elem->derKey[idx], key->keyData, key->keyLength))
-              {
-                // Now delete this version
-                if (elem->ec_key != NULL)
-                {
-                  // This array is is malloc'ed
-                  free(elem->ec_key);
-                }
-                _ks_freeKey(elem->derKey[idx]);
-                elem->derKey[idx] = NULL;
-                deleted = true;
-              }
-            }
-          }
-        }
-        if (deleted)
+        // Some more keys with this ASN and SKI exist.
+        copy = _ks_copyElement(elem, elem->noKeys - 1, idx);
+        if (copy == NULL)
         {
-          if (elem->noKeys == 1)
-          {
-            // This was the only key, remove the complete elemnt
-            _ks_freeKS_Elem(storage, bucket, elem);
-          }
-          else
-          {
-            // some more duplicate keys exist. 
-            elem->noKeys--;
-            storage->size--;
-            // Now resize
-            void** dk = realloc(elem->derKey, sizeof(BGPSecKey*) + elem->noKeys);
-            if (dk != NULL)
-            {
-              elem->derKey = (BGPSecKey**)dk;
-            }
-            void** ek = realloc(elem->ec_key, sizeof(EC_KEY*) + elem->noKeys);
-            if (ek != NULL)
-            {
-              elem->ec_key = (EC_KEY**)ek;
-            }
-          }
+          myStatus = API_STATUS_ERR_INSUF_KEYSTORAGE;
         }
       }
-      else
+    }
+    if (   (myStatus == API_STATUS_OK) && (copy == KS_DELETED)
+        && (storage->bundle != NULL)
+        && (kb_find(storage->bundle, key->asn, key->ski, &first) != 0))
+    {
+      // Removing the element would reveal the keys of the bundle.
+      copy = _ks_newElement(key->asn, key->ski, 0);
+      if (copy == NULL)
       {
-        // DER is NULL so delete the complete element.
-        storage->size -= elem->noKeys;
-        _ks_freeKS_Elem(storage, bucket, elem);
-        deleted = true;
+        myStatus = API_STATUS_ERR_INSUF_KEYSTORAGE;
       }
-      elem = NULL;
     }
+    if (myStatus != API_STATUS_OK)
+    {
+      // Nothing to do
+    }
+    else if (!fromBundle)
+    {
+      storage->size -= elem->noKeys - (copy != KS_DELETED ? copy->noKeys : 0);
+      __atomic_store_n(&slot->elem, copy, __ATOMIC_RELEASE);
+      _ks_synchronize(storage);
+      _ks_freeElement(elem);
+    }
+    else if (_ks_reserve(storage))
+    {
+      _ks_findSlot(storage->table, hash, key->asn, key->ski, NULL, &slot);
+      _ks_publish(storage->table, slot, hash, copy);
+      storage->size += copy->noKeys;
+    }
+    else
+    {
+      myStatus = API_STATUS_ERR_INSUF_KEYSTORAGE;
+      _ks_freeElement(copy);
+    }
+    if (fromBundle && (elem != NULL))
+    {
+      // Never published
+      _ks_freeElement(elem);
+    }
+    pthread_mutex_unlock(&storage->mutex);
   }
   
   if (status != NULL)
   {
     *status = myStatus;
   }
-  return retVal;
+  return ((myStatus & API_STATUS_ERROR_MASK) != 0) ? API_FAILURE
+                                                   : API_SUCCESS;
 }
 
 /** 
@@ -616,20 +949,44 @@ int ks_delKey(KeyStorage* storage, BGPSecKey* key, sca_status_t* status)
  */
 void ks_empty(KeyStorage* storage)
 {
-  if (storage != NULL)
+  KS_Table*       table  = NULL;
+  KS_Table*       empty  = NULL;
+  KS_Key_Element* elem   = NULL;
+  KeyBundle*      bundle = NULL;
+  u_int32_t       idx;
+
+  if (storage == NULL)
   {
-    if (storage->head != NULL)
-    { // Should NOT be NULL
-      int idx = 0;
-      for (; idx < KS_BUCKETS; idx++)
+    return;
+  }
+
+  pthread_mutex_lock(&storage->mutex);
+  table = storage->table;
+  empty = _ks_newTable(KS_MIN_SLOTS);
+  if ((table != NULL) && (empty != NULL))
+  {
+    bundle = storage->bundle;
+    __atomic_store_n(&storage->bundle, NULL, __ATOMIC_RELEASE);
+    __atomic_store_n(&storage->table, empty, __ATOMIC_RELEASE);
+    _ks_synchronize(storage);
+    kb_close(bundle);
+    for (idx = 0; idx <= table->mask; idx++)
+    {
+      elem = table->slots[idx].elem;
+      if ((elem != NULL) && (elem != KS_DELETED))
       {
-        while (storage->head[idx] != NULL)
-        {
-          _ks_freeKS_Elem(storage, idx, storage->head[idx]);
-        }
+        storage->size -= elem->noKeys;
+        _ks_freeElement(elem);
       }
     }
+    free(table);
   }
+  else
+  {
+    free(empty);
+  }
+  pthread_mutex_unlock(&storage->mutex);
+
   if (storage->size != 0)
   {
     sca_debugLog(LOG_WARNING, "Key storage could not be emptied! [%p]\n", 
@@ -637,6 +994,73 @@ void ks_empty(KeyStorage* storage)
   }
 }
 
+/**
+ * Attach the given key bundle to the storage, a previously attached bundle is
+ * closed. Must not be called within a read section.
+ * 
+ * API_STATUS_ERR_NO_DATA: The storage is NULL.
+ * API_STATUS_ERR_USER1: The algorithm ID or key type of the bundle does not
+ *                       match the storage.
+ * 
+ * @param storage The key storage.
+ * @param bundle The bundle, the storage takes ownership. NULL to detach the 
+ *               current bundle.
+ * @param status an OUT value that provides more information.
+ * 
+ * @return API_SUCESS if the bundle is attached, otherwise API_FAILED.
+ */
+int ks_setBundle(KeyStorage* storage, KeyBundle* bundle, sca_status_t* status)
+{
+  sca_status_t myStatus = API_STATUS_OK;
+  KeyBundle*   old      = NULL;
+
+  if (storage == NULL)
+  {
+    myStatus = API_STATUS_ERR_NO_DATA;
+  }
+  else if (   (bundle != NULL)
+           && (   (bundle->algoID != storage->algorithmID)
+               || (bundle->isPrivate != storage->isPrivate)))
+  {
+    myStatus = API_STATUS_ERR_USER1;
+  }
+  else
+  {
+    pthread_mutex_lock(&storage->mutex);
+    old = storage->bundle;
+    __atomic_store_n(&storage->bundle, bundle, __ATOMIC_RELEASE);
+    if (old != NULL)
+    {
+      _ks_synchronize(storage);
+    }
+    pthread_mutex_unlock(&storage->mutex);
+    kb_close(old);
+  }
+
+  if (status != NULL)
+  {
+    *status = myStatus;
+  }
+
+  return (myStatus == API_STATUS_OK) ? API_SUCCESS : API_FAILURE;
+}
+
+/**
+ * Empty the storage if necessary and free the allocated memory.
+ * 
+ * @param storage The storage to be freed.
+ */
+void ks_release(KeyStorage* storage)
+{
+  if (storage != NULL)
+  {
+    ks_empty(storage);
+    free(storage->table);
+    pthread_mutex_destroy(&storage->mutex);
+    free(storage);
+  }
+}
+
 /**
  * Store a copy of the the key in the given KeyStorage. In case the passed 
  * BGPSECkey only contains the ASN, algorithm ID and the SKI this implementation
@@ -645,6 +1069,7 @@ void ks_empty(KeyStorage* storage)
  * set to Key not Found.
  * 
  * API_STATUS_ERR_USER1: Wrong algorithmID
+ * API_STATUS_ERR_INSUF_KEYSTORAGE: Not enough memory.
  * API_STATUS_INFO_USER1: Duplicate Key
  * API_STATUS_INFO_KEY_NOT_FOUND: In case the real key is supposed to be located
  *                                in the srx-crypto-api's keyvolt but could not
@@ -660,153 +1085,99 @@ void ks_empty(KeyStorage* storage)
 int ks_storeKey(KeyStorage* storage, BGPSecKey* key, sca_status_t* status, 
                 bool convert)
 {
-  sca_status_t myStatus = API_STATUS_OK;
-  int  retVal   = API_SUCCESS;
-  int  bucket   = 0;
+  sca_status_t    myStatus = API_STATUS_OK;
+  KS_Slot*        slot     = NULL;
+  KS_Slot*        freeSlot = NULL;
+  KS_Key_Element* elem     = NULL;
+  KS_Key_Element* newElem  = NULL;
+  u_int32_t       hash     = 0;
+  int             kIdx     = 0;
          
-  if (storage != NULL && key != NULL)
-  {
-    if (key->algoID == storage->algorithmID)
-    {
-      // The asn is in big endian format, 
-      bucket = _ks_getBucket(key->asn);    
-    }
-    else
-    {
-      // Algorithm ID does not match.
-      myStatus = API_STATUS_ERR_USER1;
-    }
-  }
-  else
+  if (storage == NULL || key == NULL)
   {
     // Some data missing.
     myStatus = API_STATUS_ERR_NO_DATA;
   }
-  
-  if (storage->head[bucket] != NULL)
+  else if (key->algoID != storage->algorithmID)
+  {
+    // Algorithm ID does not match.
+    myStatus = API_STATUS_ERR_USER1;
+  }
+  else
   {
-    // we have to find the position to insert the new key
-    KS_Key_Element* elem = storage->head[bucket];
-    while (elem != NULL)
+    hash = _ks_hash(key->asn, key->ski);
+    pthread_mutex_lock(&storage->mutex);
+    slot = _ks_findSlot(storage->table, hash, key->asn, key->ski, &elem, NULL);
+    if (slot != NULL)
     {
-      if (elem->asn < key->asn)
+      // Go through all internal keys (most likely only one) and check if it 
+      // is already stored.
+      if (_ks_findDerKey(elem, elem->noKeys, key) != -1)
       {
-        if (elem->next != NULL)
-        {
-          elem = elem->next;
-          continue;
-        }
-        // add as last element          
-        storage->size++;
-        elem->next = _ks_createKS_Element(key, convert, storage->isPrivate, 
-                                          &myStatus);
-        elem->next->prev = elem;
-        break;
+        // duplicate key
+        myStatus |= API_STATUS_INFO_USER1;
       }
-
-      if (elem->asn > key->asn)
+      else
       {
-        // insert before the element
-        KS_Key_Element* newElem = _ks_createKS_Element(key, convert, 
-                                                 storage->isPrivate, &myStatus);
-        storage->size++;
-        newElem->next = elem;
-        newElem->prev = elem->prev;
-        elem->prev    = newElem;
-        if (newElem->prev != NULL)
+        // SKI collision, replace the element with one that has one more key.
+        newElem = _ks_copyElement(elem, elem->noKeys + 1, -1);
+        if (newElem == NULL)
         {
-          newElem->prev->next = newElem;
+          myStatus |= API_STATUS_ERR_INSUF_KEYSTORAGE;
+        }
+        else if (!_ks_setKey(newElem, elem->noKeys, key, convert, 
+                             storage->isPrivate, &myStatus))
+        {
+          _ks_freeElement(newElem);
         }
         else
         {
-          // new head
-          storage->head[bucket] = newElem;
+          storage->size++;
+          __atomic_store_n(&slot->elem, newElem, __ATOMIC_RELEASE);
+          _ks_synchronize(storage);
+          _ks_freeElement(elem);
         }
-        break;
       }
-
-      // as numbers are a match. check ski
-      if (memcmp(elem->ski, key->ski, SKI_LENGTH) == 0)
+    }
+    else
+    {
+      // Keys of the bundle with this ASN and SKI are copied into the element.
+      if (   _ks_loadBundle(storage, key->asn, key->ski, 1, &newElem)
+          && (newElem == NULL))
       {
-        // check if the key already exist.
-        int  kIdx = 0;
-        bool inserted = false;
-
-        // Go through all internal keys (most likely only one) and check if it 
-        // is already stored.
-        for (; kIdx < elem->noKeys && !inserted; kIdx++)
-        {
-          if (elem->derKey[kIdx]->keyLength == key->keyLength)
-          {
-            // check if the key is already stored
-            if (memcmp(elem->derKey[kIdx]->keyData, key->keyData, key->keyLength) == 0)
-            {
-              // duplicate key
-              inserted = true; // stop the for loop
-              myStatus |= API_STATUS_INFO_USER1;
-            }
-          }
-        }
-
-        // If not inserted then we have an SKI collision and we need to add it
-        if (!inserted)
-        {
-          // add one more key / ec_key
-          elem->noKeys++;
-          // Re-allocate the internal arrays.
-          BGPSecKey** dk = realloc(elem->derKey, sizeof(BGPSecKey*) * elem->noKeys);
-          EC_KEY** ek = realloc(elem->ec_key, sizeof(EC_KEY*) * elem->noKeys);
-                    
-          if (dk != NULL && ek != NULL)
-          {
-            storage->size++;
-            elem->derKey = dk;
-            elem->ec_key = ek;
-            elem->derKey[elem->noKeys-1] = _ks_clone(key);
-            elem->ec_key[elem->noKeys-1] = _ks_convertKey(key->keyData, 
-                                 key->keyLength, storage->isPrivate, &myStatus);
-            inserted = true;
-          }
-          else
-          {
-            // not enough memory for the ec_key, shrink the key back
-            myStatus |= API_STATUS_ERR_INSUF_KEYSTORAGE;
-            elem->noKeys--;
-            if (dk != NULL)
-            {
-              elem->derKey = realloc(dk, sizeof(BGPSecKey*) * elem->noKeys);
-            }
-            if (ek != NULL)
-            {
-              elem->ec_key = realloc(ek, sizeof(EC_KEY*) * elem->noKeys);
-            }
-          }
-        }
-        break; // The while (elem != NULL) loop.
+        newElem = _ks_newElement(key->asn, key->ski, 1);
+      }
+      kIdx = (newElem != NULL) ? newElem->noKeys - 1 : 0;
+      if (newElem == NULL)
+      {
+        myStatus |= API_STATUS_ERR_INSUF_KEYSTORAGE;
+      }
+      else if (_ks_findDerKey(newElem, kIdx, key) != -1)
+      {
+        // duplicate key
+        myStatus |= API_STATUS_INFO_USER1;
+        _ks_freeElement(newElem);
+      }
+      else if (!_ks_reserve(storage))
+      {
+        myStatus |= API_STATUS_ERR_INSUF_KEYSTORAGE;
+        _ks_freeElement(newElem);
+      }
+      else if (!_ks_setKey(newElem, kIdx, key, convert, storage->isPrivate, 
+                           &myStatus))
+      {
+        _ks_freeElement(newElem);
       }
       else
       {
-        // move to the next or add as last.
-        if (elem->next != NULL)
-        {
-          elem = elem->next;
-        }
-        else
-        {
-          storage->size++;
-          elem->next = _ks_createKS_Element(key, convert, storage->isPrivate, 
-                                            &myStatus);
-          break; // The while (elem != NULL) loop.
-        }
+        // The table might have been replaced, find the slot again.
+        _ks_findSlot(storage->table, hash, key->asn, key->ski, NULL, 
+                     &freeSlot);
+        _ks_publish(storage->table, freeSlot, hash, newElem);
+        storage->size += newElem->noKeys;
       }
     }
-  }
-  else
-  {
-    // we have a new head
-    storage->size++;
-    storage->head[bucket] = _ks_createKS_Element(key, convert, 
-                                                 storage->isPrivate, &myStatus);
+    pthread_mutex_unlock(&storage->mutex);
   }
   
   if (status != NULL)
@@ -814,6 +1185,6 @@ int ks_storeKey(KeyStorage* storage, BGPSecKey* key, sca_status_t* status,
     *status = myStatus;
   }
   
-  return retVal = ((myStatus & API_STATUS_ERROR_MASK) != 0) ? API_FAILURE
-                                                            : API_SUCCESS;
-}
\ No newline at end of file
+  return ((myStatus & API_STATUS_ERROR_MASK) != 0) ? API_FAILURE
+                                                   : API_SUCCESS;
+}
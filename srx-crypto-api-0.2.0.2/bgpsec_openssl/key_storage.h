@@ -27,6 +27,17 @@
  * Known Issue:
  *   At this time only pem formated private keys can be loaded.
  * 
+ * The keys are stored in a hash table over (ASN, SKI) with open addressing.
+ * Lookups do not take any lock, they run within a read section started with
+ * ks_beginRead. Modifications are serialized by a mutex and replace single
+ * slots atomically. A modified element or a grown table is published as a new
+ * copy, the old one is freed once all read sections that could see it ended.
+ * 
+ * A key bundle (see key_bundle.h) can be attached to the storage. Keys that are
+ * not found in the hash table are taken from the bundle. Modifying a key of
+ * the bundle copies all its keys with this ASN and SKI into the hash table, a
+ * deleted one is hidden by an element without keys.
+ * 
  * @version 0.2.0.0
  * 
  * Changelog:
@@ -42,11 +53,14 @@
 #define KEY_STORAGE_H
 
 #include <sys/types.h>
+#include <stdbool.h>
+#include <pthread.h>
 #include <openssl/ec.h>
 #include "../srx/srxcryptoapi.h"
+#include "key_bundle.h"
 
-/** Used to prevent an overflow */
-#define MAX_KEY_USED 0xFFFF
+/** The initial number of slots of the hash table, a power of 2. */
+#define KS_MIN_SLOTS 1024
 
 /**
  * The enymeration type is required for the ks_getKey function.
@@ -58,40 +72,65 @@ typedef enum {
   ks_derkey_e = 1       
 } KS_Key_Type;
 
-typedef struct _KS_Key_Element
+/** 
+ * All keys registered for one ASN and SKI. An element is not modified once it
+ * is published, except for the lazy conversion of its EC keys.
+ */
+typedef struct
 {
-  /** Pointer to previous element */
-  struct _KS_Key_Element* prev;
-  /** Pointer to next element */
-  struct _KS_Key_Element* next;
-  
   /** The ASN of all the keys. */
   u_int32_t   asn;
   /** The array containing the ASKI of the key. */
   u_int8_t    ski[SKI_LENGTH];
+  /** Indicates how many different DER keys are stored. Normally 1 but > 1 in 
+   * case of an SKI / ASN collision, 0 hides the keys of the bundle. */
+  u_int16_t   noKeys;  
   /** An array containing the DER formated key - Normally contains only one key 
    * but in case of an SKI conflict multiple keys might be possible. */
   BGPSecKey** derKey;
   /** Contains the OpenSSL Key if loaded into memory - each array element 
-   * corresponds to the DER formated key. */
+   * corresponds to the DER formated key. Set atomically on first use. */
   EC_KEY**    ec_key; 
-  /** Number of times this key is used up to MAX_KEY_USED. */
-  u_int16_t  timesUsed;
-  /** Indicates how many different DER keys are stored. Normally 1 but > 1 in 
-   * case of an SKI / ASN collision */
-  u_int16_t  noKeys;  
 } KS_Key_Element;
 
+/** One slot of the hash table. */
+typedef struct
+{
+  /** The hash of the element, only valid if elem is set. */
+  u_int32_t       hash;
+  /** The element, NULL for a free slot or KS_DELETED. */
+  KS_Key_Element* elem;
+} KS_Slot;
+
+/** The hash table, replaced as a whole when it grows. */
+typedef struct
+{
+  /** The number of slots - 1, the number of slots is a power of 2. */
+  u_int32_t mask;
+  /** The number of slots that are not free, including deleted ones. */
+  u_int32_t used;
+  /** The slots. */
+  KS_Slot   slots[];
+} KS_Table;
+
 typedef struct 
 {
   /** The algorithm ID of the keys. */
-  u_int8_t algorithmID;
+  u_int8_t  algorithmID;
   /** indicates if the keys are private or not. */
-  bool isPrivate;
-  /** The bucket head elements of the storage. */
-  KS_Key_Element** head;  
+  bool      isPrivate;
+  /** The current hash table. */
+  KS_Table* table;
   /** The number of keys stored in the storage. */
   u_int32_t size;
+  /** Serializes all modifications. */
+  pthread_mutex_t mutex;
+  /** The read epoch, incremented by each modification that frees memory. */
+  u_int32_t epoch;
+  /** The number of read sections per epoch parity. */
+  u_int32_t readers[2];
+  /** The key bundle or NULL. */
+  KeyBundle* bundle;
 } KeyStorage;
 
 /**
@@ -104,7 +143,29 @@ typedef struct
 void ks_init(KeyStorage* storage, u_int8_t algoID, bool isPrivate);
 
 /**
- * Retrieve the EC_KEY associated to the given ski and asn
+ * Start a read section. The keys returned by ks_getKey stay valid until the
+ * read section ends, even if they are deleted concurrently. Read sections
+ * must be short, modifications wait for them to end, and must not call any
+ * function that modifies the storage.
+ * 
+ * @param storage The key storage.
+ * 
+ * @return The epoch of the read section, required by ks_endRead.
+ */
+u_int32_t ks_beginRead(KeyStorage* storage);
+
+/**
+ * End a read section started with ks_beginRead.
+ * 
+ * @param storage The key storage.
+ * @param epoch The value returned by ks_beginRead.
+ */
+void ks_endRead(KeyStorage* storage, u_int32_t epoch);
+
+/**
+ * Retrieve the EC_KEY associated to the given ski and asn. Must be called 
+ * within a read section (see ks_beginRead). Thread safe, DER keys are converted
+ * into EC keys on first use.
  * 
  * Possible USER return values:
  * 
@@ -128,7 +189,8 @@ void** ks_getKey(KeyStorage* storage, u_int8_t* ski, u_int32_t asn,
                  u_int16_t* noKeys, KS_Key_Type kType, sca_status_t* status);
 
 /**
- * Store the key in the given KeyStorage.
+ * Store the key in the given KeyStorage. Must not be called within a read 
+ * section.
  * 
  * API_STATUS_INFO_USER1: Duplicate Key
  * 
@@ -143,7 +205,8 @@ int ks_storeKey(KeyStorage* storage, BGPSecKey* key, sca_status_t* status,
                 bool convert);
 
 /**
- * Delete the key from the given KeyStorage.
+ * Delete the key from the given KeyStorage. Must not be called within a read 
+ * section.
  * 
  * @param storage The storage where the key is stored in
  * @param key The BGPSecKey to be stored.
@@ -153,9 +216,25 @@ int ks_storeKey(KeyStorage* storage, BGPSecKey* key, sca_status_t* status,
  */
 int ks_delKey(KeyStorage* storage, BGPSecKey* key, sca_status_t* status);
 
+/**
+ * Attach the given key bundle to the storage, a previously attached bundle is
+ * closed. Must not be called within a read section.
+ * 
+ * API_STATUS_ERR_USER1: The bundle does not match the storage.
+ * 
+ * @param storage The key storage.
+ * @param bundle The bundle, the storage takes ownership. NULL to detach the 
+ *               current bundle.
+ * @param status an OUT value that provides more information.
+ * 
+ * @return API_SUCESS if the bundle is attached, otherwise API_FAILED.
+ */
+int ks_setBundle(KeyStorage* storage, KeyBundle* bundle, sca_status_t* status);
+
 /** 
  * Free all Key Storage elements and *associated memory that was generated
- * within the list.
+ * within the list, the key bundle is closed. Must not be called within a read
+ * section.
  */
 void ks_empty(KeyStorage* storage);
 
@@ -167,4 +246,3 @@ void ks_empty(KeyStorage* storage);
 void ks_release(KeyStorage* storage);
 
 #endif /* KEY_STORAGE_H */
-
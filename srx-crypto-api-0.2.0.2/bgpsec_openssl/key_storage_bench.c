@@ -0,0 +1,462 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Key storage benchmark. Registers the given numbers of public keys (default
+ * 100000 and 1000000) and measures the lookup rate for stored and unknown keys
+ * on multiple threads. All keys share one generated DER key, each with its own
+ * ASN and SKI. Optionally one thread keeps deleting and re-registering keys
+ * during the lookups. Built with "make check", not installed.
+ *
+ * @version 0.2.0.2
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <openssl/ec.h>
+#include <openssl/obj_mac.h>
+#include <openssl/sha.h>
+#include <openssl/x509.h>
+#include "../srx/srxcryptoapi.h"
+#include "key_storage.h"
+
+/** The maximum number of lookup threads. */
+#define KSB_MAX_THREADS     64
+/** The default number of lookups per thread. */
+#define KSB_DEF_LOOKUPS     2000000
+/** The number of lookups per read section, like one update. */
+#define KSB_LOOKUPS_PER_READ 8
+
+/** The ASN and SKI of a key. */
+typedef struct {
+  u_int32_t asn;
+  u_int8_t  ski[SKI_LENGTH];
+} KSB_KeyID;
+
+/** The settings of one benchmark run. */
+typedef struct {
+  /** The storage. */
+  KeyStorage* storage;
+  /** The number of stored keys. */
+  u_int32_t   noKeys;
+  /** The IDs of the stored keys. */
+  KSB_KeyID*  keyIDs;
+  /** The IDs of keys that are not stored. */
+  KSB_KeyID*  unknownIDs;
+  /** The number of lookups per thread. */
+  u_int32_t   lookups;
+  /** Look up unknown keys. */
+  bool        miss;
+  /** Request EC keys instead of DER keys. */
+  bool        ecKeys;
+  /** The DER key all keys share. */
+  BGPSecKey*  derKey;
+  /** Set once all lookup threads finished. */
+  bool        done;
+  /** The number of keys found. */
+  u_int32_t   found[KSB_MAX_THREADS];
+  /** The number of delete / store operations of the writer thread. */
+  u_int32_t   updates;
+} KSB_Run;
+
+/** The parameters of a lookup thread. */
+typedef struct {
+  KSB_Run* run;
+  int      id;
+} KSB_Thread;
+
+/**
+ * The key storage requires the srxCryptoAPI to load keys from file, the
+ * benchmark always provides the DER key.
+ */
+int sca_loadKey(BGPSecKey* key, bool fPrivate, sca_status_t* status)
+{
+  if (status != NULL)
+  {
+    *status |= API_STATUS_ERR_KEY_IO | API_STATUS_INFO_KEY_NOTFOUND;
+  }
+  return API_FAILURE;
+}
+
+/**
+ * Print the log messages of the key storage.
+ */
+void sca_debugLog(int level, const char *format, ...)
+{
+  va_list ap;
+  va_start(ap, format);
+  vfprintf(stderr, format, ap);
+  va_end(ap);
+}
+
+/**
+ * Return the current time in seconds.
+ *
+ * @return The monotonic time.
+ */
+static double _now()
+{
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/**
+ * Generate the ASN and SKI of the keys. Two keys share an ASN, the SKI is 
+ * derived from the number of the key.
+ *
+ * @param noKeys The number of keys.
+ * @param unknown Generate the IDs of keys that are not stored.
+ *
+ * @return The array of key IDs.
+ */
+static KSB_KeyID* _createKeyIDs(u_int32_t noKeys, bool unknown)
+{
+  KSB_KeyID* keyIDs = malloc(noKeys * sizeof(KSB_KeyID));
+  u_int8_t   hash[SHA_DIGEST_LENGTH];
+  u_int32_t  input[2] = { 0, unknown ? 1 : 0 };
+
+  for (; input[0] < noKeys; input[0]++)
+  {
+    SHA1((u_int8_t*)input, sizeof(input), hash);
+    keyIDs[input[0]].asn = htonl(input[0] / 2 + 1);
+    memcpy(keyIDs[input[0]].ski, hash, SKI_LENGTH);
+  }
+
+  return keyIDs;
+}
+
+/**
+ * Generate a random P-256 public key in DER format.
+ *
+ * @return The key with ASN and SKI not set or NULL.
+ */
+static BGPSecKey* _createKey()
+{
+  EC_KEY*    ecKey = EC_KEY_new_by_curve_name(NID_X9_62_prime256v1);
+  BGPSecKey* key   = NULL;
+  u_int8_t*  ptr   = NULL;
+
+  if (ecKey != NULL && EC_KEY_generate_key(ecKey) == 1)
+  {
+    key = malloc(sizeof(BGPSecKey));
+    memset(key, 0, sizeof(BGPSecKey));
+    key->algoID    = SCA_ECDSA_ALGORITHM;
+    key->keyLength = i2d_EC_PUBKEY(ecKey, NULL);
+    key->keyData   = malloc(key->keyLength);
+    ptr            = key->keyData;
+    i2d_EC_PUBKEY(ecKey, &ptr);
+  }
+  EC_KEY_free(ecKey);
+
+  return key;
+}
+
+/**
+ * Perform the lookups of one thread.
+ *
+ * @param arg The thread parameters (KSB_Thread).
+ *
+ * @return NULL
+ */
+static void* _lookupThread(void* arg)
+{
+  KSB_Thread* thread = (KSB_Thread*)arg;
+  KSB_Run*    run    = thread->run;
+  KSB_KeyID*  keyIDs = run->miss ? run->unknownIDs : run->keyIDs;
+  KSB_KeyID*  keyID  = NULL;
+  u_int32_t   random = 2463534242UL + thread->id * 7919;
+  u_int32_t   idx    = 0;
+  u_int32_t   found  = 0;
+  u_int32_t   epoch  = 0;
+  u_int16_t   noKeys = 0;
+  sca_status_t status;
+
+  for (; idx < run->lookups; idx++)
+  {
+    if (idx % KSB_LOOKUPS_PER_READ == 0)
+    {
+      epoch = ks_beginRead(run->storage);
+    }
+    // xorshift32
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    keyID = &keyIDs[random % run->noKeys];
+    if (ks_getKey(run->storage, keyID->ski, keyID->asn, &noKeys,
+                  run->ecKeys ? ks_eckey_e : ks_derkey_e, &status) != NULL)
+    {
+      found++;
+    }
+    if ((idx + 1) % KSB_LOOKUPS_PER_READ == 0 || idx + 1 == run->lookups)
+    {
+      ks_endRead(run->storage, epoch);
+    }
+  }
+  run->found[thread->id] = found;
+
+  return NULL;
+}
+
+/**
+ * Keep deleting and re-registering keys until the lookups are done.
+ *
+ * @param arg The benchmark run (KSB_Run).
+ *
+ * @return NULL
+ */
+static void* _updateThread(void* arg)
+{
+  KSB_Run*     run    = (KSB_Run*)arg;
+  BGPSecKey    key;
+  u_int32_t    number = 0;
+  sca_status_t status;
+
+  memcpy(&key, run->derKey, sizeof(BGPSecKey));
+  while (!__atomic_load_n(&run->done, __ATOMIC_ACQUIRE))
+  {
+    number = (number + 104729) % run->noKeys;
+    key.asn = run->keyIDs[number].asn;
+    memcpy(key.ski, run->keyIDs[number].ski, SKI_LENGTH);
+    ks_delKey(run->storage, &key, &status);
+    ks_storeKey(run->storage, &key, &status, false);
+    run->updates++;
+  }
+
+  return NULL;
+}
+
+/**
+ * Run the lookups on the given number of threads.
+ *
+ * @param run The benchmark run.
+ * @param noThreads The number of lookup threads.
+ * @param update Run an additional thread that modifies the storage.
+ *
+ * @return The number of lookups per second.
+ */
+static double _runLookups(KSB_Run* run, int noThreads, bool update)
+{
+  pthread_t  threads[KSB_MAX_THREADS];
+  pthread_t  updater;
+  KSB_Thread params[KSB_MAX_THREADS];
+  double     start = 0;
+  double     duration = 0;
+  u_int32_t  found = 0;
+  int        idx;
+
+  run->done    = false;
+  run->updates = 0;
+  if (update)
+  {
+    pthread_create(&updater, NULL, _updateThread, run);
+  }
+  start = _now();
+  for (idx = 0; idx < noThreads; idx++)
+  {
+    params[idx].run = run;
+    params[idx].id  = idx;
+    pthread_create(&threads[idx], NULL, _lookupThread, &params[idx]);
+  }
+  for (idx = 0; idx < noThreads; idx++)
+  {
+    pthread_join(threads[idx], NULL);
+    found += run->found[idx];
+  }
+  duration = _now() - start;
+  __atomic_store_n(&run->done, true, __ATOMIC_RELEASE);
+  if (update)
+  {
+    pthread_join(updater, NULL);
+  }
+
+  // Keys being re-registered might not be found.
+  if (run->miss ? (found != 0)
+                : (!update && found != run->lookups * noThreads))
+  {
+    printf ("ERROR: %u of %u lookups found a key!\n", found,
+            run->lookups * noThreads);
+  }
+
+  return (run->lookups * (double)noThreads) / duration;
+}
+
+/**
+ * Fill a key storage with the given number of keys and measure the lookups.
+ *
+ * @param derKey The DER key all keys share.
+ * @param noKeys The number of keys.
+ * @param lookups The number of lookups per thread.
+ * @param noThreads The number of lookup threads.
+ * @param update Modify the storage during the lookups.
+ * @param ecKeys Request EC keys.
+ */
+static void _benchmark(BGPSecKey* derKey, u_int32_t noKeys, u_int32_t lookups,
+                       int noThreads, bool update, bool ecKeys)
+{
+  KeyStorage*  storage = malloc(sizeof(KeyStorage));
+  KSB_Run      run;
+  BGPSecKey    key;
+  sca_status_t status;
+  double       start = 0;
+  double       storeRate = 0;
+  double       hitRate = 0;
+  double       missRate = 0;
+  u_int32_t    idx;
+
+  memset(&run, 0, sizeof(KSB_Run));
+  run.keyIDs     = _createKeyIDs(noKeys, false);
+  run.unknownIDs = _createKeyIDs(noKeys, true);
+
+  ks_init(storage, SCA_ECDSA_ALGORITHM, false);
+  memcpy(&key, derKey, sizeof(BGPSecKey));
+  start = _now();
+  for (idx = 0; idx < noKeys; idx++)
+  {
+    key.asn = run.keyIDs[idx].asn;
+    memcpy(key.ski, run.keyIDs[idx].ski, SKI_LENGTH);
+    if (ks_storeKey(storage, &key, &status, false) != API_SUCCESS)
+    {
+      printf ("ERROR: Could not store key %u (status 0x%08X)\n", idx, status);
+      break;
+    }
+  }
+  storeRate = noKeys / (_now() - start);
+
+  run.storage = storage;
+  run.noKeys  = noKeys;
+  run.lookups = lookups;
+  run.ecKeys  = ecKeys;
+  run.derKey  = derKey;
+  hitRate  = _runLookups(&run, noThreads, update);
+  run.miss = true;
+  missRate = _runLookups(&run, noThreads, update);
+
+  printf ("%8u keys: store %9.0f keys/s, found %10.0f lookups/s, "
+          "unknown %10.0f lookups/s", noKeys, storeRate, hitRate, missRate);
+  if (update)
+  {
+    printf (", %u updates", run.updates);
+  }
+  printf ("\n");
+
+  start = _now();
+  ks_release(storage);
+  printf ("          release %.3f s\n", _now() - start);
+  free(run.keyIDs);
+  free(run.unknownIDs);
+}
+
+/**
+ * Print the usage of the benchmark.
+ *
+ * @param prgName The program name.
+ */
+static void _printUsage(char* prgName)
+{
+  printf ("Usage: %s [-t <threads>] [-l <lookups>] [-u] [-e] [<keys> ...]\n",
+          prgName);
+  printf ("  -t  The number of lookup threads (default 1, max %d)\n",
+          KSB_MAX_THREADS);
+  printf ("  -l  The number of lookups per thread (default %d)\n",
+          KSB_DEF_LOOKUPS);
+  printf ("  -u  Delete and re-register keys during the lookups\n");
+  printf ("  -e  Request EC keys, converts each key on first use\n");
+  printf ("  keys  The numbers of stored keys (default 100000 1000000)\n");
+}
+
+int main(int argc, char** argv)
+{
+  BGPSecKey* derKey    = NULL;
+  u_int32_t  lookups   = KSB_DEF_LOOKUPS;
+  int        noThreads = 1;
+  bool       update    = false;
+  bool       ecKeys    = false;
+  bool       sizeGiven = false;
+  int        idx       = 1;
+
+  for (; idx < argc; idx++)
+  {
+    if (strcmp(argv[idx], "-t") == 0 && idx + 1 < argc)
+    {
+      noThreads = atoi(argv[++idx]);
+    }
+    else if (strcmp(argv[idx], "-l") == 0 && idx + 1 < argc)
+    {
+      lookups = strtoul(argv[++idx], NULL, 10);
+    }
+    else if (strcmp(argv[idx], "-u") == 0)
+    {
+      update = true;
+    }
+    else if (strcmp(argv[idx], "-e") == 0)
+    {
+      ecKeys = true;
+    }
+    else if (argv[idx][0] == '-')
+    {
+      _printUsage(argv[0]);
+      return 1;
+    }
+  }
+  if (noThreads < 1 || noThreads > KSB_MAX_THREADS || lookups == 0)
+  {
+    _printUsage(argv[0]);
+    return 1;
+  }
+
+  derKey = _createKey();
+  if (derKey == NULL)
+  {
+    printf ("ERROR: Could not generate a key!\n");
+    return 1;
+  }
+
+  printf ("%d lookup thread(s), %u lookups each%s\n", noThreads, lookups,
+          update ? ", keys are updated concurrently" : "");
+  for (idx = 1; idx < argc; idx++)
+  {
+    if (strcmp(argv[idx], "-t") == 0 || strcmp(argv[idx], "-l") == 0)
+    {
+      idx++;
+    }
+    else if (argv[idx][0] != '-' && strtoul(argv[idx], NULL, 10) > 0)
+    {
+      _benchmark(derKey, strtoul(argv[idx], NULL, 10), lookups, noThreads,
+                 update, ecKeys);
+      sizeGiven = true;
+    }
+  }
+  if (!sizeGiven)
+  {
+    _benchmark(derKey, 100000, lookups, noThreads, update, ecKeys);
+    _benchmark(derKey, 1000000, lookups, noThreads, update, ecKeys);
+  }
+
+  free(derKey->keyData);
+  free(derKey);
+
+  return 0;
+}
@@ -0,0 +1,274 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * This file provides the implementation of the signature segment cache.
+ *
+ * @version 0.2.0.2
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include "sig_cache.h"
+
+/**
+ * Determine the set of the given digest. The digest is a SHA-256 hash, its
+ * first bytes are distributed well enough.
+ *
+ * @param cache The cache.
+ * @param digest The digest.
+ *
+ * @return The first entry of the set.
+ */
+static SC_Entry* _getSet(SigCache* cache, u_int8_t* digest)
+{
+  u_int32_t setIdx;
+
+  memcpy(&setIdx, digest, sizeof(u_int32_t));
+  return cache->entries + ((setIdx & cache->setMask) * SC_WAYS);
+}
+
+/**
+ * Check if the entry contains the given signature segment.
+ *
+ * @param entry The cache entry.
+ * @param digest The digest of the signed message.
+ * @param sigSeg The signature segment followed by its signature.
+ *
+ * @return true if the entry matches.
+ */
+static bool _matches(SC_Entry* entry, u_int8_t* digest,
+                     SCA_BGPSEC_SignatureSegment* sigSeg)
+{
+  u_int16_t sigLen = ntohs(sigSeg->siglen);
+
+  return    (entry->used != 0) && (entry->sigLen == sigLen)
+         && (memcmp(entry->digest, digest, SHA256_DIGEST_LENGTH) == 0)
+         && (memcmp(entry->ski, sigSeg->ski, SKI_LENGTH) == 0)
+         && (memcmp(entry->signature, (u_int8_t*)sigSeg + LEN_SIGSEGMENT_HDR,
+                    sigLen) == 0);
+}
+
+/**
+ * Advance the clock of the cache. Requires the cache to be locked.
+ *
+ * @param cache The cache.
+ *
+ * @return The new time, never 0.
+ */
+static u_int32_t _tick(SigCache* cache)
+{
+  if (++cache->clock == 0)
+  {
+    // Wrap around, restart the aging of all entries rather than keeping a
+    // wrong order.
+    u_int32_t idx = 0;
+    u_int32_t size = (cache->setMask + 1) * SC_WAYS;
+    for (; idx < size; idx++)
+    {
+      if (cache->entries[idx].used != 0)
+      {
+        cache->entries[idx].used = 1;
+      }
+    }
+    cache->clock = 2;
+  }
+
+  return cache->clock;
+}
+
+/**
+ * Create a signature segment cache.
+ *
+ * @param capacity The maximum number of entries, rounded up to a power of 2.
+ *
+ * @return The cache or NULL if capacity is 0.
+ */
+SigCache* sc_create(u_int32_t capacity)
+{
+  SigCache* cache   = NULL;
+  u_int32_t noSets  = 1;
+
+  if (capacity == 0)
+  {
+    return NULL;
+  }
+
+  while ((noSets * SC_WAYS) < capacity)
+  {
+    noSets <<= 1;
+  }
+
+  cache = malloc(sizeof(SigCache));
+  if (cache != NULL)
+  {
+    memset(cache, 0, sizeof(SigCache));
+    cache->entries = calloc(noSets * SC_WAYS, sizeof(SC_Entry));
+    if (cache->entries == NULL)
+    {
+      free(cache);
+      return NULL;
+    }
+    cache->setMask        = noSets - 1;
+    cache->stats.capacity = noSets * SC_WAYS;
+    pthread_mutex_init(&cache->mutex, NULL);
+  }
+
+  return cache;
+}
+
+/**
+ * Release the cache and all its entries.
+ *
+ * @param cache The cache, can be NULL.
+ */
+void sc_free(SigCache* cache)
+{
+  if (cache != NULL)
+  {
+    pthread_mutex_destroy(&cache->mutex);
+    free(cache->entries);
+    free(cache);
+  }
+}
+
+/**
+ * Look up a signature segment.
+ *
+ * @param cache The cache.
+ * @param digest The digest of the signed message (SHA256_DIGEST_LENGTH).
+ * @param sigSeg The signature segment followed by its signature.
+ * @param segments The number of signature segments that do not need to be
+ *                 verified if found, used for the statistics.
+ *
+ * @return true if the signature segment was verified before.
+ */
+bool sc_lookup(SigCache* cache, u_int8_t* digest,
+               SCA_BGPSEC_SignatureSegment* sigSeg, int segments)
+{
+  SC_Entry* set   = _getSet(cache, digest);
+  bool      found = false;
+  int       way;
+
+  pthread_mutex_lock(&cache->mutex);
+  cache->stats.lookups++;
+  for (way = 0; way < SC_WAYS; way++)
+  {
+    if (_matches(&set[way], digest, sigSeg))
+    {
+      set[way].used = _tick(cache);
+      cache->stats.hits++;
+      cache->stats.hitSegments += segments;
+      found = true;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&cache->mutex);
+
+  return found;
+}
+
+/**
+ * Add a verified signature segment. All segments closer to the origin must be
+ * verified as well.
+ *
+ * @param cache The cache.
+ * @param digest The digest of the signed message (SHA256_DIGEST_LENGTH).
+ * @param sigSeg The signature segment followed by its signature.
+ */
+void sc_insert(SigCache* cache, u_int8_t* digest,
+               SCA_BGPSEC_SignatureSegment* sigSeg)
+{
+  SC_Entry* set    = _getSet(cache, digest);
+  SC_Entry* victim = NULL;
+  u_int16_t sigLen = ntohs(sigSeg->siglen);
+  int       way;
+
+  if (sigLen > SC_MAX_SIG_LEN)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&cache->mutex);
+  for (way = 0; way < SC_WAYS; way++)
+  {
+    if (_matches(&set[way], digest, sigSeg))
+    {
+      // Added by a concurrent validation already.
+      set[way].used = _tick(cache);
+      victim = NULL;
+      break;
+    }
+    if ((victim == NULL) || (set[way].used < victim->used))
+    {
+      victim = &set[way];
+    }
+  }
+
+  if (victim != NULL)
+  {
+    if (victim->used != 0)
+    {
+      cache->stats.evictions++;
+    }
+    else
+    {
+      cache->stats.entries++;
+    }
+    victim->used   = _tick(cache);
+    victim->sigLen = sigLen;
+    memcpy(victim->digest, digest, SHA256_DIGEST_LENGTH);
+    memcpy(victim->ski, sigSeg->ski, SKI_LENGTH);
+    memcpy(victim->signature, (u_int8_t*)sigSeg + LEN_SIGSEGMENT_HDR, sigLen);
+    cache->stats.inserts++;
+  }
+  pthread_mutex_unlock(&cache->mutex);
+}
+
+/**
+ * Remove all entries, e.g. because a key was removed.
+ *
+ * @param cache The cache, can be NULL.
+ */
+void sc_flush(SigCache* cache)
+{
+  if (cache != NULL)
+  {
+    pthread_mutex_lock(&cache->mutex);
+    memset(cache->entries, 0, cache->stats.capacity * sizeof(SC_Entry));
+    cache->stats.entries = 0;
+    cache->stats.flushes++;
+    pthread_mutex_unlock(&cache->mutex);
+  }
+}
+
+/**
+ * Copy the statistics of the cache.
+ *
+ * @param cache The cache.
+ * @param stats The statistics object to be filled.
+ */
+void sc_getStatistics(SigCache* cache, SCA_CacheStatistics* stats)
+{
+  pthread_mutex_lock(&cache->mutex);
+  memcpy(stats, &cache->stats, sizeof(SCA_CacheStatistics));
+  pthread_mutex_unlock(&cache->mutex);
+}
@@ -0,0 +1,134 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * This file provides a bounded cache of verified signature segments. Each
+ * entry is the tuple (digest, SKI, signature) of a signature segment that was
+ * verified successfully. The digest of a signature segment covers all signature
+ * segments closer to the origin, an entry is therefore only added once these
+ * are verified as well. A hit for a segment makes the verification of this
+ * and all following segments of the path unnecessary.
+ *
+ * The cache is set associative with SC_WAYS entries per set and replaces the
+ * least recently used entry of a set. All functions are thread safe.
+ *
+ * @version 0.2.0.2
+ */
+#ifndef SIG_CACHE_H
+#define SIG_CACHE_H
+
+#include <sys/types.h>
+#include <pthread.h>
+#include <openssl/sha.h>
+#include "../srx/srxcryptoapi.h"
+
+/** The number of entries per set. */
+#define SC_WAYS        4
+/** The longest signature that can be cached, a DER encoded P-256 ECDSA
+ * signature does not exceed 72 bytes. */
+#define SC_MAX_SIG_LEN 72
+
+/** One verified signature segment. */
+typedef struct
+{
+  /** The time of the last use, 0 for an empty entry. */
+  u_int32_t used;
+  /** The length of the signature. */
+  u_int16_t sigLen;
+  /** The digest of the message the signature is signed over. */
+  u_int8_t  digest[SHA256_DIGEST_LENGTH];
+  /** The SKI of the signer key. */
+  u_int8_t  ski[SKI_LENGTH];
+  /** The signature. */
+  u_int8_t  signature[SC_MAX_SIG_LEN];
+} SC_Entry;
+
+typedef struct
+{
+  /** The entries, SC_WAYS per set. */
+  SC_Entry*           entries;
+  /** The number of sets - 1, the number of sets is a power of 2. */
+  u_int32_t           setMask;
+  /** Counts the cache accesses, used for the LRU replacement. */
+  u_int32_t           clock;
+  /** Protects the entries and the statistics. */
+  pthread_mutex_t     mutex;
+  /** The statistics, see SCA_CacheStatistics. */
+  SCA_CacheStatistics stats;
+} SigCache;
+
+/**
+ * Create a signature segment cache.
+ *
+ * @param capacity The maximum number of entries, rounded up to a power of 2.
+ *
+ * @return The cache or NULL if capacity is 0.
+ */
+SigCache* sc_create(u_int32_t capacity);
+
+/**
+ * Release the cache and all its entries.
+ *
+ * @param cache The cache, can be NULL.
+ */
+void sc_free(SigCache* cache);
+
+/**
+ * Look up a signature segment.
+ *
+ * @param cache The cache.
+ * @param digest The digest of the signed message (SHA256_DIGEST_LENGTH).
+ * @param sigSeg The signature segment followed by its signature.
+ * @param segments The number of signature segments that do not need to be
+ *                 verified if found, used for the statistics.
+ *
+ * @return true if the signature segment was verified before.
+ */
+bool sc_lookup(SigCache* cache, u_int8_t* digest,
+               SCA_BGPSEC_SignatureSegment* sigSeg, int segments);
+
+/**
+ * Add a verified signature segment. All segments closer to the origin must be
+ * verified as well.
+ *
+ * @param cache The cache.
+ * @param digest The digest of the signed message (SHA256_DIGEST_LENGTH).
+ * @param sigSeg The signature segment followed by its signature.
+ */
+void sc_insert(SigCache* cache, u_int8_t* digest,
+               SCA_BGPSEC_SignatureSegment* sigSeg);
+
+/**
+ * Remove all entries, e.g. because a key was removed.
+ *
+ * @param cache The cache, can be NULL.
+ */
+void sc_flush(SigCache* cache);
+
+/**
+ * Copy the statistics of the cache.
+ *
+ * @param cache The cache.
+ * @param stats The statistics object to be filled.
+ */
+void sc_getStatistics(SigCache* cache, SCA_CacheStatistics* stats);
+
+#endif /* SIG_CACHE_H */
@@ -365,6 +365,31 @@ typedef struct
   SCA_Signature* signature;
 } SCA_BGPSecSignData;
 
+/**
+ * Statistics of a cache of verified signature segments. Libraries that keep
+ * such a cache return them using getCacheStatistics.
+ */
+typedef struct
+{
+  /** The maximum number of cached signature segments. */
+  u_int32_t capacity;
+  /** The number of cached signature segments. */
+  u_int32_t entries;
+  /** The number of cache lookups. */
+  u_int64_t lookups;
+  /** The number of lookups that found the signature segment. */
+  u_int64_t hits;
+  /** The number of signature segments that were not verified because of a 
+   * hit, including the segments closer to the origin. */
+  u_int64_t hitSegments;
+  /** The number of signature segments added to the cache. */
+  u_int64_t inserts;
+  /** The number of signature segments removed to make room for others. */
+  u_int64_t evictions;
+  /** The number of times the cache was emptied, e.g. by a key removal. */
+  u_int64_t flushes;
+} SCA_CacheStatistics;
+
 #define MAX_CFGFILE_NAME 255
 
 /* The SRxCryptoAPI wrapper object.*/
@@ -523,6 +548,52 @@ typedef struct
    * @return the previous debug level or -1
    */
   int (*setDebugLevel)(int debugLevel);  
+
+  /**
+   * Perform BGPSEC path validation for a batch of updates. Each update is
+   * validated as with validate, but the implementation can share the work
+   * between the updates, e.g. verify a signature segment that is contained in
+   * several updates (one path announced for many prefixes) only once.
+   * Libraries that do not implement this method are called once per update.
+   * The caller manages the memory and MUST assure the memory is intact until
+   * the function returns.
+   *
+   * @param data The array of updates to be validated. The status flag of each
+   *             update contains further information.
+   * @param numData The number of updates in the array.
+   * @param results Array of numData elements that receives API_VALRESULT_VALID
+   *                (1) or API_VALRESULT_INVALID (0) for each update. Can be
+   *                NULL.
+   *
+   * @return The number of valid updates.
+   */
+  int (*validateBatch)(SCA_BGPSecValidationData** data, int numData,
+                       int* results);
+
+  /**
+   * Sign a batch of BGPSecSign data objects. Each object is signed as with
+   * sign. Libraries that do not implement this method are called once per
+   * object.
+   *
+   * @param bgpsec_data The array of data objects to be signed. The status flag
+   *                    of each object contains further information.
+   * @param numData The number of objects in the array.
+   * @param results Array of numData elements that receives API_SUCCESS (1) or
+   *                API_FAILURE (0) for each object. Can be NULL.
+   *
+   * @return The number of signed objects.
+   */
+  int (*signBatch)(SCA_BGPSecSignData** bgpsec_data, int numData,
+                   int* results);
+
+  /**
+   * Retrieve the statistics of the cache of verified signature segments. 
+   * 
+   * @param stats The statistics object to be filled.
+   * 
+   * @return false if the library does not keep such a cache, otherwise true
+   */
+  bool (*getCacheStatistics)(SCA_CacheStatistics* stats);
   
 } SRxCryptoAPI;
 
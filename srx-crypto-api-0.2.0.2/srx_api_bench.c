@@ -0,0 +1,445 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Validation benchmark. Reads the BGPsec path attributes generated by
+ * bgpsec-io (mode GEN-C) and validates them repeatedly using the configured
+ * crypto library. Keys contained in the file are registered, all other keys
+ * must be provided by the library initialization (e.g. PUB:<ski-list>).
+ *
+ * Example using the keys in bgpsec-io's data folder:
+ *   bgpsecio -m GEN-C -o updates.bin -C bgpsecio.cfg
+ *   srx_crypto_bench -c srxcryptoapi.conf \
+ *                    -i "PUB:<data>/ski-list.txt;CACHE:0" updates.bin
+ *   srx_crypto_bench -c srxcryptoapi.conf \
+ *                    -i "PUB:<data>/ski-list.txt;CACHE:0;HOTKEYS:16" updates.bin
+ *
+ * @version 0.2.0.2
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include "srx/srxcryptoapi.h"
+
+/* informational */
+#define LOG_INFO    6
+
+#ifndef SYSCONFDIR
+#define SYSCONFDIR "."
+#endif
+
+#define CONF_FILE SYSCONFDIR "/srxcryptoapi.conf"
+
+/** The record version written by bgpsec-io (BGPSEC_IO_RECORD_VERSION) */
+#define BENCH_RECORD_VERSION  3
+/** The record type of a BGPsec path attribute (BGPSEC_IO_TYPE_BGPSEC_ATTR) */
+#define BENCH_RECORD_ATTR     2
+/** The default number of validation rounds. */
+#define BENCH_DEF_ROUNDS      5
+
+/** The record header as written by bgpsec-io (BGPSEC_IO_Record). */
+typedef struct {
+  u_int8_t  version;
+  u_int8_t  recordType;
+  u_int8_t  draft;
+  u_int16_t dataLength;
+  u_int32_t noSegments;
+  u_int16_t keyDataLength;
+  u_int32_t asn;
+  u_int32_t peerAS;
+  u_int16_t afi;
+  u_int8_t  safi;
+  u_int8_t  length;
+  u_int8_t  addr[16];
+  bool      fake;
+  u_int16_t numKeys;
+} __attribute__((packed)) BENCH_Record;
+
+/** The key header as written by bgpsec-io (BGPSEC_IO_KRecord). */
+typedef struct {
+  u_int8_t  algoID;
+  u_int32_t asn;
+  u_int8_t  ski[SKI_LENGTH];
+  u_int16_t keyLength;
+} __attribute__((packed)) BENCH_KeyRecord;
+
+/** The benchmark settings. */
+typedef struct {
+  /** The crypto API configuration file. */
+  char* configFile;
+  /** Replaces the init value of the configuration if not NULL. */
+  char* initValue;
+  /** The bgpsec-io file. */
+  char* fileName;
+  /** The number of validation rounds. */
+  int   rounds;
+  /** The number of updates per validateBatch call, 1 uses validate. */
+  int   batchSize;
+} BENCH_Params;
+
+/**
+ * Print the usage of the benchmark.
+ *
+ * @param prgName The program name.
+ */
+static void _printUsage(char* prgName)
+{
+  printf ("Usage: %s [-c <config>] [-i <init value>] [-r <rounds>] "
+          "[-b <batch size>] <bgpsec-io file>\n", prgName);
+  printf ("  -c  The crypto API configuration (default %s)\n", CONF_FILE);
+  printf ("  -i  Re-initialize the library with this value, e.g.\n"
+          "      \"PUB:ski-list.txt;CACHE:0;HOTKEYS:16\"\n");
+  printf ("  -r  The number of validation rounds (default %d)\n",
+          BENCH_DEF_ROUNDS);
+  printf ("  -b  Updates per validateBatch call (default 1, uses validate)\n");
+  printf ("  The file contains BGPsec path attributes generated by bgpsecio "
+          "in mode GEN-C.\n");
+}
+
+/**
+ * Read the program parameters.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @param params The settings to be filled.
+ *
+ * @return false if the parameters are invalid.
+ */
+static bool _checkParams(int argc, char** argv, BENCH_Params* params)
+{
+  int idx = 1;
+
+  params->configFile = CONF_FILE;
+  params->rounds     = BENCH_DEF_ROUNDS;
+  params->batchSize  = 1;
+
+  for (; idx < argc; idx++)
+  {
+    if (argv[idx][0] == '-' && strlen(argv[idx]) == 2 && idx + 1 < argc)
+    {
+      switch (argv[idx][1])
+      {
+        case 'c' :
+          params->configFile = argv[++idx];
+          break;
+        case 'i' :
+          params->initValue = argv[++idx];
+          break;
+        case 'r' :
+          params->rounds = atoi(argv[++idx]);
+          break;
+        case 'b' :
+          params->batchSize = atoi(argv[++idx]);
+          break;
+        default:
+          return false;
+      }
+    }
+    else
+    {
+      params->fileName = argv[idx];
+    }
+  }
+
+  return params->fileName != NULL && params->rounds > 0
+         && params->batchSize > 0;
+}
+
+/**
+ * Register the keys stored with a record.
+ *
+ * @param crypto The crypto API.
+ * @param keyData The key records.
+ * @param keyDataLength The length of the key records.
+ *
+ * @return The number of registered keys.
+ */
+static int _registerKeys(SRxCryptoAPI* crypto, u_int8_t* keyData,
+                         u_int16_t keyDataLength)
+{
+  BENCH_KeyRecord* kRecord = NULL;
+  BGPSecKey        key;
+  sca_status_t     status  = API_STATUS_OK;
+  int              noKeys  = 0;
+  int              pos     = 0;
+
+  while (pos + sizeof(BENCH_KeyRecord) <= keyDataLength)
+  {
+    kRecord = (BENCH_KeyRecord*)(keyData + pos);
+    pos    += sizeof(BENCH_KeyRecord);
+    memset(&key, 0, sizeof(BGPSecKey));
+    key.algoID    = kRecord->algoID;
+    key.asn       = kRecord->asn;
+    memcpy(key.ski, kRecord->ski, SKI_LENGTH);
+    key.keyLength = ntohs(kRecord->keyLength);
+    key.keyData   = keyData + pos;
+    pos          += key.keyLength;
+    if (key.keyLength != 0 && pos <= keyDataLength
+        && crypto->registerPublicKey(&key, &status) == API_SUCCESS)
+    {
+      noKeys++;
+    }
+  }
+
+  return noKeys;
+}
+
+/**
+ * Load all BGPsec path attributes of the file.
+ *
+ * @param crypto The crypto API, used to register the keys found in the file.
+ * @param fileName The bgpsec-io file.
+ * @param noUpdates OUT the number of updates loaded.
+ * @param noSegments OUT the number of signature segments of all updates.
+ *
+ * @return The validation data of all updates or NULL.
+ */
+static SCA_BGPSecValidationData* _loadUpdates(SRxCryptoAPI* crypto,
+                                              char* fileName, int* noUpdates,
+                                              long* noSegments)
+{
+  FILE*                     file    = fopen(fileName, "rb");
+  SCA_BGPSecValidationData* updates = NULL;
+  SCA_BGPSecValidationData* update  = NULL;
+  BENCH_Record              record;
+  u_int8_t*                 keyData = NULL;
+  u_int16_t                 dataLength;
+  u_int16_t                 keyDataLength;
+  int                       size    = 0;
+  int                       skipped = 0;
+  int                       noKeys  = 0;
+
+  *noUpdates  = 0;
+  *noSegments = 0;
+  if (file == NULL)
+  {
+    printf ("ERROR: Could not open '%s'\n", fileName);
+    return NULL;
+  }
+
+  while (fread(&record, sizeof(BENCH_Record), 1, file) == 1)
+  {
+    if (record.version != BENCH_RECORD_VERSION)
+    {
+      printf ("ERROR: Incompatible data version. Expected V=%d, found V=%d\n",
+              BENCH_RECORD_VERSION, record.version);
+      break;
+    }
+    dataLength    = ntohs(record.dataLength);
+    keyDataLength = ntohs(record.keyDataLength);
+
+    if (keyDataLength != 0)
+    {
+      keyData = malloc(keyDataLength);
+      if (fread(keyData, keyDataLength, 1, file) == 1)
+      {
+        noKeys += _registerKeys(crypto, keyData, keyDataLength);
+      }
+      free(keyData);
+    }
+
+    if (record.recordType != BENCH_RECORD_ATTR)
+    {
+      fseek(file, dataLength, SEEK_CUR);
+      skipped++;
+      continue;
+    }
+
+    if (*noUpdates == size)
+    {
+      size    = (size == 0) ? 1024 : size * 2;
+      updates = realloc(updates, size * sizeof(SCA_BGPSecValidationData));
+    }
+    update = &updates[*noUpdates];
+    memset(update, 0, sizeof(SCA_BGPSecValidationData));
+    update->bgpsec_path_attr = malloc(dataLength);
+    if (fread(update->bgpsec_path_attr, dataLength, 1, file) != 1)
+    {
+      free(update->bgpsec_path_attr);
+      break;
+    }
+    // The updates were generated to be sent to the peer.
+    update->myAS         = record.peerAS;
+    update->nlri         = malloc(sizeof(SCA_Prefix));
+    memset(update->nlri, 0, sizeof(SCA_Prefix));
+    update->nlri->afi    = record.afi;
+    update->nlri->safi   = record.safi;
+    update->nlri->length = record.length;
+    memcpy(update->nlri->addr.ip, record.addr, sizeof(record.addr));
+    *noSegments += ntohl(record.noSegments);
+    (*noUpdates)++;
+  }
+  fclose(file);
+
+  printf ("Loaded %d updates with %ld signatures, registered %d keys",
+          *noUpdates, *noSegments, noKeys);
+  if (skipped != 0)
+  {
+    printf (", skipped %d BGP update records", skipped);
+  }
+  printf ("\n");
+
+  return updates;
+}
+
+/**
+ * Return the current time in seconds.
+ *
+ * @return The time.
+ */
+static double _now()
+{
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec + (time.tv_nsec / 1e9);
+}
+
+/**
+ * Validate all updates once.
+ *
+ * @param crypto The crypto API.
+ * @param updates The updates.
+ * @param noUpdates The number of updates.
+ * @param batchSize The number of updates per validateBatch call.
+ *
+ * @return The number of valid updates.
+ */
+static int _validateAll(SRxCryptoAPI* crypto, SCA_BGPSecValidationData* updates,
+                        int noUpdates, int batchSize)
+{
+  SCA_BGPSecValidationData** batch = malloc(batchSize
+                                          * sizeof(SCA_BGPSecValidationData*));
+  int valid = 0;
+  int idx   = 0;
+  int count = 0;
+
+  for (idx = 0; idx < noUpdates; idx += count)
+  {
+    if (batchSize == 1)
+    {
+      valid += crypto->validate(&updates[idx]) == API_VALRESULT_VALID;
+      count  = 1;
+    }
+    else
+    {
+      for (count = 0; count < batchSize && idx + count < noUpdates; count++)
+      {
+        batch[count] = &updates[idx + count];
+      }
+      valid += crypto->validateBatch(batch, count, NULL);
+    }
+  }
+  free(batch);
+
+  return valid;
+}
+
+int main(int argc, char** argv)
+{
+  SRxCryptoAPI*             crypto     = NULL;
+  SCA_BGPSecValidationData* updates    = NULL;
+  SCA_CacheStatistics       stats;
+  BENCH_Params              params;
+  sca_status_t              status     = API_STATUS_OK;
+  long                      noSegments = 0;
+  int                       noUpdates  = 0;
+  int                       round      = 0;
+  int                       valid      = 0;
+  int                       idx        = 0;
+  double                    start      = 0;
+  double                    duration   = 0;
+
+  memset(&params, 0, sizeof(BENCH_Params));
+  if (!_checkParams(argc, argv, &params))
+  {
+    _printUsage(argv[0]);
+    return 1;
+  }
+
+  crypto = malloc(sizeof(SRxCryptoAPI));
+  memset (crypto, 0, sizeof(SRxCryptoAPI));
+  crypto->configFile = params.configFile;
+  if (!srxCryptoInit(crypto, &status))
+  {
+    printf ("Failure initializing API!\n");
+    free(crypto);
+    return 1;
+  }
+  if (params.initValue != NULL)
+  {
+    crypto->release(&status);
+    if (crypto->init(params.initValue, LOG_INFO, &status) != API_SUCCESS)
+    {
+      printf ("Failure initializing the library with '%s'!\n",
+              params.initValue);
+      srxCryptoUnbind(crypto, &status);
+      free(crypto);
+      return 1;
+    }
+  }
+
+  updates = _loadUpdates(crypto, params.fileName, &noUpdates, &noSegments);
+  for (round = 1; round <= params.rounds && noUpdates > 0; round++)
+  {
+    // Each round generates the hash messages again.
+    for (idx = 0; idx < noUpdates; idx++)
+    {
+      if (updates[idx].hashMessage[0] != NULL)
+      {
+        crypto->freeHashMessage(updates[idx].hashMessage[0]);
+        updates[idx].hashMessage[0] = NULL;
+      }
+    }
+    start    = _now();
+    valid    = _validateAll(crypto, updates, noUpdates, params.batchSize);
+    duration = _now() - start;
+    printf ("Round %d: %d/%d valid, %.3f s, %.0f updates/s, "
+            "%.0f signatures/s\n", round, valid, noUpdates, duration,
+            noUpdates / duration, noSegments / duration);
+  }
+
+  if (crypto->getCacheStatistics(&stats))
+  {
+    printf ("Signature cache: %u/%u entries, %llu lookups, %llu hits, "
+            "%llu signatures skipped\n", stats.entries, stats.capacity,
+            (unsigned long long)stats.lookups, (unsigned long long)stats.hits,
+            (unsigned long long)stats.hitSegments);
+  }
+
+  for (idx = 0; idx < noUpdates; idx++)
+  {
+    if (updates[idx].hashMessage[0] != NULL)
+    {
+      crypto->freeHashMessage(updates[idx].hashMessage[0]);
+    }
+    free(updates[idx].bgpsec_path_attr);
+    free(updates[idx].nlri);
+  }
+  free(updates);
+
+  srxCryptoUnbind(crypto, &status);
+  free(crypto);
+
+  return 0;
+}
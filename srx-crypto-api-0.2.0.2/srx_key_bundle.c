@@ -0,0 +1,381 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Key bundle generator. Reads all keys of a ski list from the key volt and
+ * writes them into one binary key bundle (see bgpsec_openssl/key_bundle.h).
+ * The bundle is used with the init value "BUNDLE:<file>" of the BGPsec OpenSSL
+ * library instead of "PUB:<ski list>" and is mapped into memory, the keys are
+ * loaded on first use.
+ *
+ * Example using the keys in bgpsec-io's data folder:
+ *   srx_key_bundle -k <data> -o <data>/ski-list.bundle <data>/ski-list.txt
+ *   srx_crypto_bench -i "BUNDLE:<data>/ski-list.bundle" updates.bin
+ *
+ * @version 0.2.0.2
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <sys/param.h>
+#include "srx/srxcryptoapi.h"
+#include "bgpsec_openssl/key_bundle.h"
+
+/** The default key volt. */
+#define BUNDLE_DEF_KEY_VOLT "/var/lib/bgpsec-keys/"
+
+/** The generator settings. */
+typedef struct {
+  /** The key volt. */
+  char* keyVolt;
+  /** The ski list. */
+  char* listFile;
+  /** The bundle to be written. */
+  char* outFile;
+  /** Indicates if the private keys are bundled. */
+  bool  isPrivate;
+} BUNDLE_Params;
+
+/**
+ * Print the usage of the generator.
+ *
+ * @param prgName The program name.
+ */
+static void _printUsage(char* prgName)
+{
+  printf ("Usage: %s [-k <key volt>] [-p] -o <bundle> <ski list>\n", prgName);
+  printf ("  -k  The key volt (default %s)\n", BUNDLE_DEF_KEY_VOLT);
+  printf ("  -p  Bundle the private keys instead of the public keys\n");
+  printf ("  -o  The key bundle to be written\n");
+  printf ("  The ski list contains one '<ASN>-SKI: <SKI HEX VALUE>' per "
+          "line.\n");
+}
+
+/**
+ * Read the program parameters.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @param params The settings to be filled.
+ *
+ * @return false if the parameters are invalid.
+ */
+static bool _checkParams(int argc, char** argv, BUNDLE_Params* params)
+{
+  int idx = 1;
+
+  params->keyVolt = BUNDLE_DEF_KEY_VOLT;
+
+  for (; idx < argc; idx++)
+  {
+    if (argv[idx][0] == '-' && strlen(argv[idx]) == 2)
+    {
+      switch (argv[idx][1])
+      {
+        case 'p' :
+          params->isPrivate = true;
+          break;
+        case 'k' :
+          if (idx + 1 == argc)
+          {
+            return false;
+          }
+          params->keyVolt = argv[++idx];
+          break;
+        case 'o' :
+          if (idx + 1 == argc)
+          {
+            return false;
+          }
+          params->outFile = argv[++idx];
+          break;
+        default:
+          return false;
+      }
+    }
+    else
+    {
+      params->listFile = argv[idx];
+    }
+  }
+
+  return params->listFile != NULL && params->outFile != NULL;
+}
+
+/**
+ * Parse one line of the ski list. The line format is the one read by the
+ * BGPsec OpenSSL library: <ASN>-SKI: <SKI HEX VALUE>
+ *
+ * @param line The line.
+ * @param key The key that receives the ASN (network format) and the SKI.
+ *
+ * @return false if the line does not contain a key.
+ */
+static bool _parseLine(char* line, BGPSecKey* key)
+{
+  char      hexBuf[3] = {0, 0, 0};
+  char*     ptr       = line;
+  u_int32_t asn       = 0;
+  int       idx       = 0;
+
+  if (line[0] == '#' || strlen(line) <= SKI_HEX_LENGTH)
+  {
+    return false;
+  }
+  for (; *ptr >= '0' && *ptr <= '9'; ptr++)
+  {
+    asn = (asn * 10) + (*ptr - '0');
+  }
+  ptr = strchr(ptr, ' ');
+  if (ptr == NULL || strlen(++ptr) < SKI_HEX_LENGTH)
+  {
+    return false;
+  }
+  for (; idx < SKI_LENGTH; idx++, ptr += 2)
+  {
+    hexBuf[0] = ptr[0];
+    hexBuf[1] = ptr[1];
+    key->ski[idx] = (u_int8_t)strtol(hexBuf, NULL, 16);
+  }
+  key->asn = htonl(asn);
+
+  return true;
+}
+
+/**
+ * Compare two keys by ASN (network format) and SKI, the order of the bundle.
+ * Keys with equal ASN and SKI are ordered by their DER key.
+ *
+ * @param a The first key.
+ * @param b The second key.
+ *
+ * @return <0, 0, >0 like memcmp.
+ */
+static int _compareKeys(const void* a, const void* b)
+{
+  const BGPSecKey* keyA = (const BGPSecKey*)a;
+  const BGPSecKey* keyB = (const BGPSecKey*)b;
+  u_int32_t        asnA = keyA->asn;
+  u_int32_t        asnB = keyB->asn;
+  int              cmp  = memcmp(&asnA, &asnB, sizeof(u_int32_t));
+
+  if (cmp == 0)
+  {
+    cmp = memcmp(keyA->ski, keyB->ski, SKI_LENGTH);
+  }
+  if (cmp == 0)
+  {
+    cmp = (int)keyA->keyLength - (int)keyB->keyLength;
+  }
+  if (cmp == 0)
+  {
+    cmp = memcmp(keyA->keyData, keyB->keyData, keyA->keyLength);
+  }
+
+  return cmp;
+}
+
+/**
+ * Load all keys of the ski list from the key volt.
+ *
+ * @param params The settings.
+ * @param keys OUT the keys loaded, must be freed by the caller.
+ * @param noKeys OUT the number of keys loaded.
+ * @param missing OUT the number of keys not found.
+ *
+ * @return false if the list could not be read.
+ */
+static bool _loadKeys(BUNDLE_Params* params, BGPSecKey** keys,
+                      u_int32_t* noKeys, u_int32_t* missing)
+{
+  FILE*        file   = fopen(params->listFile, "r");
+  BGPSecKey*   key    = NULL;
+  sca_status_t status = API_STATUS_OK;
+  u_int32_t    size   = 0;
+  char         line[1024];
+
+  *keys    = NULL;
+  *noKeys  = 0;
+  *missing = 0;
+  if (file == NULL)
+  {
+    printf ("ERROR: Could not open '%s'\n", params->listFile);
+    return false;
+  }
+
+  while (fgets(line, sizeof(line), file) != NULL)
+  {
+    if (*noKeys == size)
+    {
+      size = (size == 0) ? 1024 : size * 2;
+      *keys = realloc(*keys, size * sizeof(BGPSecKey));
+    }
+    key = &(*keys)[*noKeys];
+    memset(key, 0, sizeof(BGPSecKey));
+    key->algoID = SCA_ECDSA_ALGORITHM;
+    if (!_parseLine(line, key))
+    {
+      continue;
+    }
+    if (sca_loadKey(key, params->isPrivate, &status) == API_SUCCESS)
+    {
+      (*noKeys)++;
+    }
+    else
+    {
+      free(key->keyData);
+      (*missing)++;
+    }
+  }
+  fclose(file);
+
+  return true;
+}
+
+/**
+ * Write the bundle. The file is written under a temporary name and renamed,
+ * a bundle that is mapped by a running process is not modified.
+ *
+ * @param params The settings.
+ * @param keys The keys, sorted by _compareKeys.
+ * @param noKeys The number of keys.
+ *
+ * @return The number of keys written or -1 on error.
+ */
+static int _writeBundle(BUNDLE_Params* params, BGPSecKey* keys,
+                        u_int32_t noKeys)
+{
+  char      tmpFile[MAXPATHLEN];
+  FILE*     file    = NULL;
+  KB_Header header;
+  KB_Entry  entry;
+  u_int32_t offset  = 0;
+  u_int32_t written = 0;
+  u_int32_t idx     = 0;
+  bool      ok      = true;
+
+  // Skip keys that are listed more than once
+  for (idx = 0; idx < noKeys; idx++)
+  {
+    if (idx == 0 || _compareKeys(&keys[idx - 1], &keys[idx]) != 0)
+    {
+      keys[written++] = keys[idx];
+    }
+    else
+    {
+      free(keys[idx].keyData);
+    }
+  }
+
+  snprintf(tmpFile, MAXPATHLEN, "%s.tmp", params->outFile);
+  file = fopen(tmpFile, "wb");
+  if (file == NULL)
+  {
+    printf ("ERROR: Could not create '%s'\n", tmpFile);
+    return -1;
+  }
+
+  memset(&header, 0, sizeof(KB_Header));
+  memcpy(header.magic, KB_MAGIC, KB_MAGIC_LEN);
+  header.version   = htons(KB_VERSION);
+  header.algoID    = SCA_ECDSA_ALGORITHM;
+  header.isPrivate = params->isPrivate ? 1 : 0;
+  header.noKeys    = htonl(written);
+  ok = fwrite(&header, sizeof(KB_Header), 1, file) == 1;
+
+  offset = sizeof(KB_Header) + written * sizeof(KB_Entry);
+  for (idx = 0; ok && idx < written; idx++)
+  {
+    memset(&entry, 0, sizeof(KB_Entry));
+    entry.asn    = keys[idx].asn;
+    memcpy(entry.ski, keys[idx].ski, SKI_LENGTH);
+    entry.offset = htonl(offset);
+    entry.length = htons(keys[idx].keyLength);
+    offset      += keys[idx].keyLength;
+    ok = fwrite(&entry, sizeof(KB_Entry), 1, file) == 1;
+  }
+  for (idx = 0; ok && idx < written; idx++)
+  {
+    ok = fwrite(keys[idx].keyData, keys[idx].keyLength, 1, file) == 1;
+  }
+  ok = (fclose(file) == 0) && ok;
+
+  if (ok && rename(tmpFile, params->outFile) != 0)
+  {
+    ok = false;
+  }
+  if (!ok)
+  {
+    printf ("ERROR: Could not write '%s'\n", params->outFile);
+    remove(tmpFile);
+  }
+  for (idx = 0; idx < written; idx++)
+  {
+    free(keys[idx].keyData);
+  }
+
+  return ok ? (int)written : -1;
+}
+
+int main(int argc, char** argv)
+{
+  BUNDLE_Params params;
+  BGPSecKey*    keys    = NULL;
+  u_int32_t     noKeys  = 0;
+  u_int32_t     missing = 0;
+  int           written = 0;
+
+  memset(&params, 0, sizeof(BUNDLE_Params));
+  if (!_checkParams(argc, argv, &params))
+  {
+    _printUsage(argv[0]);
+    return 1;
+  }
+
+  sca_SetKeyPath(params.keyVolt);
+  if (!_loadKeys(&params, &keys, &noKeys, &missing))
+  {
+    return 1;
+  }
+
+  if (noKeys != 0)
+  {
+    qsort(keys, noKeys, sizeof(BGPSecKey), _compareKeys);
+  }
+  written = _writeBundle(&params, keys, noKeys);
+  free(keys);
+
+  if (written < 0)
+  {
+    return 1;
+  }
+  printf ("Wrote %d %s keys to '%s'", written,
+          params.isPrivate ? "private" : "public", params.outFile);
+  if (missing != 0)
+  {
+    printf (", %u keys not found", missing);
+  }
+  printf ("\n");
+
+  return 0;
+}
@@ -125,9 +125,12 @@
 
 #define SCA_GET_DEBUGLEVEL         "method_getDebugLevel"
 #define SCA_SET_DEBUGLEVEL         "method_setDebugLevel"
+#define SCA_GET_CACHE_STATISTICS   "method_getCacheStatistics"
 
 #define SCA_SIGN                   "method_sign"
 #define SCA_VALIDATE               "method_validate"
+#define SCA_SIGN_BATCH             "method_signBatch"
+#define SCA_VALIDATE_BATCH         "method_validateBatch"
 
 #define SCA_REGISTER_PRIVATE_KEY   "method_registerPrivateKey"
 #define SCA_UNREGISTER_PRIVATE_KEY "method_unregisterPrivateKey"
@@ -143,9 +146,12 @@
 
 #define SCA_DEF_GET_DEBUGLEVEL         "getDebugLevel"
 #define SCA_DEF_SET_DEBUGLEVEL         "setDebugLevel"
+#define SCA_DEF_GET_CACHE_STATISTICS   "getCacheStatistics"
 
 #define SCA_DEF_SIGN                   "sign"
 #define SCA_DEF_VALIDATE               "validate"
+#define SCA_DEF_SIGN_BATCH             "signBatch"
+#define SCA_DEF_VALIDATE_BATCH         "validateBatch"
 
 #define SCA_DEF_REGISTER_PRIVATE_KEY   "registerPrivateKey"
 #define SCA_DEF_UNREGISTER_PRIVATE_KEY "unregisterPrivateKey"
@@ -172,9 +178,12 @@ typedef struct {
 
   const char* str_method_getDebugLevel;
   const char* str_method_setDebugLevel;
+  const char* str_method_getCacheStatistics;
   
   const char* str_method_sign;
   const char* str_method_validate;
+  const char* str_method_signBatch;
+  const char* str_method_validateBatch;
 
   const char* str_method_registerPrivateKey;
   const char* str_method_unregisterPrivateKey;
@@ -228,6 +237,10 @@ static char _keyPath [MAXPATHLEN];
 static char _key_ext_priv[MAX_EXT_SIZE];
 /* The file extension for X509 certificates containing the public key. */
 static char _key_ext_pub[MAX_EXT_SIZE];
+/* The validate method the batch wrapper loops over. */
+static int (*_loopValidate)(SCA_BGPSecValidationData* data) = NULL;
+/* The sign method the batch wrapper loops over. */
+static int (*_loopSign)(SCA_BGPSecSignData* bgpsec_data) = NULL;
 
 // Default function implementation.
 /**
@@ -315,6 +328,20 @@ bool wrap_freeHashMessage(SCA_HashMessage* hashMessage)
     sca_debugLog (LOG_DEBUG, "Called local test wrapper 'setDebugLevel'\n");
     return -1;    
   }
+
+  /**
+   * Retrieve the statistics of the cache of verified signature segments.
+   * 
+   * @param stats The statistics object, not modified.
+   * 
+   * @return false (not supported)
+   */
+  bool wrap_getCacheStatistics(SCA_CacheStatistics* stats)
+  {
+    sca_debugLog (LOG_DEBUG, 
+                  "Called local test wrapper 'getCacheStatistics'\n");
+    return false;
+  }
   
   /**
    * Perform BGPSEC path validation. This function required the keys to be 
@@ -374,6 +401,74 @@ int wrap_sign(SCA_BGPSecSignData* data)
   return API_FAILURE;
 }
 
+/**
+ * This is the internal batch validation wrapper for libraries that only
+ * provide validate. It calls the mapped validate method for each update.
+ *
+ * @param data The array of updates to be validated.
+ * @param numData The number of updates in the array.
+ * @param results Receives the validation result of each update, can be NULL.
+ *
+ * @return The number of valid updates.
+ */
+int wrap_validateBatch(SCA_BGPSecValidationData** data, int numData,
+                       int* results)
+{
+  int valid = 0;
+  int idx   = 0;
+  int res   = API_VALRESULT_INVALID;
+
+  for (; idx < numData; idx++)
+  {
+    res = data[idx] != NULL ? _loopValidate(data[idx])
+                            : API_VALRESULT_INVALID;
+    if (res == API_VALRESULT_VALID)
+    {
+      valid++;
+    }
+    if (results != NULL)
+    {
+      results[idx] = res;
+    }
+  }
+
+  return valid;
+}
+
+/**
+ * This is the internal batch signing wrapper for libraries that only provide
+ * sign. It calls the mapped sign method for each data object.
+ *
+ * @param bgpsec_data The array of data objects to be signed.
+ * @param numData The number of objects in the array.
+ * @param results Receives the result of each sign call, can be NULL.
+ *
+ * @return The number of signed objects.
+ */
+int wrap_signBatch(SCA_BGPSecSignData** bgpsec_data, int numData,
+                   int* results)
+{
+  int noSigned = 0;
+  int idx      = 0;
+  int res      = API_FAILURE;
+
+  for (; idx < numData; idx++)
+  {
+    res = bgpsec_data[idx] != NULL ? _loopSign(bgpsec_data[idx])
+                                   : API_FAILURE;
+    if (res == API_SUCCESS)
+    {
+      noSigned++;
+    }
+    if (results != NULL)
+    {
+      results[idx] = res;
+    }
+  }
+
+  return noSigned;
+}
+
 /**
  * Register the private key. This method does not store the key. the return
  * value is 0
@@ -632,6 +727,8 @@ static void _loadMapping(config_setting_t *set, SCA_Mappings* mappings)
                      &mappings->str_method_getDebugLevel);
   __readMapping(set, SCA_SET_DEBUGLEVEL, 
                      &mappings->str_method_setDebugLevel);
+  __readMapping(set, SCA_GET_CACHE_STATISTICS, 
+                     &mappings->str_method_getCacheStatistics);
   
   
   //////////////////////////////////////////////////////////////////////////////
@@ -639,6 +736,9 @@ static void _loadMapping(config_setting_t *set, SCA_Mappings* mappings)
   //////////////////////////////////////////////////////////////////////////////
   __readMapping(set, SCA_SIGN, &mappings->str_method_sign);
   __readMapping(set, SCA_VALIDATE, &mappings->str_method_validate);
+  __readMapping(set, SCA_SIGN_BATCH, &mappings->str_method_signBatch);
+  __readMapping(set, SCA_VALIDATE_BATCH, 
+                     &mappings->str_method_validateBatch);
   
   
   //////////////////////////////////////////////////////////////////////////////
@@ -771,11 +871,23 @@ static int _mapAPI(SCA_Mappings* mappings, SRxCryptoAPI* api)
                     mappings->str_method_freeSignature, 
                     SCA_DEF_FREE_SIGNATURE);    
 
+    __doMapFunction(api->libHandle, (void**)&api->getCacheStatistics,
+                    mappings->str_method_getCacheStatistics, 
+                    SCA_DEF_GET_CACHE_STATISTICS);    
+
     
     __doMapFunction(api->libHandle, (void**)&api->sign,
                     mappings->str_method_sign, SCA_DEF_SIGN);
     __doMapFunction(api->libHandle, (void**)&api->validate,
                     mappings->str_method_validate, SCA_DEF_VALIDATE);
+    __doMapFunction(api->libHandle, (void**)&api->signBatch,
+                    mappings->str_method_signBatch, SCA_DEF_SIGN_BATCH);
+    __doMapFunction(api->libHandle, (void**)&api->validateBatch,
+                    mappings->str_method_validateBatch, 
+                    SCA_DEF_VALIDATE_BATCH);
+    // The batch wrappers use the single update methods of the library.
+    _loopSign     = api->sign;
+    _loopValidate = api->validate;
     
     __doMapFunction(api->libHandle, (void**)&api->registerPublicKey,
                     mappings->str_method_registerPublicKey,
@@ -855,9 +967,14 @@ int srxCryptoInit(SRxCryptoAPI* api, sca_status_t* status)
   
   api->freeHashMessage      = wrap_freeHashMessage;
   api->freeSignature        = wrap_freeSignature;
+  api->getCacheStatistics   = wrap_getCacheStatistics;
   
   api->sign                 = wrap_sign;
   api->validate             = wrap_validate;
+  api->signBatch            = wrap_signBatch;
+  api->validateBatch        = wrap_validateBatch;
+  _loopSign                 = wrap_sign;
+  _loopValidate             = wrap_validate;
 
   api->registerPublicKey    = wrap_registerPublicKey;
   api->unregisterPublicKey  = wrap_unregisterPublicKey;